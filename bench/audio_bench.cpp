@@ -0,0 +1,317 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <viam/sdk/common/instance.hpp>
+#include <viam/sdk/config/resource.hpp>
+#include "audio_buffer.hpp"
+#include "audio_codec.hpp"
+#include "microphone.hpp"
+#include "mp3_decoder.hpp"
+#include "mp3_encoder.hpp"
+#include "resample.hpp"
+#include "test_utils.hpp"
+
+using namespace viam::sdk;
+
+namespace {
+
+constexpr int BENCH_SAMPLE_RATE = 48000;
+// A typical PortAudio callback at 48 kHz
+constexpr int FRAMES_PER_CALLBACK = 480;
+
+// A 440 Hz tone, so codecs see realistic signal rather than silence
+std::vector<int16_t> make_tone(int sample_rate, int num_channels, double seconds = 1.0) {
+    const size_t frames = static_cast<size_t>(sample_rate * seconds);
+    std::vector<int16_t> samples(frames * num_channels);
+    for (size_t i = 0; i < frames; i++) {
+        const auto value = static_cast<int16_t>(std::sin(2.0 * 3.14159265358979 * 440.0 * i / sample_rate) * 16000);
+        for (int ch = 0; ch < num_channels; ch++) {
+            samples[i * num_channels + ch] = value;
+        }
+    }
+    return samples;
+}
+
+void set_sample_throughput(benchmark::State& state, size_t samples_per_iteration) {
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * samples_per_iteration));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * samples_per_iteration * sizeof(int16_t)));
+}
+
+// --- AudioBuffer ---
+
+void BM_AudioBufferWriteSample(benchmark::State& state) {
+    audio::AudioBuffer buffer(audio_info{audio_codecs::PCM_16, BENCH_SAMPLE_RATE, 1}, audio::BUFFER_DURATION_SECONDS);
+    int16_t sample = 0;
+    for (auto _ : state) {
+        buffer.write_sample(sample++);
+    }
+    set_sample_throughput(state, 1);
+}
+BENCHMARK(BM_AudioBufferWriteSample);
+
+// range(0): samples per block
+void BM_AudioBufferWriteSamples(benchmark::State& state) {
+    audio::AudioBuffer buffer(audio_info{audio_codecs::PCM_16, BENCH_SAMPLE_RATE, 1}, audio::BUFFER_DURATION_SECONDS);
+    const std::vector<int16_t> block(static_cast<size_t>(state.range(0)), 1234);
+    for (auto _ : state) {
+        buffer.write_samples(block.data(), block.size());
+    }
+    set_sample_throughput(state, block.size());
+}
+BENCHMARK(BM_AudioBufferWriteSamples)->Arg(FRAMES_PER_CALLBACK)->Arg(4800);
+
+// range(0): samples per read, trailing the writer by one second
+void BM_AudioBufferReadSamples(benchmark::State& state) {
+    audio::AudioBuffer buffer(audio_info{audio_codecs::PCM_16, BENCH_SAMPLE_RATE, 1}, audio::BUFFER_DURATION_SECONDS);
+    const auto tone = make_tone(BENCH_SAMPLE_RATE, 1, 5.0);
+    buffer.write_samples(tone.data(), tone.size());
+    std::vector<int16_t> out(static_cast<size_t>(state.range(0)));
+    const uint64_t start = buffer.get_write_position() - BENCH_SAMPLE_RATE;
+    uint64_t position = start;
+    for (auto _ : state) {
+        if (position + out.size() > buffer.get_write_position()) {
+            position = start;
+        }
+        benchmark::DoNotOptimize(buffer.read_samples(out.data(), static_cast<int>(out.size()), position));
+    }
+    set_sample_throughput(state, out.size());
+}
+BENCHMARK(BM_AudioBufferReadSamples)->Arg(FRAMES_PER_CALLBACK)->Arg(4800);
+
+// --- Resampling ---
+
+// range(0) -> range(1) Hz, range(2) channels, 100 ms per call
+void BM_ResampleAudio(benchmark::State& state) {
+    const int in_rate = static_cast<int>(state.range(0));
+    const int out_rate = static_cast<int>(state.range(1));
+    const int channels = static_cast<int>(state.range(2));
+    const auto input = make_tone(in_rate, channels, 0.1);
+    std::vector<int16_t> output;
+    for (auto _ : state) {
+        resample_audio(in_rate, out_rate, channels, input.data(), input.size(), output);
+        benchmark::DoNotOptimize(output.data());
+    }
+    set_sample_throughput(state, input.size());
+}
+BENCHMARK(BM_ResampleAudio)
+    ->Args({48000, 16000, 1})
+    ->Args({44100, 48000, 1})
+    ->Args({48000, 44100, 2})
+    ->Args({16000, 48000, 1})
+    ->Args({22050, 44100, 2});
+
+// --- Format conversion ---
+
+void BM_ConvertPcm16ToPcm32(benchmark::State& state) {
+    const auto input = make_tone(BENCH_SAMPLE_RATE, 1, 0.1);
+    std::vector<uint8_t> output;
+    for (auto _ : state) {
+        audio::codec::convert_pcm16_to_pcm32(input.data(), static_cast<int>(input.size()), output);
+        benchmark::DoNotOptimize(output.data());
+    }
+    set_sample_throughput(state, input.size());
+}
+BENCHMARK(BM_ConvertPcm16ToPcm32);
+
+void BM_ConvertPcm16ToFloat32(benchmark::State& state) {
+    const auto input = make_tone(BENCH_SAMPLE_RATE, 1, 0.1);
+    std::vector<uint8_t> output;
+    for (auto _ : state) {
+        audio::codec::convert_pcm16_to_float32(input.data(), static_cast<int>(input.size()), output);
+        benchmark::DoNotOptimize(output.data());
+    }
+    set_sample_throughput(state, input.size());
+}
+BENCHMARK(BM_ConvertPcm16ToFloat32);
+
+void BM_CopyPcm16(benchmark::State& state) {
+    const auto input = make_tone(BENCH_SAMPLE_RATE, 1, 0.1);
+    std::vector<uint8_t> output;
+    for (auto _ : state) {
+        audio::codec::copy_pcm16(input.data(), static_cast<int>(input.size()), output);
+        benchmark::DoNotOptimize(output.data());
+    }
+    set_sample_throughput(state, input.size());
+}
+BENCHMARK(BM_CopyPcm16);
+
+void BM_ConvertPcm32ToPcm16(benchmark::State& state) {
+    const auto tone = make_tone(BENCH_SAMPLE_RATE, 1, 0.1);
+    std::vector<uint8_t> input;
+    audio::codec::convert_pcm16_to_pcm32(tone.data(), static_cast<int>(tone.size()), input);
+    std::vector<uint8_t> output;
+    for (auto _ : state) {
+        audio::codec::convert_pcm32_to_pcm16(input.data(), static_cast<int>(input.size()), output);
+        benchmark::DoNotOptimize(output.data());
+    }
+    set_sample_throughput(state, tone.size());
+}
+BENCHMARK(BM_ConvertPcm32ToPcm16);
+
+void BM_ConvertFloat32ToPcm16(benchmark::State& state) {
+    const auto tone = make_tone(BENCH_SAMPLE_RATE, 1, 0.1);
+    std::vector<uint8_t> input;
+    audio::codec::convert_pcm16_to_float32(tone.data(), static_cast<int>(tone.size()), input);
+    std::vector<uint8_t> output;
+    for (auto _ : state) {
+        audio::codec::convert_float32_to_pcm16(input.data(), static_cast<int>(input.size()), output);
+        benchmark::DoNotOptimize(output.data());
+    }
+    set_sample_throughput(state, tone.size());
+}
+BENCHMARK(BM_ConvertFloat32ToPcm16);
+
+void BM_InterleaveStereoPcm16(benchmark::State& state) {
+    const auto left = make_tone(BENCH_SAMPLE_RATE, 1, 0.1);
+    const auto right = make_tone(BENCH_SAMPLE_RATE, 1, 0.1);
+    std::vector<int16_t> output(left.size() * 2);
+    for (auto _ : state) {
+        audio::codec::interleave_stereo_pcm16(left.data(), right.data(), output.data(), left.size());
+        benchmark::DoNotOptimize(output.data());
+    }
+    set_sample_throughput(state, output.size());
+}
+BENCHMARK(BM_InterleaveStereoPcm16);
+
+// --- MP3 ---
+
+// range(0) channels, 100 ms per call into a long-lived encoder, as get_audio does
+void BM_EncodeSamplesToMp3(benchmark::State& state) {
+    const int channels = static_cast<int>(state.range(0));
+    auto input = make_tone(BENCH_SAMPLE_RATE, channels, 0.1);
+    microphone::MP3EncoderContext ctx;
+    microphone::initialize_mp3_encoder(ctx, BENCH_SAMPLE_RATE, channels);
+    std::vector<uint8_t> output;
+    uint64_t position = 0;
+    for (auto _ : state) {
+        output.clear();
+        microphone::encode_samples_to_mp3(ctx, input.data(), static_cast<int>(input.size()), position, output);
+        position += input.size();
+        benchmark::DoNotOptimize(output.data());
+    }
+    microphone::cleanup_mp3_encoder(ctx);
+    set_sample_throughput(state, input.size());
+}
+BENCHMARK(BM_EncodeSamplesToMp3)->Arg(1)->Arg(2);
+
+// range(0) channels, one second of MP3 per call into a fresh decoder, as play() does
+void BM_DecodeMp3ToPcm16(benchmark::State& state) {
+    const int channels = static_cast<int>(state.range(0));
+    auto tone = make_tone(BENCH_SAMPLE_RATE, channels);
+    microphone::MP3EncoderContext encoder;
+    microphone::initialize_mp3_encoder(encoder, BENCH_SAMPLE_RATE, channels);
+    std::vector<uint8_t> encoded;
+    microphone::encode_samples_to_mp3(encoder, tone.data(), static_cast<int>(tone.size()), 0, encoded);
+    microphone::flush_mp3_encoder(encoder, encoded);
+    microphone::cleanup_mp3_encoder(encoder);
+
+    std::vector<uint8_t> decoded;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto ctx = std::make_unique<speaker::MP3DecoderContext>();
+        decoded.clear();
+        state.ResumeTiming();
+        speaker::decode_mp3_to_pcm16(*ctx, encoded, decoded);
+        benchmark::DoNotOptimize(decoded.data());
+    }
+    set_sample_throughput(state, tone.size());
+}
+BENCHMARK(BM_DecodeMp3ToPcm16)->Arg(1)->Arg(2);
+
+// --- End to end ---
+
+// One live get_audio call on a microphone backed by the PortAudio mock. Each iteration
+// feeds FRAMES_PER_CALLBACK-frame blocks through AudioCallback until the next chunk reaches
+// the handler, so it times capture -> ring -> encode -> delivery for one chunk.
+// range(0) selects the codec: 0 pcm16, 1 mp3, 2 opus.
+void BM_GetAudioLive(benchmark::State& state) {
+    static const char* const codecs[] = {audio_codecs::PCM_16, audio_codecs::MP3, audio::codec::OPUS_CODEC_NAME};
+    const std::string codec = codecs[state.range(0)];
+
+    ::testing::NiceMock<test_utils::MockPortAudio> pa;
+    PaDeviceInfo device_info{};
+    device_info.name = "Bench Device";
+    device_info.maxInputChannels = 1;
+    device_info.defaultSampleRate = BENCH_SAMPLE_RATE;
+    device_info.defaultLowInputLatency = 0.01;
+    ON_CALL(pa, getDeviceCount()).WillByDefault(::testing::Return(1));
+    ON_CALL(pa, getDeviceInfo(::testing::_)).WillByDefault(::testing::Return(&device_info));
+
+    ProtoStruct attrs{{"sample_rate", static_cast<double>(BENCH_SAMPLE_RATE)}, {"num_channels", 1.0}};
+    ResourceConfig config(
+        "rdk:component:audioin", "", "bench_microphone", attrs, "", microphone::Microphone::model, LinkConfig{}, log_level::warn);
+    microphone::Microphone mic(Dependencies{}, config, &pa);
+
+    const auto tone = make_tone(BENCH_SAMPLE_RATE, 1);
+    size_t offset = 0;
+    const PaStreamCallbackTimeInfo time_info{};
+    const auto feed = [&] {
+        std::shared_ptr<audio::InputStreamContext> ctx;
+        {
+            std::lock_guard<std::mutex> lock(mic.stream_ctx_mu_);
+            ctx = mic.audio_context_;
+        }
+        microphone::AudioCallback(tone.data() + offset, nullptr, FRAMES_PER_CALLBACK, &time_info, 0, ctx.get());
+        offset = (offset + FRAMES_PER_CALLBACK) % (tone.size() - FRAMES_PER_CALLBACK);
+    };
+
+    std::atomic<uint64_t> delivered{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<bool> stop{false};
+    std::atomic<bool> done{false};
+    std::thread reader([&] {
+        mic.get_audio(
+            codec,
+            [&](AudioIn::audio_chunk&& chunk) {
+                bytes.fetch_add(chunk.audio_data.size());
+                delivered.fetch_add(1);
+                return !stop.load();
+            },
+            0,
+            0,
+            ProtoStruct{});
+        done.store(true);
+    });
+
+    // Wait for the first chunk, so the reader is positioned and the encoder is warm
+    while (delivered.load() == 0) {
+        feed();
+    }
+
+    for (auto _ : state) {
+        const uint64_t target = delivered.load() + 1;
+        while (delivered.load() < target) {
+            feed();
+            std::this_thread::yield();
+        }
+    }
+
+    stop.store(true);
+    while (!done.load()) {
+        feed();
+        std::this_thread::yield();
+    }
+    reader.join();
+    state.counters["bytes_per_chunk"] = static_cast<double>(bytes.load()) / delivered.load();
+}
+BENCHMARK(BM_GetAudioLive)->Arg(0)->Arg(1)->Arg(2)->UseRealTime();
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    // The resource code needs the SDK instance alive for logging
+    Instance instance;
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
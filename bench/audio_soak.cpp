@@ -0,0 +1,415 @@
+// Load/soak harness: runs a microphone and a speaker on the mocked PortAudio interface, with
+// a timer thread per device calling AudioCallback / speakerCallback at the real device rate,
+// while concurrent get_audio clients and play_stream sessions run against them. At the end
+// it reports overflows, underruns, missed callback deadlines, CPU per client and delivery
+// latency percentiles.
+//
+//   audio-soak --seconds=60 --mic-clients=8 --speaker-streams=2 --codec=mp3
+//
+// Run it on the target board (e.g. a Pi 4) to find how many consumers a device sustains.
+#include <sys/resource.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <viam/sdk/common/instance.hpp>
+#include <viam/sdk/config/resource.hpp>
+#include "microphone.hpp"
+#include "speaker.hpp"
+#include "test_utils.hpp"
+
+using namespace viam::sdk;
+
+namespace {
+
+struct Options {
+    int seconds = 30;
+    int mic_clients = 4;
+    int speaker_streams = 1;
+    int sample_rate = 48000;
+    int num_channels = 1;
+    int frames_per_buffer = 480;
+    std::string codec = audio_codecs::PCM_16;
+    // play_stream chunk length; sources deliver in real time, lead_ms ahead of playback
+    int chunk_ms = 20;
+    int lead_ms = 60;
+};
+
+void usage() {
+    std::cerr << "usage: audio-soak [--seconds=N] [--mic-clients=N] [--speaker-streams=N] [--sample-rate=HZ]\n"
+                 "                  [--channels=N] [--frames-per-buffer=N] [--codec=pcm16|pcm32|pcm32_float|mp3|opus]\n"
+                 "                  [--chunk-ms=N] [--lead-ms=N]\n";
+}
+
+Options parse_options(int argc, char** argv) {
+    Options options;
+    const std::map<std::string, int*> ints{{"--seconds", &options.seconds},
+                                           {"--mic-clients", &options.mic_clients},
+                                           {"--speaker-streams", &options.speaker_streams},
+                                           {"--sample-rate", &options.sample_rate},
+                                           {"--channels", &options.num_channels},
+                                           {"--frames-per-buffer", &options.frames_per_buffer},
+                                           {"--chunk-ms", &options.chunk_ms},
+                                           {"--lead-ms", &options.lead_ms}};
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const auto eq = arg.find('=');
+        const std::string key = arg.substr(0, eq);
+        if (eq == std::string::npos || key == "--help") {
+            usage();
+            std::exit(key == "--help" ? 0 : 1);
+        }
+        const std::string value = arg.substr(eq + 1);
+        if (key == "--codec") {
+            options.codec = value;
+        } else if (ints.count(key)) {
+            *ints.at(key) = std::atoi(value.c_str());
+        } else {
+            usage();
+            std::exit(1);
+        }
+    }
+    if (options.seconds <= 0 || options.sample_rate <= 0 || options.num_channels <= 0 || options.frames_per_buffer <= 0 ||
+        options.chunk_ms <= 0 || options.mic_clients < 0 || options.speaker_streams < 0) {
+        usage();
+        std::exit(1);
+    }
+    return options;
+}
+
+uint64_t thread_cpu_ns() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ULL + ts.tv_nsec;
+}
+
+uint64_t process_cpu_ns() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    const auto to_ns = [](const timeval& tv) { return static_cast<uint64_t>(tv.tv_sec) * 1'000'000'000ULL + tv.tv_usec * 1000ULL; };
+    return to_ns(usage.ru_utime) + to_ns(usage.ru_stime);
+}
+
+double seconds_since(std::chrono::steady_clock::time_point origin) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - origin).count();
+}
+
+// Sorted-sample percentile; 0 for no samples
+double percentile(std::vector<double>& values, double fraction) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    const size_t rank = static_cast<size_t>(std::ceil(fraction * values.size()));
+    return values[std::min(values.size() - 1, rank == 0 ? 0 : rank - 1)];
+}
+
+// Calls a PortAudio callback every frames_per_buffer frames on an absolute schedule, the way
+// a device would. A callback that starts a full period late, or runs longer than a period,
+// is a missed deadline; the next callback then carries overrun_flag, as the host would set it.
+class DeviceClock {
+   public:
+    using Callback = std::function<void(double now_s, PaStreamCallbackFlags flags)>;
+
+    DeviceClock(std::string name, int sample_rate, int frames_per_buffer, PaStreamCallbackFlags overrun_flag, Callback callback)
+        : name_(std::move(name)),
+          period_(std::chrono::nanoseconds(static_cast<int64_t>(frames_per_buffer) * 1'000'000'000LL / sample_rate)),
+          overrun_flag_(overrun_flag),
+          callback_(std::move(callback)) {}
+
+    void start(std::chrono::steady_clock::time_point origin) {
+        thread_ = std::thread([this, origin] { run(origin); });
+    }
+
+    void stop() {
+        stop_.store(true);
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    void report() const {
+        std::vector<double> durations = durations_us_;
+        std::cout << "  " << name_ << " callbacks: " << callbacks_ << ", missed deadlines: " << missed_ << ", p50/p99/max run time: "
+                  << percentile(durations, 0.5) << "/" << percentile(durations, 0.99) << "/"
+                  << (durations.empty() ? 0 : durations.back()) << " us of a "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(period_).count() << " us period\n";
+    }
+
+   private:
+    void run(std::chrono::steady_clock::time_point origin) {
+        durations_us_.reserve(1 << 16);
+        auto deadline = std::chrono::steady_clock::now();
+        PaStreamCallbackFlags flags = 0;
+        while (!stop_.load()) {
+            std::this_thread::sleep_until(deadline);
+            const auto start = std::chrono::steady_clock::now();
+            callback_(std::chrono::duration<double>(start - origin).count(), flags);
+            const auto end = std::chrono::steady_clock::now();
+            callbacks_++;
+            if (durations_us_.size() < durations_us_.capacity()) {
+                durations_us_.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            }
+
+            const bool missed = start - deadline >= period_ || end - start > period_;
+            flags = missed ? overrun_flag_ : 0;
+            missed_ += missed ? 1 : 0;
+            deadline += period_;
+            // After a long stall, skip the lost periods instead of bursting to catch up
+            if (end - deadline > 4 * period_) {
+                deadline = end;
+            }
+        }
+    }
+
+    const std::string name_;
+    const std::chrono::nanoseconds period_;
+    const PaStreamCallbackFlags overrun_flag_;
+    const Callback callback_;
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+    uint64_t callbacks_ = 0;
+    uint64_t missed_ = 0;
+    std::vector<double> durations_us_;
+};
+
+struct ClientResult {
+    uint64_t chunks = 0;
+    uint64_t bytes = 0;
+    uint64_t cpu_ns = 0;
+    // Delivery time minus the capture time of the chunk's last sample
+    std::vector<double> latency_ms;
+    std::string error;
+};
+
+std::vector<int16_t> make_tone(int sample_rate, int num_channels, int frames) {
+    std::vector<int16_t> samples(static_cast<size_t>(frames) * num_channels);
+    for (int i = 0; i < frames; i++) {
+        const auto value = static_cast<int16_t>(std::sin(2.0 * 3.14159265358979 * 440.0 * i / sample_rate) * 16000);
+        std::fill_n(samples.begin() + static_cast<size_t>(i) * num_channels, num_channels, value);
+    }
+    return samples;
+}
+
+double stat_field(const ProtoStruct& stats, const std::string& histogram, const std::string& field) {
+    const auto* h = stats.at(histogram).get<ProtoStruct>();
+    return *h->at(field).get<double>();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const Options options = parse_options(argc, argv);
+    Instance instance;
+
+    ::testing::NiceMock<test_utils::MockPortAudio> pa;
+    PaDeviceInfo device_info{};
+    device_info.name = "Soak Device";
+    device_info.maxInputChannels = options.num_channels;
+    device_info.maxOutputChannels = options.num_channels;
+    device_info.defaultSampleRate = options.sample_rate;
+    device_info.defaultLowInputLatency = 0.01;
+    device_info.defaultLowOutputLatency = 0.01;
+    ON_CALL(pa, getDeviceCount()).WillByDefault(::testing::Return(1));
+    ON_CALL(pa, getDeviceInfo(::testing::_)).WillByDefault(::testing::Return(&device_info));
+
+    ProtoStruct attrs{{"sample_rate", static_cast<double>(options.sample_rate)}, {"num_channels", static_cast<double>(options.num_channels)}};
+    microphone::Microphone mic(
+        Dependencies{},
+        ResourceConfig("rdk:component:audioin", "", "soak_microphone", attrs, "", microphone::Microphone::model, LinkConfig{}, log_level::warn),
+        &pa);
+    // Concurrent play_stream sessions only overlap when mixing
+    ProtoStruct speaker_attrs = attrs;
+    speaker_attrs["mixing"] = options.speaker_streams > 1;
+    speaker::Speaker speaker(
+        Dependencies{},
+        ResourceConfig(
+            "rdk:component:audioout", "", "soak_speaker", speaker_attrs, "", speaker::Speaker::model, LinkConfig{}, log_level::warn),
+        &pa);
+
+    // The contexts are read once: a watchdog restart shows up as "restarts" in the report
+    const std::shared_ptr<audio::InputStreamContext> mic_ctx = mic.audio_context_;
+    const std::shared_ptr<audio::OutputStreamContext> speaker_ctx = speaker.audio_context_;
+
+    const int samples_per_buffer = options.frames_per_buffer * options.num_channels;
+    const double period_s = static_cast<double>(options.frames_per_buffer) / options.sample_rate;
+    const auto tone = make_tone(options.sample_rate, options.num_channels, options.sample_rate);
+    std::vector<int16_t> output(samples_per_buffer);
+    size_t tone_offset = 0;
+    std::atomic<int> active_streams{0};
+    uint64_t starved_callbacks = 0;
+
+    const auto origin = std::chrono::steady_clock::now();
+    DeviceClock mic_clock("microphone", options.sample_rate, options.frames_per_buffer, paInputOverflow, [&](double now_s, PaStreamCallbackFlags flags) {
+        PaStreamCallbackTimeInfo time_info{};
+        time_info.currentTime = now_s;
+        time_info.inputBufferAdcTime = now_s - period_s;
+        microphone::AudioCallback(tone.data() + tone_offset, nullptr, options.frames_per_buffer, &time_info, flags, mic_ctx.get());
+        tone_offset = (tone_offset + samples_per_buffer) % (tone.size() - samples_per_buffer);
+    });
+    DeviceClock speaker_clock(
+        "speaker", options.sample_rate, options.frames_per_buffer, paOutputUnderflow, [&](double now_s, PaStreamCallbackFlags flags) {
+            PaStreamCallbackTimeInfo time_info{};
+            time_info.currentTime = now_s;
+            time_info.outputBufferDacTime = now_s + period_s;
+            const uint64_t before = speaker_ctx->playback_position.load();
+            speaker::speakerCallback(nullptr, output.data(), options.frames_per_buffer, &time_info, flags, speaker_ctx.get());
+            // Silence padded into a buffer while a stream is playing is an audible gap
+            if (active_streams.load() > 0 && speaker_ctx->playback_position.load() - before < static_cast<uint64_t>(samples_per_buffer)) {
+                starved_callbacks++;
+            }
+        });
+    mic_clock.start(origin);
+    speaker_clock.start(origin);
+
+    std::vector<ClientResult> mic_results(options.mic_clients);
+    std::vector<ClientResult> speaker_results(options.speaker_streams);
+    std::vector<std::thread> threads;
+    const uint64_t cpu_start = process_cpu_ns();
+
+    for (int i = 0; i < options.mic_clients; i++) {
+        threads.emplace_back([&, i] {
+            ClientResult& result = mic_results[i];
+            result.latency_ms.reserve(static_cast<size_t>(options.seconds) * 1000);
+            const uint64_t cpu_before = thread_cpu_ns();
+            try {
+                mic.get_audio(
+                    options.codec,
+                    [&](AudioIn::audio_chunk&& chunk) {
+                        const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch());
+                        result.latency_ms.push_back((now - chunk.end_timestamp_ns).count() / 1e6);
+                        result.chunks++;
+                        result.bytes += chunk.audio_data.size();
+                        return true;
+                    },
+                    options.seconds,
+                    0,
+                    ProtoStruct{});
+            } catch (const std::exception& e) {
+                result.error = e.what();
+            }
+            result.cpu_ns = thread_cpu_ns() - cpu_before;
+        });
+    }
+
+    for (int i = 0; i < options.speaker_streams; i++) {
+        threads.emplace_back([&, i] {
+            ClientResult& result = speaker_results[i];
+            result.latency_ms.reserve(static_cast<size_t>(options.seconds) * 1000 / options.chunk_ms + 1);
+            const int chunk_frames = options.sample_rate * options.chunk_ms / 1000;
+            const auto chunk_period = std::chrono::milliseconds(options.chunk_ms);
+            const size_t total_chunks = static_cast<size_t>(options.seconds) * 1000 / options.chunk_ms;
+            const auto source_start = std::chrono::steady_clock::now();
+            size_t offset = 0;
+            const uint64_t cpu_before = thread_cpu_ns();
+            active_streams.fetch_add(1);
+            try {
+                speaker.play_stream(
+                    audio_info{audio_codecs::PCM_16, options.sample_rate, options.num_channels},
+                    [&]() -> boost::optional<std::vector<uint8_t>> {
+                        if (result.chunks == total_chunks) {
+                            return boost::none;
+                        }
+                        // Real-time source: chunk n is due lead_ms before it would play
+                        const auto due = source_start + result.chunks * chunk_period - std::chrono::milliseconds(options.lead_ms);
+                        std::this_thread::sleep_until(due);
+                        // How late the caller asked for this chunk relative to when it was due
+                        result.latency_ms.push_back(
+                            std::max(0.0, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - due).count()));
+                        const size_t samples = static_cast<size_t>(chunk_frames) * options.num_channels;
+                        if (offset + samples > tone.size()) {
+                            offset = 0;
+                        }
+                        std::vector<uint8_t> chunk(samples * sizeof(int16_t));
+                        std::memcpy(chunk.data(), tone.data() + offset, chunk.size());
+                        offset += samples;
+                        result.chunks++;
+                        result.bytes += chunk.size();
+                        return chunk;
+                    },
+                    ProtoStruct{});
+            } catch (const std::exception& e) {
+                result.error = e.what();
+            }
+            active_streams.fetch_sub(1);
+            result.cpu_ns = thread_cpu_ns() - cpu_before;
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const double wall_s = seconds_since(origin);
+    const uint64_t cpu_ns = process_cpu_ns() - cpu_start;
+    mic_clock.stop();
+    speaker_clock.stop();
+
+    const ProtoStruct mic_stats = mic.get_status();
+    const ProtoStruct speaker_stats = speaker.get_status();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "audio-soak: " << options.seconds << " s at " << options.sample_rate << " Hz x " << options.num_channels << " ch, "
+              << options.frames_per_buffer << " frames per callback, " << options.mic_clients << " " << options.codec
+              << " get_audio clients, " << options.speaker_streams << " play_stream sessions\n";
+
+    std::cout << "devices\n";
+    mic_clock.report();
+    speaker_clock.report();
+    std::cout << "  input overflows: " << mic_ctx->input_overflow_count.load() << ", output underflows: " << speaker_ctx->output_underflow_count.load()
+              << ", starved speaker callbacks: " << starved_callbacks << ", restarts: " << *mic_stats.at("restarts").get<double>() << " mic / "
+              << *speaker_stats.at("restarts").get<double>() << " speaker\n";
+    std::cout << "  process CPU: " << 100.0 * cpu_ns / 1e9 / wall_s << "% of one core";
+    const int clients = options.mic_clients + options.speaker_streams;
+    if (clients > 0) {
+        std::cout << " (" << 100.0 * cpu_ns / 1e9 / wall_s / clients << "% per client)";
+    }
+    std::cout << "\n";
+
+    const auto report_clients = [&](const char* title, std::vector<ClientResult>& results, const char* latency_name) {
+        if (results.empty()) {
+            return;
+        }
+        std::cout << title << "\n";
+        std::vector<double> all;
+        for (size_t i = 0; i < results.size(); i++) {
+            ClientResult& result = results[i];
+            all.insert(all.end(), result.latency_ms.begin(), result.latency_ms.end());
+            std::cout << "  #" << i << ": " << result.chunks << " chunks, " << result.bytes / 1024 << " KiB, thread CPU "
+                      << 100.0 * result.cpu_ns / 1e9 / wall_s << "%, " << latency_name << " p50/p99/max "
+                      << percentile(result.latency_ms, 0.5) << "/" << percentile(result.latency_ms, 0.99) << "/"
+                      << percentile(result.latency_ms, 1.0) << " ms";
+            if (!result.error.empty()) {
+                std::cout << ", failed: " << result.error;
+            }
+            std::cout << "\n";
+        }
+        std::cout << "  all: " << latency_name << " p50/p99/max " << percentile(all, 0.5) << "/" << percentile(all, 0.99) << "/"
+                  << percentile(all, 1.0) << " ms\n";
+    };
+    report_clients("get_audio clients", mic_results, "delivery latency");
+    report_clients("play_stream sessions", speaker_results, "source lateness");
+    if (options.speaker_streams > 0) {
+        std::cout << "  speaker queue: mean " << stat_field(speaker_stats, "queued_ms", "mean") << " ms, max "
+                  << stat_field(speaker_stats, "queued_ms", "max") << " ms\n";
+    }
+
+    bool failed = false;
+    for (const auto* results : {&mic_results, &speaker_results}) {
+        for (const auto& result : *results) {
+            failed = failed || !result.error.empty();
+        }
+    }
+    return failed ? 1 : 0;
+}
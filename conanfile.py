@@ -25,7 +25,7 @@ class audio(ConanFile):
         "shared": True
     }
 
-    exports_sources = "CMakeLists.txt", "LICENSE", "src/*", "test/*", "meta.json", "run.sh"
+    exports_sources = "CMakeLists.txt", "LICENSE", "src/*", "test/*", "bench/*", "meta.json", "run.sh"
 
     def set_version(self):
         content = load(self, "CMakeLists.txt")
@@ -45,6 +45,7 @@ class audio(ConanFile):
         self.requires("viam-cpp-sdk/0.37.0")
         self.requires("libmp3lame/3.100")
         self.requires("soxr/0.1.3")
+        self.requires("opus/1.4")
 
     def generate(self):
         tc = CMakeToolchain(self)
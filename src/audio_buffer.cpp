@@ -1,18 +1,109 @@
 #include "audio_buffer.hpp"
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <climits>
+#include <cstring>
 #include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 #include <viam/sdk/common/audio.hpp>
 #include <viam/sdk/components/audio_in.hpp>
 #include "portaudio.h"
 
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 namespace audio {
 
 namespace vsdk = ::viam::sdk;
 
-AudioBuffer::AudioBuffer(const vsdk::audio_info& audio_info, int buffer_duration_seconds)
-    : audio_buffer(nullptr), buffer_capacity(0), info(audio_info), total_samples_written(0) {
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+              "Notifier futex requires a plain 32-bit atomic");
+
+void Notifier::notify() noexcept {
+    generation_.fetch_add(1);
+    if (waiters_.load() == 0) {
+        return;
+    }
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&generation_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+void Notifier::wait_while_unchanged(uint32_t seen, std::chrono::nanoseconds timeout) noexcept {
+#ifdef __linux__
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(seconds.count());
+    ts.tv_nsec = static_cast<long>((timeout - seconds).count());
+    // Returns immediately with EAGAIN if generation_ already moved past `seen`.
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&generation_), FUTEX_WAIT_PRIVATE, seen, &ts, nullptr, 0);
+#else
+    if (generation_.load() == seen) {
+        std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(timeout, std::chrono::milliseconds(1)));
+    }
+#endif
+}
+
+namespace {
+
+// Smallest power of two >= n, so ring indexing can use a mask instead of a modulo.
+size_t round_up_to_power_of_two(size_t n) {
+    size_t size = 1;
+    while (size < n) {
+        size <<= 1;
+    }
+    return size;
+}
+
+// Same conversions as the pcm16 <-> pcm32 / float32 codecs, one sample at a time
+int32_t widen_to_int32(int16_t sample) noexcept {
+    return static_cast<int32_t>(sample) << 16;
+}
+
+float widen_to_float(int16_t sample) noexcept {
+    return static_cast<float>(sample) * INT16_TO_FLOAT_SCALE;
+}
+
+int16_t narrow_int32(int32_t sample) noexcept {
+    return static_cast<int16_t>(sample >> 16);
+}
+
+int16_t narrow_float(float sample) noexcept {
+    // NaN compares false, so it clamps to 1.0
+    return static_cast<int16_t>(std::max(-1.0f, std::min(1.0f, sample)) * FLOAT_TO_INT16_SCALE);
+}
+
+}  // namespace
+
+const char* sample_format_name(SampleFormat format) noexcept {
+    switch (format) {
+        case SampleFormat::INT32:
+            return "int32";
+        case SampleFormat::FLOAT32:
+            return "float32";
+        default:
+            return "int16";
+    }
+}
+
+SampleFormat parse_sample_format(const std::string& name) {
+    for (const SampleFormat format : {SampleFormat::INT16, SampleFormat::INT32, SampleFormat::FLOAT32}) {
+        if (name == sample_format_name(format)) {
+            return format;
+        }
+    }
+    throw std::invalid_argument("sample_format must be \"int16\", \"int32\" or \"float32\", got: " + name);
+}
+
+AudioBuffer::AudioBuffer(const vsdk::audio_info& audio_info, int buffer_duration_seconds, SampleFormat sample_format)
+    : audio_buffer(nullptr), buffer_capacity(0), info(audio_info), sample_format(sample_format), total_samples_written(0) {
     if (audio_info.sample_rate_hz <= 0) {
         VIAM_SDK_LOG(error) << "[AudioBuffer] sample_rate_hz must be positive, got: " << audio_info.sample_rate_hz;
         throw std::invalid_argument("sample_rate_hz must be positive");
@@ -27,6 +118,7 @@ AudioBuffer::AudioBuffer(const vsdk::audio_info& audio_info, int buffer_duration
     }
 
     // Pre-allocate circular buffer for N seconds of audio
+    this->buffer_duration_seconds = buffer_duration_seconds;
     buffer_capacity = audio_info.sample_rate_hz * audio_info.num_channels * buffer_duration_seconds;
 
     if (buffer_capacity <= 0) {
@@ -34,65 +126,184 @@ AudioBuffer::AudioBuffer(const vsdk::audio_info& audio_info, int buffer_duration
         throw std::invalid_argument("buffer_capacity must be positive");
     }
 
-    try {
-        audio_buffer = std::make_unique<std::atomic<int16_t>[]>(buffer_capacity);
-    } catch (const std::bad_alloc& e) {
-        VIAM_SDK_LOG(error) << "[AudioBuffer] Failed to allocate audio buffer of size " << buffer_capacity << " samples: " << e.what();
-        throw std::runtime_error("Failed to allocate audio buffer of size " + std::to_string(buffer_capacity) + " samples: " + e.what());
+    // The physical ring is rounded up to a power of two; buffer_capacity stays the
+    // advertised history window. The extra slots are slack between the oldest sample a
+    // reader may ask for and the slots the writer is currently overwriting.
+    ring_size = round_up_to_power_of_two(static_cast<size_t>(buffer_capacity));
+    ring_mask = ring_size - 1;
+
+    // Every sample starts at 0 without the constructor touching a page: for a ring this size
+    // calloc maps fresh zero pages, which the kernel only commits when the writer reaches them.
+    audio_buffer.reset(static_cast<uint8_t*>(std::calloc(ring_size, sample_bytes(sample_format))));
+    if (!audio_buffer) {
+        VIAM_SDK_LOG(error) << "[AudioBuffer] Failed to allocate audio buffer of size " << ring_size << " samples";
+        throw std::runtime_error("Failed to allocate audio buffer of size " + std::to_string(ring_size) + " samples");
     }
+}
 
-    // Initialize all elements to 0
-    for (int i = 0; i < buffer_capacity; i++) {
-        audio_buffer[i].store(0);
+void AudioBuffer::store_span(size_t index, const void* samples, size_t count, SampleFormat format) noexcept {
+    uint8_t* const ring = audio_buffer.get() + index * sample_bytes(sample_format);
+    if (format == sample_format) {
+        std::memcpy(ring, samples, count * sample_bytes(sample_format));
+        return;
+    }
+    // Only int16 is ever written into a wider ring
+    const int16_t* const in = static_cast<const int16_t*>(samples);
+    if (sample_format == SampleFormat::INT32) {
+        int32_t* const out = reinterpret_cast<int32_t*>(ring);
+        for (size_t i = 0; i < count; i++) {
+            out[i] = widen_to_int32(in[i]);
+        }
+    } else {
+        float* const out = reinterpret_cast<float*>(ring);
+        for (size_t i = 0; i < count; i++) {
+            out[i] = widen_to_float(in[i]);
+        }
+    }
+}
+
+void AudioBuffer::zero_span(size_t index, size_t count) noexcept {
+    // All-zero bits are 0.0f too
+    std::memset(audio_buffer.get() + index * sample_bytes(sample_format), 0, count * sample_bytes(sample_format));
+}
+
+void AudioBuffer::load_span(size_t index, void* samples, size_t count, SampleFormat format) const noexcept {
+    const uint8_t* const ring = audio_buffer.get() + index * sample_bytes(sample_format);
+    if (format == sample_format) {
+        std::memcpy(samples, ring, count * sample_bytes(sample_format));
+        return;
+    }
+    // A wider ring is only ever read back as int16
+    int16_t* const out = static_cast<int16_t*>(samples);
+    if (sample_format == SampleFormat::INT32) {
+        const int32_t* const in = reinterpret_cast<const int32_t*>(ring);
+        for (size_t i = 0; i < count; i++) {
+            out[i] = narrow_int32(in[i]);
+        }
+    } else {
+        const float* const in = reinterpret_cast<const float*>(ring);
+        for (size_t i = 0; i < count; i++) {
+            out[i] = narrow_float(in[i]);
+        }
     }
 }
 
 void AudioBuffer::write_sample(int16_t sample) noexcept {
-    // Find current index of circular buffer
-    uint64_t pos = total_samples_written.load();
-    int index = pos % buffer_capacity;
+    write_samples(&sample, 1);
+}
 
-    audio_buffer[index].store(sample);
+void AudioBuffer::write_samples(const int16_t* samples, size_t sample_count) noexcept {
+    write_block(samples, sample_count, SampleFormat::INT16);
+}
 
-    total_samples_written.fetch_add(1);
+void AudioBuffer::write_native(const void* samples, size_t sample_count) noexcept {
+    write_block(samples, sample_count, sample_format);
 }
 
-int AudioBuffer::read_samples(int16_t* buffer, int sample_count, uint64_t& read_position) noexcept {
-    uint64_t current_write_pos = total_samples_written.load();
+void AudioBuffer::write_silence(size_t sample_count) noexcept {
+    write_block(nullptr, sample_count, sample_format);
+}
 
-    // trying to read position that hasn't been written yet - return zero samples
-    if (read_position > current_write_pos) {
-        VIAM_SDK_LOG(warn) << "Read position " << read_position << " is ahead of write position " << current_write_pos
-                           << " - no samples available to read";
-        return 0;
+void AudioBuffer::write_block(const void* samples, size_t sample_count, SampleFormat format) noexcept {
+    if (sample_count == 0) {
+        return;
     }
 
-    // Check if that sample is still in the buffer (not overwritten by new samples)
-    if (current_write_pos > read_position + buffer_capacity) {
-        // Position has been overwritten, skip to oldest available sample
-        uint64_t old_position = read_position;
-        read_position = current_write_pos - buffer_capacity;
-        VIAM_SDK_LOG(warn) << "Audio buffer overrun: read position " << old_position
-                           << " has been overwritten. Skipping to oldest available sample at " << read_position << " (lost "
-                           << (read_position - old_position) << " samples)";
-    }
+    // Announce the slots about to be overwritten before touching them
+    const uint64_t pos = begin_write(sample_count);
 
-    uint64_t available = current_write_pos - read_position;
-    int to_read = std::min(static_cast<uint64_t>(sample_count), available);
+    // A block longer than the ring would overwrite its own head; only the newest
+    // ring_size samples survive, so skip straight to those.
+    const size_t skipped = sample_count > ring_size ? sample_count - ring_size : 0;
+    const size_t to_copy = sample_count - skipped;
 
-    for (int i = 0; i < to_read; i++) {
-        int index = (read_position + i) % buffer_capacity;
-        buffer[i] = audio_buffer[index].load();
+    // Copy in at most two spans: up to the end of the ring, then the wrapped remainder.
+    const size_t start = static_cast<size_t>((pos + skipped) & ring_mask);
+    const size_t first_span = std::min(to_copy, ring_size - start);
+    if (samples) {
+        const uint8_t* const block = static_cast<const uint8_t*>(samples) + skipped * sample_bytes(format);
+        store_span(start, block, first_span, format);
+        store_span(0, block + first_span * sample_bytes(format), to_copy - first_span, format);
+    } else {
+        zero_span(start, first_span);
+        zero_span(0, to_copy - first_span);
     }
 
-    // update to the new position in the stream
-    read_position += to_read;
+    end_write(pos + sample_count);
+}
+
+int AudioBuffer::read_samples(int16_t* buffer, int sample_count, uint64_t& read_position) noexcept {
+    return read_block(buffer, sample_count, read_position, SampleFormat::INT16);
+}
 
-    // return the actual number of samples read
-    return to_read;
+int AudioBuffer::read_native(void* buffer, int sample_count, uint64_t& read_position) noexcept {
+    return read_block(buffer, sample_count, read_position, sample_format);
+}
+
+int AudioBuffer::read_block(void* buffer, int sample_count, uint64_t& read_position, SampleFormat format) noexcept {
+    // The copy below is not synchronized with the writer, so it is validated afterwards
+    // (seqlock-style) and retried if the writer lapped the span while we were copying.
+    while (true) {
+        uint64_t current_write_pos = total_samples_written.load(std::memory_order_acquire);
+
+        // trying to read position that hasn't been written yet - return zero samples
+        if (read_position > current_write_pos) {
+            VIAM_SDK_LOG(warn) << "Read position " << read_position << " is ahead of write position " << current_write_pos
+                               << " - no samples available to read";
+            return 0;
+        }
+
+        // Check if that sample is still in the buffer (not overwritten by new samples)
+        if (current_write_pos > read_position + buffer_capacity) {
+            // Position has been overwritten, skip to oldest available sample
+            uint64_t old_position = read_position;
+            read_position = current_write_pos - buffer_capacity;
+            VIAM_SDK_LOG(warn) << "Audio buffer overrun: read position " << old_position
+                               << " has been overwritten. Skipping to oldest available sample at " << read_position << " (lost "
+                               << (read_position - old_position) << " samples)";
+        }
+
+        uint64_t available = current_write_pos - read_position;
+        const size_t to_read = std::min(static_cast<uint64_t>(std::max(sample_count, 0)), available);
+
+        // Same two-span split as write_samples.
+        const size_t start = static_cast<size_t>(read_position & ring_mask);
+        const size_t first_span = std::min(to_read, ring_size - start);
+        load_span(start, buffer, first_span, format);
+        load_span(0, static_cast<uint8_t*>(buffer) + first_span * sample_bytes(format), to_read - first_span, format);
+
+        // Re-check after the copy: every slot the writer had started overwriting is below
+        // write_reserved - ring_size. If none of those fall inside [read_position,
+        // read_position + to_read) the copy is intact.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t reserved = write_reserved.load(std::memory_order_relaxed);
+        if (reserved <= read_position + ring_size) {
+            // update to the new position in the stream
+            read_position += to_read;
+
+            // return the actual number of samples read
+            return static_cast<int>(to_read);
+        }
+
+        // The writer lapped the copy; the overrun check above skips ahead on the retry.
+        VIAM_SDK_LOG(warn) << "Audio buffer overrun during read at position " << read_position << ", retrying";
+    }
+}
+
+void AudioBuffer::share(uint8_t* storage, SharedCursor* cursor) noexcept {
+    // The old pages are about to be freed
+    ring_lock.reset();
+    audio_buffer = std::unique_ptr<uint8_t[], FreeDeleter>(storage, FreeDeleter{false});
+    cursor->write_reserved.store(write_reserved.load());
+    cursor->write_position.store(total_samples_written.load());
+    shared_cursor = cursor;
 }
 
 uint64_t AudioBuffer::get_write_position() const noexcept {
-    return total_samples_written.load();
+    return total_samples_written.load(std::memory_order_acquire);
+}
+
+bool AudioBuffer::wait_for_write_position(uint64_t position, std::chrono::nanoseconds timeout) {
+    return notifier.wait_for(timeout, [this, position]() { return get_write_position() >= position; });
 }
 }  // namespace audio
@@ -1,45 +1,275 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cstdlib>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <type_traits>
 #include <vector>
 #include <viam/sdk/common/audio.hpp>
 #include <viam/sdk/components/audio_in.hpp>
+#include "metrics.hpp"
+#include "realtime.hpp"
 #include "portaudio.h"
 
 namespace audio {
 
 namespace vsdk = ::viam::sdk;
 
-constexpr int BUFFER_DURATION_SECONDS = 30;  // How much audio history to keep in buffer
+constexpr int BUFFER_DURATION_SECONDS = 30;  // Default audio history kept by a microphone
+// Default speaker buffer. Writers are paced by backpressure, so it only has to cover the
+// backpressure margin, pre-roll and scheduling hiccups.
+constexpr int OUTPUT_BUFFER_DURATION_SECONDS = 5;
+// Accepted range for the buffer_seconds attribute
+constexpr int MIN_BUFFER_SECONDS = 2;
+constexpr int MAX_BUFFER_SECONDS = 600;
 
 // Unit-conversion constant: nanoseconds per millisecond.
 constexpr uint64_t NS_PER_MS = 1'000'000;
 
-// Base class for audio buffering - lock-free circular buffer with atomic operations
+constexpr float INT16_TO_FLOAT_SCALE = 1.0f / 32768.0f;  // Scale factor for converting int16 samples to float [-1.0, 1.0]
+constexpr float FLOAT_TO_INT16_SCALE = 32767.0f;         // Float samples are clamped to [-1.0, 1.0] before scaling
+
+// Sample type held by an AudioBuffer's ring. A microphone stores audio in the format the
+// device was opened with (the sample_format attribute), so a reader asking for that format
+// gets a straight copy. Everything else reads it as int16.
+enum class SampleFormat { INT16, INT32, FLOAT32 };
+
+constexpr size_t sample_bytes(SampleFormat format) noexcept {
+    return format == SampleFormat::INT16 ? sizeof(int16_t) : sizeof(int32_t);
+}
+
+inline PaSampleFormat pa_sample_format(SampleFormat format) noexcept {
+    switch (format) {
+        case SampleFormat::INT32:
+            return paInt32;
+        case SampleFormat::FLOAT32:
+            return paFloat32;
+        default:
+            return paInt16;
+    }
+}
+
+// Attribute spelling: "int16", "int32" or "float32"
+const char* sample_format_name(SampleFormat format) noexcept;
+// Throws std::invalid_argument for anything sample_format_name doesn't return
+SampleFormat parse_sample_format(const std::string& name);
+
+// Upper bound on a single blocking wait. Waiters re-check stop flags and stream swaps at
+// least this often even if nothing notifies them.
+constexpr std::chrono::milliseconds MAX_WAIT_SLICE{100};
+
+// Wakeup primitive the real-time audio callbacks can signal without blocking.
+// notify() is two atomic operations and only enters the kernel when a thread is actually
+// waiting. On Linux waiters sleep on a futex over generation_, so a notify that races with
+// a waiter's predicate check is never lost. Other platforms fall back to short sleeps.
+class Notifier {
+   public:
+    void notify() noexcept;
+
+    // Blocks until predicate() returns true or timeout elapses. Returns the last result of
+    // predicate(). Any state the predicate reads must be published before notify() is called.
+    template <typename Predicate>
+    bool wait_for(std::chrono::nanoseconds timeout, Predicate predicate) {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        waiters_.fetch_add(1);
+        bool satisfied = false;
+        while (true) {
+            // Read the generation before the predicate: a notify after this point changes
+            // it and makes wait_while_unchanged return immediately.
+            const uint32_t seen = generation_.load();
+            satisfied = predicate();
+            if (satisfied) {
+                break;
+            }
+            const auto remaining = deadline - std::chrono::steady_clock::now();
+            if (remaining <= std::chrono::nanoseconds::zero()) {
+                break;
+            }
+            wait_while_unchanged(seen, std::chrono::duration_cast<std::chrono::nanoseconds>(remaining));
+        }
+        waiters_.fetch_sub(1);
+        return satisfied;
+    }
+
+   private:
+    // Sleeps until generation_ != seen, a notify, or timeout (spurious wakeups allowed).
+    void wait_while_unchanged(uint32_t seen, std::chrono::nanoseconds timeout) noexcept;
+
+    std::atomic<uint32_t> generation_{0};
+    std::atomic<uint32_t> waiters_{0};
+};
+
+// Releases memory from calloc. A ring moved into shared memory is unmapped by its owner instead.
+struct FreeDeleter {
+    bool owned = true;
+    void operator()(void* memory) const noexcept {
+        if (owned) {
+            std::free(memory);
+        }
+    }
+};
+
+// A buffer's write cursor and stream clock, mirrored for readers in other processes (see
+// shared_ring.hpp). It lives in shared memory, so its members must be lock-free.
+struct SharedCursor {
+    // Mirrors of write_reserved and total_samples_written, validated the same way
+    std::atomic<uint64_t> write_reserved{0};
+    std::atomic<uint64_t> write_position{0};
+    // Unix time in ns of the stream's first sample, 0 until the first callback
+    std::atomic<int64_t> stream_start_ns{0};
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<int64_t>::is_always_lock_free,
+              "SharedCursor is read from other processes");
+
+// Base class for audio buffering - lock-free single-writer circular buffer
 // Can be used by both input (microphone) and output (speaker) models.
 // There is a 1:1 correspondence between AudioBuffer and viam audio resource
 class AudioBuffer {
    public:
-    AudioBuffer(const vsdk::audio_info& audio_info, int buffer_duration_seconds);
+    AudioBuffer(const vsdk::audio_info& audio_info, int buffer_duration_seconds, SampleFormat sample_format = SampleFormat::INT16);
     virtual ~AudioBuffer() = default;
 
     // Writes an audio sample to the audio buffer
     void write_sample(int16_t sample) noexcept;
 
-    // Read sample_count samples from the circular buffer starting at the inputted position
+    // Writes sample_count contiguous samples to the audio buffer and publishes the new
+    // write position once for the whole block. Only a single thread may write at a time
+    // (the PortAudio callback for input, the playback writer for output). A wider ring
+    // stores them widened.
+    void write_samples(const int16_t* samples, size_t sample_count) noexcept;
+
+    // write_samples for samples already in sample_format, copied as-is
+    void write_native(const void* samples, size_t sample_count) noexcept;
+
+    // write_native for a writer that knows the ring's sample type at compile time (the
+    // specialized capture callbacks): the copy is inlined with a fixed element size instead
+    // of going through the format switch. Sample must be the type sample_format stores.
+    template <typename Sample>
+    void write_frames(const Sample* samples, size_t sample_count) noexcept {
+        static_assert(std::is_trivially_copyable_v<Sample>, "ring samples are copied bytewise");
+        if (sample_count == 0) {
+            return;
+        }
+        const uint64_t pos = begin_write(sample_count);
+        const size_t skipped = sample_count > ring_size ? sample_count - ring_size : 0;
+        const size_t to_copy = sample_count - skipped;
+        const size_t start = static_cast<size_t>((pos + skipped) & ring_mask);
+        const size_t first_span = std::min(to_copy, ring_size - start);
+        Sample* const ring = reinterpret_cast<Sample*>(audio_buffer.get());
+        std::copy_n(samples + skipped, first_span, ring + start);
+        std::copy_n(samples + skipped + first_span, to_copy - first_span, ring);
+        end_write(pos + sample_count);
+    }
+
+    // Writes sample_count samples of silence, like write_samples. Used to carry the sample
+    // clock across a gap in the stream.
+    void write_silence(size_t sample_count) noexcept;
+
+    // Read sample_count samples from the circular buffer starting at the inputted position.
+    // A wider ring is narrowed to int16 on the way out.
     int read_samples(int16_t* buffer, int sample_count, uint64_t& position) noexcept;
 
+    // read_samples in sample_format: buffer receives sample_count * sample_bytes(sample_format)
+    // bytes copied straight from the ring
+    int read_native(void* buffer, int sample_count, uint64_t& position) noexcept;
+
     uint64_t get_write_position() const noexcept;
 
+    // Memory held by the ring
+    size_t memory_bytes() const noexcept {
+        return ring_size * sample_bytes(sample_format);
+    }
+
+    // Locks the ring in RAM when settings ask for it (the mlock attribute). This commits
+    // every page up front, giving up the lazy zeroing.
+    void lock_ring(const std::shared_ptr<realtime::RealtimeSettings>& settings) {
+        ring_lock.update(audio_buffer.get(), memory_bytes(), settings);
+    }
+
+    // Moves the ring into storage (at least memory_bytes(), zero-filled) and starts mirroring
+    // the write cursor into cursor, for readers in other processes. Both belong to the caller
+    // (a SharedRing), which keeps them mapped for the buffer's lifetime. Only call before
+    // anything is written; a ring that was locked has to be locked again with lock_ring.
+    void share(uint8_t* storage, SharedCursor* cursor) noexcept;
+
+    // Blocks until at least `position` samples have been written or timeout elapses.
+    // Returns true if the position was reached.
+    bool wait_for_write_position(uint64_t position, std::chrono::nanoseconds timeout);
+
     vsdk::audio_info info;
+    // What the ring stores; fixed for the buffer's lifetime
+    const SampleFormat sample_format;
+    // History window the buffer was sized for
+    int buffer_duration_seconds = 0;
+    // Number of samples of history readers may access (sample_rate * channels * seconds).
     int buffer_capacity;
+    // Physical ring size: buffer_capacity rounded up to a power of two, indexed with ring_mask.
+    size_t ring_size = 0;
+    uint64_t ring_mask = 0;
     std::atomic<uint64_t> total_samples_written;
-    std::unique_ptr<std::atomic<int16_t>[]> audio_buffer;
+    // End position of the block the writer is currently copying. Stored before the copy
+    // starts, so it runs ahead of total_samples_written while a write is in progress.
+    std::atomic<uint64_t> write_reserved{0};
+    // Plain storage, ring_size samples in sample_format; readers validate their copy against
+    // write_reserved instead of loading each sample atomically. From calloc, so a large ring
+    // comes straight from zero-filled pages that are only committed as audio is written.
+    std::unique_ptr<uint8_t[], FreeDeleter> audio_buffer;
+    // Declared after audio_buffer so the ring is unlocked before it's freed
+    realtime::LockedRegion ring_lock;
     // Updated by the audio callback on every invocation. Used by the main thread
     // to detect if the callback has stopped firing (e.g. due to USB errors).
     std::atomic<uint64_t> last_callback_time_ns{0};
+    // Callback and queue metrics. A resource points every context it creates at its own, so
+    // they survive a stream restart; a standalone buffer gets a private one.
+    std::shared_ptr<metrics::StreamMetrics> stats = std::make_shared<metrics::StreamMetrics>();
+    // Fine-grained callback durations, only with the callback_timing attribute (null otherwise).
+    // Set before the context is handed to PortAudio.
+    std::unique_ptr<metrics::CallbackTiming> callback_timing;
+    // Signalled after every write_samples() publish. Subclasses signal it for any other
+    // cursor they advance from the audio callback (e.g. playback_position).
+    Notifier notifier;
+    // Set by share(); null while the ring is private to this process
+    SharedCursor* shared_cursor = nullptr;
+
+   private:
+    // Announces that the sample_count slots after the write position are about to be
+    // overwritten, and returns that position. The release fence orders this store before the
+    // writer's plain stores, so a reader that observes any of the new data through its
+    // acquire fence also observes the reservation.
+    uint64_t begin_write(size_t sample_count) noexcept {
+        // Only the writer advances total_samples_written, so it can read its own cursor relaxed.
+        const uint64_t pos = total_samples_written.load(std::memory_order_relaxed);
+        write_reserved.store(pos + sample_count, std::memory_order_relaxed);
+        if (shared_cursor) {
+            shared_cursor->write_reserved.store(pos + sample_count, std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        return pos;
+    }
+
+    // Publishes everything up to end at once. Release pairs with the acquire load in
+    // read_samples/get_write_position so readers never see the cursor ahead of the data.
+    void end_write(uint64_t end) noexcept {
+        total_samples_written.store(end, std::memory_order_release);
+        if (shared_cursor) {
+            shared_cursor->write_position.store(end, std::memory_order_release);
+        }
+        notifier.notify();
+    }
+
+    // write_samples / write_native / write_silence; samples is in `format`, or null for silence
+    void write_block(const void* samples, size_t sample_count, SampleFormat format) noexcept;
+    // read_samples / read_native; buffer receives `format`
+    int read_block(void* buffer, int sample_count, uint64_t& position, SampleFormat format) noexcept;
+    // Copy (or zero) a span that does not wrap around the end of the ring, converting
+    // between `format` and sample_format when they differ.
+    void store_span(size_t index, const void* samples, size_t count, SampleFormat format) noexcept;
+    void zero_span(size_t index, size_t count) noexcept;
+    void load_span(size_t index, void* samples, size_t count, SampleFormat format) const noexcept;
 };
 
 }  // namespace audio
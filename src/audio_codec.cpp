@@ -5,12 +5,19 @@
 #include <sstream>
 #include <viam/sdk/components/audio_in.hpp>
 #include "audio_stream.hpp"
+#include "opus_encoder.hpp"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AUDIO_CODEC_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define AUDIO_CODEC_SSE2 1
+#endif
 
 namespace audio {
 namespace codec {
 
-constexpr float FLOAT_TO_INT16_SCALE = 32767.0f;
-
 namespace vsdk = ::viam::sdk;
 
 std::string toLower(std::string s) {
@@ -28,26 +35,278 @@ AudioCodec parse_codec(const std::string& codec_str) {
         return AudioCodec::MP3;
     } else if (codec == vsdk::audio_codecs::PCM_16) {
         return AudioCodec::PCM_16;
+    } else if (codec == OPUS_CODEC_NAME) {
+        return AudioCodec::OPUS;
     } else {
         std::ostringstream buffer;
-        buffer << "Unsupported codec: " << codec << ". Supported codecs: pcm16, pcm32, pcm32_float, mp3";
+        buffer << "Unsupported codec: " << codec << ". Supported codecs: pcm16, pcm32, pcm32_float, mp3, opus";
         VIAM_SDK_LOG(error) << buffer.str();
         throw std::invalid_argument(buffer.str());
     }
 }
 
+bool is_opus_sample_rate(int sample_rate) {
+    return sample_rate == 8000 || sample_rate == 12000 || sample_rate == 16000 || sample_rate == 24000 || sample_rate == 48000;
+}
+
+namespace {
+
+// Scalar kernels. These are the reference the vector paths must match bit for bit, and they
+// handle whatever tail is left after the vector loop.
+
+void pcm16_to_pcm32_scalar(const int16_t* in, int32_t* out, size_t count) {
+    // Convert int16 to int32 (left shift by 16 to preserve volume)
+    for (size_t i = 0; i < count; i++) {
+        out[i] = static_cast<int32_t>(in[i]) << 16;
+    }
+}
+
+void pcm16_to_float32_scalar(const int16_t* in, float* out, size_t count) {
+    // Convert int16 to float32 (normalize to range -1.0 to 1.0)
+    for (size_t i = 0; i < count; i++) {
+        out[i] = static_cast<float>(in[i]) * audio::INT16_TO_FLOAT_SCALE;
+    }
+}
+
+void pcm32_to_pcm16_scalar(const uint8_t* in, uint8_t* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        int32_t sample32;
+        memcpy(&sample32, in + i * 4, 4);
+
+        const int16_t sample16 = sample32 >> 16;
+        memcpy(out + i * 2, &sample16, 2);
+    }
+}
+
+void float32_to_pcm16_scalar(const uint8_t* in, uint8_t* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        float f;
+        memcpy(&f, in + i * 4, 4);
+
+        const float clamped = std::max(-1.0f, std::min(1.0f, f));
+        const int16_t s = static_cast<int16_t>(clamped * FLOAT_TO_INT16_SCALE);
+
+        memcpy(out + i * 2, &s, 2);
+    }
+}
+
+void interleave_stereo_scalar(const int16_t* left, const int16_t* right, int16_t* out, size_t frames) {
+    for (size_t i = 0; i < frames; i++) {
+        out[i * 2] = left[i];
+        out[i * 2 + 1] = right[i];
+    }
+}
+
+void downmix_stereo_scalar(const int16_t* in, int16_t* out, size_t frames) {
+    for (size_t i = 0; i < frames; i++) {
+        out[i] = static_cast<int16_t>((static_cast<int32_t>(in[i * 2]) + in[i * 2 + 1]) / 2);
+    }
+}
+
+// Vector kernels, selected at compile time from the baseline ISA of each target (NEON is
+// always present on ARM64 and SSE2 on x86-64), so no runtime dispatch is needed. Each
+// returns how many samples it converted; the caller finishes the rest with the scalar kernel.
+#if defined(AUDIO_CODEC_NEON)
+
+size_t pcm16_to_pcm32_simd(const int16_t* in, int32_t* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t v = vld1q_s16(in + i);
+        vst1q_s32(out + i, vshll_n_s16(vget_low_s16(v), 16));
+        vst1q_s32(out + i + 4, vshll_n_s16(vget_high_s16(v), 16));
+    }
+    return i;
+}
+
+size_t pcm16_to_float32_simd(const int16_t* in, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t v = vld1q_s16(in + i);
+        const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        const float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        vst1q_f32(out + i, vmulq_n_f32(lo, audio::INT16_TO_FLOAT_SCALE));
+        vst1q_f32(out + i + 4, vmulq_n_f32(hi, audio::INT16_TO_FLOAT_SCALE));
+    }
+    return i;
+}
+
+size_t pcm32_to_pcm16_simd(const uint8_t* in, uint8_t* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // Byte loads: the input comes straight off the wire and may be unaligned.
+        const int32x4_t lo = vreinterpretq_s32_u8(vld1q_u8(in + i * 4));
+        const int32x4_t hi = vreinterpretq_s32_u8(vld1q_u8(in + i * 4 + 16));
+        const int16x8_t packed = vcombine_s16(vshrn_n_s32(lo, 16), vshrn_n_s32(hi, 16));
+        vst1q_u8(out + i * 2, vreinterpretq_u8_s16(packed));
+    }
+    return i;
+}
+
+size_t float32_to_pcm16_simd(const uint8_t* in, uint8_t* out, size_t count) {
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t minus_one = vdupq_n_f32(-1.0f);
+    // Clamp with compare+select rather than vminq/vmaxq: those propagate NaN, while the scalar
+    // std::min(1.0f, NaN) yields 1.0f.
+    const auto clamp = [&](float32x4_t f) {
+        f = vbslq_f32(vcltq_f32(f, one), f, one);
+        return vbslq_f32(vcltq_f32(minus_one, f), f, minus_one);
+    };
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const float32x4_t lo = clamp(vreinterpretq_f32_u8(vld1q_u8(in + i * 4)));
+        const float32x4_t hi = clamp(vreinterpretq_f32_u8(vld1q_u8(in + i * 4 + 16)));
+        // vcvtq_s32_f32 truncates toward zero like static_cast
+        const int32x4_t lo_i = vcvtq_s32_f32(vmulq_n_f32(lo, FLOAT_TO_INT16_SCALE));
+        const int32x4_t hi_i = vcvtq_s32_f32(vmulq_n_f32(hi, FLOAT_TO_INT16_SCALE));
+        vst1q_u8(out + i * 2, vreinterpretq_u8_s16(vcombine_s16(vqmovn_s32(lo_i), vqmovn_s32(hi_i))));
+    }
+    return i;
+}
+
+size_t interleave_stereo_simd(const int16_t* left, const int16_t* right, int16_t* out, size_t frames) {
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        int16x8x2_t lr;
+        lr.val[0] = vld1q_s16(left + i);
+        lr.val[1] = vld1q_s16(right + i);
+        vst2q_s16(out + i * 2, lr);
+    }
+    return i;
+}
+
+size_t downmix_stereo_simd(const int16_t* in, int16_t* out, size_t frames) {
+    // Adding the sign bit before the shift makes it truncate toward zero like / 2
+    const auto halve = [](int32x4_t sum) {
+        const uint32x4_t bits = vreinterpretq_u32_s32(sum);
+        return vshrq_n_s32(vreinterpretq_s32_u32(vsraq_n_u32(bits, bits, 31)), 1);
+    };
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const int16x8x2_t lr = vld2q_s16(in + i * 2);
+        const int32x4_t lo = vaddl_s16(vget_low_s16(lr.val[0]), vget_low_s16(lr.val[1]));
+        const int32x4_t hi = vaddl_s16(vget_high_s16(lr.val[0]), vget_high_s16(lr.val[1]));
+        vst1q_s16(out + i, vcombine_s16(vmovn_s32(halve(lo)), vmovn_s32(halve(hi))));
+    }
+    return i;
+}
+
+#elif defined(AUDIO_CODEC_SSE2)
+
+size_t pcm16_to_pcm32_simd(const int16_t* in, int32_t* out, size_t count) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        // Interleaving zeros below each sample is exactly sample << 16.
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi16(zero, v));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), _mm_unpackhi_epi16(zero, v));
+    }
+    return i;
+}
+
+size_t pcm16_to_float32_simd(const int16_t* in, float* out, size_t count) {
+    const __m128 scale = _mm_set1_ps(audio::INT16_TO_FLOAT_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        // Sign-extend to int32: duplicate each sample into both halves, then shift down.
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    return i;
+}
+
+size_t pcm32_to_pcm16_simd(const uint8_t* in, uint8_t* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i lo = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 4)), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 4 + 16)), 16);
+        // Values already fit in int16 after the shift, so the saturating pack is exact.
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2), _mm_packs_epi32(lo, hi));
+    }
+    return i;
+}
+
+size_t float32_to_pcm16_simd(const uint8_t* in, uint8_t* out, size_t count) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minus_one = _mm_set1_ps(-1.0f);
+    const __m128 scale = _mm_set1_ps(FLOAT_TO_INT16_SCALE);
+    // _mm_min_ps(f, one) returns `one` when f is NaN, matching std::min(1.0f, f).
+    const auto clamp = [&](__m128 f) { return _mm_max_ps(_mm_min_ps(f, one), minus_one); };
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128 lo = clamp(_mm_loadu_ps(reinterpret_cast<const float*>(in + i * 4)));
+        const __m128 hi = clamp(_mm_loadu_ps(reinterpret_cast<const float*>(in + i * 4 + 16)));
+        // cvtt truncates toward zero like static_cast
+        const __m128i lo_i = _mm_cvttps_epi32(_mm_mul_ps(lo, scale));
+        const __m128i hi_i = _mm_cvttps_epi32(_mm_mul_ps(hi, scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2), _mm_packs_epi32(lo_i, hi_i));
+    }
+    return i;
+}
+
+size_t interleave_stereo_simd(const int16_t* left, const int16_t* right, int16_t* out, size_t frames) {
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i));
+        const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2), _mm_unpacklo_epi16(l, r));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2 + 8), _mm_unpackhi_epi16(l, r));
+    }
+    return i;
+}
+
+size_t downmix_stereo_simd(const int16_t* in, int16_t* out, size_t frames) {
+    // madd against all-ones sums each L,R pair into an int32; adding the sign bit before the
+    // shift makes it truncate toward zero like / 2
+    const __m128i ones = _mm_set1_epi16(1);
+    const auto halve = [](__m128i sum) { return _mm_srai_epi32(_mm_add_epi32(sum, _mm_srli_epi32(sum, 31)), 1); };
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const __m128i lo = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2)), ones);
+        const __m128i hi = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2 + 8)), ones);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(halve(lo), halve(hi)));
+    }
+    return i;
+}
+
+#else
+
+size_t pcm16_to_pcm32_simd(const int16_t*, int32_t*, size_t) {
+    return 0;
+}
+size_t pcm16_to_float32_simd(const int16_t*, float*, size_t) {
+    return 0;
+}
+size_t pcm32_to_pcm16_simd(const uint8_t*, uint8_t*, size_t) {
+    return 0;
+}
+size_t float32_to_pcm16_simd(const uint8_t*, uint8_t*, size_t) {
+    return 0;
+}
+size_t interleave_stereo_simd(const int16_t*, const int16_t*, int16_t*, size_t) {
+    return 0;
+}
+size_t downmix_stereo_simd(const int16_t*, int16_t*, size_t) {
+    return 0;
+}
+
+#endif
+
+}  // namespace
+
 void convert_pcm16_to_pcm32(const int16_t* samples, int sample_count, std::vector<uint8_t>& output) {
     if (samples == nullptr || sample_count <= 0) {
         output.clear();
         return;
     }
 
-    // Convert int16 to int32 (left shift by 16 to preserve volume)
     output.resize(sample_count * sizeof(int32_t));
     int32_t* out = reinterpret_cast<int32_t*>(output.data());
-    for (int i = 0; i < sample_count; i++) {
-        out[i] = static_cast<int32_t>(samples[i]) << 16;
-    }
+    const size_t done = pcm16_to_pcm32_simd(samples, out, sample_count);
+    pcm16_to_pcm32_scalar(samples + done, out + done, sample_count - done);
 }
 
 void convert_pcm16_to_float32(const int16_t* samples, int sample_count, std::vector<uint8_t>& output) {
@@ -56,12 +315,10 @@ void convert_pcm16_to_float32(const int16_t* samples, int sample_count, std::vec
         return;
     }
 
-    // Convert int16 to float32 (normalize to range -1.0 to 1.0)
     output.resize(sample_count * sizeof(float));
     float* out = reinterpret_cast<float*>(output.data());
-    for (int i = 0; i < sample_count; i++) {
-        out[i] = static_cast<float>(samples[i]) * audio::INT16_TO_FLOAT_SCALE;
-    }
+    const size_t done = pcm16_to_float32_simd(samples, out, sample_count);
+    pcm16_to_float32_scalar(samples + done, out + done, sample_count - done);
 }
 
 void copy_pcm16(const int16_t* samples, int sample_count, std::vector<uint8_t>& output) {
@@ -82,13 +339,8 @@ void convert_pcm32_to_pcm16(const uint8_t* input_data, const int byte_count, std
     const int sample_count = byte_count / 4;
     output.resize(sample_count * 2);
 
-    for (int i = 0; i < sample_count; i++) {
-        int32_t sample32;
-        memcpy(&sample32, input_data + i * 4, 4);
-
-        const int16_t sample16 = sample32 >> 16;
-        memcpy(output.data() + i * 2, &sample16, 2);
-    }
+    const size_t done = pcm32_to_pcm16_simd(input_data, output.data(), sample_count);
+    pcm32_to_pcm16_scalar(input_data + done * 4, output.data() + done * 2, sample_count - done);
 }
 
 void convert_float32_to_pcm16(const uint8_t* input_data, const int byte_count, std::vector<uint8_t>& output) {
@@ -99,22 +351,58 @@ void convert_float32_to_pcm16(const uint8_t* input_data, const int byte_count, s
     const int sample_count = byte_count / 4;
     output.resize(sample_count * 2);
 
-    for (int i = 0; i < sample_count; i++) {
-        float f;
-        memcpy(&f, input_data + i * 4, 4);
+    const size_t done = float32_to_pcm16_simd(input_data, output.data(), sample_count);
+    float32_to_pcm16_scalar(input_data + done * 4, output.data() + done * 2, sample_count - done);
+}
 
-        const float clamped = std::max(-1.0f, std::min(1.0f, f));
-        const int16_t s = static_cast<int16_t>(clamped * FLOAT_TO_INT16_SCALE);
+void interleave_stereo_pcm16(const int16_t* left, const int16_t* right, int16_t* output, size_t frames) {
+    const size_t done = interleave_stereo_simd(left, right, output, frames);
+    interleave_stereo_scalar(left + done, right + done, output + done * 2, frames - done);
+}
 
-        memcpy(output.data() + i * 2, &s, 2);
-    }
+void downmix_stereo_pcm16(const int16_t* input, int16_t* output, size_t frames) {
+    const size_t done = downmix_stereo_simd(input, output, frames);
+    downmix_stereo_scalar(input + done * 2, output + done, frames - done);
+}
+
+namespace scalar {
+
+void interleave_stereo_pcm16(const int16_t* left, const int16_t* right, int16_t* output, size_t frames) {
+    interleave_stereo_scalar(left, right, output, frames);
 }
 
+void downmix_stereo_pcm16(const int16_t* input, int16_t* output, size_t frames) {
+    downmix_stereo_scalar(input, output, frames);
+}
+
+void convert_pcm16_to_pcm32(const int16_t* samples, int sample_count, std::vector<uint8_t>& output) {
+    output.resize(std::max(sample_count, 0) * sizeof(int32_t));
+    pcm16_to_pcm32_scalar(samples, reinterpret_cast<int32_t*>(output.data()), std::max(sample_count, 0));
+}
+
+void convert_pcm16_to_float32(const int16_t* samples, int sample_count, std::vector<uint8_t>& output) {
+    output.resize(std::max(sample_count, 0) * sizeof(float));
+    pcm16_to_float32_scalar(samples, reinterpret_cast<float*>(output.data()), std::max(sample_count, 0));
+}
+
+void convert_pcm32_to_pcm16(const uint8_t* input_data, int byte_count, std::vector<uint8_t>& output) {
+    output.resize(byte_count / 4 * 2);
+    pcm32_to_pcm16_scalar(input_data, output.data(), byte_count / 4);
+}
+
+void convert_float32_to_pcm16(const uint8_t* input_data, int byte_count, std::vector<uint8_t>& output) {
+    output.resize(byte_count / 4 * 2);
+    float32_to_pcm16_scalar(input_data, output.data(), byte_count / 4);
+}
+
+}  // namespace scalar
+
 void encode_audio_chunk(AudioCodec codec,
                         int16_t* samples,
                         int sample_count,
                         uint64_t chunk_start_position,
                         microphone::MP3EncoderContext& mp3_ctx,
+                        microphone::OpusEncoderContext& opus_ctx,
                         std::vector<uint8_t>& output_data) {
     switch (codec) {
         case AudioCodec::PCM_16:
@@ -129,6 +417,9 @@ void encode_audio_chunk(AudioCodec codec,
         case AudioCodec::MP3:
             microphone::encode_samples_to_mp3(mp3_ctx, samples, sample_count, chunk_start_position, output_data);
             break;
+        case AudioCodec::OPUS:
+            microphone::encode_samples_to_opus(opus_ctx, samples, sample_count, output_data);
+            break;
         default:
             throw std::invalid_argument("Unsupported codec for encoding");
     }
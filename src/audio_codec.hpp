@@ -1,15 +1,31 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
 #include "mp3_encoder.hpp"
 
+namespace microphone {
+struct OpusEncoderContext;
+}
+
 namespace audio {
 namespace codec {
 
 // Audio codec types supported by the microphone
-enum class AudioCodec { PCM_16, PCM_32, PCM_32_FLOAT, MP3 };
+enum class AudioCodec { PCM_16, PCM_32, PCM_32_FLOAT, MP3, OPUS };
+
+// The SDK's audio_codecs has no constant for Opus
+constexpr char OPUS_CODEC_NAME[] = "opus";
+
+// Opus packets aren't self-delimiting, so on the wire each one is prefixed with its length
+// as a 16-bit little-endian integer. A stream is a plain concatenation of these, so chunks
+// can be split or joined anywhere, like MP3.
+constexpr size_t OPUS_LENGTH_PREFIX_BYTES = 2;
+
+// True for the rates libopus encodes and decodes at natively (8, 12, 16, 24 and 48 kHz)
+bool is_opus_sample_rate(int sample_rate);
 
 // Convert string to lowercase
 std::string toLower(std::string s);
@@ -30,8 +46,28 @@ void convert_pcm16_to_float32(const int16_t* samples, int sample_count, std::vec
 // Converts from int16_t array to uint8_t vector (2 bytes per sample)
 void copy_pcm16(const int16_t* samples, int sample_count, std::vector<uint8_t>& output);
 
+void convert_pcm32_to_pcm16(const uint8_t* input_data, int byte_count, std::vector<uint8_t>& output);
+// Float samples are clamped to [-1.0, 1.0] (NaN maps to 1.0) and truncated toward zero
+void convert_float32_to_pcm16(const uint8_t* input_data, int byte_count, std::vector<uint8_t>& output);
+
+// Interleaves separate left/right planes (as the MP3 decoder produces them) into L,R,L,R...
+// output must hold frames * 2 samples.
+void interleave_stereo_pcm16(const int16_t* left, const int16_t* right, int16_t* output, size_t frames);
+
+// Averages interleaved stereo frames to mono, (L + R) / 2 truncated toward zero.
+// output must hold frames samples.
+void downmix_stereo_pcm16(const int16_t* input, int16_t* output, size_t frames);
+
+// The conversions above use NEON (ARM64) or SSE2 (x86-64) kernels when the compiler targets
+// them. These are the plain per-sample loops they must match bit for bit, kept for tests.
+namespace scalar {
+void interleave_stereo_pcm16(const int16_t* left, const int16_t* right, int16_t* output, size_t frames);
+void downmix_stereo_pcm16(const int16_t* input, int16_t* output, size_t frames);
+void convert_pcm16_to_pcm32(const int16_t* samples, int sample_count, std::vector<uint8_t>& output);
+void convert_pcm16_to_float32(const int16_t* samples, int sample_count, std::vector<uint8_t>& output);
 void convert_pcm32_to_pcm16(const uint8_t* input_data, int byte_count, std::vector<uint8_t>& output);
 void convert_float32_to_pcm16(const uint8_t* input_data, int byte_count, std::vector<uint8_t>& output);
+}  // namespace scalar
 
 // WAV header utilities
 constexpr size_t wav_header_size = 44;
@@ -46,6 +82,7 @@ void encode_audio_chunk(AudioCodec codec,
                         int sample_count,
                         uint64_t chunk_start_position,
                         microphone::MP3EncoderContext& mp3_ctx,
+                        microphone::OpusEncoderContext& opus_ctx,
                         std::vector<uint8_t>& output_data);
 
 }  // namespace codec
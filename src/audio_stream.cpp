@@ -6,8 +6,12 @@
 
 namespace audio {
 
-InputStreamContext::InputStreamContext(const vsdk::audio_info& audio_info, int buffer_duration_seconds)
-    : AudioBuffer(audio_info, buffer_duration_seconds), stream_start_time(), first_sample_adc_time(0.0), first_callback_captured(false) {}
+InputStreamContext::InputStreamContext(const vsdk::audio_info& audio_info, int buffer_duration_seconds, SampleFormat sample_format)
+    : AudioBuffer(audio_info, buffer_duration_seconds, sample_format),
+      stream_start_time(),
+      first_sample_adc_time(0.0),
+      first_callback_captured(false),
+      levels(audio_info.num_channels, audio_info.sample_rate_hz) {}
 
 std::chrono::nanoseconds InputStreamContext::calculate_sample_timestamp(uint64_t sample_number) noexcept {
     // Convert sample_number to frame number (samples include all channels)
@@ -20,6 +24,28 @@ std::chrono::nanoseconds InputStreamContext::calculate_sample_timestamp(uint64_t
     return std::chrono::duration_cast<std::chrono::nanoseconds>(absolute_time.time_since_epoch());
 }
 
+void InputStreamContext::pad_to_clock(uint64_t block_frames) noexcept {
+    if (!first_callback_captured.load()) {
+        return;
+    }
+    const int64_t elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now() - stream_start_time).count();
+    if (elapsed_ns <= 0) {
+        return;
+    }
+    // Split into whole seconds so elapsed * rate can't overflow on a long-running stream
+    const uint64_t elapsed = static_cast<uint64_t>(elapsed_ns);
+    const uint64_t rate = static_cast<uint64_t>(info.sample_rate_hz);
+    const uint64_t elapsed_frames = (elapsed / NANOSECONDS_PER_SECOND) * rate + (elapsed % NANOSECONDS_PER_SECOND) * rate / NANOSECONDS_PER_SECOND;
+    if (elapsed_frames <= block_frames) {
+        return;
+    }
+    const uint64_t expected = (elapsed_frames - block_frames) * static_cast<uint64_t>(info.num_channels);
+    const uint64_t written = total_samples_written.load(std::memory_order_relaxed);
+    if (expected > written) {
+        write_silence(static_cast<size_t>(expected - written));
+    }
+}
+
 uint64_t InputStreamContext::get_sample_number_from_timestamp(int64_t timestamp) noexcept {
     auto stream_start_ns = std::chrono::time_point_cast<std::chrono::nanoseconds>(stream_start_time);
     const int64_t stream_start_timestamp_ns = stream_start_ns.time_since_epoch().count();
@@ -33,4 +59,20 @@ uint64_t InputStreamContext::get_sample_number_from_timestamp(int64_t timestamp)
 OutputStreamContext::OutputStreamContext(const vsdk::audio_info& audio_info, int buffer_duration_seconds)
     : AudioBuffer(audio_info, buffer_duration_seconds), playback_position(0) {}
 
+std::optional<std::chrono::nanoseconds> OutputStreamContext::time_until_played(uint64_t position) const noexcept {
+    const uint64_t callback_ns = last_callback_time_ns.load();
+    const int64_t delay_ns = output_delay_ns.load();
+    const uint64_t buffer_start = buffer_start_position.load();
+    if (callback_ns == 0 || delay_ns < 0) {
+        return std::nullopt;
+    }
+
+    // Frames between the start of the latest buffer and position; negative if position was in an earlier buffer
+    const double frames = (static_cast<double>(position) - static_cast<double>(buffer_start)) / info.num_channels;
+    const int64_t played_at_ns =
+        static_cast<int64_t>(callback_ns) + delay_ns + static_cast<int64_t>(frames * NANOSECONDS_PER_SECOND / info.sample_rate_hz);
+    const int64_t now_ns = std::chrono::steady_clock::now().time_since_epoch().count();
+    return std::chrono::nanoseconds(played_at_ns - now_ns);
+}
+
 }  // namespace audio
@@ -2,32 +2,51 @@
 
 #include <atomic>
 #include <chrono>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <vector>
 #include <viam/sdk/common/audio.hpp>
 #include <viam/sdk/components/audio_in.hpp>
 #include "audio_buffer.hpp"
+#include "gain.hpp"
+#include "level_meter.hpp"
 #include "portaudio.h"
+#include "shared_ring.hpp"
 
 namespace audio {
 
 namespace vsdk = ::viam::sdk;
 
 constexpr uint64_t NANOSECONDS_PER_SECOND = 1000000000ULL;
-constexpr float INT16_TO_FLOAT_SCALE = 1.0f / 32768.0f;  // Scale factor for converting int16 samples to float [-1.0, 1.0]
 
 // InputStreamContext manages a circular buffer of audio for microphone input
 // Extends AudioBuffer with timestamp tracking for accurate audio capture metadata
 class InputStreamContext : public AudioBuffer {
    public:
-    InputStreamContext(const vsdk::audio_info& audio_info, int buffer_duration_seconds = BUFFER_DURATION_SECONDS);
+    InputStreamContext(const vsdk::audio_info& audio_info,
+                       int buffer_duration_seconds = BUFFER_DURATION_SECONDS,
+                       SampleFormat sample_format = SampleFormat::INT16);
 
     std::chrono::system_clock::time_point stream_start_time;
     double first_sample_adc_time;
     std::atomic<bool> first_callback_captured;
     std::atomic<uint64_t> input_overflow_count{0};
     std::atomic<uint64_t> input_underflow_count{0};
+    // Set when a restarted stream keeps writing into this context. The next callback tops up
+    // the silence pad_to_clock wrote at restart, covering the new stream's start-up.
+    std::atomic<bool> resync_pending{false};
+    // Per-channel peak and RMS of what the callback captured, for the get_levels DoCommand
+    levels::LevelMeter levels;
+    // The ring's POSIX shared memory export (the shared_memory attribute), or null. Owned here
+    // because the ring lives inside it.
+    std::unique_ptr<shm::SharedRing> shared_ring;
     std::chrono::nanoseconds calculate_sample_timestamp(uint64_t sample_number) noexcept;
+    // Writes silence up to where the sample clock (stream_start_time) says a block of
+    // block_frames frames ending now should start, so positions keep mapping to the time
+    // they were captured across a gap in the stream. No-op before the first callback or if
+    // the buffer is already there. Only call from the writer.
+    void pad_to_clock(uint64_t block_frames) noexcept;
     uint64_t get_sample_number_from_timestamp(int64_t timestamp) noexcept;
 };
 
@@ -38,7 +57,25 @@ class OutputStreamContext : public AudioBuffer {
     std::atomic<uint64_t> playback_position;
     std::atomic<uint64_t> output_overflow_count{0};
     std::atomic<uint64_t> output_underflow_count{0};
+    // framesPerBuffer of the latest callback; the mixer keeps at least two of these queued
+    std::atomic<uint64_t> callback_frames{0};
+    // Software volume and mute, applied by the callback to everything it plays
+    gain::GainStage gain;
+    // Pre-roll: while the write position is below this, the reader plays silence and consumes
+    // nothing, so a stream starts (or resumes after running dry) with a cushion buffered.
+    // 0 when no pre-roll is pending.
+    std::atomic<uint64_t> preroll_until{0};
+    // Timing of the latest callback: the playback position its buffer started at, and how far
+    // ahead of the callback that buffer reaches the DAC (-1 when the host doesn't report it).
+    // Stored before last_callback_time_ns.
+    std::atomic<uint64_t> buffer_start_position{0};
+    std::atomic<int64_t> output_delay_ns{-1};
     OutputStreamContext(const vsdk::audio_info& audio_info, int buffer_duration_seconds = BUFFER_DURATION_SECONDS);
+
+    // How long from now until the sample at position is heard, from the latest callback's
+    // timing (accurate to about one callback buffer). Negative once it has played; nullopt
+    // before the first callback or when the host doesn't report output times.
+    std::optional<std::chrono::nanoseconds> time_until_played(uint64_t position) const noexcept;
 };
 
 }  // namespace audio
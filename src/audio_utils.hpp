@@ -1,12 +1,16 @@
 #pragma once
 
+#include <cmath>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <viam/sdk/components/audio_out.hpp>
 #include "audio_stream.hpp"
 #include "device_id.hpp"
 #include "portaudio.hpp"
+#include "realtime.hpp"
+#include "resample.hpp"
 
 namespace audio {
 namespace utils {
@@ -37,6 +41,17 @@ struct ConfigParams {
     std::optional<double> latency_ms;
     std::optional<int> historical_throttle_ms;
     std::optional<int> volume;
+    // Ring buffer history; falls back to the per-direction default
+    std::optional<int> buffer_seconds;
+    // Microphone-only: format the device is opened and buffered in
+    SampleFormat sample_format = SampleFormat::INT16;
+    // Fine-grained callback duration percentiles (callback_timing attribute)
+    bool callback_timing = false;
+    // realtime_priority / realtime_policy / cpu_affinity / mlock attributes
+    audio::realtime::RealtimeOptions realtime_options;
+    ResampleOptions resample_options;
+    // Speaker-only override for mixing source channels into the device's channels
+    std::optional<ChannelMatrix> channel_matrix;
 };
 
 // Configuration for opening a PortAudio stream
@@ -49,9 +64,16 @@ struct StreamParams {
     // viable latency instead, rounding up to the next practical value.
     // Use get_stream_latency() after opening the stream to retrieve the actual latency PortAudio selected.
     double suggested_latency_seconds;
+    // Format PortAudio delivers samples in; output streams are always int16
+    SampleFormat sample_format = SampleFormat::INT16;
     bool is_input;
     PaStreamCallback* callback;
     void* user_data;  // Points to AudioStreamContext* or PlaybackBuffer*
+    // Duplex input streams only: the output half opened on the same stream, always int16.
+    // paNoDevice for a plain input or output stream.
+    PaDeviceIndex output_device_index = paNoDevice;
+    int output_num_channels = 0;
+    double output_latency_seconds = 0;
 };
 
 // Helper function to find device by name
@@ -77,7 +99,9 @@ inline PaDeviceIndex findDeviceByName(const std::string& name, const audio::port
 
 // Helper function to find a device by the stable id reported by the
 // discovery resolver. Returns paNoDevice if no device on the system
-// currently resolves to the given id.
+// currently resolves to the given id. A RealDeviceIdResolver scans the
+// card ids on its first resolve, so the walk costs one directory pass
+// rather than one per device.
 inline PaDeviceIndex findDeviceById(const std::string& id,
                                     const audio::portaudio::PortAudioInterface& pa,
                                     const audio::device_id::DeviceIdResolver& resolver) {
@@ -100,6 +124,32 @@ inline PaDeviceIndex findDeviceById(const std::string& id,
     return paNoDevice;
 }
 
+// Whether the stream can be reopened on params.device_index as-is: true when device_id
+// isn't configured, or the device at that index still resolves to device_id (so the kernel
+// hasn't handed its card to another device). Resolves that one device instead of walking
+// them all.
+inline bool device_index_still_matches(const std::string& device_id,
+                                       const StreamParams& params,
+                                       const audio::portaudio::PortAudioInterface* pa,
+                                       const audio::device_id::DeviceIdResolver* resolver = nullptr) {
+    if (device_id.empty()) {
+        return true;
+    }
+    audio::portaudio::RealPortAudio real_pa;
+    const audio::portaudio::PortAudioInterface& audio_interface = pa ? *pa : real_pa;
+    const int device_count = audio_interface.getDeviceCount();
+    if (params.device_index < 0 || params.device_index >= device_count) {
+        return false;
+    }
+    const PaDeviceInfo* const info = audio_interface.getDeviceInfo(params.device_index);
+    if (!info) {
+        return false;
+    }
+    audio::device_id::RealDeviceIdResolver real_resolver;
+    const audio::device_id::DeviceIdResolver& resolver_ref = resolver ? *resolver : real_resolver;
+    return resolver_ref.resolve(params.device_index, *info) == device_id;
+}
+
 // If `device_id` is non-empty, re-resolves it against the current PortAudio device state
 // and updates `params.device_index` / `params.device_name` in-place if the device has
 // moved (e.g. USB unplug/replug → kernel re-enumerated).
@@ -141,6 +191,118 @@ inline bool resolve_device_id_into_params(const std::string& device_id,
     return true;
 }
 
+// Validates the resample_quality / resample_low_latency attributes shared by the microphone
+// and speaker. Throws std::invalid_argument on a bad type or unknown quality name.
+inline void validate_resample_attributes(const viam::sdk::ProtoStruct& attrs) {
+    if (attrs.count("resample_quality")) {
+        if (!attrs.at("resample_quality").is_a<std::string>()) {
+            VIAM_SDK_LOG(error) << "[validate] resample_quality attribute must be a string";
+            throw std::invalid_argument("resample_quality attribute must be a string");
+        }
+        try {
+            parse_resample_quality(*attrs.at("resample_quality").get<std::string>());
+        } catch (const std::invalid_argument& e) {
+            VIAM_SDK_LOG(error) << "[validate] " << e.what();
+            throw;
+        }
+    }
+
+    if (attrs.count("resample_low_latency")) {
+        if (!attrs.at("resample_low_latency").is_a<bool>()) {
+            VIAM_SDK_LOG(error) << "[validate] resample_low_latency attribute must be a boolean";
+            throw std::invalid_argument("resample_low_latency attribute must be a boolean");
+        }
+    }
+}
+
+inline void validate_buffer_seconds(const viam::sdk::ProtoStruct& attrs) {
+    if (!attrs.count("buffer_seconds")) {
+        return;
+    }
+    if (!attrs.at("buffer_seconds").is_a<double>()) {
+        VIAM_SDK_LOG(error) << "[validate] buffer_seconds attribute must be a number";
+        throw std::invalid_argument("buffer_seconds attribute must be a number");
+    }
+    const double seconds = *attrs.at("buffer_seconds").get<double>();
+    if (seconds < MIN_BUFFER_SECONDS || seconds > MAX_BUFFER_SECONDS || seconds != std::floor(seconds)) {
+        std::ostringstream buffer;
+        buffer << "buffer_seconds must be a whole number between " << MIN_BUFFER_SECONDS << " and " << MAX_BUFFER_SECONDS
+               << ", got: " << seconds;
+        VIAM_SDK_LOG(error) << "[validate] " << buffer.str();
+        throw std::invalid_argument(buffer.str());
+    }
+}
+
+inline void validate_sample_format(const viam::sdk::ProtoStruct& attrs) {
+    if (!attrs.count("sample_format")) {
+        return;
+    }
+    const auto* name = attrs.at("sample_format").get<std::string>();
+    if (!name) {
+        VIAM_SDK_LOG(error) << "[validate] sample_format attribute must be a string";
+        throw std::invalid_argument("sample_format attribute must be a string");
+    }
+    try {
+        parse_sample_format(*name);
+    } catch (const std::invalid_argument& e) {
+        VIAM_SDK_LOG(error) << "[validate] " << e.what();
+        throw;
+    }
+}
+
+// Validates the callback_timing attribute shared by the microphone and speaker
+inline void validate_callback_timing(const viam::sdk::ProtoStruct& attrs) {
+    if (attrs.count("callback_timing") && !attrs.at("callback_timing").is_a<bool>()) {
+        VIAM_SDK_LOG(error) << "[validate] callback_timing attribute must be a boolean";
+        throw std::invalid_argument("callback_timing attribute must be a boolean");
+    }
+}
+
+// Reports a ring's size in the shape returned by the get_buffer_settings DoCommand
+inline viam::sdk::ProtoStruct buffer_settings_struct(const AudioBuffer& buffer) {
+    return viam::sdk::ProtoStruct{{"buffer_seconds", static_cast<double>(buffer.buffer_duration_seconds)},
+                                  {"buffer_samples", static_cast<double>(buffer.buffer_capacity)},
+                                  {"buffer_bytes", static_cast<double>(buffer.memory_bytes())},
+                                  {"sample_format", std::string(sample_format_name(buffer.sample_format))}};
+}
+
+// Parses a channel_matrix attribute: a list with one row per output channel, each row a list
+// of per-input-channel gains, e.g. [[0.5, 0.5, 0, 0], [0, 0, 0.5, 0.5]] for 4 in → 2 out.
+// Throws std::invalid_argument if it isn't a non-empty list of equal-length lists of numbers.
+inline ChannelMatrix parse_channel_matrix(const viam::sdk::ProtoValue& value) {
+    const auto* rows = value.get<viam::sdk::ProtoList>();
+    if (!rows || rows->empty()) {
+        throw std::invalid_argument("channel_matrix must be a non-empty list of rows, one per output channel");
+    }
+    ChannelMatrix matrix;
+    matrix.output_channels = static_cast<int>(rows->size());
+    for (const auto& row_value : *rows) {
+        const auto* row = row_value.get<viam::sdk::ProtoList>();
+        if (!row || row->empty()) {
+            throw std::invalid_argument("channel_matrix rows must be non-empty lists of gains, one per input channel");
+        }
+        if (matrix.input_channels == 0) {
+            matrix.input_channels = static_cast<int>(row->size());
+        } else if (static_cast<int>(row->size()) != matrix.input_channels) {
+            throw std::invalid_argument("channel_matrix rows must all have the same length");
+        }
+        for (const auto& gain : *row) {
+            if (!gain.is_a<double>()) {
+                throw std::invalid_argument("channel_matrix gains must be numbers");
+            }
+            matrix.gains.push_back(static_cast<float>(*gain.get<double>()));
+        }
+    }
+    return matrix;
+}
+
+// Reports the resampler profile in the shape returned by the get_resample_settings DoCommand
+inline viam::sdk::ProtoStruct resample_settings_struct(const ResampleOptions& options) {
+    return viam::sdk::ProtoStruct{{"resample_quality", resample_quality_name(options.quality)},
+                                  {"resample_low_latency", options.low_latency},
+                                  {"soxr_recipe", soxr_recipe_name(options)}};
+}
+
 inline ConfigParams parseConfigAttributes(const viam::sdk::ResourceConfig& cfg) {
     const auto attrs = cfg.attributes();
     ConfigParams params;
@@ -173,6 +335,32 @@ inline ConfigParams parseConfigAttributes(const viam::sdk::ResourceConfig& cfg)
         params.volume = static_cast<int>(*attrs.at("volume").get<double>());
     }
 
+    if (attrs.count("buffer_seconds")) {
+        params.buffer_seconds = static_cast<int>(*attrs.at("buffer_seconds").get<double>());
+    }
+
+    if (attrs.count("callback_timing")) {
+        params.callback_timing = *attrs.at("callback_timing").get<bool>();
+    }
+
+    if (attrs.count("sample_format")) {
+        params.sample_format = parse_sample_format(*attrs.at("sample_format").get<std::string>());
+    }
+
+    params.realtime_options = audio::realtime::parse_realtime_options(attrs);
+
+    if (attrs.count("resample_quality")) {
+        params.resample_options.quality = parse_resample_quality(*attrs.at("resample_quality").get<std::string>());
+    }
+
+    if (attrs.count("resample_low_latency")) {
+        params.resample_options.low_latency = *attrs.at("resample_low_latency").get<bool>();
+    }
+
+    if (attrs.count("channel_matrix")) {
+        params.channel_matrix = parse_channel_matrix(attrs.at("channel_matrix"));
+    }
+
     VIAM_SDK_LOG(debug) << "[parseConfigAttributes] sucessfully parsed config attributes";
 
     return params;
@@ -251,6 +439,7 @@ inline StreamParams setupStreamFromConfig(const ConfigParams& params,
 
     stream_params.device_index = device_index;
     stream_params.device_name = deviceInfo->name;
+    stream_params.sample_format = direction == StreamDirection::Input ? params.sample_format : SampleFormat::INT16;
 
     stream_params.num_channels = params.num_channels.value_or(1);
 
@@ -259,12 +448,12 @@ inline StreamParams setupStreamFromConfig(const ConfigParams& params,
     // For output streams: always respect the configured rate if provided.
     if (direction == StreamDirection::Input && params.sample_rate.has_value()) {
         // PortAudio has no API to check sample rate support in isolation, so we use
-        // Pa_IsFormatSupported with otherwise valid params (known-good format, channels,
+        // Pa_IsFormatSupported with otherwise valid params (the configured format, channels,
         // and default latency) to isolate the sample rate as the only variable.
         PaStreamParameters test_params;
         test_params.device = device_index;
         test_params.channelCount = stream_params.num_channels;
-        test_params.sampleFormat = paInt16;
+        test_params.sampleFormat = pa_sample_format(stream_params.sample_format);
         test_params.suggestedLatency = deviceInfo->defaultLowInputLatency;
         test_params.hostApiSpecificStreamInfo = nullptr;
         if (audio_interface.isFormatSupported(&test_params, nullptr, params.sample_rate.value()) == paNoError) {
@@ -318,7 +507,7 @@ inline void openStream(PaStream*& stream, const StreamParams& params, const audi
     PaStreamParameters stream_params;
     stream_params.device = params.device_index;
     stream_params.channelCount = params.num_channels;
-    stream_params.sampleFormat = paInt16;
+    stream_params.sampleFormat = pa_sample_format(params.sample_format);
     stream_params.suggestedLatency = params.suggested_latency_seconds;
     stream_params.hostApiSpecificStreamInfo = nullptr;
 
@@ -326,14 +515,29 @@ inline void openStream(PaStream*& stream, const StreamParams& params, const audi
     const PaStreamParameters* inputParams = params.is_input ? &stream_params : nullptr;
     const PaStreamParameters* outputParams = params.is_input ? nullptr : &stream_params;
 
+    // A duplex stream also plays on output_device_index, from the same callback and clock
+    PaStreamParameters duplex_output_params;
+    if (params.is_input && params.output_device_index != paNoDevice) {
+        duplex_output_params.device = params.output_device_index;
+        duplex_output_params.channelCount = params.output_num_channels;
+        duplex_output_params.sampleFormat = paInt16;
+        duplex_output_params.suggestedLatency = params.output_latency_seconds;
+        duplex_output_params.hostApiSpecificStreamInfo = nullptr;
+        outputParams = &duplex_output_params;
+    }
+
     PaError err = audio_interface.isFormatSupported(inputParams, outputParams, params.sample_rate);
     if (err != paNoError) {
         std::ostringstream buffer;
         buffer << "Could not open stream — PortAudio: " << Pa_GetErrorText(err) << " — device '" << params.device_name << "' (index "
                << params.device_index << "). "
                << "Requested: sample_rate=" << params.sample_rate << "Hz, "
-               << "channels=" << params.num_channels << ", format=16-bit PCM, "
+               << "channels=" << params.num_channels << ", format=" << sample_format_name(params.sample_format) << ", "
                << "latency=" << params.suggested_latency_seconds << "s";
+        if (outputParams == &duplex_output_params) {
+            buffer << ", duplex output device index " << params.output_device_index << " with " << params.output_num_channels
+                   << " channels";
+        }
         VIAM_SDK_LOG(error) << buffer.str();
         throw std::runtime_error(buffer.str());
     }
@@ -341,6 +545,10 @@ inline void openStream(PaStream*& stream, const StreamParams& params, const audi
     VIAM_SDK_LOG(info) << "Opening stream for device '" << params.device_name << "' (index " << params.device_index << ")"
                        << " with sample rate " << params.sample_rate << " channels: " << params.num_channels << " and latency "
                        << stream_params.suggestedLatency << " seconds";
+    if (outputParams == &duplex_output_params) {
+        VIAM_SDK_LOG(info) << "Stream is duplex: also playing on device index " << params.output_device_index << " with "
+                           << params.output_num_channels << " channels";
+    }
 
     err = audio_interface.openStream(&stream,
                                      inputParams,
@@ -458,30 +666,52 @@ inline void restart_stream(PaStream*& stream, StreamParams& params, const audio:
     }
 }
 
+// Picks the stream callback for a layout, e.g. microphone::select_audio_callback
+using CallbackSelector = PaStreamCallback* (*)(int num_channels, SampleFormat sample_format);
+
 // Result of audio device setup - contains everything needed for initialization
 template <typename ContextType>
 struct AudioDeviceSetup {
     ConfigParams config_params;
     StreamParams stream_params;
     std::shared_ptr<ContextType> audio_context;
+    // The resource's real-time options and their outcome; the context's ring is already locked
+    std::shared_ptr<audio::realtime::RealtimeSettings> realtime;
 };
 
 // Helper function to setup an audio device (microphone or speaker)
-// Handles common initialization: config parsing, stream setup, context creation
+// Handles common initialization: config parsing, stream setup, context creation.
+// The context holds buffer_seconds of audio when configured, default_buffer_seconds otherwise.
+// select_callback picks the callback once the stream's channel count and format are known;
+// restarts reuse it from stream_params. The context's frames carry extra_channels more
+// channels than the stream opens (a duplex microphone's reference channel).
 template <typename ContextType>
 inline AudioDeviceSetup<ContextType> setup_audio_device(const viam::sdk::ResourceConfig& cfg,
                                                         StreamDirection direction,
-                                                        PaStreamCallback* callback,
+                                                        CallbackSelector select_callback,
                                                         const audio::portaudio::PortAudioInterface* pa,
-                                                        int buffer_duration_seconds = audio::BUFFER_DURATION_SECONDS) {
+                                                        int default_buffer_seconds = audio::BUFFER_DURATION_SECONDS,
+                                                        int extra_channels = 0) {
     AudioDeviceSetup<ContextType> setup;
 
     setup.config_params = parseConfigAttributes(cfg);
 
-    setup.stream_params = setupStreamFromConfig(setup.config_params, direction, callback, pa);
+    setup.stream_params = setupStreamFromConfig(setup.config_params, direction, nullptr, pa);
+    setup.stream_params.callback = select_callback(setup.stream_params.num_channels, setup.stream_params.sample_format);
 
-    viam::sdk::audio_info info{viam::sdk::audio_codecs::PCM_16, setup.stream_params.sample_rate, setup.stream_params.num_channels};
-    setup.audio_context = std::make_shared<ContextType>(info, buffer_duration_seconds);
+    viam::sdk::audio_info info{
+        viam::sdk::audio_codecs::PCM_16, setup.stream_params.sample_rate, setup.stream_params.num_channels + extra_channels};
+    const int buffer_seconds = setup.config_params.buffer_seconds.value_or(default_buffer_seconds);
+    if constexpr (std::is_same_v<ContextType, InputStreamContext>) {
+        setup.audio_context = std::make_shared<ContextType>(info, buffer_seconds, setup.stream_params.sample_format);
+    } else {
+        setup.audio_context = std::make_shared<ContextType>(info, buffer_seconds);
+    }
+    if (setup.config_params.callback_timing) {
+        setup.audio_context->callback_timing = std::make_unique<audio::metrics::CallbackTiming>();
+    }
+    setup.realtime = std::make_shared<audio::realtime::RealtimeSettings>(setup.config_params.realtime_options);
+    setup.audio_context->lock_ring(setup.realtime);
 
     // Set user_data to point to the audio context
     setup.stream_params.user_data = setup.audio_context.get();
@@ -494,17 +724,20 @@ constexpr uint64_t STALENESS_LOG_THROTTLE_NS = 1'000'000'000ULL;  // Log at most
 
 // Logs a warning if the audio callback hasn't fired recently, indicating the stream may have stalled.
 // last_log_ns tracks the last time the warning was emitted to throttle repeated logs — initialize to 0.
-// Should be called from the main thread (not the audio callback).
-inline void log_callback_staleness(const std::atomic<uint64_t>& last_callback_time_ns,
-                                   const std::string& context,
-                                   PaStream* stream,
-                                   uint64_t& last_log_ns) {
+// Should be called from the main thread (not the audio callback). current_stream() returns the
+// stream to report on and is only called when a warning is due, so it may take a lock.
+template <typename StreamFn>
+void log_callback_staleness(const std::atomic<uint64_t>& last_callback_time_ns,
+                            const char* context,
+                            StreamFn&& current_stream,
+                            uint64_t& last_log_ns) {
     const uint64_t last_cb = last_callback_time_ns.load();
     if (last_cb > 0) {
         const uint64_t now_ns = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
         const uint64_t elapsed_ms = (now_ns - last_cb) / audio::NS_PER_MS;
         if (elapsed_ms > STREAM_RESTART_THRESHOLD_MS && now_ns - last_log_ns > STALENESS_LOG_THROTTLE_NS) {
             last_log_ns = now_ns;
+            PaStream* const stream = current_stream();
             if (!stream) {
                 VIAM_SDK_LOG(error) << context << " log_callback_staleness called with null stream";
                 return;
@@ -0,0 +1,89 @@
+#include "clip_cache.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <viam/sdk/common/utils.hpp>
+
+namespace audio {
+namespace clips {
+
+void ClipCache::put(const std::string& id, std::shared_ptr<const Clip> clip) {
+    const size_t clip_bytes = clip->bytes();
+    if (clip_bytes > max_bytes_) {
+        std::ostringstream buffer;
+        buffer << "clip " << id << " needs " << clip_bytes << " bytes but the clip cache holds " << max_bytes_
+               << "; raise clip_cache_mb or use a shorter clip";
+        VIAM_SDK_LOG(error) << buffer.str();
+        throw std::invalid_argument(buffer.str());
+    }
+
+    std::lock_guard<std::mutex> lock(mu_);
+    const auto existing = index_.find(id);
+    if (existing != index_.end()) {
+        bytes_ -= existing->second->clip->bytes();
+        lru_.erase(existing->second);
+    }
+    lru_.push_front(Entry{id, std::move(clip)});
+    index_[id] = lru_.begin();
+    bytes_ += clip_bytes;
+    evict_to_fit();
+}
+
+bool ClipCache::replace(const std::string& id, const std::shared_ptr<const Clip>& previous, std::shared_ptr<const Clip> clip) {
+    std::lock_guard<std::mutex> lock(mu_);
+    const auto existing = index_.find(id);
+    if (existing == index_.end() || existing->second->clip != previous) {
+        return false;
+    }
+    bytes_ = bytes_ - previous->bytes() + clip->bytes();
+    existing->second->clip = std::move(clip);
+    lru_.splice(lru_.begin(), lru_, existing->second);
+    evict_to_fit();
+    return true;
+}
+
+std::shared_ptr<const Clip> ClipCache::get(const std::string& id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    const auto found = index_.find(id);
+    if (found == index_.end()) {
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, found->second);
+    return found->second->clip;
+}
+
+bool ClipCache::erase(const std::string& id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    const auto found = index_.find(id);
+    if (found == index_.end()) {
+        return false;
+    }
+    bytes_ -= found->second->clip->bytes();
+    lru_.erase(found->second);
+    index_.erase(found);
+    return true;
+}
+
+std::vector<ClipCache::Entry> ClipCache::entries() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return {lru_.begin(), lru_.end()};
+}
+
+size_t ClipCache::bytes() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return bytes_;
+}
+
+void ClipCache::evict_to_fit() {
+    // The newest clip is at the front and fits on its own, so this never evicts it
+    while (bytes_ > max_bytes_ && lru_.size() > 1) {
+        const Entry& oldest = lru_.back();
+        VIAM_SDK_LOG(info) << "[ClipCache] Evicting clip " << oldest.id << " (" << oldest.clip->bytes() << " bytes)";
+        bytes_ -= oldest.clip->bytes();
+        index_.erase(oldest.id);
+        lru_.pop_back();
+    }
+}
+
+}  // namespace clips
+}  // namespace audio
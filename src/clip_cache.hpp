@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "audio_codec.hpp"
+
+namespace audio {
+namespace clips {
+
+// Default and largest clip_cache_mb
+constexpr int DEFAULT_CACHE_MB = 16;
+constexpr int MAX_CACHE_MB = 1024;
+
+// A clip as it was preloaded: encoded audio with any WAV header stripped, and its format.
+// For MP3 and Opus the format comes from the stream and the fields here are 0.
+struct ClipSource {
+    std::vector<uint8_t> data;
+    codec::AudioCodec codec = codec::AudioCodec::PCM_16;
+    int sample_rate = 0;
+    int num_channels = 0;
+};
+
+// A preloaded clip converted to the speaker's format, ready to be written straight into the
+// stream buffer. Immutable once cached; a clip for another format is a new Clip sharing the
+// same source.
+struct Clip {
+    std::shared_ptr<const ClipSource> source;
+    // Interleaved PCM16 at sample_rate / num_channels
+    std::vector<int16_t> samples;
+    int sample_rate = 0;
+    int num_channels = 0;
+
+    // Memory charged against the cache: the converted samples plus the source kept to
+    // convert them again
+    size_t bytes() const noexcept {
+        return samples.size() * sizeof(int16_t) + (source ? source->data.size() : 0);
+    }
+
+    int duration_ms() const noexcept {
+        const uint64_t frame_rate = static_cast<uint64_t>(sample_rate) * num_channels;
+        return frame_rate == 0 ? 0 : static_cast<int>(samples.size() * 1000 / frame_rate);
+    }
+};
+
+// Preloaded clips by id, least recently used first out once the total passes max_bytes.
+// Thread-safe; a clip handed out stays valid after it's evicted or replaced.
+class ClipCache {
+   public:
+    explicit ClipCache(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+    // Stores clip under id, replacing any clip already there, and evicts the least recently
+    // used others until the cache fits. Throws std::invalid_argument if the clip alone is
+    // larger than max_bytes.
+    void put(const std::string& id, std::shared_ptr<const Clip> clip);
+
+    // Replaces the clip under id with clip, but only while it's still previous: a clip
+    // converted for a new format loses to a preload that landed meanwhile. Returns whether it
+    // was stored.
+    bool replace(const std::string& id, const std::shared_ptr<const Clip>& previous, std::shared_ptr<const Clip> clip);
+
+    // The clip under id, marked most recently used, or null
+    std::shared_ptr<const Clip> get(const std::string& id);
+
+    // Returns false if there was no clip under id
+    bool erase(const std::string& id);
+
+    struct Entry {
+        std::string id;
+        std::shared_ptr<const Clip> clip;
+    };
+    // Every clip, most recently used first
+    std::vector<Entry> entries() const;
+
+    size_t bytes() const;
+    size_t max_bytes() const noexcept {
+        return max_bytes_;
+    }
+
+   private:
+    // Caller holds mu_
+    void evict_to_fit();
+
+    const size_t max_bytes_;
+    mutable std::mutex mu_;
+    // Most recently used at the front
+    std::list<Entry> lru_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    size_t bytes_ = 0;
+};
+
+}  // namespace clips
+}  // namespace audio
@@ -115,6 +115,7 @@ std::string RealDeviceIdResolver::resolve(PaDeviceIndex /*index*/, const PaDevic
 
 #include <dirent.h>
 #include <unistd.h>
+#include <algorithm>
 #include <cctype>
 #include <climits>
 #include <string_view>
@@ -131,9 +132,9 @@ std::string basename_of(const std::string& path) {
     return pos == std::string::npos ? path : path.substr(pos + 1);
 }
 
-// True if a sound device node basename (e.g. "controlC1", "pcmC1D0p")
-// belongs to the given ALSA card number.
-bool node_belongs_to_card(const std::string& node, const std::string& card_num) {
+// Card number of a sound device node basename (e.g. "controlC1", "pcmC1D0p"), or -1
+// for anything else ("timer", "seq", ...).
+int card_of_node(const std::string& node) {
     constexpr std::string_view kControlPrefix = "controlC";
     constexpr std::string_view kPcmPrefix = "pcmC";
 
@@ -143,24 +144,23 @@ bool node_belongs_to_card(const std::string& node, const std::string& card_num)
     } else if (node.compare(0, kPcmPrefix.size(), kPcmPrefix) == 0) {
         i = kPcmPrefix.size();
     } else {
-        return false;
+        return -1;
+    }
+    int card = -1;
+    for (; i < node.size() && std::isdigit(static_cast<unsigned char>(node[i])); i++) {
+        card = (card < 0 ? 0 : card * 10) + (node[i] - '0');
     }
-    return node.compare(i, card_num.size(), card_num) == 0 &&
-           (i + card_num.size() == node.size() || !std::isdigit(static_cast<unsigned char>(node[i + card_num.size()])));
+    return card;
 }
 
-// Scans a udev-maintained directory (/dev/snd/by-id or /dev/snd/by-path)
-// for a symlink pointing at a sound node belonging to the given card, and
-// returns the symlink's basename. These names are stable across reboots;
-// by-id names are also stable across USB port moves (descriptor-based),
-// by-path names are not (topology-based). Returns empty when the directory
-// doesn't exist or no entry matches.
-std::string find_udev_link(const std::string& dir, const std::string& card_num) {
+// Adds "<prefix><symlink name>" for every card that a symlink in a udev-maintained
+// directory (/dev/snd/by-id or /dev/snd/by-path) points into, unless the card already has
+// an id. Like the per-card search this replaces, the first matching entry wins.
+void add_udev_links(CardIdMap& ids, const std::string& dir, const std::string& prefix) {
     DIR* d = ::opendir(dir.c_str());
     if (!d) {
-        return "";
+        return;
     }
-    std::string result;
     while (auto* entry = ::readdir(d)) {
         if (entry->d_name[0] == '.') {
             continue;
@@ -172,17 +172,58 @@ std::string find_udev_link(const std::string& dir, const std::string& card_num)
             continue;
         }
         buf[n] = '\0';
-        if (node_belongs_to_card(basename_of(buf), card_num)) {
-            result = entry->d_name;
-            break;
+        const int card = card_of_node(basename_of(buf));
+        if (card >= 0) {
+            ids.emplace(card, prefix + entry->d_name);
+        }
+    }
+    ::closedir(d);
+}
+
+// Adds "alsa-card:<kernel id>" for every card under sys_sound that doesn't have an id yet
+void add_kernel_ids(CardIdMap& ids, const std::string& sys_sound) {
+    DIR* d = ::opendir(sys_sound.c_str());
+    if (!d) {
+        return;
+    }
+    constexpr std::string_view kCardPrefix = "card";
+    while (auto* entry = ::readdir(d)) {
+        const std::string name = entry->d_name;
+        if (name.compare(0, kCardPrefix.size(), kCardPrefix) != 0 || name.size() == kCardPrefix.size() ||
+            !std::all_of(name.begin() + kCardPrefix.size(), name.end(), [](unsigned char c) { return std::isdigit(c); })) {
+            continue;
+        }
+        const int card = std::stoi(name.substr(kCardPrefix.size()));
+        if (ids.count(card)) {
+            continue;
+        }
+        const std::string kernel_id = audio::utils::read_file(sys_sound + "/" + name + "/id");
+        if (!kernel_id.empty()) {
+            ids.emplace(card, "alsa-card:" + kernel_id);
         }
     }
     ::closedir(d);
-    return result;
 }
 
 }  // namespace
 
+CardIdMap scan_card_ids(const std::string& dev_snd, const std::string& sys_sound) {
+    CardIdMap ids;
+    // Prefer udev's descriptor-based symlink — stable across reboots and
+    // USB port changes, and disambiguates identical devices when they
+    // advertise serials.
+    add_udev_links(ids, dev_snd + "/by-id", "by-id:");
+    // Fall back to the topology-based symlink — stable across reboots but
+    // breaks if the device is moved to a different USB port. Still tells
+    // two identical devices apart as long as neither is replugged.
+    add_udev_links(ids, dev_snd + "/by-path", "by-path:");
+    // Final fallback for systems whose udev rules don't populate the above
+    // (minimal containers, some embedded distros). The kernel-assigned
+    // card id is driver-derived and stable on the same hardware topology.
+    add_kernel_ids(ids, sys_sound);
+    return ids;
+}
+
 std::string RealDeviceIdResolver::resolve(PaDeviceIndex /*index*/, const PaDeviceInfo& info) const {
     if (!info.name) {
         return "";
@@ -196,28 +237,14 @@ std::string RealDeviceIdResolver::resolve(PaDeviceIndex /*index*/, const PaDevic
     if (!hw) {
         return "";
     }
-    const std::string card_num = std::to_string(hw->card_num);
-
-    // Prefer udev's descriptor-based symlink — stable across reboots and
-    // USB port changes, and disambiguates identical devices when they
-    // advertise serials.
-    if (auto id = find_udev_link("/dev/snd/by-id", card_num); !id.empty()) {
-        return "by-id:" + id;
-    }
-    // Fall back to the topology-based symlink — stable across reboots but
-    // breaks if the device is moved to a different USB port. Still tells
-    // two identical devices apart as long as neither is replugged.
-    if (auto id = find_udev_link("/dev/snd/by-path", card_num); !id.empty()) {
-        return "by-path:" + id;
+    if (!card_ids_) {
+        card_ids_ = scan_card_ids();
     }
-    // Final fallback for systems whose udev rules don't populate the above
-    // (minimal containers, some embedded distros). The kernel-assigned
-    // card id is driver-derived and stable on the same hardware topology.
-    const std::string kernel_id = audio::utils::read_file("/sys/class/sound/card" + card_num + "/id");
-    if (!kernel_id.empty()) {
-        return "alsa-card:" + kernel_id;
+    const auto it = card_ids_->find(hw->card_num);
+    if (it != card_ids_->end()) {
+        return it->second;
     }
-    VIAM_SDK_LOG(debug) << "[device_id] No stable id for ALSA card " << card_num << " (\"" << name << "\")";
+    VIAM_SDK_LOG(debug) << "[device_id] No stable id for ALSA card " << hw->card_num << " (\"" << name << "\")";
     return "";
 }
 
@@ -237,3 +264,18 @@ std::string RealDeviceIdResolver::resolve(PaDeviceIndex, const PaDeviceInfo&) co
 }  // namespace audio
 
 #endif
+
+#if !defined(__linux__)
+
+namespace audio {
+namespace device_id {
+
+// ALSA cards only exist on Linux
+CardIdMap scan_card_ids(const std::string&, const std::string&) {
+    return {};
+}
+
+}  // namespace device_id
+}  // namespace audio
+
+#endif
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <optional>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 #include "portaudio.h"
 
@@ -17,14 +20,36 @@ class DeviceIdResolver {
     virtual ~DeviceIdResolver() = default;
 };
 
+// ALSA card number → stable id ("by-id:<...>", "by-path:<...>" or
+// "alsa-card:<kernel-id>"). Cards with no stable id are absent.
+using CardIdMap = std::unordered_map<int, std::string>;
+
+// Reads /dev/snd/by-id, /dev/snd/by-path and /sys/class/sound once and
+// maps every ALSA card to its stable id, in that order of preference.
+// The directories are parameters for tests. Returns an empty map on
+// non-Linux platforms.
+CardIdMap scan_card_ids(const std::string& dev_snd = "/dev/snd", const std::string& sys_sound = "/sys/class/sound");
+
 // Production resolver. On macOS it returns Core Audio's
 // kAudioDevicePropertyDeviceUID via name matching. On Linux it returns
 // a udev-maintained symlink name ("by-id:<...>" or "by-path:<...>"), or
 // "alsa-card:<kernel-id>" when udev sound rules aren't populated. On
 // other platforms it always returns "".
+//
+// On Linux the first resolve() scans every card with scan_card_ids() and
+// later calls are a lookup, like ApeRoutingMap for routing. Use one
+// resolver per discovery pass or restart, so the snapshot never outlives
+// the devices it describes; it isn't safe to share across threads.
 class RealDeviceIdResolver : public DeviceIdResolver {
    public:
+    RealDeviceIdResolver() = default;
+    // Uses an existing snapshot instead of scanning
+    explicit RealDeviceIdResolver(CardIdMap card_ids) : card_ids_(std::move(card_ids)) {}
+
     std::string resolve(PaDeviceIndex index, const PaDeviceInfo& info) const override;
+
+   private:
+    mutable std::optional<CardIdMap> card_ids_;
 };
 
 }  // namespace device_id
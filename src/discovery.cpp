@@ -1,7 +1,9 @@
 #include "discovery.hpp"
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <viam/sdk/config/resource.hpp>
 #include <viam/sdk/services/discovery.hpp>
 #include "microphone.hpp"
@@ -18,9 +20,45 @@ AudioDiscovery::AudioDiscovery(vsdk::Dependencies dependencies,
                                vsdk::ResourceConfig configuration,
                                audio::portaudio::PortAudioInterface* pa,
                                audio::device_id::DeviceIdResolver* resolver)
-    : Discovery(configuration.name()), pa_(pa), resolver_(resolver ? resolver : &default_resolver_) {}
+    : Discovery(configuration.name()), pa_(pa), resolver_(resolver) {
+    const auto attrs = configuration.attributes();
+    if (attrs.count("cache_ttl_seconds") && attrs.at("cache_ttl_seconds").is_a<double>()) {
+        cache_ttl_ = std::chrono::seconds(static_cast<int>(*attrs.at("cache_ttl_seconds").get<double>()));
+    }
+    if (cache_ttl_.count() > 0) {
+        hotplug_ = std::make_unique<audio::hotplug::HotplugMonitor>([this]() { devices_changed_.store(true); });
+    }
+}
+
+std::vector<std::string> AudioDiscovery::validate(vsdk::ResourceConfig cfg) {
+    const auto attrs = cfg.attributes();
+    if (attrs.count("cache_ttl_seconds")) {
+        const auto* ttl = attrs.at("cache_ttl_seconds").get<double>();
+        if (!ttl || *ttl != static_cast<int>(*ttl) || *ttl < 0) {
+            VIAM_SDK_LOG(error) << "[validate] cache_ttl_seconds must be a non-negative integer";
+            throw std::invalid_argument("cache_ttl_seconds must be a non-negative integer");
+        }
+    }
+    return {};
+}
 
 std::vector<vsdk::ResourceConfig> AudioDiscovery::discover_resources(const vsdk::ProtoStruct& extra) {
+    std::lock_guard<std::mutex> lock(cache_mu_);
+    // Cleared before scanning, so a device that changes mid-scan triggers another one
+    const bool devices_changed = devices_changed_.exchange(false);
+    const bool refresh = extra.count("refresh") && extra.at("refresh").is_a<bool>() && *extra.at("refresh").get<bool>();
+    const auto now = std::chrono::steady_clock::now();
+    if (cache_valid_ && !devices_changed && !refresh && now - cached_at_ < cache_ttl_) {
+        VIAM_RESOURCE_LOG(debug) << "Returning cached discovery results (" << cached_configs_.size() << " devices)";
+        return cached_configs_;
+    }
+    cached_configs_ = scan_devices();
+    cached_at_ = now;
+    cache_valid_ = cache_ttl_.count() > 0;
+    return cached_configs_;
+}
+
+std::vector<vsdk::ResourceConfig> AudioDiscovery::scan_devices() {
     std::vector<vsdk::ResourceConfig> configs;
 
     const int numDevices = pa_ ? pa_->getDeviceCount() : Pa_GetDeviceCount();
@@ -93,6 +131,9 @@ std::vector<vsdk::ResourceConfig> AudioDiscovery::discover_resources(const vsdk:
     // Scan APE-card cross-bar routing once up front; the per-device check below
     // is then a pure hash lookup.
     const audio::routing::ApeRoutingMap ape_routing = audio::routing::scan_ape_cards();
+    // Likewise the stable ids: one pass over the udev symlinks, then a lookup per device
+    audio::device_id::RealDeviceIdResolver pass_resolver;
+    const audio::device_id::DeviceIdResolver& resolver = resolver_ ? *resolver_ : pass_resolver;
 
     auto is_unrouted = [&](const PaDeviceInfo& info, bool is_input, const char* dir) {
         if (audio::routing::is_unrouted_admaif(info, is_input, ape_routing)) {
@@ -106,7 +147,7 @@ std::vector<vsdk::ResourceConfig> AudioDiscovery::discover_resources(const vsdk:
         const PaDeviceInfo* info = pa_ ? pa_->getDeviceInfo(i) : Pa_GetDeviceInfo(i);
         const std::string device_name = info->name;
         const double sample_rate = info->defaultSampleRate;
-        const std::string device_id = resolver_->resolve(i, *info);
+        const std::string device_id = resolver.resolve(i, *info);
 
         // Module only supports mono/stereo, clamp to what we can
         // actually use.
@@ -140,6 +181,23 @@ std::vector<vsdk::ResourceConfig> AudioDiscovery::discover_resources(const vsdk:
 }
 
 vsdk::ProtoStruct AudioDiscovery::do_command(const vsdk::ProtoStruct& command) {
+    if (command.count("refresh")) {
+        const auto* refresh = command.at("refresh").get<bool>();
+        if (!refresh) {
+            VIAM_RESOURCE_LOG(error) << "refresh must be a boolean";
+            throw std::invalid_argument("refresh must be a boolean");
+        }
+        if (!*refresh) {
+            return vsdk::ProtoStruct{{"refreshed", false}};
+        }
+        std::lock_guard<std::mutex> lock(cache_mu_);
+        devices_changed_.store(false);
+        cached_configs_ = scan_devices();
+        cached_at_ = std::chrono::steady_clock::now();
+        cache_valid_ = cache_ttl_.count() > 0;
+        return vsdk::ProtoStruct{{"refreshed", true}, {"devices", static_cast<double>(cached_configs_.size())}};
+    }
+
     VIAM_RESOURCE_LOG(error) << "do_command not implemented";
     return vsdk::ProtoStruct{};
 }
@@ -1,13 +1,21 @@
 #pragma once
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
 
 #include <viam/sdk/config/resource.hpp>
 #include <viam/sdk/services/discovery.hpp>
 #include "device_id.hpp"
+#include "hotplug.hpp"
 #include "portaudio.hpp"
 
 namespace discovery {
 
+// How long a discovery result is reused before the devices are scanned again, unless a
+// hotplug event or a "refresh" DoCommand invalidates it first
+constexpr int DEFAULT_CACHE_TTL_SECONDS = 30;
+
 class AudioDiscovery : public viam::sdk::Discovery {
    public:
     explicit AudioDiscovery(viam::sdk::Dependencies dependencies,
@@ -19,12 +27,28 @@ class AudioDiscovery : public viam::sdk::Discovery {
     viam::sdk::ProtoStruct get_status() override {
         return {};
     }
+    static std::vector<std::string> validate(viam::sdk::ResourceConfig cfg);
     static viam::sdk::Model model;
 
    private:
-    // These are null in production and used for testing to inject mocks.
+    // Enumerates the devices and builds their configs, bypassing the cache
+    std::vector<viam::sdk::ResourceConfig> scan_devices();
+
+    // These are null in production and used for testing to inject mocks. Without a
+    // resolver, each scan uses a fresh RealDeviceIdResolver so its card id snapshot is
+    // current.
     const audio::portaudio::PortAudioInterface* pa_{};
-    audio::device_id::RealDeviceIdResolver default_resolver_{};
     const audio::device_id::DeviceIdResolver* resolver_{};
+
+    // The last scan, reused for cache_ttl_ (0 disables caching). cache_mu_ is held across
+    // a scan so concurrent callers wait for it rather than all scanning.
+    std::chrono::seconds cache_ttl_{DEFAULT_CACHE_TTL_SECONDS};
+    std::mutex cache_mu_;
+    bool cache_valid_ = false;
+    std::chrono::steady_clock::time_point cached_at_;
+    std::vector<viam::sdk::ResourceConfig> cached_configs_;
+    // Set by hotplug_ when a device comes or goes; the next call rescans
+    std::atomic<bool> devices_changed_{false};
+    std::unique_ptr<audio::hotplug::HotplugMonitor> hotplug_;
 };
 }  // namespace discovery
@@ -0,0 +1,141 @@
+#include "disk_history.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <viam/sdk/common/utils.hpp>
+
+namespace audio {
+
+DiskHistory::DiskHistory(std::shared_ptr<InputStreamContext> source, const std::string& path, int seconds)
+    : path(path),
+      capacity(static_cast<uint64_t>(source->info.sample_rate_hz) * source->info.num_channels * std::max(seconds, 1)),
+      source_(std::move(source)) {
+    const size_t bytes = capacity * sizeof(int16_t);
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd_ < 0) {
+        VIAM_SDK_LOG(error) << "[DiskHistory] Failed to open " << path << ": " << std::strerror(errno);
+        throw std::runtime_error("Failed to open disk history file " + path + ": " + std::strerror(errno));
+    }
+
+    // Reserve the blocks up front where we can, so a full disk fails here rather than as a
+    // SIGBUS when the drain first writes to a sparse page
+#ifdef __linux__
+    const int sized = ::posix_fallocate(fd_, 0, static_cast<off_t>(bytes));
+#else
+    const int sized = ::ftruncate(fd_, static_cast<off_t>(bytes)) == 0 ? 0 : errno;
+#endif
+    void* map = sized == 0 ? ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0) : MAP_FAILED;
+    if (map == MAP_FAILED) {
+        const int error = sized != 0 ? sized : errno;
+        ::close(fd_);
+        ::unlink(path.c_str());
+        VIAM_SDK_LOG(error) << "[DiskHistory] Failed to map " << bytes << " bytes of " << path << ": " << std::strerror(error);
+        throw std::runtime_error("Failed to map disk history file " + path + ": " + std::strerror(error));
+    }
+    map_ = static_cast<int16_t*>(map);
+
+    const uint64_t start = source_->get_write_position();
+    oldest_.store(start);
+    reserved_.store(start);
+    end_.store(start);
+    thread_ = std::thread([this]() { run(); });
+
+    VIAM_SDK_LOG(info) << "[DiskHistory] Keeping " << seconds << "s of history in " << path << " (" << bytes << " bytes)";
+}
+
+DiskHistory::~DiskHistory() {
+    stop_.store(true);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    ::munmap(map_, capacity * sizeof(int16_t));
+    ::close(fd_);
+    ::unlink(path.c_str());
+}
+
+uint64_t DiskHistory::oldest_position() const noexcept {
+    const uint64_t end = end_.load(std::memory_order_acquire);
+    const uint64_t lapped = end > capacity ? end - capacity : 0;
+    return std::max(oldest_.load(std::memory_order_acquire), lapped);
+}
+
+uint64_t DiskHistory::end_position() const noexcept {
+    return end_.load(std::memory_order_acquire);
+}
+
+void DiskHistory::run() {
+    const size_t segment_samples =
+        static_cast<size_t>(source_->info.sample_rate_hz) * source_->info.num_channels * DISK_HISTORY_SEGMENT_MS / 1000;
+    std::vector<int16_t> segment(segment_samples);
+    uint64_t position = end_.load();
+
+    while (!stop_.load()) {
+        if (!source_->wait_for_write_position(position + segment_samples, MAX_WAIT_SLICE)) {
+            continue;
+        }
+
+        uint64_t read_position = position;
+        const int samples_read = source_->read_samples(segment.data(), static_cast<int>(segment_samples), read_position);
+        if (samples_read <= 0) {
+            continue;
+        }
+        const uint64_t segment_start = read_position - samples_read;
+        if (segment_start != position) {
+            // The ring lapped the drain (e.g. it was descheduled for longer than the ring
+            // holds). The skipped audio is gone, so the history restarts after the gap.
+            VIAM_SDK_LOG(warn) << "[DiskHistory] Drain fell behind the ring, lost " << (segment_start - position) << " samples";
+            oldest_.store(segment_start, std::memory_order_release);
+        }
+        store(segment_start, segment.data(), samples_read);
+        position = read_position;
+    }
+}
+
+void DiskHistory::store(uint64_t position, const int16_t* samples, size_t count) noexcept {
+    // Same protocol as AudioBuffer::write_samples: announce the slots, copy, then publish
+    reserved_.store(position + count, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const size_t start = static_cast<size_t>(position % capacity);
+    const size_t first_span = std::min(count, static_cast<size_t>(capacity) - start);
+    std::memcpy(map_ + start, samples, first_span * sizeof(int16_t));
+    std::memcpy(map_, samples + first_span, (count - first_span) * sizeof(int16_t));
+
+    end_.store(position + count, std::memory_order_release);
+}
+
+int DiskHistory::read_samples(int16_t* buffer, int sample_count, uint64_t& position) noexcept {
+    while (true) {
+        const uint64_t end = end_.load(std::memory_order_acquire);
+        if (position >= end) {
+            return 0;
+        }
+        const uint64_t oldest = oldest_position();
+        if (position < oldest) {
+            VIAM_SDK_LOG(warn) << "[DiskHistory] Read position " << position << " has been overwritten, skipping to " << oldest;
+            position = oldest;
+            continue;
+        }
+
+        const size_t to_read = std::min(static_cast<uint64_t>(std::max(sample_count, 0)), end - position);
+        const size_t start = static_cast<size_t>(position % capacity);
+        const size_t first_span = std::min(to_read, static_cast<size_t>(capacity) - start);
+        std::memcpy(buffer, map_ + start, first_span * sizeof(int16_t));
+        std::memcpy(buffer + first_span, map_, (to_read - first_span) * sizeof(int16_t));
+
+        // Intact if the drain hadn't started overwriting any of the span, and no gap reset
+        // moved the history past it
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (reserved_.load(std::memory_order_relaxed) <= position + capacity && position >= oldest_.load()) {
+            position += to_read;
+            return static_cast<int>(to_read);
+        }
+    }
+}
+
+}  // namespace audio
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include "audio_stream.hpp"
+
+namespace audio {
+
+// How much audio the drain thread copies to disk at a time. Only whole segments are spilled,
+// so the disk tier trails the ring by up to this much.
+constexpr int DISK_HISTORY_SEGMENT_MS = 500;
+
+// Optional second tier of capture history, for lookback beyond the RAM ring. A background
+// thread copies completed segments of a context's ring into a file-backed ring, mapped into
+// memory, using the same absolute sample positions. Readers reach it through read_samples()
+// with the same seqlock-style validation as AudioBuffer. The audio callback never touches it;
+// all file I/O happens on the drain thread (and in the kernel's writeback).
+// One instance serves one context. Stall restarts reopen the stream into that same context,
+// so the history carries on across them.
+class DiskHistory {
+   public:
+    // Creates or truncates the file at path, sized for `seconds` of the source's format, maps
+    // it and starts draining from the source's current write position. The file is removed
+    // when the history is destroyed. Throws std::runtime_error if the file can't be created,
+    // sized or mapped.
+    DiskHistory(std::shared_ptr<InputStreamContext> source, const std::string& path, int seconds);
+    ~DiskHistory();
+
+    DiskHistory(const DiskHistory&) = delete;
+    DiskHistory& operator=(const DiskHistory&) = delete;
+
+    // Oldest sample position still on disk
+    uint64_t oldest_position() const noexcept;
+    // One past the newest sample position spilled to disk
+    uint64_t end_position() const noexcept;
+
+    bool contains(uint64_t position, uint64_t sample_count) const noexcept {
+        return position >= oldest_position() && position + sample_count <= end_position();
+    }
+
+    // Same contract as AudioBuffer::read_samples over the disk tier: copies up to sample_count
+    // samples from position and advances it, skipping ahead if position has been overwritten.
+    // Returns 0 if position hasn't been spilled yet.
+    int read_samples(int16_t* buffer, int sample_count, uint64_t& position) noexcept;
+
+    const std::shared_ptr<InputStreamContext>& source() const noexcept {
+        return source_;
+    }
+
+    const std::string path;
+    // Samples the file holds
+    const uint64_t capacity;
+
+   private:
+    void run();
+    // Copies count samples that belong at position into the file ring
+    void store(uint64_t position, const int16_t* samples, size_t count) noexcept;
+
+    const std::shared_ptr<InputStreamContext> source_;
+    int fd_ = -1;
+    int16_t* map_ = nullptr;
+    // oldest_ only moves on a gap (the drain fell a whole ring behind); the file ring lapping
+    // itself is accounted for in oldest_position()
+    std::atomic<uint64_t> oldest_{0};
+    std::atomic<uint64_t> end_{0};
+    // End of the span the drain is currently copying, stored before the copy starts
+    std::atomic<uint64_t> reserved_{0};
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
+
+}  // namespace audio
@@ -0,0 +1,150 @@
+#include "hotplug.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <viam/sdk/common/utils.hpp>
+
+#if defined(__linux__)
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <CoreAudio/CoreAudio.h>
+#endif
+
+namespace audio {
+namespace hotplug {
+
+bool is_sound_device_uevent(const char* message, size_t length) {
+    const std::string_view event(message, length);
+    // The header is "ACTION@devpath"; "change" events are jack and mixer state, not devices
+    // coming or going
+    if (event.compare(0, 4, "add@") != 0 && event.compare(0, 7, "remove@") != 0) {
+        return false;
+    }
+    size_t pos = event.find('\0');
+    while (pos != std::string_view::npos && pos + 1 < event.size()) {
+        const size_t next = event.find('\0', pos + 1);
+        const std::string_view field = event.substr(pos + 1, next == std::string_view::npos ? std::string_view::npos : next - pos - 1);
+        if (field == "SUBSYSTEM=sound") {
+            return true;
+        }
+        pos = next;
+    }
+    return false;
+}
+
+#if defined(__linux__)
+
+HotplugMonitor::HotplugMonitor(std::function<void()> on_change) : on_change_(std::move(on_change)) {
+    socket_fd_ = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (socket_fd_ < 0) {
+        VIAM_SDK_LOG(debug) << "[hotplug] uevent socket unavailable (" << std::strerror(errno) << "); relying on stall polling";
+        return;
+    }
+    sockaddr_nl addr{};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1;  // the kernel's own uevents, which don't need udev running
+    if (::bind(socket_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        VIAM_SDK_LOG(debug) << "[hotplug] uevent socket bind failed (" << std::strerror(errno) << "); relying on stall polling";
+        ::close(socket_fd_);
+        socket_fd_ = -1;
+        return;
+    }
+    wake_fd_ = ::eventfd(0, EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        ::close(socket_fd_);
+        socket_fd_ = -1;
+        return;
+    }
+    active_ = true;
+    thread_ = std::thread([this] { run(); });
+}
+
+HotplugMonitor::~HotplugMonitor() {
+    if (thread_.joinable()) {
+        const uint64_t one = 1;
+        (void)!::write(wake_fd_, &one, sizeof(one));
+        thread_.join();
+    }
+    if (wake_fd_ >= 0) {
+        ::close(wake_fd_);
+    }
+    if (socket_fd_ >= 0) {
+        ::close(socket_fd_);
+    }
+}
+
+void HotplugMonitor::run() {
+    // uevents are at most a few KB; anything longer is truncated, which the parser tolerates
+    char buffer[8192];
+    pollfd fds[2] = {{socket_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+    while (true) {
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            VIAM_SDK_LOG(warn) << "[hotplug] poll failed (" << std::strerror(errno) << "); hotplug events stopped";
+            return;
+        }
+        if (fds[1].revents) {
+            return;
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+        const ssize_t n = ::recv(socket_fd_, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (n > 0 && is_sound_device_uevent(buffer, static_cast<size_t>(n))) {
+            VIAM_SDK_LOG(debug) << "[hotplug] " << std::string(buffer, ::strnlen(buffer, static_cast<size_t>(n)));
+            notify();
+        }
+    }
+}
+
+#elif defined(__APPLE__)
+
+namespace {
+
+OSStatus on_devices_changed(AudioObjectID, UInt32, const AudioObjectPropertyAddress*, void* client_data) {
+    static_cast<const HotplugMonitor*>(client_data)->notify();
+    return noErr;
+}
+
+// kAudioObjectPropertyElementMain is spelled differently before macOS 12; both are 0
+constexpr AudioObjectPropertyAddress kDevicesAddress{
+    kAudioHardwarePropertyDevices, kAudioObjectPropertyScopeGlobal, 0};
+
+}  // namespace
+
+HotplugMonitor::HotplugMonitor(std::function<void()> on_change) : on_change_(std::move(on_change)) {
+    const OSStatus err = AudioObjectAddPropertyListener(kAudioObjectSystemObject, &kDevicesAddress, on_devices_changed, this);
+    if (err != noErr) {
+        VIAM_SDK_LOG(debug) << "[hotplug] Core Audio device listener unavailable (" << err << "); relying on stall polling";
+        return;
+    }
+    active_ = true;
+}
+
+HotplugMonitor::~HotplugMonitor() {
+    if (active_) {
+        AudioObjectRemovePropertyListener(kAudioObjectSystemObject, &kDevicesAddress, on_devices_changed, this);
+    }
+}
+
+#else
+
+HotplugMonitor::HotplugMonitor(std::function<void()> on_change) : on_change_(std::move(on_change)) {}
+
+HotplugMonitor::~HotplugMonitor() = default;
+
+#endif
+
+}  // namespace hotplug
+}  // namespace audio
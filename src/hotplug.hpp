@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <thread>
+
+namespace audio {
+namespace hotplug {
+
+// Calls on_change whenever an audio device is added to or removed from the system, so stream
+// recovery can react to a replug instead of waiting for the stall watchdog's next poll.
+// On Linux it listens for the kernel's "sound" uevents on a netlink socket; on macOS it
+// listens for changes to Core Audio's device list. Elsewhere, or when the OS refuses the
+// listener, active() is false and nothing is ever reported.
+//
+// on_change runs on the monitor's own thread (a Core Audio thread on macOS), and a single
+// replug fires it several times in a row (card, control and PCM nodes), so it should only
+// flag the change and wake whoever does the work.
+class HotplugMonitor {
+   public:
+    explicit HotplugMonitor(std::function<void()> on_change);
+    ~HotplugMonitor();
+
+    HotplugMonitor(const HotplugMonitor&) = delete;
+    HotplugMonitor& operator=(const HotplugMonitor&) = delete;
+
+    // Whether device changes are actually being reported
+    bool active() const noexcept {
+        return active_;
+    }
+
+    // Invokes on_change; the platform listeners call this
+    void notify() const {
+        on_change_();
+    }
+
+   private:
+    std::function<void()> on_change_;
+    bool active_ = false;
+#if defined(__linux__)
+    void run();
+
+    int socket_fd_ = -1;
+    // Signalled to wake run() for shutdown
+    int wake_fd_ = -1;
+    std::thread thread_;
+#endif
+};
+
+// Whether a kernel uevent ("ACTION@devpath\0KEY=value\0...") adds or removes a sound device.
+// Exposed for tests.
+bool is_sound_device_uevent(const char* message, size_t length);
+
+}  // namespace hotplug
+}  // namespace audio
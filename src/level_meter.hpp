@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "audio_buffer.hpp"
+
+namespace audio {
+namespace levels {
+
+// Resolution of the meter: the callback folds its samples into slots of this many ms
+constexpr int SLOT_MS = 10;
+// Completed slots kept per channel (a little over 10 s); the longest window a reader can ask for
+constexpr size_t HISTORY_SLOTS = 1024;
+constexpr int MAX_WINDOW_MS = 10000;
+// Level reported for digital silence, which has no finite dBFS
+constexpr double FLOOR_DB = -120;
+
+inline double to_dbfs(double amplitude) {
+    return amplitude > 0 ? std::max(FLOOR_DB, 20 * std::log10(amplitude)) : FLOOR_DB;
+}
+
+// Peak and RMS of one channel over a window, in dBFS
+struct ChannelLevel {
+    double peak_dbfs = FLOOR_DB;
+    double rms_dbfs = FLOOR_DB;
+};
+
+struct WindowLevels {
+    // Audio actually covered: the request rounded up to whole slots, and cut short if the stream
+    // hasn't been running that long. 0 before the first slot completes.
+    int window_ms = 0;
+    std::vector<ChannelLevel> channels;
+};
+
+// Per-channel peak and RMS of everything a capture callback writes, kept so clients can poll
+// levels instead of pulling audio. add() runs on the audio thread and never blocks or
+// allocates: it accumulates into the current slot and publishes each slot as it completes.
+// window() may run on any thread; it sums the newest completed slots, so a level is at most
+// one slot (SLOT_MS) behind the audio.
+class LevelMeter {
+   public:
+    LevelMeter(int num_channels, int sample_rate)
+        : num_channels_(static_cast<size_t>(std::max(1, num_channels))),
+          slot_frames_(std::max<size_t>(1, static_cast<size_t>(sample_rate) * SLOT_MS / 1000)),
+          peak_acc_(num_channels_, 0.0f),
+          square_acc_(num_channels_, 0.0),
+          peaks_(new std::atomic<float>[HISTORY_SLOTS * num_channels_]),
+          squares_(new std::atomic<double>[HISTORY_SLOTS * num_channels_]) {}
+
+    // Adds frames of interleaved samples. Channels fixes the channel count at compile time (the
+    // specialized capture callbacks); 0 uses the meter's.
+    template <typename Sample, int Channels = 0>
+    void add(const Sample* samples, size_t frames) noexcept {
+        const size_t channels = Channels > 0 ? Channels : num_channels_;
+        while (frames > 0) {
+            // Whole slot-sized runs, so the per-frame loop has no publish check in it
+            const size_t run = std::min(frames, slot_frames_ - frames_acc_);
+            for (size_t frame = 0; frame < run; frame++) {
+                for (size_t ch = 0; ch < channels; ch++) {
+                    const float value = to_unit(samples[frame * channels + ch]);
+                    peak_acc_[ch] = std::max(peak_acc_[ch], std::fabs(value));
+                    square_acc_[ch] += static_cast<double>(value) * value;
+                }
+            }
+            samples += run * channels;
+            frames -= run;
+            frames_acc_ += run;
+            if (frames_acc_ == slot_frames_) {
+                publish();
+            }
+        }
+    }
+
+    // add() for a buffer in `format`, for callers that only know it at runtime
+    void add(const void* samples, size_t frames, SampleFormat format) noexcept {
+        switch (format) {
+            case SampleFormat::INT32:
+                add(static_cast<const int32_t*>(samples), frames);
+                break;
+            case SampleFormat::FLOAT32:
+                add(static_cast<const float*>(samples), frames);
+                break;
+            default:
+                add(static_cast<const int16_t*>(samples), frames);
+                break;
+        }
+    }
+
+    // Levels over the newest window_ms of audio (clamped to SLOT_MS..MAX_WINDOW_MS)
+    WindowLevels window(int window_ms) const {
+        const uint64_t wanted = static_cast<uint64_t>((std::clamp(window_ms, SLOT_MS, MAX_WINDOW_MS) + SLOT_MS - 1) / SLOT_MS);
+        WindowLevels result;
+        std::vector<float> peaks(num_channels_);
+        std::vector<double> squares(num_channels_);
+        while (true) {
+            const uint64_t end = published_.load(std::memory_order_acquire);
+            const uint64_t count = std::min(wanted, end);
+            std::fill(peaks.begin(), peaks.end(), 0.0f);
+            std::fill(squares.begin(), squares.end(), 0.0);
+            for (uint64_t slot = end - count; slot < end; slot++) {
+                const size_t base = static_cast<size_t>(slot % HISTORY_SLOTS) * num_channels_;
+                for (size_t ch = 0; ch < num_channels_; ch++) {
+                    peaks[ch] = std::max(peaks[ch], peaks_[base + ch].load(std::memory_order_relaxed));
+                    squares[ch] += squares_[base + ch].load(std::memory_order_relaxed);
+                }
+            }
+            // The slots are only valid if the writer hasn't lapped the oldest of them meanwhile
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (published_.load(std::memory_order_relaxed) - (end - count) >= HISTORY_SLOTS) {
+                continue;
+            }
+            result.window_ms = static_cast<int>(count) * SLOT_MS;
+            result.channels.resize(num_channels_);
+            for (size_t ch = 0; ch < num_channels_ && count > 0; ch++) {
+                result.channels[ch].peak_dbfs = to_dbfs(peaks[ch]);
+                result.channels[ch].rms_dbfs = to_dbfs(std::sqrt(squares[ch] / static_cast<double>(count * slot_frames_)));
+            }
+            return result;
+        }
+    }
+
+    size_t num_channels() const noexcept {
+        return num_channels_;
+    }
+
+   private:
+    static float to_unit(int16_t sample) noexcept {
+        return sample * INT16_TO_FLOAT_SCALE;
+    }
+    static float to_unit(int32_t sample) noexcept {
+        return static_cast<float>(sample * (1.0 / 2147483648.0));
+    }
+    static float to_unit(float sample) noexcept {
+        return sample;
+    }
+
+    void publish() noexcept {
+        const uint64_t slot = published_.load(std::memory_order_relaxed);
+        // Orders the stores below after the slot count, so a reader that sees any of them also
+        // sees the count and can tell it was lapped
+        std::atomic_thread_fence(std::memory_order_release);
+        const size_t base = static_cast<size_t>(slot % HISTORY_SLOTS) * num_channels_;
+        for (size_t ch = 0; ch < num_channels_; ch++) {
+            peaks_[base + ch].store(peak_acc_[ch], std::memory_order_relaxed);
+            squares_[base + ch].store(square_acc_[ch], std::memory_order_relaxed);
+            peak_acc_[ch] = 0.0f;
+            square_acc_[ch] = 0.0;
+        }
+        frames_acc_ = 0;
+        published_.store(slot + 1, std::memory_order_release);
+    }
+
+    const size_t num_channels_;
+    const size_t slot_frames_;
+    // The slot being filled; only touched by the audio thread
+    std::vector<float> peak_acc_;
+    std::vector<double> square_acc_;
+    size_t frames_acc_ = 0;
+    // Completed slots, HISTORY_SLOTS rows of num_channels_ each, indexed by slot number
+    std::unique_ptr<std::atomic<float>[]> peaks_;
+    std::unique_ptr<std::atomic<double>[]> squares_;
+    // Number of slots completed so far
+    std::atomic<uint64_t> published_{0};
+};
+
+}  // namespace levels
+}  // namespace audio
@@ -33,7 +33,8 @@ std::vector<std::shared_ptr<vsdk::ModelRegistration>> create_all_model_registrat
     registrations.push_back(std::make_shared<vsdk::ModelRegistration>(
         vsdk::API::get<vsdk::Discovery>(), discovery::AudioDiscovery::model, [](vsdk::Dependencies deps, vsdk::ResourceConfig config) {
             return std::make_unique<discovery::AudioDiscovery>(std::move(deps), std::move(config));
-        }));
+        },
+        discovery::AudioDiscovery::validate));
 
     return registrations;
 }
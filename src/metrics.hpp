@@ -0,0 +1,269 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include <viam/sdk/common/proto_value.hpp>
+#include <viam/sdk/common/utils.hpp>
+
+namespace audio {
+namespace metrics {
+
+namespace vsdk = ::viam::sdk;
+
+// Relaxed atomic counter. Readers want totals, not ordering against other state.
+class Counter {
+   public:
+    void add(uint64_t n = 1) noexcept {
+        value_.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const noexcept {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+    // Returns the value, zeroing it when reset is set
+    uint64_t read(bool reset) noexcept {
+        return reset ? value_.exchange(0, std::memory_order_relaxed) : value();
+    }
+
+   private:
+    std::atomic<uint64_t> value_{0};
+};
+
+// Histogram over fixed power-of-two buckets: bucket 0 counts zeros, bucket i counts values in
+// [2^(i-1), 2^i), and the last bucket everything above. record() is a few relaxed atomic
+// operations and never blocks or allocates, so it's safe on the audio thread. Fields are
+// read one at a time, so a snapshot taken while values are recorded may be off by those.
+class Histogram {
+   public:
+    static constexpr size_t BUCKETS = 24;
+
+    static size_t bucket_for(uint64_t value) noexcept {
+        size_t bucket = 0;
+        while (value != 0 && bucket < BUCKETS - 1) {
+            value >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    // Smallest value counted in bucket
+    static uint64_t bucket_floor(size_t bucket) noexcept {
+        return bucket == 0 ? 0 : uint64_t{1} << (bucket - 1);
+    }
+
+    void record(uint64_t value) noexcept {
+        buckets_[bucket_for(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t count() const noexcept {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    // {"count", "mean", "max", "buckets": [{"min", "count"}, ...]} with empty buckets left out.
+    // When reset is set each field is zeroed as it's read.
+    vsdk::ProtoStruct to_struct(bool reset) {
+        const auto take = [reset](std::atomic<uint64_t>& field) {
+            return reset ? field.exchange(0, std::memory_order_relaxed) : field.load(std::memory_order_relaxed);
+        };
+        vsdk::ProtoList buckets;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            const uint64_t n = take(buckets_[i]);
+            if (n != 0) {
+                buckets.push_back(vsdk::ProtoStruct{{"min", static_cast<double>(bucket_floor(i))}, {"count", static_cast<double>(n)}});
+            }
+        }
+        const uint64_t count = take(count_);
+        const uint64_t sum = take(sum_);
+        return vsdk::ProtoStruct{{"count", static_cast<double>(count)},
+                                 {"mean", count == 0 ? 0.0 : static_cast<double>(sum) / count},
+                                 {"max", static_cast<double>(take(max_))},
+                                 {"buckets", std::move(buckets)}};
+    }
+
+   private:
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// Records the time from construction to destruction into a histogram, in microseconds
+class ScopedTimer {
+   public:
+    explicit ScopedTimer(Histogram& histogram) noexcept : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        const auto elapsed = std::chrono::steady_clock::now() - start_;
+        histogram_.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+   private:
+    Histogram& histogram_;
+    const std::chrono::steady_clock::time_point start_;
+};
+
+// Callback durations at fine resolution, for percentiles against the buffer period. Enabled
+// per device by the callback_timing attribute. The buckets are allocated once in the
+// constructor, RESOLUTION_US wide up to MAX_US (longer callbacks land in the last one), so
+// record() is a few relaxed atomic operations and never allocates.
+class CallbackTiming {
+   public:
+    static constexpr uint64_t RESOLUTION_US = 10;
+    static constexpr uint64_t MAX_US = 100'000;
+    static constexpr size_t BUCKETS = MAX_US / RESOLUTION_US + 1;
+
+    CallbackTiming() : buckets_(std::make_unique<std::atomic<uint32_t>[]>(BUCKETS)) {}
+
+    // Records one callback that ran for duration_ns and was handed frames frames
+    void record(uint64_t duration_ns, uint64_t frames, int sample_rate) noexcept {
+        const uint64_t duration_us = duration_ns / 1000;
+        buckets_[std::min<uint64_t>(duration_us / RESOLUTION_US, BUCKETS - 1)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        uint64_t max = max_us_.load(std::memory_order_relaxed);
+        while (duration_us > max && !max_us_.compare_exchange_weak(max, duration_us, std::memory_order_relaxed)) {
+        }
+        if (sample_rate > 0) {
+            const uint64_t period_us = frames * 1'000'000 / static_cast<uint64_t>(sample_rate);
+            period_us_.store(period_us, std::memory_order_relaxed);
+            if (duration_us > period_us) {
+                overruns_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Upper edge of the bucket holding the given fraction of counts, or max_us if that's the
+    // overflow bucket (or it is smaller). 0 for no counts.
+    static uint64_t percentile_us(const std::vector<uint32_t>& counts, double fraction, uint64_t max_us) {
+        uint64_t total = 0;
+        for (uint32_t n : counts) {
+            total += n;
+        }
+        if (total == 0) {
+            return 0;
+        }
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * total)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return i + 1 == counts.size() ? max_us : std::min(max_us, (i + 1) * RESOLUTION_US);
+            }
+        }
+        return max_us;
+    }
+
+    // {"count", "p50_us", "p99_us", "max_us", "period_us", "p99_of_period", "overruns"}, where
+    // period_us is the latest callback's buffer period and overruns counts callbacks that ran
+    // longer than theirs. When reset is set the counts are zeroed as they're read.
+    vsdk::ProtoStruct to_struct(bool reset) {
+        std::vector<uint32_t> counts(BUCKETS);
+        for (size_t i = 0; i < BUCKETS; i++) {
+            counts[i] = reset ? buckets_[i].exchange(0, std::memory_order_relaxed) : buckets_[i].load(std::memory_order_relaxed);
+        }
+        const auto take = [reset](std::atomic<uint64_t>& field) {
+            return reset ? field.exchange(0, std::memory_order_relaxed) : field.load(std::memory_order_relaxed);
+        };
+        const uint64_t max_us = take(max_us_);
+        const uint64_t p99_us = percentile_us(counts, 0.99, max_us);
+        const uint64_t period_us = period_us_.load(std::memory_order_relaxed);
+        return vsdk::ProtoStruct{{"count", static_cast<double>(take(count_))},
+                                 {"p50_us", static_cast<double>(percentile_us(counts, 0.5, max_us))},
+                                 {"p99_us", static_cast<double>(p99_us)},
+                                 {"max_us", static_cast<double>(max_us)},
+                                 {"period_us", static_cast<double>(period_us)},
+                                 {"p99_of_period", period_us == 0 ? 0.0 : static_cast<double>(p99_us) / period_us},
+                                 {"overruns", static_cast<double>(take(overruns_))}};
+    }
+
+   private:
+    const std::unique_ptr<std::atomic<uint32_t>[]> buckets_;
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> max_us_{0};
+    std::atomic<uint64_t> period_us_{0};
+    std::atomic<uint64_t> overruns_{0};
+};
+
+// Running numbers for one microphone or speaker, reported by get_status and the get_stats
+// DoCommand. Owned by the resource and shared by each stream context it creates, so they
+// carry across stream restarts.
+struct StreamMetrics {
+    // Time spent inside the audio callback
+    Histogram callback_duration_us;
+    // Time between consecutive callbacks, and how far that strays from the buffer period
+    Histogram callback_interval_us;
+    Histogram callback_jitter_us;
+    // Audio queued between the ring's writer and reader: for a speaker, what's buffered ahead
+    // of playback at each callback; for a microphone, how far each reader trails capture, per
+    // chunk delivered
+    Histogram queued_ms;
+    // Per-chunk resampling, and encoding (microphone) or decoding (speaker)
+    Histogram resample_us;
+    Histogram codec_us;
+    // Chunks delivered to clients (microphone) or taken from play calls (speaker)
+    Counter chunks;
+    Counter restarts;
+
+    // Records one callback that started at start_ns, ended at end_ns and was handed frames
+    // frames. previous_ns is when the callback before it started, 0 for the first one.
+    void record_callback(uint64_t previous_ns, uint64_t start_ns, uint64_t end_ns, uint64_t frames, int sample_rate) noexcept {
+        callback_duration_us.record((end_ns - start_ns) / 1000);
+        if (previous_ns == 0 || start_ns < previous_ns || sample_rate <= 0) {
+            return;
+        }
+        const uint64_t interval_ns = start_ns - previous_ns;
+        const uint64_t period_ns = frames * 1'000'000'000ULL / static_cast<uint64_t>(sample_rate);
+        callback_interval_us.record(interval_ns / 1000);
+        callback_jitter_us.record((interval_ns > period_ns ? interval_ns - period_ns : period_ns - interval_ns) / 1000);
+    }
+
+    vsdk::ProtoStruct to_struct(bool reset) {
+        return vsdk::ProtoStruct{{"callback_duration_us", callback_duration_us.to_struct(reset)},
+                                 {"callback_interval_us", callback_interval_us.to_struct(reset)},
+                                 {"callback_jitter_us", callback_jitter_us.to_struct(reset)},
+                                 {"queued_ms", queued_ms.to_struct(reset)},
+                                 {"resample_us", resample_us.to_struct(reset)},
+                                 {"codec_us", codec_us.to_struct(reset)},
+                                 {"chunks", static_cast<double>(chunks.read(reset))},
+                                 {"restarts", static_cast<double>(restarts.read(reset))}};
+    }
+};
+
+// Reads the reset option of a get_stats DoCommand: {"get_stats": true} or
+// {"get_stats": {"reset": true}}. Throws std::invalid_argument for any other shape.
+inline bool parse_stats_reset(const vsdk::ProtoValue& request) {
+    if (request.is_a<bool>()) {
+        return false;
+    }
+    const auto* options = request.get<vsdk::ProtoStruct>();
+    if (!options) {
+        VIAM_SDK_LOG(error) << "[get_stats] argument must be a boolean or a struct";
+        throw std::invalid_argument("get_stats argument must be a boolean or a struct");
+    }
+    if (!options->count("reset")) {
+        return false;
+    }
+    if (!options->at("reset").is_a<bool>()) {
+        VIAM_SDK_LOG(error) << "[get_stats] reset must be a boolean";
+        throw std::invalid_argument("get_stats reset must be a boolean");
+    }
+    return *options->at("reset").get<bool>();
+}
+
+}  // namespace metrics
+}  // namespace audio
@@ -1,13 +1,18 @@
 #include "microphone.hpp"
 #include <algorithm>
 #include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
 #include <sstream>
 #include <thread>
+#include <type_traits>
 #include "audio_buffer.hpp"
 #include "audio_codec.hpp"
 #include "audio_stream.hpp"
 #include "audio_utils.hpp"
 #include "mp3_encoder.hpp"
+#include "opus_encoder.hpp"
 #include "resample.hpp"
 
 #ifdef __APPLE__
@@ -19,14 +24,104 @@ using audio::codec::AudioCodec;
 
 // === Static Helper Functions ===
 
+// The PCM codec whose payload is a device buffer's samples as they're stored
+static AudioCodec pcm_codec_for(audio::SampleFormat format) {
+    switch (format) {
+        case audio::SampleFormat::INT32:
+            return AudioCodec::PCM_32;
+        case audio::SampleFormat::FLOAT32:
+            return AudioCodec::PCM_32_FLOAT;
+        default:
+            return AudioCodec::PCM_16;
+    }
+}
+
+// Reads get_levels' argument: true for the default windows, or {"window_ms": [...]}.
+// Throws std::invalid_argument on anything else.
+static std::vector<int> parse_level_windows(const vsdk::ProtoValue& request) {
+    if (request.is_a<bool>()) {
+        return {DEFAULT_LEVEL_WINDOWS_MS.begin(), DEFAULT_LEVEL_WINDOWS_MS.end()};
+    }
+    const auto* options = request.get<vsdk::ProtoStruct>();
+    const vsdk::ProtoList* list = nullptr;
+    if (options && options->count("window_ms")) {
+        list = options->at("window_ms").get<vsdk::ProtoList>();
+    }
+    if (!list || list->empty()) {
+        VIAM_SDK_LOG(error) << "get_levels takes true or {\"window_ms\": [...]}";
+        throw std::invalid_argument("get_levels takes true or {\"window_ms\": [...]}");
+    }
+    std::vector<int> windows;
+    for (const auto& entry : *list) {
+        const auto* ms = entry.get<double>();
+        if (!ms || *ms < audio::levels::SLOT_MS || *ms > audio::levels::MAX_WINDOW_MS) {
+            std::ostringstream buffer;
+            buffer << "get_levels window_ms entries must be between " << audio::levels::SLOT_MS << " and "
+                   << audio::levels::MAX_WINDOW_MS;
+            VIAM_SDK_LOG(error) << buffer.str();
+            throw std::invalid_argument(buffer.str());
+        }
+        windows.push_back(static_cast<int>(*ms));
+    }
+    return windows;
+}
+
+// The get_levels response: per-channel peak and RMS for each window
+static vsdk::ProtoStruct levels_struct(const audio::levels::LevelMeter& meter, const std::vector<int>& windows) {
+    vsdk::ProtoList results;
+    for (const int window_ms : windows) {
+        const audio::levels::WindowLevels levels = meter.window(window_ms);
+        vsdk::ProtoList peaks;
+        vsdk::ProtoList rms;
+        for (const auto& channel : levels.channels) {
+            peaks.push_back(channel.peak_dbfs);
+            rms.push_back(channel.rms_dbfs);
+        }
+        results.push_back(vsdk::ProtoStruct{{"window_ms", static_cast<double>(levels.window_ms)},
+                                            {"peak_dbfs", std::move(peaks)},
+                                            {"rms_dbfs", std::move(rms)}});
+    }
+    return vsdk::ProtoStruct{{"num_channels", static_cast<double>(meter.num_channels())}, {"windows", std::move(results)}};
+}
+
+// The get_shared_memory response: where to find the exported ring and how to read it, or just
+// enabled: false when shared_memory is off
+static vsdk::ProtoStruct shared_memory_struct(const audio::shm::SharedRing* ring) {
+    if (!ring) {
+        return vsdk::ProtoStruct{{"enabled", false}};
+    }
+    const audio::shm::RingHeader& header = ring->header();
+    return vsdk::ProtoStruct{{"enabled", true},
+                             {"name", ring->name},
+                             {"size_bytes", static_cast<double>(ring->size)},
+                             {"version", static_cast<double>(header.version)},
+                             {"header_bytes", static_cast<double>(header.header_bytes)},
+                             {"sample_rate", static_cast<double>(header.sample_rate)},
+                             {"num_channels", static_cast<double>(header.num_channels)},
+                             {"sample_format", std::string(audio::sample_format_name(static_cast<audio::SampleFormat>(header.sample_format)))},
+                             {"ring_samples", static_cast<double>(header.ring_samples)},
+                             {"capacity_samples", static_cast<double>(header.capacity_samples)}};
+}
+
+// The duplex_speaker dependency, which must be a speaker from this module so its stream can be
+// handed over. Throws std::invalid_argument otherwise.
+static std::shared_ptr<speaker::Speaker> find_duplex_speaker(const vsdk::Dependencies& deps, const std::string& name) {
+    for (const auto& dep : deps) {
+        if (dep.second && dep.second->name() == name) {
+            if (auto found = std::dynamic_pointer_cast<speaker::Speaker>(dep.second)) {
+                return found;
+            }
+        }
+    }
+    VIAM_SDK_LOG(error) << "duplex_speaker " << name << " must be a speaker from this module";
+    throw std::invalid_argument("duplex_speaker " + name + " must be a speaker from this module");
+}
+
 // Calculate chunk size aligned to MP3 frame boundaries
 // Returns the number of samples (including all channels) for an optimal chunk size
 // mp3_frame_size should be the actual frame size from LAME (1152 or 576), defaults to 1152
-int calculate_aligned_chunk_size(int sample_rate, int num_channels, int mp3_frame_size = 1152) {
-    // Calculate how many frames fit into approximately 100-200ms
-    // Target: around 150ms for reasonable latency
-
-    const double target_duration_seconds = 0.15;  // 150ms target
+// target_duration_seconds defaults to 150ms, a reasonable latency for most clients
+int calculate_aligned_chunk_size(int sample_rate, int num_channels, int mp3_frame_size = 1152, double target_duration_seconds = 0.15) {
     const double samples_per_channel_target = sample_rate * target_duration_seconds;
 
     // Round to nearest number of MP3 frames
@@ -50,37 +145,378 @@ int calculate_aligned_chunk_size(int sample_rate, int num_channels, int mp3_fram
 }
 
 // Calculate chunk size based on codec and audio format
-// For MP3, aligns chunk size with the mp3 frame size
+// For MP3, aligns chunk size with the mp3 frame size; for Opus, a chunk is a whole number of packets.
+// chunk_duration_ms is the caller's requested duration, or 0 for the codec default. Throws
+// std::invalid_argument if the codec's frames can't produce that duration.
 static int calculate_chunk_size(const audio::codec::AudioCodec codec,
                                 int sample_rate,
                                 int num_channels,
-                                const MP3EncoderContext* mp3_ctx = nullptr) {
+                                const MP3EncoderContext* mp3_ctx = nullptr,
+                                const OpusEncoderContext* opus_ctx = nullptr,
+                                int chunk_duration_ms = 0) {
     if (codec == AudioCodec::MP3) {
         if (mp3_ctx == nullptr || mp3_ctx->frame_size == 0) {
             throw std::invalid_argument("MP3 encoder must be initialized before calculating chunk size");
         }
-        // Use actual frame size from LAME
-        return calculate_aligned_chunk_size(sample_rate, num_channels, mp3_ctx->frame_size);
+        if (chunk_duration_ms == 0) {
+            // Use actual frame size from LAME
+            return calculate_aligned_chunk_size(sample_rate, num_channels, mp3_ctx->frame_size);
+        }
+        const double frame_ms = 1000.0 * mp3_ctx->frame_size / sample_rate;
+        if (chunk_duration_ms < frame_ms) {
+            std::ostringstream buffer;
+            buffer << "chunk_duration_ms " << chunk_duration_ms << " is shorter than one MP3 frame (" << frame_ms << "ms at "
+                   << sample_rate << "Hz)";
+            VIAM_SDK_LOG(error) << buffer.str();
+            throw std::invalid_argument(buffer.str());
+        }
+        return calculate_aligned_chunk_size(sample_rate, num_channels, mp3_ctx->frame_size, chunk_duration_ms / 1000.0);
+    } else if (codec == AudioCodec::OPUS) {
+        if (opus_ctx == nullptr || opus_ctx->frame_size == 0) {
+            throw std::invalid_argument("Opus encoder must be initialized before calculating chunk size");
+        }
+        if (chunk_duration_ms == 0) {
+            return opus_ctx->frame_size * num_channels;
+        }
+        const int frame_ms = opus_ctx->frame_size * 1000 / sample_rate;
+        if (chunk_duration_ms % frame_ms != 0) {
+            std::ostringstream buffer;
+            buffer << "chunk_duration_ms " << chunk_duration_ms << " must be a multiple of the " << frame_ms
+                   << "ms Opus packet duration (see opus_frame_ms)";
+            VIAM_SDK_LOG(error) << buffer.str();
+            throw std::invalid_argument(buffer.str());
+        }
+        return opus_ctx->frame_size * num_channels * (chunk_duration_ms / frame_ms);
     } else {
-        // PCM codecs: 100ms chunks
-        const int num_samples_per_100_ms = static_cast<int>(sample_rate * 0.1);
-        return num_samples_per_100_ms * num_channels;
+        // PCM codecs: 100ms chunks by default
+        const int duration_ms = chunk_duration_ms > 0 ? chunk_duration_ms : 100;
+        const int samples_per_channel = static_cast<int>(static_cast<int64_t>(sample_rate) * duration_ms / 1000);
+        return samples_per_channel * num_channels;
+    }
+}
+
+// Reads chunk_duration_ms from get_audio's extra; 0 when it isn't set.
+// Throws std::invalid_argument if it's not a whole number of ms in range.
+static int parse_chunk_duration_ms(const vsdk::ProtoStruct& extra) {
+    if (!extra.count("chunk_duration_ms")) {
+        return 0;
+    }
+    if (!extra.at("chunk_duration_ms").is_a<double>()) {
+        VIAM_SDK_LOG(error) << "chunk_duration_ms must be a number";
+        throw std::invalid_argument("chunk_duration_ms must be a number");
+    }
+    const double duration_ms = *extra.at("chunk_duration_ms").get<double>();
+    if (duration_ms < MIN_CHUNK_DURATION_MS || duration_ms > MAX_CHUNK_DURATION_MS || duration_ms != std::floor(duration_ms)) {
+        std::ostringstream buffer;
+        buffer << "chunk_duration_ms must be a whole number between " << MIN_CHUNK_DURATION_MS << " and " << MAX_CHUNK_DURATION_MS
+               << ", got: " << duration_ms;
+        VIAM_SDK_LOG(error) << buffer.str();
+        throw std::invalid_argument(buffer.str());
+    }
+    return static_cast<int>(duration_ms);
+}
+
+ReplayOptions parse_replay_options(const vsdk::ProtoStruct& extra) {
+    ReplayOptions options;
+    if (extra.count("replay_speed")) {
+        if (!extra.at("replay_speed").is_a<double>()) {
+            VIAM_SDK_LOG(error) << "replay_speed must be a number";
+            throw std::invalid_argument("replay_speed must be a number");
+        }
+        options.speed = *extra.at("replay_speed").get<double>();
+        if (options.speed != 0 && options.speed < 1) {
+            VIAM_SDK_LOG(error) << "replay_speed must be 0 (unlimited) or at least 1, got: " << options.speed;
+            throw std::invalid_argument("replay_speed must be 0 (unlimited) or at least 1");
+        }
+    }
+    if (extra.count("replay_chunk_ms")) {
+        if (!extra.at("replay_chunk_ms").is_a<double>()) {
+            VIAM_SDK_LOG(error) << "replay_chunk_ms must be a number";
+            throw std::invalid_argument("replay_chunk_ms must be a number");
+        }
+        const double chunk_ms = *extra.at("replay_chunk_ms").get<double>();
+        if (chunk_ms < 0 || chunk_ms > MAX_REPLAY_CHUNK_MS) {
+            std::ostringstream buffer;
+            buffer << "replay_chunk_ms must be between 0 and " << MAX_REPLAY_CHUNK_MS << ", got: " << chunk_ms;
+            VIAM_SDK_LOG(error) << buffer.str();
+            throw std::invalid_argument(buffer.str());
+        }
+        options.chunk_ms = static_cast<int>(chunk_ms);
+    }
+    return options;
+}
+
+void ReplayPacer::pace(std::chrono::nanoseconds duration) {
+    if (speed_ <= 0) {
+        return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (!started_) {
+        started_ = true;
+        start_ = now;
+        sent_ = std::chrono::nanoseconds::zero();
+    }
+    sent_ += duration;
+
+    auto due = start_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(sent_ / speed_);
+    // Credit older than MAX_CREDIT is forfeited, so a long stall doesn't buy an unbounded burst
+    const auto oldest = now - MAX_CREDIT;
+    if (due < oldest) {
+        start_ += oldest - due;
+        due = oldest;
+    }
+    if (due > now) {
+        std::this_thread::sleep_until(due);
+    }
+}
+
+// === SharedEncoder Implementation ===
+
+SharedEncoder::SharedEncoder(AudioCodec codec,
+                             std::shared_ptr<audio::InputStreamContext> stream_context,
+                             uint64_t read_position,
+                             ResampleOptions resample_options)
+    : codec(codec), resample_options(resample_options), context_(std::move(stream_context)), read_position_(read_position) {}
+
+uint64_t SharedEncoder::next_index() {
+    std::lock_guard<std::mutex> lock(chunks_mu_);
+    return first_index_ + chunks_.size();
+}
+
+uint64_t SharedEncoder::read_position() {
+    std::lock_guard<std::mutex> lock(produce_mu_);
+    return read_position_;
+}
+
+void SharedEncoder::enable_silence_gate(const audio::silence::GateOptions& options) {
+    if (!options.enabled) {
+        return;
+    }
+    gate_ = std::make_unique<audio::silence::SilenceGate>(
+        options, device_samples_per_chunk, static_cast<uint64_t>(stream_sample_rate) * num_channels);
+}
+
+std::shared_ptr<const EncodedChunk> SharedEncoder::get_chunk(uint64_t& index) {
+    // Returns the published chunk for index, or nullptr if it hasn't been produced yet.
+    // Caller must hold chunks_mu_.
+    const auto lookup = [this, &index]() -> std::shared_ptr<const EncodedChunk> {
+        if (index < first_index_) {
+            VIAM_SDK_LOG(warn) << "[get_audio] Reader fell " << (first_index_ - index)
+                               << " chunks behind the shared encoder, skipping to oldest retained chunk";
+            index = first_index_;
+        }
+        if (index < first_index_ + chunks_.size()) {
+            return chunks_[index - first_index_];
+        }
+        return nullptr;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(chunks_mu_);
+        if (auto chunk = lookup()) {
+            return chunk;
+        }
+    }
+
+    std::lock_guard<std::mutex> produce_lock(produce_mu_);
+    // Another reader may have produced this chunk while we waited for produce_mu_.
+    {
+        std::lock_guard<std::mutex> lock(chunks_mu_);
+        if (auto chunk = lookup()) {
+            return chunk;
+        }
+    }
+
+    auto chunk = produce_chunk();
+    if (!chunk) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(chunks_mu_);
+    chunks_.push_back(chunk);
+    if (chunks_.size() > MAX_RETAINED_CHUNKS) {
+        auto evicted = std::move(chunks_.front());
+        chunks_.pop_front();
+        ++first_index_;
+        // chunks_ was the only owner, and new references are only handed out from chunks_
+        // under chunks_mu_, so no reader can still be looking at it.
+        if (evicted.use_count() == 1 && free_chunks_.size() < MAX_FREE_CHUNKS) {
+            free_chunks_.push_back(std::move(evicted));
+        }
+    }
+    index = first_index_ + chunks_.size() - 1;
+    return chunk;
+}
+
+bool SharedEncoder::in_disk_tier(int sample_count) {
+    // Whole chunks only, so a chunk never stitches the two tiers together
+    if (!history || history->source() != context_) {
+        return false;
+    }
+    const uint64_t write_position = context_->get_write_position();
+    const uint64_t ring_oldest =
+        write_position > static_cast<uint64_t>(context_->buffer_capacity) ? write_position - context_->buffer_capacity : 0;
+    return read_position_ < ring_oldest && history->contains(read_position_, sample_count);
+}
+
+int SharedEncoder::read_device_samples(int16_t* buffer, int sample_count) {
+    if (in_disk_tier(sample_count)) {
+        return history->read_samples(buffer, sample_count, read_position_);
+    }
+    return context_->read_samples(buffer, sample_count, read_position_);
+}
+
+void SharedEncoder::stamp(EncodedChunk& chunk, uint64_t start_position, uint64_t end_position) const {
+    int encoder_delay = 0;
+    if (codec == AudioCodec::MP3 && mp3_ctx.encoder) {
+        encoder_delay = mp3_ctx.encoder_delay;
+    } else if (codec == AudioCodec::OPUS && opus_ctx.encoder) {
+        encoder_delay = opus_ctx.encoder_delay;
+    }
+    if (encoder_delay > 0) {
+        // Adjust for encoder delay since decoded output will be shifted
+        const uint64_t delay_samples = static_cast<uint64_t>(encoder_delay) * num_channels;
+        // Timestamps should reflect the data the encoder returned,
+        // adjust for encoder delay
+        start_position = start_position >= delay_samples ? start_position - delay_samples : 0;
+        end_position -= delay_samples;
+    }
+
+    chunk.start_timestamp_ns = context_->calculate_sample_timestamp(start_position);
+    chunk.end_timestamp_ns = context_->calculate_sample_timestamp(end_position);
+    chunk.end_position = end_position;
+}
+
+std::shared_ptr<EncodedChunk> SharedEncoder::produce_chunk() {
+    // Each pass reads one chunk; only chunks the silence gate skips go round again
+    while (true) {
+        // Wait until we have a full chunk worth of samples
+        const uint64_t available_samples = context_->get_write_position() - read_position_;
+        if (available_samples < static_cast<uint64_t>(device_samples_per_chunk)) {
+            return nullptr;
+        }
+
+        std::shared_ptr<EncodedChunk> chunk;
+        if (!free_chunks_.empty()) {
+            chunk = std::move(free_chunks_.back());
+            free_chunks_.pop_back();
+            // MP3 encoding appends, so start from empty; the capacity is what we're reusing
+            chunk->audio_data.clear();
+            chunk->gap = false;
+        } else {
+            chunk = std::make_shared<EncodedChunk>();
+        }
+
+        // The disk tier only holds int16, so a wider device buffer is only copied from the ring
+        const audio::SampleFormat format = context_->sample_format;
+        const bool copy = direct_copy && (format == audio::SampleFormat::INT16 || !in_disk_tier(device_samples_per_chunk));
+
+        // Read exactly one chunk worth of samples
+        int samples_read = 0;
+        if (copy) {
+            // The device format is already the wire format: read straight into the payload
+            chunk->audio_data.resize(device_samples_per_chunk * audio::sample_bytes(format));
+            samples_read = format == audio::SampleFormat::INT16
+                               ? read_device_samples(reinterpret_cast<int16_t*>(chunk->audio_data.data()), device_samples_per_chunk)
+                               : context_->read_native(chunk->audio_data.data(), device_samples_per_chunk, read_position_);
+        } else {
+            device_samples_.resize(device_samples_per_chunk);
+            samples_read = read_device_samples(device_samples_.data(), device_samples_per_chunk);
+        }
+
+        if (samples_read < device_samples_per_chunk) {
+            // Shouldn't happen since we checked available_samples, but to be safe
+            VIAM_SDK_LOG(warn) << "Read fewer samples than expected: " << samples_read << " vs " << device_samples_per_chunk;
+            free_chunks_.push_back(std::move(chunk));
+            return nullptr;
+        }
+        // read_samples may have skipped ahead past overwritten audio
+        const uint64_t chunk_start_position = read_position_ - samples_read;
+
+        if (gate_) {
+            // Judged on the device samples, before any resampling or encoding is spent on them
+            const double level = copy ? audio::silence::rms_dbfs(chunk->audio_data.data(), samples_read, format)
+                                      : audio::silence::rms_dbfs(device_samples_.data(), samples_read, audio::SampleFormat::INT16);
+            const auto decision = gate_->next(chunk_start_position, read_position_, level);
+            if (decision.action != audio::silence::SilenceGate::Action::ENCODE) {
+                read_position_ = decision.resume;
+                if (decision.action == audio::silence::SilenceGate::Action::SKIP) {
+                    free_chunks_.push_back(std::move(chunk));
+                    continue;
+                }
+                chunk->audio_data.clear();
+                chunk->gap = true;
+                stamp(*chunk, decision.gap_start, decision.gap_end);
+                return chunk;
+            }
+        }
+
+        if (!copy) {
+            int16_t* final_samples = device_samples_.data();
+            int final_sample_count = samples_read;
+            if (requested_sample_rate != stream_sample_rate) {
+                // Resample from device rate to requested rate
+                if (!resampler_) {
+                    resampler_ =
+                        std::make_unique<StreamingResampler>(stream_sample_rate, requested_sample_rate, num_channels, resample_options);
+                }
+                const audio::metrics::ScopedTimer timer(context_->stats->resample_us);
+                resampler_->process(device_samples_.data(), samples_read, resampled_samples_);
+                final_samples = resampled_samples_.data();
+                final_sample_count = resampled_samples_.size();
+                audio::realtime::lock_vector(resampled_samples_lock_, resampled_samples_, realtime);
+            }
+            audio::realtime::lock_vector(device_samples_lock_, device_samples_, realtime);
+
+            // Convert from int16 (the device buffer as read) to requested codec
+            const audio::metrics::ScopedTimer timer(context_->stats->codec_us);
+            audio::codec::encode_audio_chunk(
+                codec, final_samples, final_sample_count, chunk_start_position, mp3_ctx, opus_ctx, chunk->audio_data);
+        }
+
+        // Calculate timestamps based on sample position in stream
+        stamp(*chunk, chunk_start_position, chunk_start_position + samples_read);
+        return chunk;
     }
 }
 
 // === Microphone Class Implementation ===
 
+DuplexContext::DuplexContext(audio::InputStreamContext& input, audio::OutputStreamContext& output)
+    : input(input),
+      output(output),
+      capture_channels(input.info.num_channels - 1),
+      frames(DUPLEX_BLOCK_FRAMES * static_cast<size_t>(input.info.num_channels) * audio::sample_bytes(input.sample_format)) {}
+
 void Microphone::restart_stalled_stream(const std::shared_ptr<audio::InputStreamContext>& stream_context) {
     std::lock_guard<std::mutex> lock(stream_ctx_mu_);
-    // Only restart if this is still the active context — another thread may have already restarted.
+    // Only restart this microphone's own context; restarts keep it, so it never changes
     if (stream_context != audio_context_) {
         return;
     }
 
     VIAM_SDK_LOG(debug) << "[microphone stall_watcher] Restarting stalled stream";
 
-    // If device_id was configured, re-resolve before restarting in case the kernel
-    // re-enumerated and the cached device_index is stale (e.g. USB unplug/replug).
+    if (stream_) {
+        try {
+            audio::utils::abort_stream(stream_, pa_);
+        } catch (const std::exception& e) {
+            VIAM_SDK_LOG(error) << "[microphone stall_watcher] Error shutting down stalled stream: " << e.what();
+        }
+        stream_ = nullptr;
+    }
+
+    // Fast path: reopen the same device index, unless device_id shows the index now belongs
+    // to another device
+    std::string error;
+    const PaDeviceIndex tried_index = stream_params_.device_index;
+    const bool tried_fast = audio::utils::device_index_still_matches(device_id_, stream_params_, pa_);
+    if (tried_fast && reopen_stream(stream_context, error)) {
+        return;
+    }
+
+    // If device_id was configured, re-resolve in case the kernel re-enumerated and the
+    // cached device_index is stale (e.g. USB unplug/replug).
     // When the device is missing, skip the actual stream open — PortAudio would just
     // spam ALSA errors. Bump attempts so the watchdog enters backoff; once the device
     // returns, a backoff retry will resolve and proceed.
@@ -90,63 +526,161 @@ void Microphone::restart_stalled_stream(const std::shared_ptr<audio::InputStream
         }
         return;
     }
+    // Same device the fast path just failed on; no point opening it twice
+    if ((!tried_fast || stream_params_.device_index != tried_index) && reopen_stream(stream_context, error)) {
+        return;
+    }
 
-    if (stream_) {
-        try {
-            audio::utils::abort_stream(stream_, pa_);
-        } catch (const std::exception& e) {
-            VIAM_SDK_LOG(error) << "[microphone stall_watcher] Error shutting down stalled stream: " << e.what();
-        }
-        stream_ = nullptr;
+    if (restart_attempts_ < audio::utils::MAX_RESTART_ATTEMPTS) {
+        ++restart_attempts_;
     }
+    VIAM_SDK_LOG(error) << "[microphone stall_watcher] Failed to restart stream (attempt " << restart_attempts_ << "/"
+                        << audio::utils::MAX_RESTART_ATTEMPTS << "): " << error;
+}
 
-    const viam::sdk::audio_info info{viam::sdk::audio_codecs::PCM_16, stream_params_.sample_rate, stream_params_.num_channels};
-    const auto new_context = std::make_shared<audio::InputStreamContext>(info, audio::BUFFER_DURATION_SECONDS);
+bool Microphone::reopen_stream(const std::shared_ptr<audio::InputStreamContext>& stream_context, std::string& error) {
+    // The stream restarts into the same context, so the history, positions and every reader
+    // carry on; readers see a gap rather than a disconnect. Silence fills the gap, keeping
+    // positions on stream_start_time's clock, and the new stream's first callback tops it up.
+    stream_context->pad_to_clock(0);
+    stream_context->resync_pending.store(true);
+    uint64_t stalled_callback_ns = stream_context->last_callback_time_ns.load();
 
     try {
-        stream_params_.user_data = new_context.get();
+        // A duplex stream's DuplexContext already points at stream_context, the only one it has
+        stream_params_.user_data = duplex_ ? static_cast<void*>(duplex_.get()) : stream_context.get();
         audio::utils::restart_stream(stream_, stream_params_, pa_);
-        audio_context_ = new_context;
-        restart_attempts_ = 0;
-        VIAM_SDK_LOG(info) << "[microphone stall_watcher] Stream restarted successfully";
     } catch (const std::exception& e) {
-        if (restart_attempts_ < audio::utils::MAX_RESTART_ATTEMPTS) {
-            ++restart_attempts_;
+        error = e.what();
+        return false;
+    }
+    // Give the new stream's first callback the usual grace before the watchdog counts it as
+    // stalled, unless it has already run
+    stream_context->last_callback_time_ns.compare_exchange_strong(stalled_callback_ns, 0);
+    restart_attempts_ = 0;
+    stats_->restarts.add();
+    VIAM_SDK_LOG(info) << "[microphone stall_watcher] Stream restarted successfully";
+    return true;
+}
+
+std::shared_ptr<SharedEncoder> Microphone::acquire_shared_encoder(AudioCodec codec_enum,
+                                                                  const std::shared_ptr<audio::InputStreamContext>& stream_context,
+                                                                  const StageOptions& options) {
+    int requested_sample_rate = 0;
+    ResampleOptions resample_options;
+    {
+        std::lock_guard<std::mutex> lock(stream_ctx_mu_);
+        requested_sample_rate = requested_sample_rate_;
+        resample_options = resample_options_;
+    }
+
+    std::lock_guard<std::mutex> lock(shared_encoders_mu_);
+    // Drop stages whose last reader has gone.
+    for (auto it = shared_encoders_.begin(); it != shared_encoders_.end();) {
+        it = it->second.expired() ? shared_encoders_.erase(it) : std::next(it);
+    }
+
+    // Encoder settings only split MP3 stages; the other codecs ignore them.
+    StageOptions key_options = options;
+    if (codec_enum != AudioCodec::MP3) {
+        key_options.mp3 = MP3EncoderOptions{};
+    }
+    // Hangover and pre-roll mean nothing without a threshold
+    if (!key_options.silence.enabled) {
+        key_options.silence = audio::silence::GateOptions{};
+    }
+    const auto key = std::make_tuple(codec_enum, requested_sample_rate, key_options);
+    if (auto existing = shared_encoders_[key].lock()) {
+        return existing;
+    }
+
+    auto encoder = std::make_shared<SharedEncoder>(codec_enum, stream_context, stream_context->get_write_position(), resample_options);
+    encoder->realtime = realtime_;
+    setup_stream_params(codec_enum,
+                        encoder->mp3_ctx,
+                        encoder->opus_ctx,
+                        encoder->stream_sample_rate,
+                        encoder->requested_sample_rate,
+                        encoder->num_channels,
+                        encoder->historical_throttle_ms,
+                        encoder->samples_per_chunk,
+                        encoder->device_samples_per_chunk,
+                        encoder->direct_copy,
+                        options);
+    encoder->enable_silence_gate(options.silence);
+    shared_encoders_[key] = encoder;
+    return encoder;
+}
+
+bool Microphone::release_shared_encoder(const std::shared_ptr<SharedEncoder>& encoder) {
+    // Readers only join a stage through shared_encoders_ under this lock, so the count can't
+    // grow while it's held
+    std::lock_guard<std::mutex> lock(shared_encoders_mu_);
+    if (encoder.use_count() > 1) {
+        return false;
+    }
+    for (auto it = shared_encoders_.begin(); it != shared_encoders_.end(); ++it) {
+        if (it->second.lock() == encoder) {
+            shared_encoders_.erase(it);
+            break;
         }
-        VIAM_SDK_LOG(error) << "[microphone stall_watcher] Failed to restart stream (attempt " << restart_attempts_ << "/"
-                            << audio::utils::MAX_RESTART_ATTEMPTS << "): " << e.what();
     }
+    return true;
 }
 
 void Microphone::setup_stream_params(AudioCodec codec_enum,
                                      MP3EncoderContext& mp3_ctx,
+                                     OpusEncoderContext& opus_ctx,
                                      int& stream_sample_rate,
                                      int& requested_sample_rate,
                                      int& stream_num_channels,
                                      int& stream_historical_throttle_ms,
                                      int& samples_per_chunk,
-                                     int& device_samples_per_chunk) {
+                                     int& device_samples_per_chunk,
+                                     bool& direct_copy,
+                                     const StageOptions& options) {
     // Get current stream parameters
+    int opus_frame_ms = 0;
+    audio::SampleFormat sample_format = audio::SampleFormat::INT16;
     {
         std::lock_guard<std::mutex> lock(stream_ctx_mu_);
         stream_sample_rate = stream_params_.sample_rate;
+        sample_format = stream_params_.sample_format;
         requested_sample_rate = requested_sample_rate_;
-        stream_num_channels = stream_params_.num_channels;
+        // The buffer's frames, which include a duplex stream's reference channel
+        stream_num_channels = audio_context_->info.num_channels;
         stream_historical_throttle_ms = historical_throttle_ms_;
+        opus_frame_ms = opus_frame_ms_;
     }
 
     if (codec_enum == AudioCodec::MP3) {
-        initialize_mp3_encoder(mp3_ctx, requested_sample_rate, stream_num_channels);
+        initialize_mp3_encoder(mp3_ctx, requested_sample_rate, stream_num_channels, options.mp3);
+    } else if (codec_enum == AudioCodec::OPUS) {
+        // Opus only runs at a few rates; anything else (e.g. 44.1 kHz) is resampled to 48 kHz
+        if (!audio::codec::is_opus_sample_rate(requested_sample_rate)) {
+            VIAM_SDK_LOG(debug) << "Opus does not support " << requested_sample_rate << "Hz, encoding at 48000Hz";
+            requested_sample_rate = 48000;
+        }
+        initialize_opus_encoder(opus_ctx, requested_sample_rate, stream_num_channels, opus_frame_ms);
     }
 
     // Calculate chunk size based on codec
-    samples_per_chunk = calculate_chunk_size(codec_enum, requested_sample_rate, stream_num_channels, &mp3_ctx);
+    samples_per_chunk =
+        calculate_chunk_size(codec_enum, requested_sample_rate, stream_num_channels, &mp3_ctx, &opus_ctx, options.chunk_duration_ms);
+
+    // The device buffer's own format at the device rate needs no conversion at all, so chunks
+    // can be read from the device buffer directly into their payload
+    direct_copy = codec_enum == pcm_codec_for(sample_format) && stream_sample_rate == requested_sample_rate;
 
     // Calculate how many samples to read from device buffer
     device_samples_per_chunk = samples_per_chunk;
     if (stream_sample_rate != requested_sample_rate) {
-        // Adjust read size to account for resampling
-        device_samples_per_chunk = std::lround(samples_per_chunk * stream_sample_rate / requested_sample_rate);
+        // Adjust read size to account for resampling. Rounded per channel so a chunk always
+        // ends on a frame boundary.
+        const int frames_per_chunk = samples_per_chunk / stream_num_channels;
+        device_samples_per_chunk =
+            static_cast<int>(std::lround(static_cast<double>(frames_per_chunk) * stream_sample_rate / requested_sample_rate)) *
+            stream_num_channels;
     }
 
     // Validate chunk size
@@ -172,19 +706,84 @@ Microphone::Microphone(viam::sdk::Dependencies deps, viam::sdk::ResourceConfig c
     }
 #endif
 
-    auto setup = audio::utils::setup_audio_device<audio::InputStreamContext>(cfg, audio::utils::StreamDirection::Input, AudioCallback, pa_);
+    const auto attrs = cfg.attributes();
+    std::string duplex_speaker_name;
+    if (attrs.count("duplex_speaker") && attrs.at("duplex_speaker").is_a<std::string>()) {
+        duplex_speaker_name = *attrs.at("duplex_speaker").get<std::string>();
+    }
+
+    // A duplex buffer has room for the reference channel after the captured ones
+    auto setup = audio::utils::setup_audio_device<audio::InputStreamContext>(cfg,
+                                                                             audio::utils::StreamDirection::Input,
+                                                                             select_audio_callback,
+                                                                             pa_,
+                                                                             audio::BUFFER_DURATION_SECONDS,
+                                                                             duplex_speaker_name.empty() ? 0 : 1);
+
+    // Before the stream starts, since the ring moves into the mapping
+    if (attrs.count("shared_memory") && attrs.at("shared_memory").is_a<bool>() && *attrs.at("shared_memory").get<bool>()) {
+        setup.audio_context->shared_ring =
+            std::make_unique<audio::shm::SharedRing>(audio::shm::ring_name(cfg.name()), *setup.audio_context);
+        setup.audio_context->lock_ring(setup.realtime);
+    }
+
+    if (!duplex_speaker_name.empty()) {
+        duplex_speaker_ = find_duplex_speaker(deps, duplex_speaker_name);
+        const speaker::DuplexOutput output = duplex_speaker_->attach_duplex();
+        // One stream has one rate, and neither side resamples in the callback
+        if (output.sample_rate != setup.stream_params.sample_rate) {
+            duplex_speaker_->detach_duplex();
+            std::ostringstream buffer;
+            buffer << "duplex_speaker " << duplex_speaker_name << " plays at " << output.sample_rate << " Hz but the microphone captures at "
+                   << setup.stream_params.sample_rate << " Hz; configure the same sample_rate on both";
+            VIAM_SDK_LOG(error) << buffer.str();
+            throw std::invalid_argument(buffer.str());
+        }
+        setup.stream_params.output_device_index = output.device_index;
+        setup.stream_params.output_num_channels = output.num_channels;
+        setup.stream_params.output_latency_seconds = output.latency_seconds;
+        setup.stream_params.callback = DuplexCallback;
+        duplex_ = std::make_unique<DuplexContext>(*setup.audio_context, *output.context);
+    }
 
     // Set new configuration and start stream under lock
     {
         std::lock_guard<std::mutex> lock(stream_ctx_mu_);
         stream_params_ = setup.stream_params;
-        stream_params_.user_data = setup.audio_context.get();
+        stream_params_.user_data = duplex_ ? static_cast<void*>(duplex_.get()) : setup.audio_context.get();
         device_id_ = setup.config_params.device_id;
-        audio::utils::restart_stream(stream_, stream_params_, pa_);
+        try {
+            audio::utils::restart_stream(stream_, stream_params_, pa_);
+        } catch (...) {
+            // The destructor won't run, so give the speaker its stream back here
+            if (duplex_speaker_) {
+                duplex_speaker_->detach_duplex();
+            }
+            throw;
+        }
         audio_context_ = setup.audio_context;
+        stats_ = audio_context_->stats;
+        realtime_ = setup.realtime;
         requested_sample_rate_ =
             setup.config_params.sample_rate.value_or(setup.stream_params.sample_rate);  // User's requested rate, defaults to device rate
         historical_throttle_ms_ = setup.config_params.historical_throttle_ms.value_or(DEFAULT_HISTORICAL_THROTTLE_MS);
+        resample_options_ = setup.config_params.resample_options;
+        mp3_options_ = parse_mp3_options(cfg.attributes());
+        silence_options_ = audio::silence::parse_gate_options(cfg.attributes());
+        opus_frame_ms_ = parse_opus_frame_ms(cfg.attributes());
+
+        if (attrs.count("disk_history_seconds") && attrs.at("disk_history_seconds").is_a<double>()) {
+            disk_history_seconds_ = static_cast<int>(*attrs.at("disk_history_seconds").get<double>());
+        }
+        if (attrs.count("disk_history_path") && attrs.at("disk_history_path").is_a<std::string>()) {
+            disk_history_path_ = *attrs.at("disk_history_path").get<std::string>();
+        } else {
+            // Module data persists across restarts and is on real storage, unlike a tmpfs /tmp
+            const char* data_dir = std::getenv("VIAM_MODULE_DATA");
+            const std::filesystem::path dir = data_dir ? std::filesystem::path(data_dir) : std::filesystem::temp_directory_path();
+            disk_history_path_ = (dir / (cfg.name() + ".history")).string();
+        }
+        start_disk_history();
     }
 
     watchdog_ = std::make_unique<audio::utils::StallWatchdog<audio::InputStreamContext>>(
@@ -198,13 +797,17 @@ Microphone::Microphone(viam::sdk::Dependencies deps, viam::sdk::ResourceConfig c
         },
         [this](const std::shared_ptr<audio::InputStreamContext>& ctx) { restart_stalled_stream(ctx); },
         "[microphone stall_watcher]");
-    watchdog_->start();
+    watchdog_->start([this]() { audio::realtime::apply_to_current_thread(realtime_); });
+    hotplug_ = std::make_unique<audio::hotplug::HotplugMonitor>([this]() { watchdog_->notify_device_change(); });
+    watchdog_->set_hotplug_active(hotplug_->active());
 }
 
 Microphone::~Microphone() {
     VIAM_SDK_LOG(debug) << "[Microphone::~Microphone] Destructor called";
     // Stop and join the watchdog before tearing down the stream so it can't touch a
-    // half-destroyed audio_context_.
+    // half-destroyed audio_context_. The hotplug monitor goes first, since it calls into the
+    // watchdog.
+    hotplug_.reset();
     if (watchdog_) {
         watchdog_->stop();
     }
@@ -219,6 +822,10 @@ Microphone::~Microphone() {
             VIAM_SDK_LOG(error) << "Failed to close stream in destructor: " << Pa_GetErrorText(err);
         }
     }
+    // The duplex stream is closed, so the speaker can play from its own again
+    if (duplex_speaker_) {
+        duplex_speaker_->detach_duplex();
+    }
 }
 
 vsdk::Model Microphone::model("viam", "system-audio", "microphone");
@@ -286,20 +893,155 @@ std::vector<std::string> Microphone::validate(viam::sdk::ResourceConfig cfg) {
             throw std::invalid_argument("historical_throttle_ms must be non-negative");
         }
     }
+
+    audio::utils::validate_resample_attributes(attrs);
+    audio::utils::validate_buffer_seconds(attrs);
+    audio::utils::validate_callback_timing(attrs);
+    audio::utils::validate_sample_format(attrs);
+    audio::realtime::parse_realtime_options(attrs);
+
+    if (attrs.count("shared_memory") && !attrs["shared_memory"].is_a<bool>()) {
+        VIAM_SDK_LOG(error) << "[validate] shared_memory attribute must be a boolean";
+        throw std::invalid_argument("shared_memory attribute must be a boolean");
+    }
+
+    if (attrs.count("disk_history_seconds")) {
+        if (!attrs["disk_history_seconds"].is_a<double>()) {
+            VIAM_SDK_LOG(error) << "[validate] disk_history_seconds attribute must be a number";
+            throw std::invalid_argument("disk_history_seconds attribute must be a number");
+        }
+        const double seconds = *attrs.at("disk_history_seconds").get<double>();
+        if (seconds < 0 || seconds > MAX_DISK_HISTORY_SECONDS || seconds != std::floor(seconds)) {
+            std::ostringstream buffer;
+            buffer << "disk_history_seconds must be a whole number between 0 and " << MAX_DISK_HISTORY_SECONDS << ", got: " << seconds;
+            VIAM_SDK_LOG(error) << "[validate] " << buffer.str();
+            throw std::invalid_argument(buffer.str());
+        }
+    }
+    if (attrs.count("disk_history_path") && !attrs["disk_history_path"].is_a<std::string>()) {
+        VIAM_SDK_LOG(error) << "[validate] disk_history_path attribute must be a string";
+        throw std::invalid_argument("disk_history_path attribute must be a string");
+    }
+
+    parse_mp3_options(attrs);
+    parse_opus_frame_ms(attrs);
+    audio::silence::parse_gate_options(attrs);
+
+    // The duplex speaker is a dependency, so it's built first and handed to the constructor
+    if (attrs.count("duplex_speaker")) {
+        const auto* speaker_name = attrs.at("duplex_speaker").get<std::string>();
+        if (!speaker_name || speaker_name->empty()) {
+            VIAM_SDK_LOG(error) << "[validate] duplex_speaker attribute must be the name of a speaker";
+            throw std::invalid_argument("duplex_speaker attribute must be the name of a speaker");
+        }
+        return {*speaker_name};
+    }
     return {};
 }
 
+void Microphone::start_disk_history() {
+    // Release the file before a new history truncates it
+    disk_history_.reset();
+    if (disk_history_seconds_ <= 0) {
+        return;
+    }
+    try {
+        disk_history_ = std::make_shared<audio::DiskHistory>(audio_context_, disk_history_path_, disk_history_seconds_);
+    } catch (const std::exception& e) {
+        VIAM_SDK_LOG(error) << "Disk history disabled: " << e.what();
+    }
+}
+
 viam::sdk::ProtoStruct Microphone::do_command(const viam::sdk::ProtoStruct& command) {
+    if (command.count("get_resample_settings")) {
+        std::lock_guard<std::mutex> lock(stream_ctx_mu_);
+        return audio::utils::resample_settings_struct(resample_options_);
+    }
+
+    if (command.count("get_buffer_settings")) {
+        std::lock_guard<std::mutex> lock(stream_ctx_mu_);
+        return audio::utils::buffer_settings_struct(*audio_context_);
+    }
+
+    if (command.count("get_mp3_settings")) {
+        std::lock_guard<std::mutex> lock(stream_ctx_mu_);
+        return mp3_settings_struct(mp3_options_);
+    }
+
+    if (command.count("get_stats")) {
+        return stats_struct(audio::metrics::parse_stats_reset(command.at("get_stats")));
+    }
+
+    if (command.count("get_levels")) {
+        const std::vector<int> windows = parse_level_windows(command.at("get_levels"));
+        std::shared_ptr<audio::InputStreamContext> context;
+        {
+            std::lock_guard<std::mutex> lock(stream_ctx_mu_);
+            context = audio_context_;
+        }
+        return levels_struct(context->levels, windows);
+    }
+
+    if (command.count("get_shared_memory")) {
+        std::shared_ptr<audio::InputStreamContext> context;
+        {
+            std::lock_guard<std::mutex> lock(stream_ctx_mu_);
+            context = audio_context_;
+        }
+        return shared_memory_struct(context->shared_ring.get());
+    }
+
     VIAM_SDK_LOG(error) << "do_command not implemented";
     return viam::sdk::ProtoStruct();
 }
 
+viam::sdk::ProtoStruct Microphone::get_status() {
+    return stats_struct(false);
+}
+
+viam::sdk::ProtoStruct Microphone::stats_struct(bool reset) {
+    viam::sdk::ProtoStruct stats = stats_->to_struct(reset);
+    {
+        std::lock_guard<std::mutex> lock(stream_ctx_mu_);
+        // The stream context outlives stall restarts, so the overflow/underflow counts cover the
+        // resource's lifetime and aren't zeroed here
+        stats["input_overflows"] = static_cast<double>(audio_context_->input_overflow_count.load());
+        stats["input_underflows"] = static_cast<double>(audio_context_->input_underflow_count.load());
+        if (audio_context_->callback_timing) {
+            stats["callback_timing"] = audio_context_->callback_timing->to_struct(reset);
+        }
+    }
+    if (realtime_ && realtime_->options.enabled()) {
+        stats["realtime"] = realtime_->to_struct();
+    }
+
+    viam::sdk::ProtoList clients;
+    std::lock_guard<std::mutex> lock(clients_mu_);
+    for (auto it = clients_.begin(); it != clients_.end();) {
+        const auto client = it->second.lock();
+        if (!client) {
+            it = clients_.erase(it);
+            continue;
+        }
+        clients.push_back(viam::sdk::ProtoStruct{{"id", static_cast<double>(it->first)},
+                                                 {"codec", client->codec},
+                                                 {"historical", client->historical},
+                                                 {"chunks", static_cast<double>(client->chunks.read(reset))},
+                                                 {"bytes", static_cast<double>(client->bytes.read(reset))}});
+        ++it;
+    }
+    stats["clients"] = std::move(clients);
+    return stats;
+}
+
 void Microphone::get_audio(std::string const& codec,
                            std::function<bool(vsdk::AudioIn::audio_chunk&& chunk)> const& chunk_handler,
                            double const& duration_seconds,
                            int64_t const& previous_timestamp,
                            const viam::sdk::ProtoStruct& extra) {
     VIAM_SDK_LOG(debug) << "get_audio called";
+    // This is a borrowed gRPC thread, so its scheduling is put back when the call returns
+    const audio::realtime::ScopedThreadSettings thread_settings(realtime_);
 
     // Parse codec string to enum
     const AudioCodec codec_enum = audio::codec::parse_codec(codec);
@@ -310,9 +1052,7 @@ void Microphone::get_audio(std::string const& codec,
 
     uint64_t sequence = 0;
 
-    // Track which context we're reading from to detect any device config changes
     std::shared_ptr<audio::InputStreamContext> stream_context;
-    uint64_t read_position = 0;
 
     {
         std::lock_guard<std::mutex> lock(stream_ctx_mu_);
@@ -323,59 +1063,83 @@ void Microphone::get_audio(std::string const& codec,
         stream_context = audio_context_;
     }
 
-    // Initialize read position based on timestamp param
-    read_position = get_initial_read_position(stream_context, previous_timestamp);
-
-    // Get sample rate and channels - will be updated if context changes
-    int stream_sample_rate = 0;  // Device's native sample rate
-    int stream_num_channels = 0;
-    int stream_historical_throttle_ms = 0;
-    int requested_sample_rate = 0;
-    int samples_per_chunk = 0;
-    int device_samples_per_chunk = 0;
-
-    MP3EncoderContext mp3_ctx;
-    uint64_t last_chunk_end_position;
-    uint64_t last_logged_overflow_count = 0;
-    uint64_t last_logged_underflow_count = 0;
-    uint64_t last_staleness_log_ns = 0;
-
-    // Setup initial stream parameters and initialize encoder
-    setup_stream_params(codec_enum,
-                        mp3_ctx,
-                        stream_sample_rate,
-                        requested_sample_rate,
-                        stream_num_channels,
-                        stream_historical_throttle_ms,
-                        samples_per_chunk,
-                        device_samples_per_chunk);
+    // chunk_duration_ms, and for MP3 the mp3_* keys, in extra override the defaults for this call
+    StageOptions stage_options;
+    stage_options.chunk_duration_ms = parse_chunk_duration_ms(extra);
+    const ReplayOptions replay = parse_replay_options(extra);
+    ReplayPacer pacer(replay.speed);
+    {
+        std::lock_guard<std::mutex> lock(stream_ctx_mu_);
+        stage_options.silence = silence_options_;
+    }
+    stage_options.silence = audio::silence::parse_gate_options(extra, stage_options.silence);
+    if (codec_enum == AudioCodec::MP3) {
+        MP3EncoderOptions configured;
+        {
+            std::lock_guard<std::mutex> lock(stream_ctx_mu_);
+            configured = mp3_options_;
+        }
+        stage_options.mp3 = parse_mp3_options(extra, configured);
+    }
 
-    while (true) {
-        PaStream* current_stream = nullptr;
+    // Live readers share one resample+encode pass per (codec, sample rate, options). Historical
+    // readers start at their own position, so they get a private stage.
+    const bool shared = previous_timestamp == 0;
+    std::shared_ptr<SharedEncoder> encoder;
+    if (shared) {
+        encoder = acquire_shared_encoder(codec_enum, stream_context, stage_options);
+    } else {
+        ResampleOptions resample_options;
+        std::shared_ptr<audio::DiskHistory> history;
         {
             std::lock_guard<std::mutex> lock(stream_ctx_mu_);
+            resample_options = resample_options_;
+            history = disk_history_;
+        }
+        // Initialize read position based on timestamp param
+        const uint64_t read_position = get_initial_read_position(stream_context, previous_timestamp, history.get());
+        encoder = std::make_shared<SharedEncoder>(codec_enum, stream_context, read_position, resample_options);
+        encoder->history = std::move(history);
+        encoder->realtime = realtime_;
+        setup_stream_params(codec_enum,
+                            encoder->mp3_ctx,
+                            encoder->opus_ctx,
+                            encoder->stream_sample_rate,
+                            encoder->requested_sample_rate,
+                            encoder->num_channels,
+                            encoder->historical_throttle_ms,
+                            encoder->samples_per_chunk,
+                            encoder->device_samples_per_chunk,
+                            encoder->direct_copy,
+                            stage_options);
+        encoder->enable_silence_gate(stage_options.silence);
+    }
+    uint64_t chunk_index = encoder->next_index();
 
-            // The watchdog may have restarted a stalled stream, which swaps in a
-            // fresh audio_context_ (same format, fresh circular buffer). Skip any
-            // stale data from the old buffer and reset diagnostic counters.
-            if (audio_context_ != stream_context) {
-                VIAM_SDK_LOG(info) << "Detected stream change";
-                stream_context = audio_context_;
-                read_position = stream_context->get_write_position();
-                restart_attempts_ = 0;
-                last_logged_overflow_count = 0;
-                last_logged_underflow_count = 0;
-                last_staleness_log_ns = 0;
-            }
-            current_stream = stream_;
+    const auto client = std::make_shared<ClientStats>();
+    client->codec = codec;
+    client->historical = !shared;
+    {
+        std::lock_guard<std::mutex> lock(clients_mu_);
+        for (auto it = clients_.begin(); it != clients_.end();) {
+            it = it->second.expired() ? clients_.erase(it) : std::next(it);
         }
+        clients_[next_client_id_++] = client;
+    }
+
+    // Payload vector handed to chunk_handler each iteration and taken back afterwards, so
+    // its capacity is reused unless the handler moved the data out.
+    std::vector<uint8_t> payload;
+
+    uint64_t last_chunk_end_position = 0;
+    uint64_t last_logged_overflow_count = 0;
+    uint64_t last_logged_underflow_count = 0;
 
-        // Check if we have enough samples for a full chunk
-        const uint64_t write_pos = stream_context->get_write_position();
-        const uint64_t available_samples = write_pos - read_position;
+    while (true) {
+        const auto encoded = encoder->get_chunk(chunk_index);
 
         // Wait until we have a full chunk worth of samples
-        if (available_samples < device_samples_per_chunk) {
+        if (!encoded) {
             const uint64_t overflow_count = stream_context->input_overflow_count.load();
             if (overflow_count != last_logged_overflow_count) {
                 VIAM_SDK_LOG(warn) << "[get_audio] Input overflow detected — " << (overflow_count - last_logged_overflow_count)
@@ -390,62 +1154,25 @@ void Microphone::get_audio(std::string const& codec,
                 last_logged_underflow_count = underflow_count;
             }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            continue;
-        }
-
-        std::vector<int16_t> temp_buffer(device_samples_per_chunk);
-        uint64_t chunk_start_position = read_position;
-        // Read exactly one chunk worth of samples
-        const int samples_read = stream_context->read_samples(temp_buffer.data(), device_samples_per_chunk, read_position);
-
-        if (samples_read < device_samples_per_chunk) {
-            // Shouldn't happen since we checked available_samples, but to be safe
-            VIAM_SDK_LOG(warn) << "Read fewer samples than expected: " << samples_read << " vs " << device_samples_per_chunk;
+            // Sleep until the callback has written enough for the encoder's next chunk
+            stream_context->wait_for_write_position(encoder->read_position() + encoder->device_samples_per_chunk,
+                                                    audio::MAX_WAIT_SLICE);
             continue;
         }
-
-        std::vector<int16_t> final_buffer;
-        int final_sample_count;
-        if (requested_sample_rate != stream_sample_rate) {
-            // Resample from device rate to requested rate
-            resample_audio(stream_sample_rate, requested_sample_rate, stream_num_channels, temp_buffer.data(), samples_read, final_buffer);
-            final_sample_count = final_buffer.size();
-        } else {
-            final_buffer = std::move(temp_buffer);
-            final_sample_count = samples_read;
-        }
+        ++chunk_index;
 
         vsdk::AudioIn::audio_chunk chunk;
-
-        // Convert from int16 (captured format) to requested codec
-        audio::codec::encode_audio_chunk(
-            codec_enum, final_buffer.data(), final_sample_count, chunk_start_position, mp3_ctx, chunk.audio_data);
-
+        // The SDK hands each handler its own vector, so copy out of the shared chunk.
+        chunk.audio_data = std::move(payload);
+        chunk.audio_data.assign(encoded->audio_data.begin(), encoded->audio_data.end());
         chunk.info.codec = codec;
-        chunk.info.sample_rate_hz = requested_sample_rate;
-        chunk.info.num_channels = stream_num_channels;
+        chunk.info.sample_rate_hz = encoder->requested_sample_rate;
+        chunk.info.num_channels = encoder->num_channels;
         chunk.sequence_number = sequence++;
+        chunk.start_timestamp_ns = encoded->start_timestamp_ns;
+        chunk.end_timestamp_ns = encoded->end_timestamp_ns;
 
-        // Calculate timestamps based on sample position in stream
-        uint64_t chunk_end_position = chunk_start_position + samples_read;
-        if (codec_enum == AudioCodec::MP3 && mp3_ctx.encoder) {
-            // Aadjust for encoder delay since decoded output will be shifted
-            const int delay_samples = mp3_ctx.encoder_delay * stream_num_channels;
-            // Timestamps should reflect the data the encoder returned,
-            // adjust for encoder delay
-            if (chunk_start_position >= delay_samples) {
-                chunk_start_position -= delay_samples;
-            } else {
-                chunk_start_position = 0;
-            }
-            chunk_end_position -= delay_samples;
-        }
-
-        chunk.start_timestamp_ns = stream_context->calculate_sample_timestamp(chunk_start_position);
-        chunk.end_timestamp_ns = stream_context->calculate_sample_timestamp(chunk_end_position);
-
-        last_chunk_end_position = chunk_end_position;
+        last_chunk_end_position = encoded->end_position;
 
         // Set audio duration limit after first chunk (save the starting timestamp)
         if (!duration_limit_set && duration_seconds > 0) {
@@ -455,6 +1182,42 @@ void Microphone::get_audio(std::string const& codec,
                                 << first_chunk_start_timestamp_ns;
         }
 
+        // A historical read well behind the write position is catching up: it's replayed as
+        // fast as the consumer and replay_speed allow, optionally in coalesced chunks. Within
+        // REPLAY_CATCH_UP_MS it drops back to delivering each chunk as it's captured.
+        const uint64_t catch_up_samples =
+            static_cast<uint64_t>(encoder->stream_sample_rate) * encoder->num_channels * REPLAY_CATCH_UP_MS / 1000;
+        const bool catching_up = !shared && stream_context->get_write_position() - encoder->read_position() > catch_up_samples;
+
+        // Encoded chunks concatenate cleanly for every codec (PCM samples, MP3 frames,
+        // length-prefixed Opus packets), so coalescing just appends the chunks that follow.
+        // Gaps are never merged with audio, or the silence would vanish from the timeline.
+        if (catching_up && replay.chunk_ms > 0 && !encoded->gap) {
+            const int64_t coalesce_ns = static_cast<int64_t>(replay.chunk_ms) * 1'000'000;
+            const int64_t duration_limit_ns = static_cast<int64_t>(duration_seconds * 1e9);
+            while ((chunk.end_timestamp_ns - chunk.start_timestamp_ns).count() < coalesce_ns) {
+                if (duration_limit_set && chunk.end_timestamp_ns.count() - first_chunk_start_timestamp_ns >= duration_limit_ns) {
+                    break;
+                }
+                const auto next = encoder->get_chunk(chunk_index);
+                if (!next || next->gap) {
+                    break;
+                }
+                ++chunk_index;
+                chunk.audio_data.insert(chunk.audio_data.end(), next->audio_data.begin(), next->audio_data.end());
+                chunk.end_timestamp_ns = next->end_timestamp_ns;
+                last_chunk_end_position = next->end_position;
+            }
+        }
+        const std::chrono::nanoseconds chunk_duration = chunk.end_timestamp_ns - chunk.start_timestamp_ns;
+
+        const uint64_t write_position = stream_context->get_write_position();
+        const uint64_t samples_behind = write_position - std::min(write_position, last_chunk_end_position);
+        stats_->queued_ms.record(samples_behind * 1000 / (static_cast<uint64_t>(encoder->stream_sample_rate) * encoder->num_channels));
+        stats_->chunks.add();
+        client->chunks.add();
+        client->bytes.add(chunk.audio_data.size());
+
         // Check if we've read enough audio (only if duration limit is set)
         if (duration_limit_set) {
             const int64_t time_elapsed_ns = chunk.end_timestamp_ns.count() - first_chunk_start_timestamp_ns;
@@ -474,42 +1237,44 @@ void Microphone::get_audio(std::string const& codec,
             VIAM_RESOURCE_LOG(info) << "Chunk handler returned false, client disconnected";
             return;
         }
-
-        // Check if we're reading historical data (far behind write position)
-        if (previous_timestamp != 0) {
-            const uint64_t current_write_pos = stream_context->get_write_position();
-            const uint64_t distance_behind = current_write_pos - read_position;
-            // If we're more than 1 second behind, we're reading historical data
-            const uint64_t one_second_samples = stream_sample_rate * stream_num_channels;
-            if (distance_behind > one_second_samples) {
-                // Throttle historical data to give clients time to process
-                std::this_thread::sleep_for(std::chrono::milliseconds(stream_historical_throttle_ms));
+        // The handler takes an rvalue but may only have copied the bytes (as the gRPC
+        // server does when serializing); if so, keep the buffer for the next chunk.
+        payload = std::move(chunk.audio_data);
+        payload.clear();
+
+        if (catching_up) {
+            pacer.pace(chunk_duration);
+            if (encoder->historical_throttle_ms > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(encoder->historical_throttle_ms));
             }
+        } else {
+            pacer.reset();
         }
     }
 
     // Flush MP3 encoder at end of the stream to ensure all recorded audio
-    // is returned
-    if (codec_enum == AudioCodec::MP3 && mp3_ctx.encoder) {
+    // is returned. A shared stage is flushed by its last reader; one that other
+    // readers are still using keeps running, so a reader leaving it gets no tail.
+    if (codec_enum == AudioCodec::MP3 && encoder->mp3_ctx.encoder && (!shared || release_shared_encoder(encoder))) {
         std::vector<uint8_t> final_data;
-        flush_mp3_encoder(mp3_ctx, final_data);
+        flush_mp3_encoder(encoder->mp3_ctx, final_data);
 
         if (!final_data.empty()) {
             const size_t final_data_size = final_data.size();
             vsdk::AudioIn::audio_chunk final_chunk;
             final_chunk.audio_data = std::move(final_data);
             final_chunk.info.codec = codec;
-            final_chunk.info.sample_rate_hz = requested_sample_rate;
-            final_chunk.info.num_channels = stream_num_channels;
+            final_chunk.info.sample_rate_hz = encoder->requested_sample_rate;
+            final_chunk.info.num_channels = encoder->num_channels;
             final_chunk.sequence_number = sequence++;
 
             // Since our chunk sizes are aligned with the frame size,
             // there will be delay_samples flushed from the encoder buffer
-            const int delay_samples = mp3_ctx.encoder_delay * stream_num_channels;
+            const int delay_samples = encoder->mp3_ctx.encoder_delay * encoder->num_channels;
             const uint64_t timestamp_start = last_chunk_end_position;
             const uint64_t timestamp_end = last_chunk_end_position + delay_samples;
 
-            VIAM_SDK_LOG(debug) << "Flush: last_chunk_end=" << last_chunk_end_position << " encoder_delay=" << mp3_ctx.encoder_delay
+            VIAM_SDK_LOG(debug) << "Flush: last_chunk_end=" << last_chunk_end_position << " encoder_delay=" << encoder->mp3_ctx.encoder_delay
                                 << " samples (" << delay_samples << " total)"
                                 << " timestamp_start=" << timestamp_start << " timestamp_end=" << timestamp_end
                                 << " flush_duration_samples=" << (timestamp_end - timestamp_start);
@@ -528,11 +1293,14 @@ void Microphone::get_audio(std::string const& codec,
 viam::sdk::audio_properties Microphone::get_properties(const viam::sdk::ProtoStruct& extra) {
     viam::sdk::audio_properties props;
 
-    props.supported_codecs = {
-        vsdk::audio_codecs::PCM_16, vsdk::audio_codecs::PCM_32, vsdk::audio_codecs::PCM_32_FLOAT, vsdk::audio_codecs::MP3};
+    props.supported_codecs = {vsdk::audio_codecs::PCM_16,
+                              vsdk::audio_codecs::PCM_32,
+                              vsdk::audio_codecs::PCM_32_FLOAT,
+                              vsdk::audio_codecs::MP3,
+                              audio::codec::OPUS_CODEC_NAME};
     std::lock_guard<std::mutex> lock(stream_ctx_mu_);
     props.sample_rate_hz = requested_sample_rate_;  // Return requested rate (what user will actually receive)
-    props.num_channels = stream_params_.num_channels;
+    props.num_channels = audio_context_->info.num_channels;
 
     return props;
 }
@@ -541,7 +1309,9 @@ std::vector<viam::sdk::GeometryConfig> Microphone::get_geometries(const viam::sd
     throw std::runtime_error("get_geometries is unimplemented");
 }
 
-uint64_t get_initial_read_position(const std::shared_ptr<audio::InputStreamContext>& stream_context, int64_t previous_timestamp) {
+uint64_t get_initial_read_position(const std::shared_ptr<audio::InputStreamContext>& stream_context,
+                                   int64_t previous_timestamp,
+                                   const audio::DiskHistory* history) {
     if (!stream_context) {
         throw std::invalid_argument("stream_context is null");
     }
@@ -587,11 +1357,17 @@ uint64_t get_initial_read_position(const std::shared_ptr<audio::InputStreamConte
         throw std::invalid_argument(buffer.str());
     }
 
-    // Validate timestamp is not too old (audio has been overwritten)
-    if (current_write_pos > read_position + stream_context->buffer_capacity) {
+    // Validate timestamp is not too old (audio has been overwritten, and isn't on disk either)
+    const bool on_disk = history && history->source() == stream_context && read_position >= history->oldest_position();
+    if (current_write_pos > read_position + stream_context->buffer_capacity && !on_disk) {
         std::ostringstream buffer;
         buffer << "requested timestamp is too old - audio has been overwritten. "
-               << "Buffer only holds " << audio::BUFFER_DURATION_SECONDS << " seconds of audio history.";
+               << "Buffer only holds " << stream_context->buffer_duration_seconds << " seconds of audio history";
+        if (history) {
+            buffer << " in memory and " << (history->capacity / (stream_context->info.sample_rate_hz * stream_context->info.num_channels))
+                   << " on disk";
+        }
+        buffer << ".";
         VIAM_SDK_LOG(error) << buffer.str();
         throw std::invalid_argument(buffer.str());
     }
@@ -622,6 +1398,8 @@ PaDeviceIndex findDeviceByName(const std::string& name, const audio::portaudio::
     return paNoDevice;
 }
 
+namespace {
+
 /**
  * PortAudio callback function - runs on real-time audio thread.
  *  This function must not:
@@ -630,57 +1408,211 @@ PaDeviceIndex findDeviceByName(const std::string& name, const audio::portaudio::
  * - Call any functions that may block
  * - Take unpredictable amounts of time to complete
  *
+ * The bookkeeping every capture callback does around its copy: the callback clock, xrun
+ * counts, the stream clock anchor and restart resync, then the callback stats. copy() writes
+ * the block into the ring; it isn't called when PortAudio passes no input.
  */
+template <typename Copy>
+int run_capture(audio::InputStreamContext& ctx,
+                unsigned long framesPerBuffer,
+                const PaStreamCallbackTimeInfo* timeInfo,
+                PaStreamCallbackFlags statusFlags,
+                bool has_input,
+                Copy&& copy) {
+    const uint64_t start_ns = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    const uint64_t previous_ns = ctx.last_callback_time_ns.exchange(start_ns);
+
+    if (statusFlags & paInputOverflow) {
+        ctx.input_overflow_count.fetch_add(1);
+    }
+    if (statusFlags & paInputUnderflow) {
+        ctx.input_underflow_count.fetch_add(1);
+    }
+
+    if (!has_input) {
+        return paContinue;
+    }
+
+    // First callback: establish anchor between PortAudio time and wall-clock time
+    if (!ctx.first_callback_captured.load()) {
+        // the inputBufferADCTime describes the time when the
+        // first sample of the input buffer was captured,
+        // synced with the clock of the device
+        ctx.first_sample_adc_time = timeInfo->inputBufferAdcTime;
+        ctx.stream_start_time = std::chrono::system_clock::now();
+        if (ctx.shared_cursor) {
+            ctx.shared_cursor->stream_start_ns.store(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(ctx.stream_start_time.time_since_epoch()).count(),
+                std::memory_order_release);
+        }
+        ctx.first_callback_captured.store(true);
+    }
+
+    // First callback after a restart that kept this context: fill the gap so positions still
+    // line up with stream_start_time
+    if (ctx.resync_pending.load(std::memory_order_relaxed)) {
+        ctx.resync_pending.store(false, std::memory_order_relaxed);
+        ctx.pad_to_clock(framesPerBuffer);
+    }
+
+    copy();
+
+    const uint64_t end_ns = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    ctx.stats->record_callback(previous_ns, start_ns, end_ns, framesPerBuffer, ctx.info.sample_rate_hz);
+    if (ctx.callback_timing) {
+        ctx.callback_timing->record(end_ns - start_ns, framesPerBuffer, ctx.info.sample_rate_hz);
+    }
+    return paContinue;
+}
+
+// Channels is the stream's channel count and Sample the type its ring stores, or 0 and void
+// for the generic callback, which reads both from the context at runtime.
 // outputBuffer used for playback of audio - unused for microphone
-int AudioCallback(const void* inputBuffer,
-                  void* outputBuffer,
-                  unsigned long framesPerBuffer,
-                  const PaStreamCallbackTimeInfo* timeInfo,
-                  PaStreamCallbackFlags statusFlags,
-                  void* userData) {
+template <int Channels, typename Sample>
+int capture_callback(const void* inputBuffer,
+                     unsigned long framesPerBuffer,
+                     const PaStreamCallbackTimeInfo* timeInfo,
+                     PaStreamCallbackFlags statusFlags,
+                     void* userData) {
     if (!userData) {
         // something wrong, stop stream
         return paAbort;
     }
     audio::InputStreamContext* ctx = static_cast<audio::InputStreamContext*>(userData);
 
-    if (!ctx) {
-        // something wrong, stop stream
-        return paAbort;
-    }
+    return run_capture(*ctx, framesPerBuffer, timeInfo, statusFlags, inputBuffer != nullptr, [&]() {
+        const uint64_t total_samples = framesPerBuffer * (Channels > 0 ? Channels : ctx->info.num_channels);
 
-    ctx->last_callback_time_ns.store(static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+        // Copy the whole callback buffer in one block so the write position is published once.
+        // The stream was opened in the ring's sample_format, so this is a plain copy.
+        if constexpr (std::is_void_v<Sample>) {
+            ctx->write_native(inputBuffer, total_samples);
+            ctx->levels.add(inputBuffer, framesPerBuffer, ctx->sample_format);
+        } else {
+            ctx->write_frames(static_cast<const Sample*>(inputBuffer), total_samples);
+            ctx->levels.add<Sample, Channels>(static_cast<const Sample*>(inputBuffer), framesPerBuffer);
+        }
+    });
+}
 
-    if (statusFlags & paInputOverflow) {
-        ctx->input_overflow_count.fetch_add(1);
-    }
-    if (statusFlags & paInputUnderflow) {
-        ctx->input_underflow_count.fetch_add(1);
+// A played int16 sample (or sum of samples scaled by 1/divisor) in the ring's sample type
+template <typename Sample>
+Sample reference_sample(int32_t sum, int32_t divisor) noexcept {
+    if constexpr (std::is_same_v<Sample, float>) {
+        return static_cast<float>(sum) / static_cast<float>(divisor) * audio::INT16_TO_FLOAT_SCALE;
+    } else if constexpr (std::is_same_v<Sample, int32_t>) {
+        return static_cast<int32_t>(static_cast<int64_t>(sum) * 65536 / divisor);
+    } else {
+        return static_cast<int16_t>(sum / divisor);
     }
+}
 
-    if (inputBuffer == nullptr) {
-        return paContinue;
+// Writes framesPerBuffer captured frames to the duplex ring, each followed by the mono mix of
+// the frame played alongside it, one DUPLEX_BLOCK_FRAMES block at a time
+template <typename Sample>
+void write_with_reference(DuplexContext& duplex, const Sample* captured, const int16_t* played, unsigned long framesPerBuffer) noexcept {
+    const size_t capture_channels = static_cast<size_t>(duplex.capture_channels);
+    const size_t output_channels = static_cast<size_t>(duplex.output.info.num_channels);
+    Sample* const block = reinterpret_cast<Sample*>(duplex.frames.data());
+    size_t remaining = framesPerBuffer;
+    while (remaining > 0) {
+        const size_t count = std::min(remaining, DUPLEX_BLOCK_FRAMES);
+        Sample* out = block;
+        for (size_t frame = 0; frame < count; frame++) {
+            out = std::copy_n(captured, capture_channels, out);
+            captured += capture_channels;
+            int32_t sum = 0;
+            for (size_t ch = 0; ch < output_channels; ch++) {
+                sum += played[ch];
+            }
+            played += output_channels;
+            *out++ = reference_sample<Sample>(sum, static_cast<int32_t>(output_channels));
+        }
+        duplex.input.write_frames(block, count * (capture_channels + 1));
+        duplex.input.levels.add(block, count);
+        remaining -= count;
     }
+}
 
-    const int16_t* input = static_cast<const int16_t*>(inputBuffer);
+template <int Channels, typename Sample>
+int specialized_callback(const void* inputBuffer,
+                         void* /*outputBuffer*/,
+                         unsigned long framesPerBuffer,
+                         const PaStreamCallbackTimeInfo* timeInfo,
+                         PaStreamCallbackFlags statusFlags,
+                         void* userData) {
+    return capture_callback<Channels, Sample>(inputBuffer, framesPerBuffer, timeInfo, statusFlags, userData);
+}
 
-    // First callback: establish anchor between PortAudio time and wall-clock time
-    if (!ctx->first_callback_captured.load()) {
-        // the inputBufferADCTime describes the time when the
-        // first sample of the input buffer was captured,
-        // synced with the clock of the device
-        ctx->first_sample_adc_time = timeInfo->inputBufferAdcTime;
-        ctx->stream_start_time = std::chrono::system_clock::now();
-        ctx->first_callback_captured.store(true);
+template <typename Sample>
+PaStreamCallback* select_for_channels(int num_channels) {
+    switch (num_channels) {
+        case 1:
+            return specialized_callback<1, Sample>;
+        case 2:
+            return specialized_callback<2, Sample>;
+        case 4:
+            return specialized_callback<4, Sample>;
+        case 8:
+            return specialized_callback<8, Sample>;
+        default:
+            return AudioCallback;
     }
+}
+
+}  // namespace
+
+int AudioCallback(const void* inputBuffer,
+                  void* outputBuffer,
+                  unsigned long framesPerBuffer,
+                  const PaStreamCallbackTimeInfo* timeInfo,
+                  PaStreamCallbackFlags statusFlags,
+                  void* userData) {
+    return capture_callback<0, void>(inputBuffer, framesPerBuffer, timeInfo, statusFlags, userData);
+}
 
-    const uint64_t total_samples = framesPerBuffer * ctx->info.num_channels;
+int DuplexCallback(const void* inputBuffer,
+                   void* outputBuffer,
+                   unsigned long framesPerBuffer,
+                   const PaStreamCallbackTimeInfo* timeInfo,
+                   PaStreamCallbackFlags statusFlags,
+                   void* userData) {
+    if (!userData) {
+        return paAbort;
+    }
+    DuplexContext* const duplex = static_cast<DuplexContext*>(userData);
 
-    for (int i = 0; i < total_samples; ++i) {
-        ctx->write_sample(input[i]);
+    // Play first, so the reference is exactly what this callback hands the device, gain included
+    const int played = speaker::speakerCallback(nullptr, outputBuffer, framesPerBuffer, timeInfo, statusFlags, &duplex->output);
+    if (played != paContinue) {
+        return played;
     }
+    const int16_t* const output = static_cast<const int16_t*>(outputBuffer);
 
-    return paContinue;
+    return run_capture(duplex->input, framesPerBuffer, timeInfo, statusFlags, inputBuffer != nullptr, [&]() {
+        switch (duplex->input.sample_format) {
+            case audio::SampleFormat::INT32:
+                write_with_reference(*duplex, static_cast<const int32_t*>(inputBuffer), output, framesPerBuffer);
+                break;
+            case audio::SampleFormat::FLOAT32:
+                write_with_reference(*duplex, static_cast<const float*>(inputBuffer), output, framesPerBuffer);
+                break;
+            default:
+                write_with_reference(*duplex, static_cast<const int16_t*>(inputBuffer), output, framesPerBuffer);
+                break;
+        }
+    });
+}
+
+PaStreamCallback* select_audio_callback(int num_channels, audio::SampleFormat format) {
+    switch (format) {
+        case audio::SampleFormat::INT16:
+            return select_for_channels<int16_t>(num_channels);
+        case audio::SampleFormat::FLOAT32:
+            return select_for_channels<float>(num_channels);
+        default:
+            return AudioCallback;
+    }
 }
 
 }  // namespace microphone
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <deque>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <tuple>
@@ -12,14 +17,37 @@
 #include "audio_codec.hpp"
 #include "audio_stream.hpp"
 #include "audio_utils.hpp"
+#include "disk_history.hpp"
+#include "hotplug.hpp"
+#include "metrics.hpp"
+#include "mp3_encoder.hpp"
+#include "opus_encoder.hpp"
 #include "portaudio.h"
 #include "portaudio.hpp"
+#include "resample.hpp"
+#include "silence_gate.hpp"
+#include "speaker.hpp"
 #include "watchdog.hpp"
 
 namespace microphone {
 namespace vsdk = ::viam::sdk;
 
-constexpr double DEFAULT_HISTORICAL_THROTTLE_MS = 50;
+// Historical reads are paced by the consumer (and replay_speed) rather than a fixed pause
+constexpr double DEFAULT_HISTORICAL_THROTTLE_MS = 0;
+// Historical reads this far behind the write position are catching up, and replayed faster
+// than real time
+constexpr int REPLAY_CATCH_UP_MS = 1000;
+// Most audio replay_chunk_ms may coalesce into one chunk
+constexpr int MAX_REPLAY_CHUNK_MS = 5000;
+// Upper bound for disk_history_seconds (a day)
+constexpr int MAX_DISK_HISTORY_SECONDS = 86400;
+// Accepted range for chunk_duration_ms in get_audio's extra
+constexpr int MIN_CHUNK_DURATION_MS = 5;
+constexpr int MAX_CHUNK_DURATION_MS = 1000;
+// Windows get_levels reports when it isn't given any
+constexpr std::array<int, 3> DEFAULT_LEVEL_WINDOWS_MS = {100, 1000, 10000};
+// Frames the duplex callback interleaves per pass; a longer callback buffer takes several
+constexpr size_t DUPLEX_BLOCK_FRAMES = 512;
 PaDeviceIndex findDeviceByName(const std::string& name, const audio::portaudio::PortAudioInterface& pa);
 
 // Calculates the initial read position from a previous timestamp
@@ -30,7 +58,201 @@ PaDeviceIndex findDeviceByName(const std::string& name, const audio::portaudio::
 //   - previous_timestamp is in the future (audio not yet captured)
 //   - previous_timestamp is too old (audio has been overwritten in circular buffer)
 // Returns the write position if previous_timestamp == 0 (default: most recent audio)
-uint64_t get_initial_read_position(const std::shared_ptr<audio::InputStreamContext>& stream_context, int64_t previous_timestamp);
+// Audio the ring has overwritten is still accepted when history (the disk tier of
+// stream_context, if any) holds it.
+uint64_t get_initial_read_position(const std::shared_ptr<audio::InputStreamContext>& stream_context,
+                                   int64_t previous_timestamp,
+                                   const audio::DiskHistory* history = nullptr);
+
+// Options for catching up on a historical read (previous_timestamp), from get_audio's extra
+struct ReplayOptions {
+    // Ceiling on catch-up speed as a multiple of real time (replay_speed); 0 replays as fast as
+    // the chunk handler accepts chunks
+    double speed = 0;
+    // Coalesce consecutive chunks into up to this much audio while catching up
+    // (replay_chunk_ms); 0 keeps the normal chunk duration
+    int chunk_ms = 0;
+};
+
+// Throws std::invalid_argument on a malformed replay_speed or replay_chunk_ms
+ReplayOptions parse_replay_options(const vsdk::ProtoStruct& extra);
+
+// Credit-based pacing for historical replay. Each chunk spends its duration of audio and
+// credit comes back at speed times the wall clock, so replay never runs ahead of that rate.
+// Time the chunk handler spent blocked (e.g. on gRPC flow control) already earned credit, so a
+// slow consumer isn't slowed down twice; at most MAX_CREDIT is banked for a later burst.
+class ReplayPacer {
+   public:
+    static constexpr std::chrono::milliseconds MAX_CREDIT{1000};
+
+    explicit ReplayPacer(double speed) : speed_(speed) {}
+
+    // Accounts for a chunk of the given duration, sleeping while credit is overdrawn.
+    // Does nothing when speed is 0.
+    void pace(std::chrono::nanoseconds duration);
+
+    // Drops the accumulated credit, e.g. once the reader has caught up with real time
+    void reset() {
+        started_ = false;
+    }
+
+   private:
+    const double speed_;
+    bool started_ = false;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::nanoseconds sent_{0};
+};
+
+// One resampled and encoded chunk. Immutable once published, so every reader of a
+// SharedEncoder holds the same instance.
+struct EncodedChunk {
+    std::vector<uint8_t> audio_data;
+    std::chrono::nanoseconds start_timestamp_ns{0};
+    std::chrono::nanoseconds end_timestamp_ns{0};
+    // Device buffer position the chunk ends at, already adjusted for MP3 encoder delay
+    uint64_t end_position = 0;
+    // Silence the stage's gate skipped: no audio_data, and the timestamps span the skipped audio
+    bool gap = false;
+};
+
+// Per-call get_audio options that change what a stage produces. Live readers only share a
+// stage when these match.
+struct StageOptions {
+    MP3EncoderOptions mp3;
+    // chunk_duration_ms from extra; 0 uses the codec default (100 ms for PCM, about 150 ms of
+    // MP3 frames, one packet for Opus)
+    int chunk_duration_ms = 0;
+    // The silence_* keys, on top of the configured gate
+    audio::silence::GateOptions silence;
+
+    bool operator<(const StageOptions& other) const {
+        return std::tie(mp3, chunk_duration_ms, silence) < std::tie(other.mp3, other.chunk_duration_ms, other.silence);
+    }
+};
+
+// Resample+encode stage for one (codec, sample rate, StageOptions) combination.
+// Live get_audio calls with the same parameters share a single instance: whichever reader
+// first asks for a chunk that hasn't been produced yet reads it from the device buffer,
+// resamples and encodes it, and publishes it. The other readers receive the same
+// reference-counted chunk and only track their own chunk index.
+// Historical reads (previous_timestamp != 0) start at arbitrary positions, so each gets a
+// private stage that nobody else reads from.
+class SharedEncoder {
+   public:
+    // How many published chunks are kept for readers that are behind (~5s of MP3 or 3.2s of PCM)
+    static constexpr size_t MAX_RETAINED_CHUNKS = 32;
+    // How many evicted chunks are kept for reuse. Eviction and production alternate one for
+    // one, so a couple is enough to make steady-state production allocation-free.
+    static constexpr size_t MAX_FREE_CHUNKS = 4;
+
+    SharedEncoder(audio::codec::AudioCodec codec,
+                  std::shared_ptr<audio::InputStreamContext> stream_context,
+                  uint64_t read_position,
+                  ResampleOptions resample_options = ResampleOptions{});
+
+    // Index of the next chunk to be produced; new readers start here.
+    uint64_t next_index();
+
+    // Returns chunk `index`, producing it from the stage's context first if it is the next one.
+    // Returns nullptr if there aren't enough samples for a full chunk yet. If the chunk has
+    // already been evicted, index is moved forward to the oldest retained chunk.
+    std::shared_ptr<const EncodedChunk> get_chunk(uint64_t& index);
+
+    // Device buffer position of the next chunk to be produced
+    uint64_t read_position();
+
+    // Skips silent chunks as options describe (see SilenceGate), publishing gap chunks in
+    // their place. Call after setup_stream_params and before the stage is handed to any
+    // reader; does nothing if the options leave the gate off.
+    void enable_silence_gate(const audio::silence::GateOptions& options);
+
+    // Codec and chunk sizing, filled in by Microphone::setup_stream_params before the
+    // stage is handed to any reader and constant afterwards.
+    const audio::codec::AudioCodec codec;
+    MP3EncoderContext mp3_ctx;
+    OpusEncoderContext opus_ctx;
+    int stream_sample_rate = 0;
+    int requested_sample_rate = 0;
+    int num_channels = 0;
+    int historical_throttle_ms = 0;
+    int samples_per_chunk = 0;
+    int device_samples_per_chunk = 0;
+    // The codec is the device buffer's sample format (PCM_16 for int16, PCM_32 for int32,
+    // PCM_32_FLOAT for float32) at the device rate: chunks are read straight from the device
+    // buffer into the payload, skipping the scratch buffer and encode step
+    bool direct_copy = false;
+    const ResampleOptions resample_options;
+    // Disk tier to read from when the ring no longer holds read_position. Only set on the
+    // private stage of a historical read, before it's used.
+    std::shared_ptr<audio::DiskHistory> history;
+    // Keeps the scratch buffers locked in RAM with the mlock attribute. Set before the stage
+    // is handed to any reader.
+    std::shared_ptr<audio::realtime::RealtimeSettings> realtime;
+
+   private:
+    // Reads, resamples and encodes the chunk at read_position_, or returns the gap the silence
+    // gate reports in its place. Caller must hold produce_mu_.
+    std::shared_ptr<EncodedChunk> produce_chunk();
+
+    // Sets the chunk's timestamps and end_position for the device buffer span [start_position,
+    // end_position), shifted back by the encoder delay like the audio around it
+    void stamp(EncodedChunk& chunk, uint64_t start_position, uint64_t end_position) const;
+
+    // Whether the sample_count samples at read_position_ come from the disk tier: it holds
+    // all of them and the ring no longer does. Caller must hold produce_mu_.
+    bool in_disk_tier(int sample_count);
+
+    // Reads sample_count samples at read_position_ from the disk tier when in_disk_tier(),
+    // from the ring otherwise. Caller must hold produce_mu_.
+    int read_device_samples(int16_t* buffer, int sample_count);
+
+    // Serializes producers; protects context_, read_position_, mp3_ctx, opus_ctx, resampler_, the scratch
+    // buffers and free_chunks_
+    std::mutex produce_mu_;
+    std::shared_ptr<audio::InputStreamContext> context_;
+    uint64_t read_position_;
+    // Created on first use when the requested rate differs from the device rate; keeps
+    // filter history across chunks
+    std::unique_ptr<StreamingResampler> resampler_;
+    // Null unless enable_silence_gate turned it on
+    std::unique_ptr<audio::silence::SilenceGate> gate_;
+    std::vector<int16_t> device_samples_;
+    std::vector<int16_t> resampled_samples_;
+    audio::realtime::LockedRegion device_samples_lock_;
+    audio::realtime::LockedRegion resampled_samples_lock_;
+    // Evicted chunks no reader still held; their audio_data capacity is reused by produce_chunk
+    std::vector<std::shared_ptr<EncodedChunk>> free_chunks_;
+
+    // Protects the published chunks; never held while encoding
+    std::mutex chunks_mu_;
+    // Held non-const so evicted chunks can be recycled; readers only ever see them as const
+    std::deque<std::shared_ptr<EncodedChunk>> chunks_;
+    uint64_t first_index_ = 0;  // index of chunks_.front()
+};
+
+// user_data of a duplex stream (the duplex_speaker attribute). One callback plays the
+// speaker's audio from output and captures into input, appending to each captured frame what
+// was played alongside it, mixed to mono, as a reference channel. Both halves run on the
+// device clock, so the reference never drifts against the captured audio.
+struct DuplexContext {
+    DuplexContext(audio::InputStreamContext& input, audio::OutputStreamContext& output);
+
+    audio::InputStreamContext& input;
+    audio::OutputStreamContext& output;
+    // Channels the stream captures; input's frames hold one more, the reference
+    const int capture_channels;
+    // One block of DUPLEX_BLOCK_FRAMES frames in input's sample format, sized up front so the
+    // callback never allocates
+    std::vector<uint8_t> frames;
+};
+
+// Delivery counters for one get_audio call, reported by get_stats while the call is running
+struct ClientStats {
+    std::string codec;
+    bool historical = false;
+    audio::metrics::Counter chunks;
+    audio::metrics::Counter bytes;
+};
 
 class Microphone final : public viam::sdk::AudioIn {
    public:
@@ -50,31 +272,63 @@ class Microphone final : public viam::sdk::AudioIn {
 
     viam::sdk::audio_properties get_properties(const viam::sdk::ProtoStruct& extra);
     std::vector<viam::sdk::GeometryConfig> get_geometries(const viam::sdk::ProtoStruct& extra);
-    viam::sdk::ProtoStruct get_status() override {
-        return {};
-    }
+    // Capture metrics, the same as the get_stats DoCommand
+    viam::sdk::ProtoStruct get_status() override;
 
-    // Restarts the stream.
+    // Reports stats_, the stream's overflow/underflow counts and every running
+    // get_audio call, zeroing the counters when reset is set
+    viam::sdk::ProtoStruct stats_struct(bool reset);
+
+    // Restarts the stream into the same context: first on the cached device index, then
+    // after re-resolving device_id if that fails.
     // Must NOT be called while holding stream_ctx_mu_.
     void restart_stalled_stream(const std::shared_ptr<audio::InputStreamContext>& stream_context);
 
+    // Reopens stream_ on stream_params_, writing into stream_context. Returns false with
+    // error set if the device wouldn't open. Caller must hold stream_ctx_mu_.
+    bool reopen_stream(const std::shared_ptr<audio::InputStreamContext>& stream_context, std::string& error);
+
+    // Replaces the disk tier with one draining audio_context_, when disk_history_seconds is
+    // set. A failure to create the file is logged and leaves it disabled.
+    // Caller must hold stream_ctx_mu_.
+    void start_disk_history();
+
+    // Returns the stage shared by live readers of (codec, requested sample rate, options),
+    // creating it if no reader currently holds one.
+    std::shared_ptr<SharedEncoder> acquire_shared_encoder(audio::codec::AudioCodec codec_enum,
+                                                          const std::shared_ptr<audio::InputStreamContext>& stream_context,
+                                                          const StageOptions& options = StageOptions{});
+
+    // Takes a stage out of shared_encoders_ if the caller holds the last reference to it, so
+    // no new reader can join. Returns whether the caller now owns the stage alone.
+    bool release_shared_encoder(const std::shared_ptr<SharedEncoder>& encoder);
+
     void setup_stream_params(audio::codec::AudioCodec codec_enum,
                              MP3EncoderContext& mp3_ctx,
+                             OpusEncoderContext& opus_ctx,
                              int& stream_sample_rate,
                              int& requested_sample_rate,
                              int& stream_num_channels,
                              int& stream_historical_throttle_ms,
                              int& samples_per_chunk,
-                             int& device_samples_per_chunk);
+                             int& device_samples_per_chunk,
+                             bool& direct_copy,
+                             const StageOptions& options = StageOptions{});
 
     // Member variables
     int requested_sample_rate_;   // User's requested sample rate (may differ from device rate)
-    int historical_throttle_ms_;  // Throttle time for historical data stream
+    int historical_throttle_ms_;  // Fixed pause between historical chunks, on top of replay pacing (legacy)
+    ResampleOptions resample_options_;  // soxr quality profile for device rate -> requested rate
+    MP3EncoderOptions mp3_options_;     // Configured MP3 bitrate/mode/quality; get_audio extra may override
+    audio::silence::GateOptions silence_options_;  // Configured silence gate; get_audio extra may override
+    int opus_frame_ms_ = OPUS_DEFAULT_FRAME_MS;  // Opus packet (and chunk) duration
     static vsdk::Model model;
 
     // The mutex protects the stream and context
     std::mutex stream_ctx_mu_;
     PaStream* stream_;
+    // Set once in the constructor; stall restarts reopen the stream into the same context, so
+    // get_audio reads it for the whole call without taking the lock again
     std::shared_ptr<audio::InputStreamContext> audio_context_;
     // This is null in production and used for testing to inject the mock portaudio functions
     const audio::portaudio::PortAudioInterface* pa_;
@@ -82,6 +336,22 @@ class Microphone final : public viam::sdk::AudioIn {
 
     audio::utils::StreamParams stream_params_;
 
+    // Optional on-disk history tier for audio_context_ (null when disabled). Protected by
+    // stream_ctx_mu_; configuration is set once in the constructor.
+    int disk_history_seconds_ = 0;
+    std::string disk_history_path_;
+    std::shared_ptr<audio::DiskHistory> disk_history_;
+
+    // Metrics for the resource's lifetime, across stall restarts; set once in the constructor
+    std::shared_ptr<audio::metrics::StreamMetrics> stats_;
+    // Real-time scheduling and memory locking options and their outcome; set once in the constructor
+    std::shared_ptr<audio::realtime::RealtimeSettings> realtime_;
+
+    // Running get_audio calls by arrival order. Held weakly so an entry goes with its call.
+    std::mutex clients_mu_;
+    std::map<uint64_t, std::weak_ptr<ClientStats>> clients_;
+    uint64_t next_client_id_ = 0;
+
     // Device id from the resource config (empty if user configured by device_name or
     // system default). Used by restart_stalled_stream to re-resolve the device's current
     // PortAudio index, so we recover from kernel re-enumeration (e.g. USB unplug/replug).
@@ -90,6 +360,19 @@ class Microphone final : public viam::sdk::AudioIn {
     // Background watchdog that polls audio_context_->last_callback_time_ns and triggers
     // restart_stalled_stream when the mic callback has gone silent for too long.
     std::unique_ptr<audio::utils::StallWatchdog<audio::InputStreamContext>> watchdog_;
+    // Wakes watchdog_ when an audio device is added or removed, so a replugged device
+    // is picked up right away
+    std::unique_ptr<audio::hotplug::HotplugMonitor> hotplug_;
+
+    // Live stages keyed by (codec, requested sample rate, options). Held weakly so a stage
+    // goes away with its last reader.
+    std::mutex shared_encoders_mu_;
+    std::map<std::tuple<audio::codec::AudioCodec, int, StageOptions>, std::weak_ptr<SharedEncoder>> shared_encoders_;
+
+    // Duplex mode (duplex_speaker attribute): the speaker whose audio stream_ plays and the
+    // callback's user_data. Both null otherwise; set once in the constructor.
+    std::shared_ptr<speaker::Speaker> duplex_speaker_;
+    std::unique_ptr<DuplexContext> duplex_;
 };
 
 /**
@@ -112,4 +395,18 @@ int AudioCallback(const void* inputBuffer,
                   PaStreamCallbackFlags statusFlags,
                   void* userData);
 
+// Callback of a duplex stream; userData is a DuplexContext. Plays like speakerCallback, then
+// captures like AudioCallback with the reference channel appended.
+int DuplexCallback(const void* inputBuffer,
+                   void* outputBuffer,
+                   unsigned long framesPerBuffer,
+                   const PaStreamCallbackTimeInfo* timeInfo,
+                   PaStreamCallbackFlags statusFlags,
+                   void* userData);
+
+// The capture callback for a stream's layout: a copy of AudioCallback compiled for a fixed
+// channel count (1, 2, 4 or 8) and sample type (int16 or float32), so the block copy has no
+// runtime stride or format switch. AudioCallback for any other layout.
+PaStreamCallback* select_audio_callback(int num_channels, audio::SampleFormat format);
+
 }  // namespace microphone
@@ -1,11 +1,16 @@
 #include "mp3_decoder.hpp"
+#include <algorithm>
 #include <cstring>
 #include <stdexcept>
 #include <viam/sdk/common/utils.hpp>
+#include "audio_codec.hpp"
 
 namespace speaker {
 
-MP3DecoderContext::MP3DecoderContext() : sample_rate(0), num_channels(0) {
+// One MP3 frame is at most 1152 samples per channel
+constexpr size_t MAX_FRAME_SAMPLES = 1152;
+
+MP3DecoderContext::MP3DecoderContext() : sample_rate(0), num_channels(0), pcm_left(MAX_FRAME_SAMPLES), pcm_right(MAX_FRAME_SAMPLES) {
     CleanupPtr<hip_decode_exit> hip(hip_decode_init());
     if (!hip) {
         VIAM_SDK_LOG(error) << "Failed to initialize MP3 decoder";
@@ -42,12 +47,10 @@ static size_t get_id3v2_offset(const uint8_t* const data, const size_t size) {
     return 0;
 }
 
-// Helper to append PCM samples to output buffer
-static void append_samples(std::vector<uint8_t>& output_data,
-                           const std::vector<int16_t>& pcm_samples_left,
-                           const std::vector<int16_t>& pcm_samples_right,
-                           const int sample_count,
-                           const int num_channels) {
+// Helper to append the frame in ctx.pcm_left/pcm_right to the output buffer, interleaving
+// straight into the destination
+static void append_samples(std::vector<uint8_t>& output_data, const MP3DecoderContext& ctx, const int sample_count) {
+    const int num_channels = ctx.num_channels;
     if (num_channels != 1 && num_channels != 2) {
         VIAM_SDK_LOG(error) << "invalid num channels: " << num_channels;
         throw std::invalid_argument("invalid num channels");
@@ -57,31 +60,44 @@ static void append_samples(std::vector<uint8_t>& output_data,
         throw std::invalid_argument("sample_count must be non-negative");
     }
     // Bounds check to prevent buffer overflow
-    if (sample_count > static_cast<int>(pcm_samples_left.size()) || sample_count > static_cast<int>(pcm_samples_right.size())) {
-        VIAM_SDK_LOG(error) << "sample_count " << sample_count << " exceeds buffer size (left channel size =" << pcm_samples_left.size()
-                            << ", right sample size =" << pcm_samples_right.size() << ")";
+    if (sample_count > static_cast<int>(ctx.pcm_left.size()) || sample_count > static_cast<int>(ctx.pcm_right.size())) {
+        VIAM_SDK_LOG(error) << "sample_count " << sample_count << " exceeds buffer size (left channel size =" << ctx.pcm_left.size()
+                            << ", right sample size =" << ctx.pcm_right.size() << ")";
         throw std::runtime_error("sample_count exceeds pcm data buffer size");
     }
-    const size_t samples_to_add = sample_count * num_channels;
+    const size_t samples_to_add = static_cast<size_t>(sample_count) * num_channels;
 
-    // Interleave into a int16_t buffer
-    std::vector<int16_t> interleaved;
-    interleaved.reserve(samples_to_add);
+    const size_t current_size = output_data.size();
+    output_data.resize(current_size + samples_to_add * sizeof(int16_t));
+    // output_data only ever holds whole int16 samples, so this is 2-byte aligned
+    int16_t* const out = reinterpret_cast<int16_t*>(output_data.data() + current_size);
 
     if (num_channels == 1) {
         // mono: copy left channel samples
-        interleaved.insert(interleaved.end(), pcm_samples_left.begin(), pcm_samples_left.begin() + sample_count);
+        std::memcpy(out, ctx.pcm_left.data(), samples_to_add * sizeof(int16_t));
     } else {
         // stereo: interleave L, R, L, R, ...
-        for (int i = 0; i < sample_count; ++i) {
-            interleaved.push_back(pcm_samples_left[i]);
-            interleaved.push_back(pcm_samples_right[i]);
-        }
+        audio::codec::interleave_stereo_pcm16(ctx.pcm_left.data(), ctx.pcm_right.data(), out, sample_count);
     }
+}
 
-    // Append the raw bytes of interleaved samples to output_data
-    const uint8_t* const bytes = reinterpret_cast<const uint8_t*>(interleaved.data());
-    output_data.insert(output_data.end(), bytes, bytes + interleaved.size() * sizeof(int16_t));
+// Best-effort size of the PCM16 a whole MP3 buffer decodes to, from the first frame's header,
+// so the output can be reserved once. Uses the Xing/Info sample count when present, otherwise
+// the bitrate; returns 0 when neither is known.
+static size_t estimate_decoded_bytes(const mp3data_struct& mp3data, const size_t mp3_data_size) {
+    if (mp3data.stereo <= 0) {
+        return 0;
+    }
+    if (mp3data.nsamp > 0) {
+        return static_cast<size_t>(mp3data.nsamp) * mp3data.stereo * sizeof(int16_t);
+    }
+    if (mp3data.bitrate > 0 && mp3data.samplerate > 0) {
+        const double duration_seconds = static_cast<double>(mp3_data_size) * 8 / (mp3data.bitrate * 1000.0);
+        // One extra frame of slack for rounding
+        const size_t frames = static_cast<size_t>(duration_seconds * mp3data.samplerate) + MAX_FRAME_SAMPLES;
+        return frames * mp3data.stereo * sizeof(int16_t);
+    }
+    return 0;
 }
 
 void decode_mp3_to_pcm16(MP3DecoderContext& ctx, const uint8_t* const encoded_data, const size_t size, std::vector<uint8_t>& decoded_data) {
@@ -118,10 +134,8 @@ void decode_mp3_to_pcm16(MP3DecoderContext& ctx, const uint8_t* const encoded_da
 
     VIAM_SDK_LOG(debug) << "Decoding MP3 data, buffer size after sync scan: " << mp3_data_size << " (skipped " << offset << " bytes total)";
 
-    // Buffers for decoded PCM samples - one MP3 frame is max 1152 samples
-    const size_t frame_buffer_size = 1152;  // Samples per channel
-    std::vector<int16_t> pcm_left(frame_buffer_size);
-    std::vector<int16_t> pcm_right(frame_buffer_size);
+    int16_t* const pcm_left = ctx.pcm_left.data();
+    int16_t* const pcm_right = ctx.pcm_right.data();
 
     mp3data_struct mp3data;
     memset(&mp3data, 0, sizeof(mp3data));
@@ -130,8 +144,8 @@ void decode_mp3_to_pcm16(MP3DecoderContext& ctx, const uint8_t* const encoded_da
 
     // Feed ALL data to LAME once - it buffers internally
     // First call may return 0
-    int decoded_samples = hip_decode1_headers(
-        ctx.decoder.get(), const_cast<unsigned char*>(encoded_data + offset), mp3_data_size, pcm_left.data(), pcm_right.data(), &mp3data);
+    int decoded_samples =
+        hip_decode1_headers(ctx.decoder.get(), const_cast<unsigned char*>(encoded_data + offset), mp3_data_size, pcm_left, pcm_right, &mp3data);
 
     if (decoded_samples < 0) {
         VIAM_SDK_LOG(error) << "[decode_mp3_to_pcm16]: Error decoding MP3 data";
@@ -143,11 +157,12 @@ void decode_mp3_to_pcm16(MP3DecoderContext& ctx, const uint8_t* const encoded_da
         ctx.sample_rate = mp3data.samplerate;
         ctx.num_channels = mp3data.stereo;
         VIAM_SDK_LOG(debug) << "found MP3 audio properties: " << ctx.sample_rate << "Hz, " << ctx.num_channels << " channels";
+        decoded_data.reserve(decoded_data.size() + estimate_decoded_bytes(mp3data, mp3_data_size));
     }
 
     // Append first frame if we got samples
     if (decoded_samples > 0) {
-        append_samples(decoded_data, pcm_left, pcm_right, decoded_samples, ctx.num_channels);
+        append_samples(decoded_data, ctx, decoded_samples);
         frames_decoded++;
     }
 
@@ -155,7 +170,7 @@ void decode_mp3_to_pcm16(MP3DecoderContext& ctx, const uint8_t* const encoded_da
     // Keep going even if some calls return 0 - LAME may need multiple calls to sync and flush
     int consecutive_zeros = 0;
     while (consecutive_zeros < 3) {
-        decoded_samples = hip_decode1_headers(ctx.decoder.get(), nullptr, 0, pcm_left.data(), pcm_right.data(), &mp3data);
+        decoded_samples = hip_decode1_headers(ctx.decoder.get(), nullptr, 0, pcm_left, pcm_right, &mp3data);
 
         if (decoded_samples < 0) {
             VIAM_SDK_LOG(error) << "[decode_mp3_to_pcm16]: Error during decode";
@@ -177,8 +192,9 @@ void decode_mp3_to_pcm16(MP3DecoderContext& ctx, const uint8_t* const encoded_da
             ctx.sample_rate = mp3data.samplerate;
             ctx.num_channels = mp3data.stereo;
             VIAM_SDK_LOG(debug) << "found MP3 audio properties: " << ctx.sample_rate << "Hz, " << ctx.num_channels << " channels";
+            decoded_data.reserve(decoded_data.size() + estimate_decoded_bytes(mp3data, mp3_data_size));
         }
-        append_samples(decoded_data, pcm_left, pcm_right, decoded_samples, ctx.num_channels);
+        append_samples(decoded_data, ctx, decoded_samples);
         frames_decoded++;
     }
 
@@ -202,4 +218,114 @@ void decode_mp3_to_pcm16(MP3DecoderContext& ctx, const std::vector<uint8_t>& enc
     decode_mp3_to_pcm16(ctx, encoded_data.data(), encoded_data.size(), decoded_data);
 }
 
+// Finds the start of the MP3 data in ctx.pending: checks for an ID3v2 tag, skips it (which
+// may take several chunks), then scans for a frame sync. Returns true once synced and leaves
+// the bytes from the sync word onward in ctx.pending.
+static bool sync_pending_input(MP3DecoderContext& ctx) {
+    std::vector<uint8_t>& pending = ctx.pending;
+    if (!ctx.id3_checked) {
+        const bool may_be_id3 = (pending.size() < 1 || pending[0] == 'I') && (pending.size() < 2 || pending[1] == 'D') &&
+                                (pending.size() < 3 || pending[2] == '3');
+        if (may_be_id3 && pending.size() < 10) {
+            return false;  // need the whole 10-byte header to know
+        }
+        ctx.id3_bytes_to_skip = get_id3v2_offset(pending.data(), pending.size());
+        ctx.id3_checked = true;
+        if (ctx.id3_bytes_to_skip > 0) {
+            VIAM_SDK_LOG(debug) << "Skipping ID3v2 tag of size " << ctx.id3_bytes_to_skip << " bytes";
+        }
+    }
+
+    if (ctx.id3_bytes_to_skip > 0) {
+        const size_t skip = std::min(ctx.id3_bytes_to_skip, pending.size());
+        pending.erase(pending.begin(), pending.begin() + skip);
+        ctx.id3_bytes_to_skip -= skip;
+        if (ctx.id3_bytes_to_skip > 0) {
+            return false;
+        }
+    }
+
+    // Scan for first MP3 frame sync (0xFF followed by 0xE0 mask)
+    size_t offset = 0;
+    while (offset + 1 < pending.size()) {
+        if (pending[offset] == 0xFF && (pending[offset + 1] & 0xE0) == 0xE0) {
+            break;
+        }
+        offset++;
+    }
+    if (offset + 1 >= pending.size()) {
+        // Keep a trailing byte in case it's the first half of a sync word
+        pending.erase(pending.begin(), pending.begin() + offset);
+        return false;
+    }
+    if (offset > 0) {
+        VIAM_SDK_LOG(debug) << "decode_mp3_chunk: skipped " << offset << " bytes before first frame sync";
+    }
+    pending.erase(pending.begin(), pending.begin() + offset);
+    return true;
+}
+
+void decode_mp3_chunk(MP3DecoderContext& ctx, const uint8_t* const encoded_data, const size_t size, std::vector<uint8_t>& decoded_data) {
+    if (!ctx.decoder) {
+        VIAM_SDK_LOG(error) << "decode_mp3_chunk: MP3 decoder not initialized";
+        throw std::runtime_error("decode_mp3_chunk: MP3 decoder not initialized");
+    }
+    if (size == 0) {
+        return;
+    }
+
+    const uint8_t* input = encoded_data;
+    size_t input_size = size;
+    if (!ctx.synced) {
+        ctx.pending.insert(ctx.pending.end(), encoded_data, encoded_data + size);
+        if (!sync_pending_input(ctx)) {
+            return;
+        }
+        ctx.synced = true;
+        input = ctx.pending.data();
+        input_size = ctx.pending.size();
+    }
+
+    int16_t* const pcm_left = ctx.pcm_left.data();
+    int16_t* const pcm_right = ctx.pcm_right.data();
+
+    mp3data_struct mp3data;
+    memset(&mp3data, 0, sizeof(mp3data));
+
+    // Hand the new bytes to LAME, which buffers partial frames, then drain every frame it can
+    // complete. As in decode_mp3_to_pcm16, a zero return doesn't necessarily mean it's empty.
+    int decoded_samples = hip_decode1_headers(ctx.decoder.get(), const_cast<unsigned char*>(input), input_size, pcm_left, pcm_right, &mp3data);
+    int consecutive_zeros = 0;
+    while (true) {
+        if (decoded_samples < 0) {
+            VIAM_SDK_LOG(error) << "[decode_mp3_chunk]: Error decoding MP3 data";
+            throw std::runtime_error("[decode_mp3_chunk]: MP3 decoding error");
+        }
+        if (decoded_samples == 0) {
+            if (++consecutive_zeros >= 3) {
+                break;
+            }
+        } else {
+            consecutive_zeros = 0;
+            if (ctx.sample_rate == 0 && mp3data.samplerate != 0) {
+                ctx.sample_rate = mp3data.samplerate;
+                ctx.num_channels = mp3data.stereo;
+                VIAM_SDK_LOG(debug) << "found MP3 audio properties: " << ctx.sample_rate << "Hz, " << ctx.num_channels << " channels";
+            }
+            if (ctx.num_channels == 0) {
+                VIAM_SDK_LOG(error) << "[decode_mp3_chunk]: decoded audio before the stream's channel count was known";
+                throw std::runtime_error("[decode_mp3_chunk]: Failed to extract MP3 audio properties");
+            }
+            append_samples(decoded_data, ctx, decoded_samples);
+        }
+        decoded_samples = hip_decode1_headers(ctx.decoder.get(), nullptr, 0, pcm_left, pcm_right, &mp3data);
+    }
+
+    if (!ctx.pending.empty()) {
+        // Already handed to LAME
+        ctx.pending.clear();
+        ctx.pending.shrink_to_fit();
+    }
+}
+
 }  // namespace speaker
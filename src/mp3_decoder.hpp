@@ -16,6 +16,17 @@ struct MP3DecoderContext {
     int sample_rate = 0;
     int num_channels = 0;
 
+    // Incremental decoding state (decode_mp3_chunk). Until the first frame sync is found, input
+    // is held in pending_ so an ID3v2 tag or sync word split across chunks is still handled.
+    bool synced = false;
+    bool id3_checked = false;
+    size_t id3_bytes_to_skip = 0;
+    std::vector<uint8_t> pending;
+
+    // Per-channel output of one hip_decode1_headers call, reused for every frame
+    std::vector<int16_t> pcm_left;
+    std::vector<int16_t> pcm_right;
+
     MP3DecoderContext();
 
     ~MP3DecoderContext();
@@ -24,4 +35,10 @@ struct MP3DecoderContext {
 void decode_mp3_to_pcm16(MP3DecoderContext& ctx, const uint8_t* encoded_data, size_t size, std::vector<uint8_t>& output_data);
 void decode_mp3_to_pcm16(MP3DecoderContext& ctx, const std::vector<uint8_t>& encoded_data, std::vector<uint8_t>& output_data);
 
+// Decodes one piece of an MP3 byte stream, e.g. a play_stream chunk. Chunks may split frames
+// anywhere; the decoder buffers partial frames and output_data is appended with the PCM16 of
+// every frame completed so far, which may be nothing. ctx.sample_rate / ctx.num_channels are
+// set once the first frame header is seen.
+void decode_mp3_chunk(MP3DecoderContext& ctx, const uint8_t* encoded_data, size_t size, std::vector<uint8_t>& output_data);
+
 }  // namespace speaker
@@ -38,7 +38,76 @@ static const std::string mp3lame_encode_error_to_string(int error_code) {
     }
 }
 
-void initialize_mp3_encoder(MP3EncoderContext& ctx, int sample_rate, int num_channels) {
+std::string mp3_bitrate_mode_name(MP3BitrateMode mode) {
+    switch (mode) {
+        case MP3BitrateMode::CBR:
+            return "cbr";
+        case MP3BitrateMode::VBR:
+            return "vbr";
+        case MP3BitrateMode::ABR:
+            return "abr";
+    }
+    return "cbr";
+}
+
+MP3EncoderOptions parse_mp3_options(const vsdk::ProtoStruct& attrs, const MP3EncoderOptions& defaults) {
+    MP3EncoderOptions options = defaults;
+
+    if (attrs.count("mp3_bitrate")) {
+        if (!attrs.at("mp3_bitrate").is_a<double>()) {
+            VIAM_SDK_LOG(error) << "mp3_bitrate must be a number";
+            throw std::invalid_argument("mp3_bitrate must be a number");
+        }
+        const double bitrate = *attrs.at("mp3_bitrate").get<double>();
+        if (bitrate < MIN_MP3_BIT_RATE || bitrate > MAX_MP3_BIT_RATE) {
+            VIAM_SDK_LOG(error) << "mp3_bitrate must be between " << MIN_MP3_BIT_RATE << " and " << MAX_MP3_BIT_RATE << " kbps";
+            throw std::invalid_argument("mp3_bitrate must be between " + std::to_string(MIN_MP3_BIT_RATE) + " and " +
+                                        std::to_string(MAX_MP3_BIT_RATE) + " kbps");
+        }
+        options.bitrate_kbps = static_cast<int>(bitrate);
+    }
+
+    if (attrs.count("mp3_bitrate_mode")) {
+        if (!attrs.at("mp3_bitrate_mode").is_a<std::string>()) {
+            VIAM_SDK_LOG(error) << "mp3_bitrate_mode must be a string";
+            throw std::invalid_argument("mp3_bitrate_mode must be a string");
+        }
+        const std::string mode = *attrs.at("mp3_bitrate_mode").get<std::string>();
+        if (mode == "cbr") {
+            options.mode = MP3BitrateMode::CBR;
+        } else if (mode == "vbr") {
+            options.mode = MP3BitrateMode::VBR;
+        } else if (mode == "abr") {
+            options.mode = MP3BitrateMode::ABR;
+        } else {
+            VIAM_SDK_LOG(error) << "mp3_bitrate_mode must be one of cbr, vbr, abr; got: " << mode;
+            throw std::invalid_argument("mp3_bitrate_mode must be one of cbr, vbr, abr; got: " + mode);
+        }
+    }
+
+    if (attrs.count("mp3_quality")) {
+        if (!attrs.at("mp3_quality").is_a<double>()) {
+            VIAM_SDK_LOG(error) << "mp3_quality must be a number";
+            throw std::invalid_argument("mp3_quality must be a number");
+        }
+        const double quality = *attrs.at("mp3_quality").get<double>();
+        if (quality < 0 || quality > 9) {
+            VIAM_SDK_LOG(error) << "mp3_quality must be between 0 (best) and 9 (fastest)";
+            throw std::invalid_argument("mp3_quality must be between 0 (best) and 9 (fastest)");
+        }
+        options.quality = static_cast<int>(quality);
+    }
+
+    return options;
+}
+
+vsdk::ProtoStruct mp3_settings_struct(const MP3EncoderOptions& options) {
+    return vsdk::ProtoStruct{{"mp3_bitrate", static_cast<double>(options.bitrate_kbps)},
+                             {"mp3_bitrate_mode", mp3_bitrate_mode_name(options.mode)},
+                             {"mp3_quality", static_cast<double>(options.quality)}};
+}
+
+void initialize_mp3_encoder(MP3EncoderContext& ctx, int sample_rate, int num_channels, const MP3EncoderOptions& options) {
     ctx.sample_rate = sample_rate;
     ctx.num_channels = num_channels;
 
@@ -53,10 +122,27 @@ void initialize_mp3_encoder(MP3EncoderContext& ctx, int sample_rate, int num_cha
     // Configure encoder
     lame_set_in_samplerate(ctx.encoder.get(), sample_rate);
     lame_set_num_channels(ctx.encoder.get(), num_channels);
-    // 192 kbps bit rate - how many bits of audio used to represent one second of audio
-    // higher bitrate = better quality,larger file size
-    lame_set_brate(ctx.encoder.get(), MP3_BIT_RATE);
-    lame_set_quality(ctx.encoder.get(), MP3_QUALITY);
+    lame_set_quality(ctx.encoder.get(), options.quality);
+    switch (options.mode) {
+        case MP3BitrateMode::CBR:
+            lame_set_VBR(ctx.encoder.get(), vbr_off);
+            lame_set_brate(ctx.encoder.get(), options.bitrate_kbps);
+            break;
+        case MP3BitrateMode::VBR:
+            lame_set_VBR(ctx.encoder.get(), vbr_default);
+            lame_set_VBR_q(ctx.encoder.get(), options.quality);
+            lame_set_VBR_max_bitrate_kbps(ctx.encoder.get(), options.bitrate_kbps);
+            break;
+        case MP3BitrateMode::ABR:
+            lame_set_VBR(ctx.encoder.get(), vbr_abr);
+            lame_set_VBR_mean_bitrate_kbps(ctx.encoder.get(), options.bitrate_kbps);
+            break;
+    }
+    if (options.mode != MP3BitrateMode::CBR) {
+        // The Xing/Info header is a placeholder frame meant to be rewritten after encoding,
+        // which is impossible for a stream that has already been sent.
+        lame_set_bWriteVbrTag(ctx.encoder.get(), 0);
+    }
 
     int init_result = lame_init_params(ctx.encoder.get());
     if (init_result < 0) {
@@ -73,7 +159,8 @@ void initialize_mp3_encoder(MP3EncoderContext& ctx, int sample_rate, int num_cha
     ctx.frame_size = lame_get_framesize(ctx.encoder.get());
 
     VIAM_SDK_LOG(debug) << "MP3 encoder initialized: " << sample_rate << "Hz, " << num_channels
-                        << " channels, 192kbps CBR, encoder delay: " << ctx.encoder_delay << " samples, "
+                        << " channels, " << options.bitrate_kbps << "kbps " << mp3_bitrate_mode_name(options.mode) << ", quality "
+                        << options.quality << ", encoder delay: " << ctx.encoder_delay << " samples, "
                         << " frame size: " << ctx.frame_size << " samples/frame)";
 }
 
@@ -3,6 +3,8 @@
 #include <lame/lame.h>
 
 #include <cstdint>
+#include <string>
+#include <tuple>
 #include <vector>
 #include <viam/sdk/config/resource.hpp>
 #include "audio_utils.hpp"
@@ -10,15 +12,48 @@
 namespace microphone {
 namespace vsdk = ::viam::sdk;
 
-// 192 kbps bit rate - how many bits of audio used to represent one second of audio
+// Default 192 kbps bit rate - how many bits of audio used to represent one second of audio
 // higher bitrate = better quality,larger file size
 constexpr int MP3_BIT_RATE = 192;
-// (0=best, 9=worst)
+// Default LAME quality (0=best, 9=worst)
 // higher quality = slower
 constexpr int MP3_QUALITY = 2;
 
+// Accepted range for mp3_bitrate (kbps); LAME rounds to the nearest bitrate the MPEG version allows
+constexpr int MIN_MP3_BIT_RATE = 8;
+constexpr int MAX_MP3_BIT_RATE = 320;
+
 using audio::utils::CleanupPtr;
 
+enum class MP3BitrateMode { CBR, VBR, ABR };
+
+// Encoder settings, from the mp3_bitrate / mp3_bitrate_mode / mp3_quality attributes or the
+// same keys in get_audio's extra.
+//   CBR: constant bitrate_kbps
+//   VBR: quality also picks the VBR quality (V0-V9); bitrate_kbps is the ceiling
+//   ABR: average of bitrate_kbps
+struct MP3EncoderOptions {
+    int bitrate_kbps = MP3_BIT_RATE;
+    MP3BitrateMode mode = MP3BitrateMode::CBR;
+    int quality = MP3_QUALITY;
+
+    bool operator==(const MP3EncoderOptions& other) const {
+        return bitrate_kbps == other.bitrate_kbps && mode == other.mode && quality == other.quality;
+    }
+    bool operator<(const MP3EncoderOptions& other) const {
+        return std::tie(bitrate_kbps, mode, quality) < std::tie(other.bitrate_kbps, other.mode, other.quality);
+    }
+};
+
+std::string mp3_bitrate_mode_name(MP3BitrateMode mode);
+
+// Reads the mp3_* keys present in attrs on top of defaults.
+// Throws std::invalid_argument on a wrong type or out-of-range value.
+MP3EncoderOptions parse_mp3_options(const vsdk::ProtoStruct& attrs, const MP3EncoderOptions& defaults = MP3EncoderOptions{});
+
+// The encoder settings in the shape returned by the get_mp3_settings DoCommand
+vsdk::ProtoStruct mp3_settings_struct(const MP3EncoderOptions& options);
+
 struct MP3EncoderContext {
     CleanupPtr<lame_close> encoder = nullptr;
 
@@ -30,7 +65,10 @@ struct MP3EncoderContext {
 
     int frame_size = 0;
 };
-void initialize_mp3_encoder(MP3EncoderContext& ctx, int sample_rate, int num_channels);
+void initialize_mp3_encoder(MP3EncoderContext& ctx,
+                            int sample_rate,
+                            int num_channels,
+                            const MP3EncoderOptions& options = MP3EncoderOptions{});
 void flush_mp3_encoder(MP3EncoderContext& ctx, std::vector<uint8_t>& output_data);
 void cleanup_mp3_encoder(MP3EncoderContext& ctx);
 void encode_samples_to_mp3(
@@ -0,0 +1,113 @@
+#include "opus_decoder.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <viam/sdk/common/utils.hpp>
+#include "audio_codec.hpp"
+
+namespace speaker {
+
+// Opus packets carry at most 120 ms of audio
+constexpr int MAX_PACKET_MS = 120;
+constexpr int FALLBACK_SAMPLE_RATE = 48000;
+
+static void create_decoder(OpusDecoderContext& ctx, const uint8_t* packet, int preferred_sample_rate) {
+    const int sample_rate = audio::codec::is_opus_sample_rate(preferred_sample_rate) ? preferred_sample_rate : FALLBACK_SAMPLE_RATE;
+    const int num_channels = opus_packet_get_nb_channels(packet);
+    if (num_channels != 1 && num_channels != 2) {
+        VIAM_SDK_LOG(error) << "Invalid Opus packet: " << opus_strerror(num_channels);
+        throw std::runtime_error("Invalid Opus packet");
+    }
+
+    int error = OPUS_OK;
+    CleanupPtr<opus_decoder_destroy> decoder(opus_decoder_create(sample_rate, num_channels, &error));
+    if (!decoder || error != OPUS_OK) {
+        VIAM_SDK_LOG(error) << "Failed to initialize Opus decoder: " << opus_strerror(error) << " (code: " << error << ")";
+        throw std::runtime_error("Failed to initialize Opus decoder");
+    }
+
+    ctx.decoder = std::move(decoder);
+    ctx.sample_rate = sample_rate;
+    ctx.num_channels = num_channels;
+    ctx.pcm.resize(static_cast<size_t>(sample_rate) * MAX_PACKET_MS / 1000 * num_channels);
+    VIAM_SDK_LOG(debug) << "Opus decoder initialized: " << sample_rate << "Hz, " << num_channels << " channels";
+}
+
+// Decodes one packet and appends its samples to output_data
+static void decode_packet(OpusDecoderContext& ctx,
+                          const uint8_t* packet,
+                          size_t packet_size,
+                          int preferred_sample_rate,
+                          std::vector<uint8_t>& output_data) {
+    if (packet_size == 0) {
+        return;
+    }
+    if (!ctx.decoder) {
+        create_decoder(ctx, packet, preferred_sample_rate);
+    }
+
+    const int max_frames = static_cast<int>(ctx.pcm.size() / ctx.num_channels);
+    const int frames = opus_decode(ctx.decoder.get(), packet, static_cast<opus_int32>(packet_size), ctx.pcm.data(), max_frames, 0);
+    if (frames < 0) {
+        VIAM_SDK_LOG(error) << "Error decoding Opus packet: " << opus_strerror(frames) << " (code: " << frames << ")";
+        throw std::runtime_error("Opus decoding error");
+    }
+
+    const size_t bytes = static_cast<size_t>(frames) * ctx.num_channels * sizeof(int16_t);
+    const size_t current_size = output_data.size();
+    output_data.resize(current_size + bytes);
+    std::memcpy(output_data.data() + current_size, ctx.pcm.data(), bytes);
+}
+
+static size_t packet_length(const uint8_t* prefix) {
+    return static_cast<size_t>(prefix[0]) | (static_cast<size_t>(prefix[1]) << 8);
+}
+
+void decode_opus_chunk(
+    OpusDecoderContext& ctx, const uint8_t* encoded_data, size_t size, int preferred_sample_rate, std::vector<uint8_t>& output_data) {
+    constexpr size_t prefix_bytes = audio::codec::OPUS_LENGTH_PREFIX_BYTES;
+    if (size == 0) {
+        return;
+    }
+
+    const uint8_t* data = encoded_data;
+    size_t remaining = size;
+
+    // Finish a packet split across chunks first
+    if (!ctx.pending.empty()) {
+        if (ctx.pending.size() < prefix_bytes) {
+            const size_t taken = std::min(prefix_bytes - ctx.pending.size(), remaining);
+            ctx.pending.insert(ctx.pending.end(), data, data + taken);
+            data += taken;
+            remaining -= taken;
+            if (ctx.pending.size() < prefix_bytes) {
+                return;
+            }
+        }
+        const size_t total = prefix_bytes + packet_length(ctx.pending.data());
+        const size_t taken = std::min(total - ctx.pending.size(), remaining);
+        ctx.pending.insert(ctx.pending.end(), data, data + taken);
+        data += taken;
+        remaining -= taken;
+        if (ctx.pending.size() < total) {
+            return;
+        }
+        decode_packet(ctx, ctx.pending.data() + prefix_bytes, total - prefix_bytes, preferred_sample_rate, output_data);
+        ctx.pending.clear();
+    }
+
+    // Whole packets are decoded in place
+    while (remaining >= prefix_bytes) {
+        const size_t length = packet_length(data);
+        if (remaining < prefix_bytes + length) {
+            break;
+        }
+        decode_packet(ctx, data + prefix_bytes, length, preferred_sample_rate, output_data);
+        data += prefix_bytes + length;
+        remaining -= prefix_bytes + length;
+    }
+
+    ctx.pending.insert(ctx.pending.end(), data, data + remaining);
+}
+
+}  // namespace speaker
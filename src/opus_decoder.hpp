@@ -0,0 +1,36 @@
+#pragma once
+
+#include <opus/opus.h>
+#include <cstdint>
+#include <vector>
+#include "audio_utils.hpp"
+
+namespace speaker {
+
+using audio::utils::CleanupPtr;
+
+struct OpusDecoderContext {
+    CleanupPtr<opus_decoder_destroy> decoder = nullptr;
+
+    // Rate and channel count the decoder outputs, set when the first packet arrives. Opus
+    // decodes to any of its native rates regardless of the rate it was encoded at.
+    int sample_rate = 0;
+    int num_channels = 0;
+
+    // A length prefix or packet split across chunks
+    std::vector<uint8_t> pending;
+
+    // Interleaved output of one opus_decode call, reused for every packet
+    std::vector<int16_t> pcm;
+};
+
+// Decodes one piece of a length-prefixed Opus stream (see audio::codec::OPUS_LENGTH_PREFIX_BYTES),
+// e.g. a play_stream chunk. Chunks may split packets anywhere; output_data is appended with the
+// PCM16 of every packet completed so far, which may be nothing.
+// The decoder is created on the first packet, at preferred_sample_rate when Opus supports it
+// (48 kHz otherwise) and with the packet's channel count. Throws std::runtime_error on a
+// packet libopus rejects.
+void decode_opus_chunk(
+    OpusDecoderContext& ctx, const uint8_t* encoded_data, size_t size, int preferred_sample_rate, std::vector<uint8_t>& output_data);
+
+}  // namespace speaker
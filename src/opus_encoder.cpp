@@ -0,0 +1,129 @@
+#include "opus_encoder.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "audio_codec.hpp"
+
+namespace microphone {
+
+int parse_opus_frame_ms(const vsdk::ProtoStruct& attrs) {
+    if (!attrs.count("opus_frame_ms")) {
+        return OPUS_DEFAULT_FRAME_MS;
+    }
+    if (!attrs.at("opus_frame_ms").is_a<double>()) {
+        VIAM_SDK_LOG(error) << "opus_frame_ms must be a number";
+        throw std::invalid_argument("opus_frame_ms must be a number");
+    }
+    const double frame_ms = *attrs.at("opus_frame_ms").get<double>();
+    if (frame_ms != 10 && frame_ms != 20) {
+        VIAM_SDK_LOG(error) << "opus_frame_ms must be 10 or 20, got: " << frame_ms;
+        throw std::invalid_argument("opus_frame_ms must be 10 or 20");
+    }
+    return static_cast<int>(frame_ms);
+}
+
+void initialize_opus_encoder(OpusEncoderContext& ctx, int sample_rate, int num_channels, int frame_ms) {
+    if (!audio::codec::is_opus_sample_rate(sample_rate)) {
+        VIAM_SDK_LOG(error) << "Opus does not support a sample rate of " << sample_rate << "Hz";
+        throw std::invalid_argument("Opus sample rate must be 8000, 12000, 16000, 24000 or 48000 Hz");
+    }
+    if (num_channels != 1 && num_channels != 2) {
+        VIAM_SDK_LOG(error) << "Unsupported number of channels for Opus: " << num_channels;
+        throw std::invalid_argument("Opus supports only mono (1) and stereo (2)");
+    }
+
+    int error = OPUS_OK;
+    CleanupPtr<opus_encoder_destroy> encoder(opus_encoder_create(sample_rate, num_channels, OPUS_APPLICATION_VOIP, &error));
+    if (!encoder || error != OPUS_OK) {
+        VIAM_SDK_LOG(error) << "Failed to initialize Opus encoder: " << opus_strerror(error) << " (code: " << error << ")";
+        throw std::runtime_error("Failed to initialize Opus encoder");
+    }
+
+    opus_encoder_ctl(encoder.get(), OPUS_SET_BITRATE(OPUS_BIT_RATE_PER_CHANNEL * num_channels));
+
+    opus_int32 lookahead = 0;
+    opus_encoder_ctl(encoder.get(), OPUS_GET_LOOKAHEAD(&lookahead));
+
+    ctx.encoder = std::move(encoder);
+    ctx.sample_rate = sample_rate;
+    ctx.num_channels = num_channels;
+    ctx.frame_size = sample_rate * frame_ms / 1000;
+    ctx.encoder_delay = lookahead;
+    ctx.pending.clear();
+
+    VIAM_SDK_LOG(debug) << "Opus encoder initialized: " << sample_rate << "Hz, " << num_channels << " channels, "
+                        << OPUS_BIT_RATE_PER_CHANNEL * num_channels / 1000 << "kbps, " << frame_ms << "ms frames (" << ctx.frame_size
+                        << " samples/frame), encoder delay: " << ctx.encoder_delay << " samples";
+}
+
+void cleanup_opus_encoder(OpusEncoderContext& ctx) {
+    ctx.encoder.reset();
+    ctx.sample_rate = 0;
+    ctx.num_channels = 0;
+    ctx.frame_size = 0;
+    ctx.encoder_delay = 0;
+    ctx.pending.clear();
+}
+
+void encode_samples_to_opus(OpusEncoderContext& ctx, const int16_t* samples, int sample_count, std::vector<uint8_t>& output_data) {
+    if (!ctx.encoder) {
+        VIAM_SDK_LOG(error) << "encode_samples_to_opus: Opus encoder not initialized";
+        throw std::runtime_error("encode_samples_to_opus: Opus encoder not initialized");
+    }
+
+    if (samples == nullptr) {
+        VIAM_SDK_LOG(error) << "encode_samples_to_opus: samples pointer is null";
+        throw std::invalid_argument("encode_samples_to_opus: samples cannot be null");
+    }
+
+    if (sample_count <= 0) {
+        return;
+    }
+
+    const size_t frame_samples = static_cast<size_t>(ctx.frame_size) * ctx.num_channels;
+
+    // Frames are encoded straight from samples; only a frame split across calls goes through pending
+    const int16_t* input = samples;
+    size_t remaining = sample_count;
+    if (!ctx.pending.empty()) {
+        const size_t needed = frame_samples - ctx.pending.size();
+        const size_t taken = std::min(needed, remaining);
+        ctx.pending.insert(ctx.pending.end(), input, input + taken);
+        input += taken;
+        remaining -= taken;
+    }
+
+    const auto encode_frame = [&](const int16_t* frame) {
+        const size_t current_size = output_data.size();
+        output_data.resize(current_size + audio::codec::OPUS_LENGTH_PREFIX_BYTES + OPUS_MAX_PACKET_BYTES);
+        const opus_int32 bytes_written =
+            opus_encode(ctx.encoder.get(),
+                        frame,
+                        ctx.frame_size,
+                        output_data.data() + current_size + audio::codec::OPUS_LENGTH_PREFIX_BYTES,
+                        OPUS_MAX_PACKET_BYTES);
+        if (bytes_written < 0) {
+            output_data.resize(current_size);
+            VIAM_SDK_LOG(error) << "Error encoding Opus frame: " << opus_strerror(bytes_written) << " (code: " << bytes_written << ")";
+            throw std::runtime_error("Opus encoding error");
+        }
+        output_data[current_size] = static_cast<uint8_t>(bytes_written & 0xFF);
+        output_data[current_size + 1] = static_cast<uint8_t>((bytes_written >> 8) & 0xFF);
+        output_data.resize(current_size + audio::codec::OPUS_LENGTH_PREFIX_BYTES + bytes_written);
+    };
+
+    if (ctx.pending.size() == frame_samples) {
+        encode_frame(ctx.pending.data());
+        ctx.pending.clear();
+    }
+
+    while (remaining >= frame_samples) {
+        encode_frame(input);
+        input += frame_samples;
+        remaining -= frame_samples;
+    }
+
+    ctx.pending.insert(ctx.pending.end(), input, input + remaining);
+}
+
+}  // namespace microphone
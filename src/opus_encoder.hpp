@@ -0,0 +1,53 @@
+#pragma once
+
+#include <opus/opus.h>
+
+#include <cstdint>
+#include <vector>
+#include <viam/sdk/config/resource.hpp>
+#include "audio_utils.hpp"
+
+namespace microphone {
+namespace vsdk = ::viam::sdk;
+
+// Packet duration; each get_audio chunk is one packet. 20 ms is the usual choice for voice,
+// 10 ms halves the packetization delay at the cost of a somewhat higher bitrate.
+constexpr int OPUS_DEFAULT_FRAME_MS = 20;
+// 32 kbps per channel is transparent for speech and good for general audio
+constexpr int OPUS_BIT_RATE_PER_CHANNEL = 32000;
+// Largest packet libopus recommends allowing room for
+constexpr int OPUS_MAX_PACKET_BYTES = 4000;
+
+using audio::utils::CleanupPtr;
+
+struct OpusEncoderContext {
+    CleanupPtr<opus_encoder_destroy> encoder = nullptr;
+
+    int sample_rate = 0;
+    int num_channels = 0;
+
+    // Samples per channel in one packet
+    int frame_size = 0;
+
+    // Opus lookahead: how many samples (per channel) the decoded output lags the input
+    int encoder_delay = 0;
+
+    // Interleaved input left over from the last call, always less than one frame
+    std::vector<int16_t> pending;
+};
+
+// Reads the opus_frame_ms attribute (10 or 20), or returns OPUS_DEFAULT_FRAME_MS when it's
+// not set. Throws std::invalid_argument on any other value.
+int parse_opus_frame_ms(const vsdk::ProtoStruct& attrs);
+
+// sample_rate must be one Opus supports natively (see audio::codec::is_opus_sample_rate)
+// and num_channels 1 or 2.
+void initialize_opus_encoder(OpusEncoderContext& ctx, int sample_rate, int num_channels, int frame_ms = OPUS_DEFAULT_FRAME_MS);
+void cleanup_opus_encoder(OpusEncoderContext& ctx);
+
+// Encodes every complete frame of pending input plus samples, appending each packet to
+// output_data with its length prefix (audio::codec::OPUS_LENGTH_PREFIX_BYTES). Input beyond
+// the last complete frame is kept for the next call.
+void encode_samples_to_opus(OpusEncoderContext& ctx, const int16_t* samples, int sample_count, std::vector<uint8_t>& output_data);
+
+}  // namespace microphone
@@ -0,0 +1,354 @@
+#include "realtime.hpp"
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <viam/sdk/common/utils.hpp>
+
+namespace audio {
+namespace realtime {
+
+namespace {
+
+int native_policy(SchedPolicy policy) {
+    return policy == SchedPolicy::RR ? SCHED_RR : SCHED_FIFO;
+}
+
+std::string policy_name(SchedPolicy policy) {
+    return policy == SchedPolicy::RR ? "rr" : "fifo";
+}
+
+// Sets the calling thread's scheduling. Returns 0 or an errno value.
+int set_scheduling(int policy, int priority) {
+    sched_param param{};
+    param.sched_priority = priority;
+    return pthread_setschedparam(pthread_self(), policy, &param);
+}
+
+#ifdef __linux__
+int set_affinity(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+int get_affinity(std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    const int err = pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err == 0) {
+        cpus.clear();
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    return err;
+}
+#else
+// Thread affinity isn't exposed on macOS
+int set_affinity(const std::vector<int>&) {
+    return ENOTSUP;
+}
+
+int get_affinity(std::vector<int>&) {
+    return ENOTSUP;
+}
+#endif
+
+// Applies settings to the calling thread and records the outcome. Returns which parts were
+// applied, so a scoped caller knows what to restore.
+std::pair<bool, bool> apply(RealtimeSettings& settings) {
+    const RealtimeOptions& options = settings.options;
+    std::string error;
+    bool priority_ok = true;
+    bool affinity_ok = true;
+    if (options.priority > 0) {
+        const int err = set_scheduling(native_policy(options.policy), options.priority);
+        priority_ok = err == 0;
+        if (!priority_ok) {
+            error = "realtime_priority " + std::to_string(options.priority) + " (" + policy_name(options.policy) +
+                    ") not granted: " + std::strerror(err);
+        }
+    }
+    if (!options.cpus.empty()) {
+        const int err = set_affinity(options.cpus);
+        affinity_ok = err == 0;
+        if (!affinity_ok) {
+            error += (error.empty() ? "" : "; ") + std::string("cpu_affinity not applied: ") + std::strerror(err);
+        }
+    }
+    settings.record_thread(priority_ok, affinity_ok, error);
+    return {options.priority > 0 && priority_ok, !options.cpus.empty() && affinity_ok};
+}
+
+// mlock doesn't count: one munlock unlocks a page however many buffers locked it, and
+// small heap buffers share pages. So every locked page is counted here, process-wide, and
+// only unlocked when its last region lets go.
+class PageLocks {
+   public:
+    // Locks the pages spanning [data, data + bytes). Returns 0 or an errno value.
+    int lock(const void* data, size_t bytes) {
+        const auto [first, last] = span(data, bytes);
+        const std::lock_guard<std::mutex> lock(mu_);
+        // Always mlock, even pages already counted: one freed and remapped since is no longer
+        // locked, and mlock of a locked page is harmless
+        if (::mlock(reinterpret_cast<const void*>(first), last - first) != 0) {
+            const int err = errno;
+            // A failed mlock may have locked part of the range
+            unlock_uncounted(first, last);
+            return err;
+        }
+        for (uintptr_t page = first; page < last; page += page_size_) {
+            counts_[page]++;
+        }
+        return 0;
+    }
+
+    // Releases one lock on each page spanning [data, data + bytes) and munlocks those no
+    // other region still holds
+    void unlock(const void* data, size_t bytes) noexcept {
+        const auto [first, last] = span(data, bytes);
+        const std::lock_guard<std::mutex> lock(mu_);
+        for (uintptr_t page = first; page < last; page += page_size_) {
+            const auto it = counts_.find(page);
+            if (it != counts_.end() && --it->second == 0) {
+                counts_.erase(it);
+            }
+        }
+        unlock_uncounted(first, last);
+    }
+
+    size_t count(const void* address) {
+        const uintptr_t page = span(address, 1).first;
+        const std::lock_guard<std::mutex> lock(mu_);
+        const auto it = counts_.find(page);
+        return it == counts_.end() ? 0 : it->second;
+    }
+
+   private:
+    std::pair<uintptr_t, uintptr_t> span(const void* data, size_t bytes) const noexcept {
+        const auto begin = reinterpret_cast<uintptr_t>(data);
+        return {begin & ~(page_size_ - 1), (begin + bytes + page_size_ - 1) & ~(page_size_ - 1)};
+    }
+
+    // munlocks each run of pages in [first, last) that no region holds. Needs mu_. The pages
+    // may already have been freed (a vector that reallocated); munlock then fails or unlocks
+    // nothing another region holds, which is fine.
+    void unlock_uncounted(uintptr_t first, uintptr_t last) noexcept {
+        uintptr_t run = first;
+        for (uintptr_t page = first; page <= last; page += page_size_) {
+            if (page == last || counts_.count(page) != 0) {
+                if (page > run) {
+                    ::munlock(reinterpret_cast<const void*>(run), page - run);
+                }
+                run = page + page_size_;
+            }
+        }
+    }
+
+    const uintptr_t page_size_ = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+    std::mutex mu_;
+    std::map<uintptr_t, size_t> counts_;
+};
+
+PageLocks& page_locks() {
+    static PageLocks locks;
+    return locks;
+}
+
+}  // namespace
+
+RealtimeOptions parse_realtime_options(const vsdk::ProtoStruct& attrs) {
+    RealtimeOptions options;
+    if (attrs.count("realtime_priority")) {
+        const auto* value = attrs.at("realtime_priority").get<double>();
+        if (!value || *value != static_cast<int>(*value) || *value < MIN_REALTIME_PRIORITY || *value > MAX_REALTIME_PRIORITY) {
+            VIAM_SDK_LOG(error) << "[validate] realtime_priority must be an integer between " << MIN_REALTIME_PRIORITY << " and "
+                                << MAX_REALTIME_PRIORITY;
+            throw std::invalid_argument("realtime_priority must be an integer between " + std::to_string(MIN_REALTIME_PRIORITY) +
+                                        " and " + std::to_string(MAX_REALTIME_PRIORITY));
+        }
+        options.priority = static_cast<int>(*value);
+    }
+
+    if (attrs.count("realtime_policy")) {
+        const auto* value = attrs.at("realtime_policy").get<std::string>();
+        if (!value || (*value != "fifo" && *value != "rr")) {
+            VIAM_SDK_LOG(error) << "[validate] realtime_policy must be \"fifo\" or \"rr\"";
+            throw std::invalid_argument("realtime_policy must be \"fifo\" or \"rr\"");
+        }
+        options.policy = *value == "rr" ? SchedPolicy::RR : SchedPolicy::FIFO;
+    }
+
+    if (attrs.count("cpu_affinity")) {
+        const auto* list = attrs.at("cpu_affinity").get<vsdk::ProtoList>();
+        if (!list || list->empty()) {
+            VIAM_SDK_LOG(error) << "[validate] cpu_affinity must be a non-empty list of CPU indices";
+            throw std::invalid_argument("cpu_affinity must be a non-empty list of CPU indices");
+        }
+        for (const auto& entry : *list) {
+            const auto* cpu = entry.get<double>();
+            if (!cpu || *cpu != static_cast<int>(*cpu) || *cpu < 0 || *cpu >= 1024) {
+                VIAM_SDK_LOG(error) << "[validate] cpu_affinity entries must be CPU indices between 0 and 1023";
+                throw std::invalid_argument("cpu_affinity entries must be CPU indices between 0 and 1023");
+            }
+            options.cpus.push_back(static_cast<int>(*cpu));
+        }
+    }
+
+    if (attrs.count("mlock")) {
+        const auto* value = attrs.at("mlock").get<bool>();
+        if (!value) {
+            VIAM_SDK_LOG(error) << "[validate] mlock attribute must be a boolean";
+            throw std::invalid_argument("mlock attribute must be a boolean");
+        }
+        options.lock_memory = *value;
+    }
+    return options;
+}
+
+void RealtimeSettings::record_thread(bool priority_ok, bool affinity_ok, const std::string& error) {
+    threads_.fetch_add(1, std::memory_order_relaxed);
+    if (!priority_ok) {
+        priority_failures_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!affinity_ok) {
+        affinity_failures_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!error.empty()) {
+        record_error(error);
+    }
+}
+
+void RealtimeSettings::record_lock(size_t bytes) noexcept {
+    locked_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void RealtimeSettings::record_unlock(size_t bytes) noexcept {
+    locked_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void RealtimeSettings::record_lock_failure(const std::string& error) {
+    lock_failures_.fetch_add(1, std::memory_order_relaxed);
+    record_error(error);
+}
+
+void RealtimeSettings::record_error(const std::string& error) {
+    std::lock_guard<std::mutex> lock(error_mu_);
+    // Every thread and buffer hits the same refusal, so only log when it changes
+    if (error != last_error_) {
+        VIAM_SDK_LOG(warn) << "[realtime] " << error;
+        last_error_ = error;
+    }
+}
+
+vsdk::ProtoStruct RealtimeSettings::to_struct() {
+    const uint64_t threads = threads_.load(std::memory_order_relaxed);
+    const uint64_t priority_failures = priority_failures_.load(std::memory_order_relaxed);
+    const uint64_t affinity_failures = affinity_failures_.load(std::memory_order_relaxed);
+    const uint64_t lock_failures = lock_failures_.load(std::memory_order_relaxed);
+
+    vsdk::ProtoStruct result{{"threads", static_cast<double>(threads)}};
+    if (options.priority > 0) {
+        result["priority"] = static_cast<double>(options.priority);
+        result["policy"] = policy_name(options.policy);
+        result["priority_honored"] = threads > 0 && priority_failures == 0;
+        result["priority_failures"] = static_cast<double>(priority_failures);
+    }
+    if (!options.cpus.empty()) {
+        vsdk::ProtoList cpus;
+        for (int cpu : options.cpus) {
+            cpus.push_back(static_cast<double>(cpu));
+        }
+        result["cpu_affinity"] = std::move(cpus);
+        result["affinity_honored"] = threads > 0 && affinity_failures == 0;
+        result["affinity_failures"] = static_cast<double>(affinity_failures);
+    }
+    if (options.lock_memory) {
+        result["mlock_honored"] = lock_failures == 0;
+        result["mlock_failures"] = static_cast<double>(lock_failures);
+        result["locked_bytes"] = static_cast<double>(locked_bytes_.load(std::memory_order_relaxed));
+    }
+    std::lock_guard<std::mutex> lock(error_mu_);
+    if (!last_error_.empty()) {
+        result["last_error"] = last_error_;
+    }
+    return result;
+}
+
+ScopedThreadSettings::ScopedThreadSettings(const std::shared_ptr<RealtimeSettings>& settings) {
+    if (!settings || !settings->options.configures_threads()) {
+        return;
+    }
+    sched_param param{};
+    const bool have_scheduling = pthread_getschedparam(pthread_self(), &previous_policy_, &param) == 0;
+    previous_priority_ = param.sched_priority;
+    const bool have_affinity = settings->options.cpus.empty() || get_affinity(previous_cpus_) == 0;
+
+    const auto applied = apply(*settings);
+    restore_priority_ = applied.first && have_scheduling;
+    restore_affinity_ = applied.second && have_affinity;
+}
+
+ScopedThreadSettings::~ScopedThreadSettings() {
+    if (restore_priority_) {
+        set_scheduling(previous_policy_, previous_priority_);
+    }
+    if (restore_affinity_) {
+        set_affinity(previous_cpus_);
+    }
+}
+
+void apply_to_current_thread(const std::shared_ptr<RealtimeSettings>& settings) {
+    if (settings && settings->options.configures_threads()) {
+        apply(*settings);
+    }
+}
+
+void LockedRegion::update(const void* data, size_t bytes, const std::shared_ptr<RealtimeSettings>& settings) {
+    if (!settings || !settings->options.lock_memory || (data == data_ && bytes == bytes_)) {
+        return;
+    }
+    reset();
+    if (!data || bytes == 0) {
+        return;
+    }
+    if (const int err = page_locks().lock(data, bytes)) {
+        settings->record_lock_failure("mlock of " + std::to_string(bytes) + " bytes failed: " + std::strerror(err));
+        return;
+    }
+    data_ = data;
+    bytes_ = bytes;
+    settings_ = settings;
+    settings_->record_lock(bytes);
+}
+
+void LockedRegion::reset() noexcept {
+    if (!data_) {
+        return;
+    }
+    page_locks().unlock(data_, bytes_);
+    settings_->record_unlock(bytes_);
+    data_ = nullptr;
+    bytes_ = 0;
+    settings_.reset();
+}
+
+size_t page_lock_count(const void* address) {
+    return page_locks().count(address);
+}
+
+}  // namespace realtime
+}  // namespace audio
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <viam/sdk/common/proto_value.hpp>
+
+namespace audio {
+namespace realtime {
+
+namespace vsdk = ::viam::sdk;
+
+// Accepted range for the realtime_priority attribute (the POSIX real-time range on Linux)
+constexpr int MIN_REALTIME_PRIORITY = 1;
+constexpr int MAX_REALTIME_PRIORITY = 99;
+
+enum class SchedPolicy { FIFO, RR };
+
+// The realtime_priority, realtime_policy, cpu_affinity and mlock attributes
+struct RealtimeOptions {
+    // Real-time priority for the module's audio threads; 0 leaves their scheduling alone
+    int priority = 0;
+    SchedPolicy policy = SchedPolicy::FIFO;
+    // CPUs the audio threads are pinned to; empty leaves their affinity alone
+    std::vector<int> cpus;
+    // Lock the ring buffers and codec scratch buffers in RAM
+    bool lock_memory = false;
+
+    bool configures_threads() const {
+        return priority > 0 || !cpus.empty();
+    }
+    bool enabled() const {
+        return configures_threads() || lock_memory;
+    }
+};
+
+// Reads the real-time attributes present in attrs. Throws std::invalid_argument on a wrong
+// type or out-of-range value, so it also serves as validation.
+RealtimeOptions parse_realtime_options(const vsdk::ProtoStruct& attrs);
+
+// A resource's real-time options and what the OS actually granted. Owned by the resource and
+// shared with whatever applies the options (threads, rings, scratch buffers). The OS may
+// refuse any of them, e.g. SCHED_FIFO without CAP_SYS_NICE or mlock past RLIMIT_MEMLOCK;
+// that's logged once and counted, and the audio carries on without it.
+class RealtimeSettings {
+   public:
+    explicit RealtimeSettings(RealtimeOptions options) : options(std::move(options)) {}
+
+    const RealtimeOptions options;
+
+    // Records one thread the options were applied to; error describes whatever failed
+    void record_thread(bool priority_ok, bool affinity_ok, const std::string& error);
+    void record_lock(size_t bytes) noexcept;
+    void record_unlock(size_t bytes) noexcept;
+    void record_lock_failure(const std::string& error);
+
+    // What was requested, whether each part was honored, and the last error. Reported
+    // under "realtime" by get_status / get_stats.
+    vsdk::ProtoStruct to_struct();
+
+   private:
+    void record_error(const std::string& error);
+
+    std::atomic<uint64_t> threads_{0};
+    std::atomic<uint64_t> priority_failures_{0};
+    std::atomic<uint64_t> affinity_failures_{0};
+    std::atomic<uint64_t> locked_bytes_{0};
+    std::atomic<uint64_t> lock_failures_{0};
+    std::mutex error_mu_;
+    std::string last_error_;
+};
+
+// Applies the priority and CPU affinity to the calling thread and restores the thread's
+// previous settings on destruction. For threads the module borrows for a call, like the gRPC
+// thread running get_audio or play_stream. A no-op when settings is null or doesn't configure
+// threads.
+class ScopedThreadSettings {
+   public:
+    explicit ScopedThreadSettings(const std::shared_ptr<RealtimeSettings>& settings);
+    ~ScopedThreadSettings();
+
+    ScopedThreadSettings(const ScopedThreadSettings&) = delete;
+    ScopedThreadSettings& operator=(const ScopedThreadSettings&) = delete;
+
+   private:
+    bool restore_priority_ = false;
+    int previous_policy_ = 0;
+    int previous_priority_ = 0;
+    bool restore_affinity_ = false;
+    std::vector<int> previous_cpus_;
+};
+
+// Applies the priority and CPU affinity to the calling thread for good. For threads the
+// module owns, like the speaker's mixer and the stall watchdogs. A no-op when settings is
+// null or doesn't configure threads.
+void apply_to_current_thread(const std::shared_ptr<RealtimeSettings>& settings);
+
+// One buffer kept locked in RAM. update() is called after the buffer may have moved or grown
+// and only touches the page tables when it has. Pages shared with other regions stay locked
+// until every region holding them lets go.
+class LockedRegion {
+   public:
+    LockedRegion() = default;
+    ~LockedRegion() {
+        reset();
+    }
+
+    LockedRegion(const LockedRegion&) = delete;
+    LockedRegion& operator=(const LockedRegion&) = delete;
+
+    // Locks [data, data + bytes), unlocking the previously locked range if it differs. A no-op
+    // when settings is null or doesn't lock memory.
+    void update(const void* data, size_t bytes, const std::shared_ptr<RealtimeSettings>& settings);
+
+    // Unlocks the current range
+    void reset() noexcept;
+
+    size_t locked_bytes() const noexcept {
+        return bytes_;
+    }
+
+   private:
+    const void* data_ = nullptr;
+    size_t bytes_ = 0;
+    std::shared_ptr<RealtimeSettings> settings_;
+};
+
+// Locks a vector's whole capacity, so later growth within it stays resident
+template <typename T>
+void lock_vector(LockedRegion& region, const std::vector<T>& buffer, const std::shared_ptr<RealtimeSettings>& settings) {
+    region.update(buffer.data(), buffer.capacity() * sizeof(T), settings);
+}
+
+// How many LockedRegions currently hold the page containing address. Pages are only
+// munlocked once this drops to zero.
+size_t page_lock_count(const void* address);
+
+}  // namespace realtime
+}  // namespace audio
@@ -1,10 +1,96 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
 #include <sstream>
+#include <stdexcept>
+#include <string>
 #include <vector>
+#include "audio_codec.hpp"
 #include "soxr.h"
 
+// Resampler quality profiles, mapped onto soxr recipes. High matches soxr's default, which is
+// what every resample used before this was configurable.
+enum class ResampleQuality { Quick, Low, Medium, High, VeryHigh };
+
+struct ResampleOptions {
+    ResampleQuality quality = ResampleQuality::High;
+    // Use a minimum-phase filter: much lower group delay, at the cost of phase linearity
+    bool low_latency = false;
+};
+
+// Parse a resample_quality attribute value (quick, low, medium, high, very_high)
+// Throws std::invalid_argument if the name is unknown
+inline ResampleQuality parse_resample_quality(const std::string& name) {
+    if (name == "quick") {
+        return ResampleQuality::Quick;
+    }
+    if (name == "low") {
+        return ResampleQuality::Low;
+    }
+    if (name == "medium") {
+        return ResampleQuality::Medium;
+    }
+    if (name == "high") {
+        return ResampleQuality::High;
+    }
+    if (name == "very_high") {
+        return ResampleQuality::VeryHigh;
+    }
+    throw std::invalid_argument("resample_quality must be one of quick, low, medium, high, very_high; got: " + name);
+}
+
+inline std::string resample_quality_name(ResampleQuality quality) {
+    switch (quality) {
+        case ResampleQuality::Quick:
+            return "quick";
+        case ResampleQuality::Low:
+            return "low";
+        case ResampleQuality::Medium:
+            return "medium";
+        case ResampleQuality::High:
+            return "high";
+        case ResampleQuality::VeryHigh:
+            return "very_high";
+    }
+    return "high";
+}
+
+inline unsigned long soxr_recipe(ResampleQuality quality) {
+    switch (quality) {
+        case ResampleQuality::Quick:
+            return SOXR_QQ;
+        case ResampleQuality::Low:
+            return SOXR_LQ;
+        case ResampleQuality::Medium:
+            return SOXR_MQ;
+        case ResampleQuality::High:
+            return SOXR_HQ;
+        case ResampleQuality::VeryHigh:
+            return SOXR_VHQ;
+    }
+    return SOXR_HQ;
+}
+
+inline soxr_quality_spec_t make_quality_spec(const ResampleOptions& options) {
+    const unsigned long phase = options.low_latency ? SOXR_MINIMUM_PHASE : SOXR_LINEAR_PHASE;
+    return soxr_quality_spec(soxr_recipe(options.quality) | phase, 0);
+}
+
+// Human-readable soxr recipe, e.g. "SOXR_HQ | SOXR_MINIMUM_PHASE"
+inline std::string soxr_recipe_name(const ResampleOptions& options) {
+    static const char* const names[] = {"SOXR_QQ", "SOXR_LQ", "SOXR_MQ", "SOXR_HQ", "SOXR_VHQ"};
+    std::string name = names[static_cast<int>(options.quality)];
+    if (options.low_latency) {
+        name += " | SOXR_MINIMUM_PHASE";
+    }
+    return name;
+}
+
 // Resample PCM16 audio from one sample rate to another
 // input_samples: pointer to input int16_t samples
 // input_sample_count: total number of samples (frames * channels)
@@ -14,7 +100,8 @@ inline void resample_audio(int input_sample_rate,
                            int num_channels,
                            const int16_t* input_samples,
                            size_t input_sample_count,
-                           std::vector<int16_t>& output_samples) {
+                           std::vector<int16_t>& output_samples,
+                           const ResampleOptions& options = ResampleOptions{}) {
     // soxr_oneshot expects "samples per channel" (frames), not total samples
     size_t input_frames = input_sample_count / num_channels;
 
@@ -28,6 +115,7 @@ inline void resample_audio(int input_sample_rate,
 
     // Specify I/O format as int16 (default is float32)
     soxr_io_spec_t io_spec = soxr_io_spec(SOXR_INT16_I, SOXR_INT16_I);
+    const soxr_quality_spec_t quality_spec = make_quality_spec(options);
 
     size_t output_done_frames = 0;
     soxr_error_t err = soxr_oneshot(input_sample_rate,
@@ -40,8 +128,8 @@ inline void resample_audio(int input_sample_rate,
                                     output_frames,
                                     &output_done_frames,
                                     &io_spec,
-                                    NULL,
-                                    NULL  // default configuration
+                                    &quality_spec,
+                                    NULL  // default runtime configuration
     );
     if (err) {
         std::ostringstream buffer;
@@ -56,30 +144,274 @@ inline void resample_audio(int input_sample_rate,
     output_samples.resize(output_done_samples);
 }
 
-// Convert PCM16 audio between channel counts.
-// Supports mono→stereo (duplicate) and stereo→mono (average L+R).
-// output_samples will be resized and filled with converted data.
-inline void convert_channels(const int16_t* input_samples,
-                             size_t input_sample_count,
-                             int input_channels,
-                             int output_channels,
-                             std::vector<int16_t>& output_samples) {
-    if (input_channels == 1 && output_channels == 2) {
-        // Mono → stereo: duplicate each sample to both channels
-        output_samples.resize(input_sample_count * 2);
-        for (size_t i = 0; i < input_sample_count; i++) {
-            output_samples[i * 2] = input_samples[i];
-            output_samples[i * 2 + 1] = input_samples[i];
+// Stateful PCM16 resampler for one get_audio/play_stream session.
+// resample_audio runs soxr_oneshot, which rebuilds the filter on every call and starts each
+// chunk with an empty history. This keeps one soxr_t alive instead, so consecutive chunks are
+// filtered as a single continuous signal with no boundary artifacts. Because the filter holds
+// samples back, process() may return fewer samples than the rate ratio implies;
+// call flush() once at end-of-stream to drain the remainder.
+class StreamingResampler {
+   public:
+    StreamingResampler(int input_sample_rate, int output_sample_rate, int num_channels, const ResampleOptions& options = ResampleOptions{})
+        : input_sample_rate_(input_sample_rate), output_sample_rate_(output_sample_rate), num_channels_(num_channels) {
+        // Specify I/O format as int16 (default is float32)
+        const soxr_io_spec_t io_spec = soxr_io_spec(SOXR_INT16_I, SOXR_INT16_I);
+        const soxr_quality_spec_t quality_spec = make_quality_spec(options);
+        soxr_error_t err = nullptr;
+        soxr_.reset(soxr_create(input_sample_rate, output_sample_rate, num_channels, &err, &io_spec, &quality_spec, NULL));
+        if (err || !soxr_) {
+            std::ostringstream buffer;
+            buffer << "failed to create resampler: " << soxr_strerror(err);
+            VIAM_SDK_LOG(error) << buffer.str();
+            throw std::runtime_error(buffer.str());
         }
-    } else if (input_channels == 2 && output_channels == 1) {
-        // Stereo → mono: average left and right channels
-        output_samples.resize(input_sample_count / 2);
-        for (size_t i = 0; i < input_sample_count / 2; i++) {
-            output_samples[i] =
-                static_cast<int16_t>((static_cast<int32_t>(input_samples[i * 2]) + static_cast<int32_t>(input_samples[i * 2 + 1])) / 2);
+    }
+
+    // Resamples input_sample_count samples (frames * channels). output_samples is resized
+    // and filled with whatever the filter produced for this input.
+    void process(const int16_t* input_samples, size_t input_sample_count, std::vector<int16_t>& output_samples) {
+        const size_t input_frames = input_sample_count / num_channels_;
+        input_frames_total_ += input_frames;
+        run(input_samples, input_frames, output_samples);
+    }
+
+    // Drains the samples still held in the filter. The total output across the session is
+    // trimmed to the same length resample_audio would produce for the whole input.
+    void flush(std::vector<int16_t>& output_samples) {
+        const uint64_t expected_frames =
+            static_cast<uint64_t>(std::lround(static_cast<double>(input_frames_total_) * output_sample_rate_ / input_sample_rate_));
+        const uint64_t tail_frames = expected_frames > output_frames_total_ ? expected_frames - output_frames_total_ : 0;
+        run(nullptr, 0, output_samples, static_cast<size_t>(tail_frames));
+        reset();
+    }
+
+    // Drops all filter history, e.g. when the source stream is restarted.
+    void reset() {
+        soxr_clear(soxr_.get());
+        input_frames_total_ = 0;
+        output_frames_total_ = 0;
+    }
+
+    int input_sample_rate() const {
+        return input_sample_rate_;
+    }
+    int output_sample_rate() const {
+        return output_sample_rate_;
+    }
+
+   private:
+    struct SoxrDeleter {
+        void operator()(soxr_t soxr) const {
+            soxr_delete(soxr);
+        }
+    };
+
+    // Feeds input_frames frames (or the end-of-input marker when input_samples is null) and
+    // collects the output, growing output_samples if the filter has more than expected.
+    // When draining, stops once max_output_frames have been collected.
+    void run(const int16_t* input_samples,
+             size_t input_frames,
+             std::vector<int16_t>& output_samples,
+             size_t max_output_frames = std::numeric_limits<size_t>::max()) {
+        size_t capacity_frames =
+            static_cast<size_t>(std::ceil(static_cast<double>(input_frames) * output_sample_rate_ / input_sample_rate_)) + 64;
+        capacity_frames = std::min(capacity_frames, max_output_frames);
+        output_samples.resize(capacity_frames * num_channels_);
+        if (capacity_frames == 0) {
+            return;
+        }
+
+        size_t consumed_frames = 0;
+        size_t produced_frames = 0;
+        while (true) {
+            size_t input_done = 0;
+            size_t output_done = 0;
+            const int16_t* in = input_samples ? input_samples + consumed_frames * num_channels_ : nullptr;
+            soxr_error_t err = soxr_process(soxr_.get(),
+                                            in,
+                                            input_samples ? input_frames - consumed_frames : 0,
+                                            &input_done,
+                                            output_samples.data() + produced_frames * num_channels_,
+                                            capacity_frames - produced_frames,
+                                            &output_done);
+            if (err) {
+                std::ostringstream buffer;
+                buffer << "failed to resample: " << soxr_strerror(err);
+                VIAM_SDK_LOG(error) << buffer.str();
+                throw std::runtime_error(buffer.str());
+            }
+            consumed_frames += input_done;
+            produced_frames += output_done;
+
+            if (produced_frames == max_output_frames) {
+                break;
+            }
+            if (produced_frames == capacity_frames) {
+                // Output space ran out; there may be more to collect.
+                capacity_frames = std::min(capacity_frames * 2, max_output_frames);
+                output_samples.resize(capacity_frames * num_channels_);
+                continue;
+            }
+            const bool input_finished = input_samples ? consumed_frames == input_frames : output_done == 0;
+            if (input_finished || (input_done == 0 && output_done == 0)) {
+                break;
+            }
         }
-    } else {
+
+        output_frames_total_ += produced_frames;
+        output_samples.resize(produced_frames * num_channels_);
+    }
+
+    int input_sample_rate_;
+    int output_sample_rate_;
+    int num_channels_;
+    std::unique_ptr<struct soxr, SoxrDeleter> soxr_;
+    uint64_t input_frames_total_ = 0;
+    uint64_t output_frames_total_ = 0;
+};
+
+// Gains for mixing input_channels into output_channels, stored row-major by output channel:
+// output[o] = sum over i of gains[o * input_channels + i] * input[i]
+struct ChannelMatrix {
+    int input_channels = 0;
+    int output_channels = 0;
+    std::vector<float> gains;
+
+    float gain(int output_channel, int input_channel) const {
+        return gains[static_cast<size_t>(output_channel) * input_channels + input_channel];
+    }
+};
+
+// Default mix between any two channel counts:
+//   same count:   identity
+//   upmix (N→M):  output o copies input o % N (mono is duplicated, stereo alternates L/R)
+//   downmix:      output o is the average of every input i with i % M == o
+//                 (stereo→mono and 4→2 average pairs, N→mono averages everything)
+inline ChannelMatrix default_channel_matrix(int input_channels, int output_channels) {
+    if (input_channels <= 0 || output_channels <= 0) {
         throw std::invalid_argument("Unsupported channel conversion from " + std::to_string(input_channels) + " to " +
                                     std::to_string(output_channels) + " channels");
     }
+    ChannelMatrix matrix{input_channels, output_channels, std::vector<float>(static_cast<size_t>(input_channels) * output_channels, 0.0f)};
+    for (int o = 0; o < output_channels; o++) {
+        if (output_channels >= input_channels) {
+            matrix.gains[static_cast<size_t>(o) * input_channels + o % input_channels] = 1.0f;
+            continue;
+        }
+        int sources = 0;
+        for (int i = o; i < input_channels; i += output_channels) {
+            sources++;
+        }
+        for (int i = o; i < input_channels; i += output_channels) {
+            matrix.gains[static_cast<size_t>(o) * input_channels + i] = 1.0f / sources;
+        }
+    }
+    return matrix;
+}
+
+// True if matrix only copies each output channel from input o % input_channels, as the default
+// does for same-count and upmix conversions
+inline bool is_copy_matrix(const ChannelMatrix& matrix) {
+    if (matrix.output_channels < matrix.input_channels) {
+        return false;
+    }
+    for (int o = 0; o < matrix.output_channels; o++) {
+        for (int i = 0; i < matrix.input_channels; i++) {
+            if (matrix.gain(o, i) != (i == o % matrix.input_channels ? 1.0f : 0.0f)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// True if matrix averages every input channel into one output, as the default N→mono does
+inline bool is_average_to_mono_matrix(const ChannelMatrix& matrix) {
+    const float share = 1.0f / matrix.input_channels;
+    return matrix.output_channels == 1 &&
+           std::all_of(matrix.gains.begin(), matrix.gains.end(), [share](float gain) { return gain == share; });
+}
+
+// Mixes interleaved PCM16 through matrix into output, which must hold
+// (input_sample_count / matrix.input_channels) * matrix.output_channels samples.
+// Writes straight into the caller's buffer so nothing is allocated per chunk.
+//
+// The shapes the default matrix produces skip the gain loop: copies and upmixes move samples
+// (mono→stereo with the codec's NEON/SSE2 interleave), and N→mono sums in int32 and divides,
+// stereo with a NEON/SSE2 kernel. Any other matrix accumulates each output sample in float,
+// truncates toward zero and saturates to int16. Float holds sums of int16 exactly, so the
+// two agree wherever the gains are exact in float (1/2, 1/4); for 1/3 or 1/6 the integer
+// path gives the exact average where float rounding could land one below.
+inline void mix_channels(const int16_t* input_samples, size_t input_sample_count, const ChannelMatrix& matrix, int16_t* output_samples) {
+    const int in_ch = matrix.input_channels;
+    const int out_ch = matrix.output_channels;
+    const size_t frames = input_sample_count / in_ch;
+    const float* gains = matrix.gains.data();
+
+    if (is_copy_matrix(matrix)) {
+        if (in_ch == out_ch) {
+            std::memcpy(output_samples, input_samples, frames * in_ch * sizeof(int16_t));
+        } else if (in_ch == 1 && out_ch == 2) {
+            audio::codec::interleave_stereo_pcm16(input_samples, input_samples, output_samples, frames);
+        } else {
+            for (size_t f = 0; f < frames; f++) {
+                const int16_t* in = input_samples + f * in_ch;
+                int16_t* out = output_samples + f * out_ch;
+                for (int o = 0; o < out_ch; o++) {
+                    out[o] = in[o % in_ch];
+                }
+            }
+        }
+        return;
+    }
+    if (is_average_to_mono_matrix(matrix)) {
+        if (in_ch == 2) {
+            audio::codec::downmix_stereo_pcm16(input_samples, output_samples, frames);
+            return;
+        }
+        for (size_t f = 0; f < frames; f++) {
+            const int16_t* in = input_samples + f * in_ch;
+            int32_t sum = 0;
+            for (int i = 0; i < in_ch; i++) {
+                sum += in[i];
+            }
+            output_samples[f] = static_cast<int16_t>(sum / in_ch);
+        }
+        return;
+    }
+
+    for (size_t f = 0; f < frames; f++) {
+        const int16_t* in = input_samples + f * in_ch;
+        int16_t* out = output_samples + f * out_ch;
+        for (int o = 0; o < out_ch; o++) {
+            const float* row = gains + static_cast<size_t>(o) * in_ch;
+            float acc = 0.0f;
+            for (int i = 0; i < in_ch; i++) {
+                acc += row[i] * static_cast<float>(in[i]);
+            }
+            acc = std::max(-32768.0f, std::min(32767.0f, acc));
+            out[o] = static_cast<int16_t>(acc);
+        }
+    }
+}
+
+// Convert PCM16 audio between channel counts using matrix.
+// output_samples will be resized and filled with converted data; its capacity is reused, so
+// callers that keep the vector across chunks don't allocate once it has grown.
+inline void convert_channels(const int16_t* input_samples,
+                             size_t input_sample_count,
+                             const ChannelMatrix& matrix,
+                             std::vector<int16_t>& output_samples) {
+    output_samples.resize(input_sample_count / matrix.input_channels * matrix.output_channels);
+    mix_channels(input_samples, input_sample_count, matrix, output_samples.data());
+}
+
+// Convert PCM16 audio between channel counts with default_channel_matrix.
+// Mono→stereo duplicates, stereo→mono averages L+R, and other counts follow the rules above.
+inline void convert_channels(const int16_t* input_samples,
+                             size_t input_sample_count,
+                             int input_channels,
+                             int output_channels,
+                             std::vector<int16_t>& output_samples) {
+    convert_channels(input_samples, input_sample_count, default_channel_matrix(input_channels, output_channels), output_samples);
 }
@@ -0,0 +1,86 @@
+#include "shared_ring.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <viam/sdk/common/utils.hpp>
+
+namespace audio {
+namespace shm {
+
+std::string ring_name(const std::string& resource_name) {
+    return "/viam-audio-" + resource_name;
+}
+
+SharedRing::SharedRing(std::string name, AudioBuffer& buffer)
+    : name(std::move(name)), size(RING_HEADER_BYTES + buffer.memory_bytes()), buffer_(buffer) {
+    // A ring left behind by a crashed process would otherwise make the exclusive create fail.
+    // Readers still mapping it keep their (now frozen) copy.
+    ::shm_unlink(this->name.c_str());
+    fd_ = ::shm_open(this->name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd_ < 0) {
+        VIAM_SDK_LOG(error) << "[SharedRing] Failed to create " << this->name << ": " << std::strerror(errno);
+        throw std::runtime_error("Failed to create shared memory " + this->name + ": " + std::strerror(errno));
+    }
+    // shm_open's mode is filtered through the umask
+    ::fchmod(fd_, 0644);
+
+    // Reserve the pages up front where we can, so a full /dev/shm fails here rather than as a
+    // SIGBUS in the audio callback
+#ifdef __linux__
+    const int sized = ::posix_fallocate(fd_, 0, static_cast<off_t>(size));
+#else
+    const int sized = ::ftruncate(fd_, static_cast<off_t>(size)) == 0 ? 0 : errno;
+#endif
+    void* map = sized == 0 ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0) : MAP_FAILED;
+    if (map == MAP_FAILED) {
+        const int error = sized != 0 ? sized : errno;
+        ::close(fd_);
+        ::shm_unlink(this->name.c_str());
+        VIAM_SDK_LOG(error) << "[SharedRing] Failed to map " << size << " bytes of " << this->name << ": " << std::strerror(error);
+        throw std::runtime_error("Failed to map shared memory " + this->name + ": " + std::strerror(error));
+    }
+
+    header_ = new (map) RingHeader();
+    std::memcpy(header_->magic, RING_MAGIC, sizeof(RING_MAGIC));
+    header_->version = RING_VERSION;
+    header_->header_bytes = static_cast<uint32_t>(RING_HEADER_BYTES);
+    header_->sample_rate = static_cast<uint32_t>(buffer.info.sample_rate_hz);
+    header_->num_channels = static_cast<uint32_t>(buffer.info.num_channels);
+    header_->sample_format = static_cast<uint32_t>(buffer.sample_format);
+    header_->sample_bytes = static_cast<uint32_t>(sample_bytes(buffer.sample_format));
+    header_->ring_samples = buffer.ring_size;
+    header_->capacity_samples = static_cast<uint64_t>(buffer.buffer_capacity);
+    buffer.share(static_cast<uint8_t*>(map) + RING_HEADER_BYTES, &header_->cursor);
+
+    VIAM_SDK_LOG(info) << "[SharedRing] Exporting " << buffer.info.sample_rate_hz << " Hz, " << buffer.info.num_channels << " channel "
+                       << sample_format_name(buffer.sample_format) << " audio as " << this->name << " (" << size << " bytes)";
+}
+
+SharedRing::~SharedRing() {
+    header_->closed.store(1, std::memory_order_release);
+    // The buffer is going away with us; make sure nothing touches the mapping after this
+    buffer_.shared_cursor = nullptr;
+    buffer_.ring_lock.reset();
+
+    // A reconfigured microphone builds its new ring before the old one is destroyed, so the
+    // name is only ours to remove if it still refers to this object
+    struct stat ours {};
+    struct stat current {};
+    const int current_fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (current_fd >= 0) {
+        if (::fstat(fd_, &ours) == 0 && ::fstat(current_fd, &current) == 0 && ours.st_dev == current.st_dev && ours.st_ino == current.st_ino) {
+            ::shm_unlink(name.c_str());
+        }
+        ::close(current_fd);
+    }
+    ::munmap(header_, size);
+    ::close(fd_);
+}
+
+}  // namespace shm
+}  // namespace audio
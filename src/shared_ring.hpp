@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include "audio_buffer.hpp"
+
+namespace audio {
+namespace shm {
+
+constexpr char RING_MAGIC[8] = {'V', 'I', 'A', 'M', 'R', 'I', 'N', 'G'};
+// Bumped whenever RingHeader's layout changes
+constexpr uint32_t RING_VERSION = 1;
+// The samples start this far into the mapping, on a page boundary of their own
+constexpr size_t RING_HEADER_BYTES = 4096;
+
+// Start of an exported ring. Plain fixed-width fields in native byte order, so a reader in any
+// language can map it (offsets are listed in the README). Everything but cursor and closed is
+// written once, before the name becomes visible.
+struct RingHeader {
+    char magic[8];
+    uint32_t version;
+    // Offset of the samples from the start of the mapping
+    uint32_t header_bytes;
+    uint32_t sample_rate;
+    // Interleaved channels per frame
+    uint32_t num_channels;
+    // SampleFormat: 0 int16, 1 int32, 2 float32
+    uint32_t sample_format;
+    uint32_t sample_bytes;
+    // Physical ring size in samples, a power of two: sample n lives at index n % ring_samples
+    uint64_t ring_samples;
+    // History a reader may rely on, in samples; the rest of the ring is slack for the writer
+    uint64_t capacity_samples;
+    SharedCursor cursor;
+    // Set once the microphone lets go of the ring. The name may meanwhile point at a newer ring
+    // (after a reconfigure), so a reader that sees this should open the name again.
+    std::atomic<uint32_t> closed;
+};
+static_assert(std::is_standard_layout_v<RingHeader>, "RingHeader is read from other processes");
+static_assert(sizeof(RingHeader) <= RING_HEADER_BYTES);
+
+// The name a microphone exports its ring under: "/viam-audio-<resource name>"
+std::string ring_name(const std::string& resource_name);
+
+// A POSIX shared memory object holding an AudioBuffer's ring, so readers on the same host can
+// map it read-only and copy PCM straight out of it at whatever latency they like, instead of
+// pulling chunks through get_audio. The ring itself moves into the mapping (see
+// AudioBuffer::share), so exporting adds no copy to the audio callback, only two stores of the
+// mirrored cursor. Readers follow the same protocol as AudioBuffer's own.
+// One instance serves one buffer, and must be destroyed before it (or with it).
+class SharedRing {
+   public:
+    // Creates the object `name`, replacing one a crashed process may have left behind, sizes it
+    // for buffer's ring, maps it and moves the ring into it. Call before anything is written to
+    // buffer. The object is readable by every user and writable only by this one. Throws
+    // std::runtime_error if it can't be created, sized or mapped.
+    SharedRing(std::string name, AudioBuffer& buffer);
+    // Marks the ring closed and unmaps it. The name is removed unless a newer ring has already
+    // taken it over.
+    ~SharedRing();
+
+    SharedRing(const SharedRing&) = delete;
+    SharedRing& operator=(const SharedRing&) = delete;
+
+    const RingHeader& header() const noexcept {
+        return *header_;
+    }
+
+    const std::string name;
+    // Bytes mapped: the header page plus the ring
+    const size_t size;
+
+   private:
+    AudioBuffer& buffer_;
+    int fd_ = -1;
+    RingHeader* header_ = nullptr;
+};
+
+}  // namespace shm
+}  // namespace audio
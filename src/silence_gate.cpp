@@ -0,0 +1,147 @@
+#include "silence_gate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <viam/sdk/common/utils.hpp>
+
+namespace audio {
+namespace silence {
+
+namespace {
+
+// Reads a whole number of milliseconds in [0, max_ms] from attrs[key]
+int parse_ms(const vsdk::ProtoStruct& attrs, const std::string& key, int max_ms) {
+    const auto* value = attrs.at(key).get<double>();
+    if (!value || *value < 0 || *value > max_ms || *value != std::floor(*value)) {
+        std::ostringstream buffer;
+        buffer << key << " must be a whole number of milliseconds between 0 and " << max_ms;
+        VIAM_SDK_LOG(error) << buffer.str();
+        throw std::invalid_argument(buffer.str());
+    }
+    return static_cast<int>(*value);
+}
+
+// Rounds ms of audio up to whole chunks, in samples
+uint64_t whole_chunks(int ms, uint64_t chunk_samples, uint64_t samples_per_second) {
+    const uint64_t samples = samples_per_second * static_cast<uint64_t>(ms) / 1000;
+    return (samples + chunk_samples - 1) / chunk_samples * chunk_samples;
+}
+
+template <typename Sample>
+double mean_square(const Sample* samples, size_t sample_count, double full_scale) noexcept {
+    double sum = 0;
+    for (size_t i = 0; i < sample_count; i++) {
+        const double sample = static_cast<double>(samples[i]) / full_scale;
+        sum += sample * sample;
+    }
+    return sum / sample_count;
+}
+
+}  // namespace
+
+GateOptions parse_gate_options(const vsdk::ProtoStruct& attrs, const GateOptions& defaults) {
+    GateOptions options = defaults;
+
+    if (attrs.count("silence_threshold_db")) {
+        const auto* threshold = attrs.at("silence_threshold_db").get<double>();
+        if (!threshold || *threshold < MIN_THRESHOLD_DB || *threshold > MAX_THRESHOLD_DB) {
+            std::ostringstream buffer;
+            buffer << "silence_threshold_db must be a number between " << MIN_THRESHOLD_DB << " and " << MAX_THRESHOLD_DB << " dBFS";
+            VIAM_SDK_LOG(error) << buffer.str();
+            throw std::invalid_argument(buffer.str());
+        }
+        options.enabled = true;
+        options.threshold_db = *threshold;
+    }
+    if (attrs.count("silence_hangover_ms")) {
+        options.hangover_ms = parse_ms(attrs, "silence_hangover_ms", MAX_HANGOVER_MS);
+    }
+    if (attrs.count("silence_preroll_ms")) {
+        options.preroll_ms = parse_ms(attrs, "silence_preroll_ms", MAX_PREROLL_MS);
+    }
+    return options;
+}
+
+double rms_dbfs(const void* samples, size_t sample_count, SampleFormat format) noexcept {
+    if (sample_count == 0) {
+        return SILENT_DB;
+    }
+    double power = 0;
+    switch (format) {
+        case SampleFormat::INT16:
+            power = mean_square(static_cast<const int16_t*>(samples), sample_count, 32768.0);
+            break;
+        case SampleFormat::INT32:
+            power = mean_square(static_cast<const int32_t*>(samples), sample_count, 2147483648.0);
+            break;
+        case SampleFormat::FLOAT32:
+            power = mean_square(static_cast<const float*>(samples), sample_count, 1.0);
+            break;
+    }
+    // 10 * log10 of the mean square is 20 * log10 of the RMS
+    return power > 0 ? std::max(SILENT_DB, 10 * std::log10(power)) : SILENT_DB;
+}
+
+SilenceGate::SilenceGate(const GateOptions& options, uint64_t chunk_samples, uint64_t samples_per_second)
+    : threshold_db_(options.threshold_db),
+      hangover_samples_(whole_chunks(options.hangover_ms, chunk_samples, samples_per_second)),
+      preroll_samples_(whole_chunks(options.preroll_ms, chunk_samples, samples_per_second)),
+      report_samples_(std::max(chunk_samples, whole_chunks(GAP_REPORT_MS, chunk_samples, samples_per_second))) {}
+
+SilenceGate::Decision SilenceGate::next(uint64_t start, uint64_t end, double level_db) {
+    if (!started_) {
+        started_ = true;
+        held_from_ = start;
+    }
+    const bool loud = level_db >= threshold_db_;
+
+    if (open_) {
+        if (end <= replay_through_) {
+            return Decision{};
+        }
+        if (loud) {
+            hangover_left_ = hangover_samples_;
+            return Decision{};
+        }
+        if (hangover_left_ >= end - start) {
+            hangover_left_ -= end - start;
+            return Decision{};
+        }
+        open_ = false;
+        held_from_ = start;
+    }
+
+    if (loud) {
+        open_ = true;
+        hangover_left_ = hangover_samples_;
+        replay_through_ = end;
+        const uint64_t preroll_start = std::max(held_from_, start - std::min(start, preroll_samples_));
+        if (preroll_start > held_from_) {
+            return Decision{Action::GAP, held_from_, preroll_start, preroll_start};
+        }
+        if (preroll_start < start) {
+            return Decision{Action::SKIP, 0, 0, preroll_start};
+        }
+        return Decision{};
+    }
+
+    if (end - held_from_ >= report_samples_ + preroll_samples_) {
+        const uint64_t gap_end = end - preroll_samples_;
+        const Decision decision{Action::GAP, held_from_, gap_end, end};
+        held_from_ = gap_end;
+        return decision;
+    }
+    return Decision{Action::SKIP, 0, 0, end};
+}
+
+void SilenceGate::reset() {
+    started_ = false;
+    open_ = false;
+    hangover_left_ = 0;
+    replay_through_ = 0;
+}
+
+}  // namespace silence
+}  // namespace audio
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <viam/sdk/common/proto_value.hpp>
+#include "audio_buffer.hpp"
+
+namespace audio {
+namespace silence {
+
+namespace vsdk = ::viam::sdk;
+
+// Accepted ranges for the silence_* attributes and get_audio extra keys
+constexpr double MIN_THRESHOLD_DB = -96;
+constexpr double MAX_THRESHOLD_DB = 0;
+constexpr int MAX_HANGOVER_MS = 10000;
+// Pre-roll is replayed from the ring, which always holds at least MIN_BUFFER_SECONDS
+constexpr int MAX_PREROLL_MS = 1000;
+constexpr int DEFAULT_HANGOVER_MS = 300;
+constexpr int DEFAULT_PREROLL_MS = 200;
+// A gate that stays closed still reports the silence at least this often, so readers see the
+// stream advance (and duration limits still end) while nothing is said
+constexpr int GAP_REPORT_MS = 1000;
+// Level reported for digital silence, which has no finite dBFS
+constexpr double SILENT_DB = -120;
+
+// The silence_threshold_db, silence_hangover_ms and silence_preroll_ms attributes, or the same
+// keys in get_audio's extra. The gate is off unless a threshold is set.
+struct GateOptions {
+    bool enabled = false;
+    // Chunks whose RMS level is below this (dBFS) count as silence
+    double threshold_db = 0;
+    // Silence kept after the last loud chunk before the gate closes
+    int hangover_ms = DEFAULT_HANGOVER_MS;
+    // Audio from before the first loud chunk sent when the gate opens
+    int preroll_ms = DEFAULT_PREROLL_MS;
+
+    bool operator<(const GateOptions& other) const {
+        return std::tie(enabled, threshold_db, hangover_ms, preroll_ms) <
+               std::tie(other.enabled, other.threshold_db, other.hangover_ms, other.preroll_ms);
+    }
+};
+
+// Reads the silence_* keys present in attrs on top of defaults.
+// Throws std::invalid_argument on a wrong type or out-of-range value.
+GateOptions parse_gate_options(const vsdk::ProtoStruct& attrs, const GateOptions& defaults = GateOptions{});
+
+// RMS level of sample_count samples in `format`, in dBFS (SILENT_DB for all zeros)
+double rms_dbfs(const void* samples, size_t sample_count, SampleFormat format) noexcept;
+
+// Decides, one chunk at a time, which parts of a stream are worth encoding. Works on device
+// buffer positions and whole chunks, so hangover and pre-roll are rounded up to chunks.
+//
+// While the gate is open every chunk is encoded. Once hangover's worth of chunks in a row has
+// been quiet it closes, and quiet chunks are skipped: the caller moves on without resampling
+// or encoding them. The skipped span is reported as one gap, either when a loud chunk opens
+// the gate again or every GAP_REPORT_MS, always holding back the last pre-roll's worth. On
+// opening, the caller rewinds over that held-back audio and encodes it ahead of the loud
+// chunk. Gaps and chunks therefore tile the stream with no holes or overlaps.
+//
+// A new gate starts closed, so a stream that opens on silence sends nothing until someone
+// speaks. Not thread-safe; owned by a SharedEncoder and used under its produce lock.
+class SilenceGate {
+   public:
+    enum class Action {
+        ENCODE,  // Encode the chunk as usual
+        SKIP,    // Don't encode it; continue reading at resume
+        GAP,     // Don't encode it; report [gap_start, gap_end) as silence and continue at resume
+    };
+
+    struct Decision {
+        Action action = Action::ENCODE;
+        uint64_t gap_start = 0;
+        uint64_t gap_end = 0;
+        // Device buffer position to read the next chunk from, for SKIP and GAP. Before the
+        // chunk when it opened the gate and pre-roll has to be replayed first.
+        uint64_t resume = 0;
+    };
+
+    // samples_per_second is the device rate times its channel count
+    SilenceGate(const GateOptions& options, uint64_t chunk_samples, uint64_t samples_per_second);
+
+    // Classifies the chunk [start, end) given its level. Chunks must be passed in stream
+    // order, starting wherever the previous decision said to resume.
+    Decision next(uint64_t start, uint64_t end, double level_db);
+
+    // Forgets the stream, e.g. after the stage moves to a new context
+    void reset();
+
+    bool is_open() const noexcept {
+        return open_;
+    }
+
+   private:
+    const double threshold_db_;
+    const uint64_t hangover_samples_;
+    const uint64_t preroll_samples_;
+    const uint64_t report_samples_;
+
+    bool started_ = false;
+    bool open_ = false;
+    // Quiet audio the open gate may still send
+    uint64_t hangover_left_ = 0;
+    // Closed: start of the silence not yet reported as a gap
+    uint64_t held_from_ = 0;
+    // Chunks ending at or before this are encoded regardless of level (the pre-roll replay)
+    uint64_t replay_through_ = 0;
+};
+
+}  // namespace silence
+}  // namespace audio
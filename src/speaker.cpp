@@ -1,5 +1,11 @@
 #include "speaker.hpp"
+#include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <sstream>
 #include <stdexcept>
 #include <thread>
 #include <viam/sdk/common/exception.hpp>
@@ -8,7 +14,10 @@
 #include "audio_buffer.hpp"
 #include "audio_codec.hpp"
 #include "audio_utils.hpp"
+#include "clip_cache.hpp"
+#include "gain.hpp"
 #include "mp3_decoder.hpp"
+#include "opus_decoder.hpp"
 #include "resample.hpp"
 #include "volume.hpp"
 
@@ -25,24 +34,176 @@ constexpr int MAX_VOLUME = 100;
 // advancing playback_position (scheduler jitter, USB stalls, etc.).
 constexpr int BUFFER_MARGIN_MS = 50;
 
+// How much encoded MP3 or Opus play() hands the decoder at a time: a few MP3 frames (about
+// 85 ms at 192 kbps), small enough that playback starts almost immediately.
+constexpr size_t DECODE_SLICE_BYTES = 2048;
+
+// Longest audio a single play() accepts. Writes are paced through the stream buffer, so this
+// bounds the memory for converting the whole clip rather than the buffer size.
+constexpr int MAX_PLAY_DURATION_SECONDS = 30;
+
+// How far the mixer keeps the stream buffer ahead of the callback, at least two callback
+// buffers. A new source is heard after at most this much already-mixed audio.
+constexpr int MIX_AHEAD_MS = 20;
+// Ring each mixed call writes into; backpressure keeps producers within it
+constexpr int MIX_SOURCE_BUFFER_SECONDS = 2;
+// Sources below the highest active priority are attenuated by this much (-12 dB)
+constexpr float MIX_DUCK_GAIN = 0.25f;
+constexpr double MAX_MIX_GAIN = 4.0;
+
+// play_stream pre-roll limits. The ceiling keeps a full pre-roll well inside the stream
+// buffer, so backpressure can never wait on a callback that is itself waiting for pre-roll.
+constexpr int DEFAULT_MAX_PREROLL_MS = 300;
+constexpr int MAX_PREROLL_MS = 1000;
+// Smallest step the adaptive pre-roll grows by, and how much it shrinks after
+// JITTER_SHRINK_AFTER_MS of playback without the source falling behind
+constexpr int JITTER_STEP_MS = 20;
+constexpr int JITTER_SHRINK_AFTER_MS = 10000;
+
+namespace {
+
+// Drops a pending pre-roll however play_stream exits, so audio already written still plays
+struct PrerollRelease {
+    audio::OutputStreamContext& ring;
+    ~PrerollRelease() {
+        ring.preroll_until.store(0);
+    }
+};
+
+// Wraps audio to preload as a clip, taking the format from a WAV header when there is one.
+// Throws std::invalid_argument for PCM of unknown format.
+std::shared_ptr<const audio::clips::ClipSource> make_clip_source(std::vector<uint8_t> data,
+                                                                 AudioCodec codec,
+                                                                 int sample_rate,
+                                                                 int num_channels) {
+    auto source = std::make_shared<audio::clips::ClipSource>();
+    if (audio::codec::has_wav_header(data.data(), data.size())) {
+        codec = AudioCodec::PCM_16;
+        num_channels = audio::codec::wav_num_channels(data.data());
+        sample_rate = audio::codec::wav_sample_rate(data.data());
+        data.erase(data.begin(), data.begin() + audio::codec::wav_header_size);
+    }
+    if (codec == AudioCodec::MP3 || codec == AudioCodec::OPUS) {
+        sample_rate = 0;
+        num_channels = 0;
+    } else if (sample_rate <= 0 || num_channels <= 0) {
+        VIAM_SDK_LOG(error) << "[preload_clip] PCM clips need a sample_rate and num_channels";
+        throw std::invalid_argument("PCM clips need a sample_rate and num_channels");
+    }
+    if (data.empty()) {
+        VIAM_SDK_LOG(error) << "[preload_clip] Clip has no audio";
+        throw std::invalid_argument("clip has no audio");
+    }
+    source->data = std::move(data);
+    source->codec = codec;
+    source->sample_rate = sample_rate;
+    source->num_channels = num_channels;
+    return source;
+}
+
+// Reads preload_clip's {"id", "path", "codec", "sample_rate", "num_channels"}. The codec is
+// optional for a .wav or .mp3 file.
+std::pair<std::string, std::shared_ptr<const audio::clips::ClipSource>> parse_preload_clip(const vsdk::ProtoValue& request) {
+    const auto* fields = request.get<vsdk::ProtoStruct>();
+    const std::string* id = fields && fields->count("id") ? fields->at("id").get<std::string>() : nullptr;
+    const std::string* path = fields && fields->count("path") ? fields->at("path").get<std::string>() : nullptr;
+    if (!id || id->empty() || !path) {
+        VIAM_SDK_LOG(error) << "preload_clip takes {\"id\": ..., \"path\": ...}";
+        throw std::invalid_argument("preload_clip takes {\"id\": ..., \"path\": ...}");
+    }
+
+    std::ifstream file(*path, std::ios::binary);
+    if (!file) {
+        VIAM_SDK_LOG(error) << "[preload_clip] Can't open " << *path;
+        throw std::invalid_argument("can't open clip file " + *path);
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    AudioCodec codec = AudioCodec::PCM_16;
+    if (fields->count("codec") && fields->at("codec").is_a<std::string>()) {
+        codec = audio::codec::parse_codec(*fields->at("codec").get<std::string>());
+    } else if (path->size() > 4 && audio::codec::toLower(path->substr(path->size() - 4)) == ".mp3") {
+        codec = AudioCodec::MP3;
+    }
+    int sample_rate = 0;
+    int num_channels = 0;
+    if (fields->count("sample_rate") && fields->at("sample_rate").is_a<double>()) {
+        sample_rate = static_cast<int>(*fields->at("sample_rate").get<double>());
+    }
+    if (fields->count("num_channels") && fields->at("num_channels").is_a<double>()) {
+        num_channels = static_cast<int>(*fields->at("num_channels").get<double>());
+    }
+    return {*id, make_clip_source(std::move(data), codec, sample_rate, num_channels)};
+}
+
+// The get_clips response
+vsdk::ProtoStruct clips_struct(const audio::clips::ClipCache& cache) {
+    vsdk::ProtoList clips;
+    for (const auto& entry : cache.entries()) {
+        clips.push_back(vsdk::ProtoStruct{{"id", entry.id},
+                                          {"duration_ms", static_cast<double>(entry.clip->duration_ms())},
+                                          {"bytes", static_cast<double>(entry.clip->bytes())}});
+    }
+    return vsdk::ProtoStruct{{"clips", std::move(clips)},
+                             {"bytes", static_cast<double>(cache.bytes())},
+                             {"max_bytes", static_cast<double>(cache.max_bytes())}};
+}
+
+}  // namespace
+
+MixSource::MixSource(const vsdk::audio_info& info, float gain, int priority)
+    : ring(info, MIX_SOURCE_BUFFER_SECONDS), gain(gain), priority(priority), applied_gain(gain) {}
+
 Speaker::Speaker(viam::sdk::Dependencies deps, viam::sdk::ResourceConfig cfg, audio::portaudio::PortAudioInterface* pa)
     : viam::sdk::AudioOut(cfg.name()), pa_(pa), stream_(nullptr) {
     auto setup = audio::utils::setup_audio_device<audio::OutputStreamContext>(
-        cfg, audio::utils::StreamDirection::Output, speakerCallback, pa_, audio::BUFFER_DURATION_SECONDS);
+        cfg, audio::utils::StreamDirection::Output, select_speaker_callback, pa_, audio::OUTPUT_BUFFER_DURATION_SECONDS);
+
+    const auto attrs = cfg.attributes();
 
     // Set new configuration and start stream under lock
     {
         std::lock_guard<std::mutex> lock(stream_mu_);
         audio_context_ = setup.audio_context;
+        stats_ = audio_context_->stats;
+        realtime_ = setup.realtime;
         setup.stream_params.user_data = setup.audio_context.get();
         stream_params_ = setup.stream_params;
         device_id_ = setup.config_params.device_id;
+        volume_ = setup.config_params.volume;
+        hardware_volume_ = attrs.count("volume_control") && attrs.at("volume_control").is_a<std::string>() &&
+                           *attrs.at("volume_control").get<std::string>() == "hardware";
+        // Nothing has played yet, so start at the configured volume rather than ramping to it
+        update_software_gain();
+        audio_context_->gain.reset(audio_context_->gain.target());
         audio::utils::restart_stream(stream_, stream_params_, pa_);
         latency_ = audio::utils::get_stream_latency(stream_, stream_params_, pa_);
-        volume_ = setup.config_params.volume;
-        if (volume_) {
-            audio::volume::set_volume(stream_params_.device_name, *volume_);
-        }
+        resample_options_ = setup.config_params.resample_options;
+        channel_matrix_ = setup.config_params.channel_matrix;
+    }
+    if (volume_ && hardware_volume_) {
+        std::lock_guard<std::mutex> lock(mixer_mu_);
+        hardware_mixer_.set_volume(stream_params_.device_name, *volume_);
+    }
+
+    if (attrs.count("preroll_ms") && attrs.at("preroll_ms").is_a<double>()) {
+        preroll_ms_ = static_cast<int>(*attrs.at("preroll_ms").get<double>());
+    }
+    max_preroll_ms_ = std::max(preroll_ms_, DEFAULT_MAX_PREROLL_MS);
+    if (attrs.count("max_preroll_ms") && attrs.at("max_preroll_ms").is_a<double>()) {
+        max_preroll_ms_ = static_cast<int>(*attrs.at("max_preroll_ms").get<double>());
+    }
+    jitter_target_ms_.store(preroll_ms_);
+
+    int clip_cache_mb = audio::clips::DEFAULT_CACHE_MB;
+    if (attrs.count("clip_cache_mb") && attrs.at("clip_cache_mb").is_a<double>()) {
+        clip_cache_mb = static_cast<int>(*attrs.at("clip_cache_mb").get<double>());
+    }
+    clips_ = std::make_unique<audio::clips::ClipCache>(static_cast<size_t>(clip_cache_mb) << 20);
+
+    if (attrs.count("mixing") && attrs.at("mixing").is_a<bool>() && *attrs.at("mixing").get<bool>()) {
+        mixing_ = true;
+        mixer_thread_ = std::thread([this]() { run_mixer(); });
     }
 
     watchdog_ = std::make_unique<audio::utils::StallWatchdog<audio::OutputStreamContext>>(
@@ -56,15 +217,24 @@ Speaker::Speaker(viam::sdk::Dependencies deps, viam::sdk::ResourceConfig cfg, au
         },
         [this](const std::shared_ptr<audio::OutputStreamContext>& ctx) { restart_stalled_stream(ctx); },
         "[speaker stall_watcher]");
-    watchdog_->start();
+    watchdog_->start([this]() { audio::realtime::apply_to_current_thread(realtime_); });
+    hotplug_ = std::make_unique<audio::hotplug::HotplugMonitor>([this]() { watchdog_->notify_device_change(); });
+    watchdog_->set_hotplug_active(hotplug_->active());
 }
 
 Speaker::~Speaker() {
     // Stop and join the watchdog before tearing down the stream so it can't touch a
-    // half-destroyed audio_context_.
+    // half-destroyed audio_context_. The hotplug monitor goes first, since it calls into the
+    // watchdog.
+    hotplug_.reset();
     if (watchdog_) {
         watchdog_->stop();
     }
+    if (mixer_thread_.joinable()) {
+        mixer_stop_.store(true);
+        notify_mixer();
+        mixer_thread_.join();
+    }
 
     if (stream_) {
         PaError err = Pa_StopStream(stream_);
@@ -81,26 +251,55 @@ Speaker::~Speaker() {
 
 vsdk::Model Speaker::model = {"viam", "system-audio", "speaker"};
 
+void Speaker::update_software_gain() {
+    int32_t gain = audio::gain::UNITY_Q16;
+    if (muted_) {
+        gain = 0;
+    } else if (volume_ && !hardware_volume_) {
+        gain = audio::gain::volume_to_gain_q16(*volume_);
+    }
+    audio_context_->gain.set_target(gain);
+}
+
 /**
- * Tear down the existing stream and bring up a fresh one with the saved params.
+ * Tear down the existing stream and bring up a fresh one with the saved params, first on
+ * the cached device index and then, if that fails, after re-resolving device_id.
  *
- * Bails out if `playback_context` is no longer the active audio_context_ — that means
- * another stall recovery already replaced it, so the in-flight play() call (if any)
- * is about to exit on its own and we shouldn't race.
+ * `playback_context` is always audio_context_, which the speaker keeps for its lifetime.
+ * Does nothing while a microphone's duplex stream plays it.
  *
- * On a successful restart, any unplayed audio in the old buffer is discarded. The
- * in-flight play() loop will see audio_context_ change and return early.
+ * The new stream plays from the same context, so unplayed audio, the playback position
+ * and in-flight play()/play_stream() calls carry on after the gap.
  */
 void Speaker::restart_stalled_stream(const std::shared_ptr<audio::OutputStreamContext>& playback_context) {
     std::lock_guard<std::mutex> lock(stream_mu_);
-    if (playback_context != audio_context_) {
+    // A duplex stream is the microphone's to restart
+    if (duplex_attached_) {
         return;
     }
 
     VIAM_SDK_LOG(debug) << "[speaker stall_watcher] Restarting stalled speaker stream";
 
-    // If device_id was configured, re-resolve before restarting in case the kernel
-    // re-enumerated and the cached device_index is stale (e.g. USB unplug/replug).
+    if (stream_) {
+        try {
+            audio::utils::abort_stream(stream_, pa_);
+        } catch (const std::exception& e) {
+            VIAM_SDK_LOG(error) << "[speaker stall_watcher] Error shutting down stalled stream: " << e.what();
+        }
+        stream_ = nullptr;
+    }
+
+    // Fast path: reopen the same device index, unless device_id shows the index now belongs
+    // to another device
+    std::string error;
+    const PaDeviceIndex tried_index = stream_params_.device_index;
+    const bool tried_fast = audio::utils::device_index_still_matches(device_id_, stream_params_, pa_);
+    if (tried_fast && reopen_stream(playback_context, error)) {
+        return;
+    }
+
+    // If device_id was configured, re-resolve in case the kernel re-enumerated and the
+    // cached device_index is stale (e.g. USB unplug/replug).
     // When the device is missing, skip the actual stream open — PortAudio would just
     // spam ALSA errors. Bump attempts so the watchdog enters backoff; once the device
     // returns, a backoff retry will resolve and proceed.
@@ -110,35 +309,84 @@ void Speaker::restart_stalled_stream(const std::shared_ptr<audio::OutputStreamCo
         }
         return;
     }
+    // Same device the fast path just failed on; no point opening it twice
+    if ((!tried_fast || stream_params_.device_index != tried_index) && reopen_stream(playback_context, error)) {
+        return;
+    }
+
+    if (restart_attempts_ < audio::utils::MAX_RESTART_ATTEMPTS) {
+        ++restart_attempts_;
+    }
+    VIAM_SDK_LOG(error) << "[speaker stall_watcher] Failed to restart stream (attempt " << restart_attempts_ << "/"
+                        << audio::utils::MAX_RESTART_ATTEMPTS << "): " << error;
+}
 
+bool Speaker::reopen_stream(const std::shared_ptr<audio::OutputStreamContext>& playback_context, std::string& error) {
+    uint64_t stalled_callback_ns = playback_context->last_callback_time_ns.load();
+    try {
+        stream_params_.user_data = playback_context.get();
+        audio::utils::restart_stream(stream_, stream_params_, pa_);
+    } catch (const std::exception& e) {
+        error = e.what();
+        return false;
+    }
+    latency_ = audio::utils::get_stream_latency(stream_, stream_params_, pa_);
+    // Give the new stream's first callback the usual grace before the watchdog counts it as
+    // stalled, unless it has already run
+    playback_context->last_callback_time_ns.compare_exchange_strong(stalled_callback_ns, 0);
+    restart_attempts_ = 0;
+    stats_->restarts.add();
+    // The device may have been re-enumerated, so re-resolve its mixer on the next set_volume
+    hardware_mixer_.invalidate();
+    // Wake play()/play_stream() waiting on playback so they see the new stream's progress
+    playback_context->notifier.notify();
+    VIAM_SDK_LOG(info) << "[speaker stall_watcher] Speaker stream restarted successfully";
+    return true;
+}
+
+DuplexOutput Speaker::attach_duplex() {
+    std::lock_guard<std::mutex> lock(stream_mu_);
+    if (duplex_attached_) {
+        VIAM_SDK_LOG(error) << "[attach_duplex] Speaker " << name() << " is already playing through another microphone's duplex stream";
+        throw std::runtime_error("speaker " + name() + " is already playing through another microphone's duplex stream");
+    }
     if (stream_) {
         try {
-            audio::utils::abort_stream(stream_, pa_);
+            audio::utils::shutdown_stream(stream_, pa_);
         } catch (const std::exception& e) {
-            VIAM_SDK_LOG(error) << "[speaker stall_watcher] Error shutting down stalled stream: " << e.what();
+            VIAM_SDK_LOG(error) << "[attach_duplex] Error closing speaker stream: " << e.what();
         }
         stream_ = nullptr;
     }
+    duplex_attached_ = true;
+    VIAM_SDK_LOG(info) << "[attach_duplex] Speaker " << name() << " now plays through a microphone's duplex stream";
+    return DuplexOutput{audio_context_,
+                        stream_params_.device_index,
+                        stream_params_.num_channels,
+                        stream_params_.sample_rate,
+                        stream_params_.suggested_latency_seconds};
+}
 
-    const viam::sdk::audio_info info{viam::sdk::audio_codecs::PCM_16, stream_params_.sample_rate, stream_params_.num_channels};
-    const auto new_context = std::make_shared<audio::OutputStreamContext>(info, audio::BUFFER_DURATION_SECONDS);
-
+void Speaker::detach_duplex() {
+    std::lock_guard<std::mutex> lock(stream_mu_);
+    if (!duplex_attached_) {
+        return;
+    }
+    duplex_attached_ = false;
     try {
-        stream_params_.user_data = new_context.get();
+        stream_params_.user_data = audio_context_.get();
         audio::utils::restart_stream(stream_, stream_params_, pa_);
         latency_ = audio::utils::get_stream_latency(stream_, stream_params_, pa_);
-        audio_context_ = new_context;
-        restart_attempts_ = 0;
-        VIAM_SDK_LOG(info) << "[speaker stall_watcher] Speaker stream restarted successfully";
+        // The duplex stream's last callback says nothing about this one; give it the usual grace
+        audio_context_->last_callback_time_ns.store(0);
     } catch (const std::exception& e) {
-        if (restart_attempts_ < audio::utils::MAX_RESTART_ATTEMPTS) {
-            ++restart_attempts_;
-        }
-        VIAM_SDK_LOG(error) << "[speaker stall_watcher] Failed to restart stream (attempt " << restart_attempts_ << "/"
-                            << audio::utils::MAX_RESTART_ATTEMPTS << "): " << e.what();
+        // Nothing advances the context now, so the watchdog retries once it looks stalled
+        VIAM_SDK_LOG(error) << "[detach_duplex] Failed to reopen speaker stream: " << e.what();
     }
 }
 
+namespace {
+
 /**
  * PortAudio callback function - runs on real-time audio thread.
  *  This function must not:
@@ -147,20 +395,36 @@ void Speaker::restart_stalled_stream(const std::shared_ptr<audio::OutputStreamCo
  * - Call any functions that may block
  * - Take unpredictable amounts of time to complete
  *
+ * Channels is the stream's channel count, or 0 for the generic callback, which reads it from
+ * the context at runtime.
  */
-int speakerCallback(const void* inputBuffer,
-                    void* outputBuffer,
-                    const unsigned long framesPerBuffer,
-                    const PaStreamCallbackTimeInfo* timeInfo,
-                    PaStreamCallbackFlags statusFlags,
-                    void* userData) {
+template <int Channels>
+int playback_callback(void* outputBuffer,
+                      const unsigned long framesPerBuffer,
+                      const PaStreamCallbackTimeInfo* timeInfo,
+                      PaStreamCallbackFlags statusFlags,
+                      void* userData) {
     if (!userData || !outputBuffer) {
         return paAbort;
     }
 
     audio::OutputStreamContext* const ctx = static_cast<audio::OutputStreamContext*>(userData);
 
-    ctx->last_callback_time_ns.store(static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    const uint64_t start_ns = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+
+    // Load current playback position from the context
+    uint64_t read_pos = ctx->playback_position.load();
+
+    // Record when this buffer will be heard, so wait_for_playback can finish as soon as the
+    // last sample is out instead of sleeping a fixed latency
+    ctx->buffer_start_position.store(read_pos);
+    if (timeInfo && timeInfo->outputBufferDacTime > 0) {
+        const double delay_seconds = timeInfo->outputBufferDacTime - timeInfo->currentTime;
+        ctx->output_delay_ns.store(static_cast<int64_t>(delay_seconds * audio::NANOSECONDS_PER_SECOND));
+    } else {
+        ctx->output_delay_ns.store(-1);
+    }
+    const uint64_t previous_ns = ctx->last_callback_time_ns.exchange(start_ns);
 
     if (statusFlags & paOutputOverflow) {
         ctx->output_overflow_count.fetch_add(1);
@@ -171,25 +435,74 @@ int speakerCallback(const void* inputBuffer,
 
     int16_t* const output = static_cast<int16_t*>(outputBuffer);
 
-    const uint64_t total_samples = framesPerBuffer * ctx->info.num_channels;
+    const int num_channels = Channels > 0 ? Channels : ctx->info.num_channels;
+    const uint64_t total_samples = framesPerBuffer * num_channels;
+    ctx->callback_frames.store(framesPerBuffer);
 
-    // Load current playback position from the context
-    uint64_t read_pos = ctx->playback_position.load();
+    const uint64_t write_pos = ctx->get_write_position();
+    const uint64_t queued = write_pos > read_pos ? write_pos - read_pos : 0;
+    ctx->stats->queued_ms.record(queued * 1000 / (static_cast<uint64_t>(ctx->info.sample_rate_hz) * ctx->info.num_channels));
+
+    // Play nothing until a pending pre-roll has been buffered
+    const uint64_t to_read = write_pos < ctx->preroll_until.load() ? 0 : total_samples;
 
     // Read samples from our circular buffer and put into portaudio output buffer
-    const int samples_read = ctx->read_samples(output, total_samples, read_pos);
+    const int samples_read = ctx->read_samples(output, to_read, read_pos);
 
-    // Store updated playback position
+    // Store updated playback position and wake writers/drainers waiting on it
     ctx->playback_position.store(read_pos);
+    ctx->notifier.notify();
 
     // If we didn't get enough samples, fill the rest with silence
-    for (int i = samples_read; i < total_samples; i++) {
-        output[i] = 0;
-    }
+    std::fill(output + samples_read, output + total_samples, int16_t{0});
 
+    // Over the whole buffer, silence included, so a gain ramp advances in real time
+    ctx->gain.apply<Channels>(output, framesPerBuffer, num_channels, ctx->info.sample_rate_hz);
+
+    const uint64_t end_ns = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    ctx->stats->record_callback(previous_ns, start_ns, end_ns, framesPerBuffer, ctx->info.sample_rate_hz);
+    if (ctx->callback_timing) {
+        ctx->callback_timing->record(end_ns - start_ns, framesPerBuffer, ctx->info.sample_rate_hz);
+    }
     return paContinue;
 }
 
+template <int Channels>
+int specialized_callback(const void* /*inputBuffer*/,
+                         void* outputBuffer,
+                         unsigned long framesPerBuffer,
+                         const PaStreamCallbackTimeInfo* timeInfo,
+                         PaStreamCallbackFlags statusFlags,
+                         void* userData) {
+    return playback_callback<Channels>(outputBuffer, framesPerBuffer, timeInfo, statusFlags, userData);
+}
+
+}  // namespace
+
+int speakerCallback(const void* inputBuffer,
+                    void* outputBuffer,
+                    const unsigned long framesPerBuffer,
+                    const PaStreamCallbackTimeInfo* timeInfo,
+                    PaStreamCallbackFlags statusFlags,
+                    void* userData) {
+    return playback_callback<0>(outputBuffer, framesPerBuffer, timeInfo, statusFlags, userData);
+}
+
+PaStreamCallback* select_speaker_callback(int num_channels, audio::SampleFormat /*sample_format*/) {
+    switch (num_channels) {
+        case 1:
+            return specialized_callback<1>;
+        case 2:
+            return specialized_callback<2>;
+        case 4:
+            return specialized_callback<4>;
+        case 8:
+            return specialized_callback<8>;
+        default:
+            return speakerCallback;
+    }
+}
+
 std::vector<std::string> Speaker::validate(vsdk::ResourceConfig cfg) {
     auto attrs = cfg.attributes();
 
@@ -250,6 +563,68 @@ std::vector<std::string> Speaker::validate(vsdk::ResourceConfig cfg) {
         }
     }
 
+    if (attrs.count("channel_matrix")) {
+        ChannelMatrix matrix;
+        try {
+            matrix = audio::utils::parse_channel_matrix(attrs.at("channel_matrix"));
+        } catch (const std::invalid_argument& e) {
+            VIAM_SDK_LOG(error) << "[validate] " << e.what();
+            throw;
+        }
+        if (attrs.count("num_channels") && matrix.output_channels != static_cast<int>(*attrs.at("num_channels").get<double>())) {
+            VIAM_SDK_LOG(error) << "[validate] channel_matrix must have one row per speaker channel (num_channels)";
+            throw std::invalid_argument("channel_matrix must have one row per speaker channel (num_channels)");
+        }
+    }
+
+    if (attrs.count("volume_control")) {
+        if (!attrs["volume_control"].is_a<std::string>()) {
+            VIAM_SDK_LOG(error) << "[validate] volume_control attribute must be a string";
+            throw std::invalid_argument("volume_control attribute must be a string");
+        }
+        const std::string control = *attrs.at("volume_control").get<std::string>();
+        if (control != "software" && control != "hardware") {
+            VIAM_SDK_LOG(error) << "[validate] volume_control must be \"software\" or \"hardware\", got: " << control;
+            throw std::invalid_argument("volume_control must be \"software\" or \"hardware\"");
+        }
+    }
+    audio::utils::validate_buffer_seconds(attrs);
+    audio::utils::validate_callback_timing(attrs);
+    audio::realtime::parse_realtime_options(attrs);
+    for (const char* name : {"preroll_ms", "max_preroll_ms"}) {
+        if (!attrs.count(name)) {
+            continue;
+        }
+        if (!attrs[name].is_a<double>()) {
+            VIAM_SDK_LOG(error) << "[validate] " << name << " attribute must be a number";
+            throw std::invalid_argument(std::string(name) + " attribute must be a number");
+        }
+        const double ms = *attrs.at(name).get<double>();
+        if (ms < 0 || ms > MAX_PREROLL_MS) {
+            VIAM_SDK_LOG(error) << "[validate] " << name << " must be between 0 and " << MAX_PREROLL_MS << ", got: " << ms;
+            throw std::invalid_argument(std::string(name) + " must be between 0 and " + std::to_string(MAX_PREROLL_MS));
+        }
+    }
+    if (attrs.count("preroll_ms") && attrs.count("max_preroll_ms") &&
+        *attrs.at("max_preroll_ms").get<double>() < *attrs.at("preroll_ms").get<double>()) {
+        VIAM_SDK_LOG(error) << "[validate] max_preroll_ms must be at least preroll_ms";
+        throw std::invalid_argument("max_preroll_ms must be at least preroll_ms");
+    }
+    if (attrs.count("clip_cache_mb")) {
+        const auto* megabytes = attrs.at("clip_cache_mb").get<double>();
+        if (!megabytes || *megabytes < 0 || *megabytes > audio::clips::MAX_CACHE_MB || *megabytes != std::floor(*megabytes)) {
+            std::ostringstream buffer;
+            buffer << "clip_cache_mb must be a whole number between 0 and " << audio::clips::MAX_CACHE_MB;
+            VIAM_SDK_LOG(error) << "[validate] " << buffer.str();
+            throw std::invalid_argument(buffer.str());
+        }
+    }
+    if (attrs.count("mixing") && !attrs["mixing"].is_a<bool>()) {
+        VIAM_SDK_LOG(error) << "[validate] mixing attribute must be a boolean";
+        throw std::invalid_argument("mixing attribute must be a boolean");
+    }
+
+    audio::utils::validate_resample_attributes(attrs);
     return {};
 }
 
@@ -263,20 +638,102 @@ viam::sdk::ProtoStruct Speaker::do_command(const viam::sdk::ProtoStruct& command
             throw std::invalid_argument("volume must be between 0 and 100");
         }
 
-        std::lock_guard<std::mutex> lock(stream_mu_);
-        audio::volume::set_volume(stream_params_.device_name, vol);
-        volume_ = vol;
+        std::lock_guard<std::mutex> mixer_lock(mixer_mu_);
+        std::string device_name;
+        {
+            std::lock_guard<std::mutex> lock(stream_mu_);
+            volume_ = vol;
+            update_software_gain();
+            device_name = stream_params_.device_name;
+        }
+        if (hardware_volume_) {
+            hardware_mixer_.set_volume(device_name, vol);
+        }
 
         return viam::sdk::ProtoStruct{{"volume", static_cast<double>(vol)}};
     }
 
+    if (command.count("mute")) {
+        if (!command.at("mute").is_a<bool>()) {
+            throw std::invalid_argument("mute must be a boolean");
+        }
+        std::lock_guard<std::mutex> lock(stream_mu_);
+        muted_ = *command.at("mute").get<bool>();
+        update_software_gain();
+
+        return viam::sdk::ProtoStruct{{"muted", muted_}};
+    }
+
+    if (command.count("get_buffer_settings")) {
+        std::lock_guard<std::mutex> lock(stream_mu_);
+        return audio::utils::buffer_settings_struct(*audio_context_);
+    }
+
+    if (command.count("get_volume")) {
+        std::lock_guard<std::mutex> lock(stream_mu_);
+        viam::sdk::ProtoStruct result{{"muted", muted_}, {"volume_control", std::string(hardware_volume_ ? "hardware" : "software")}};
+        if (volume_) {
+            result["volume"] = static_cast<double>(*volume_);
+        } else if (!hardware_volume_) {
+            result["volume"] = static_cast<double>(MAX_VOLUME);
+        }
+        return result;
+    }
+
+    if (command.count("get_resample_settings")) {
+        return audio::utils::resample_settings_struct(resample_options_);
+    }
+
+    if (command.count("get_stats")) {
+        return stats_struct(audio::metrics::parse_stats_reset(command.at("get_stats")));
+    }
+
+    if (command.count("preload_clip")) {
+        auto [id, source] = parse_preload_clip(command.at("preload_clip"));
+        const auto clip = preload_clip(id, std::move(source));
+        return viam::sdk::ProtoStruct{{"id", id}, {"duration_ms", static_cast<double>(clip->duration_ms())}};
+    }
+
+    if (command.count("play_clip")) {
+        // "id", or {"id": "id", ...} with the same gain and priority keys as play's extra
+        const auto& request = command.at("play_clip");
+        const viam::sdk::ProtoStruct* options = request.get<viam::sdk::ProtoStruct>();
+        const std::string* id = options && options->count("id") ? options->at("id").get<std::string>() : request.get<std::string>();
+        if (!id) {
+            VIAM_SDK_LOG(error) << "play_clip takes a clip id or {\"id\": ...}";
+            throw std::invalid_argument("play_clip takes a clip id or {\"id\": ...}");
+        }
+        const auto clip = play_clip(*id, options ? *options : viam::sdk::ProtoStruct{});
+        return viam::sdk::ProtoStruct{{"played", *id}, {"duration_ms", static_cast<double>(clip->duration_ms())}};
+    }
+
+    if (command.count("remove_clip")) {
+        const auto* id = command.at("remove_clip").get<std::string>();
+        if (!id) {
+            throw std::invalid_argument("remove_clip takes a clip id");
+        }
+        return viam::sdk::ProtoStruct{{"removed", clips_->erase(*id)}};
+    }
+
+    if (command.count("get_clips")) {
+        return clips_struct(*clips_);
+    }
+
     if (command.count("stop")) {
         VIAM_SDK_LOG(info) << "Stop command received, interrupting playback";
         stop_requested_.store(true);
+        {
+            std::lock_guard<std::mutex> lock(mix_mu_);
+            for (const auto& source : mix_sources_) {
+                source->stop_requested.store(true);
+                source->ring.notifier.notify();
+            }
+        }
         // Advance playback position to write position so no more audio is played.
         std::lock_guard<std::mutex> lock(stream_mu_);
         if (audio_context_) {
             audio_context_->playback_position.store(audio_context_->get_write_position());
+            audio_context_->notifier.notify();
         }
         return viam::sdk::ProtoStruct{{"stopped", true}};
     }
@@ -284,21 +741,118 @@ viam::sdk::ProtoStruct Speaker::do_command(const viam::sdk::ProtoStruct& command
     throw std::invalid_argument("unknown command");
 }
 
+viam::sdk::ProtoStruct Speaker::get_status() {
+    return stats_struct(false);
+}
+
+viam::sdk::ProtoStruct Speaker::stats_struct(bool reset) {
+    viam::sdk::ProtoStruct stats = stats_->to_struct(reset);
+    stats["jitter_target_ms"] = static_cast<double>(jitter_target_ms_.load());
+    std::lock_guard<std::mutex> lock(stream_mu_);
+    // The stream context outlives stall restarts, so the overflow/underflow counts cover the
+    // resource's lifetime and aren't zeroed here
+    stats["output_overflows"] = static_cast<double>(audio_context_->output_overflow_count.load());
+    stats["output_underflows"] = static_cast<double>(audio_context_->output_underflow_count.load());
+    if (audio_context_->callback_timing) {
+        stats["callback_timing"] = audio_context_->callback_timing->to_struct(reset);
+    }
+    if (realtime_ && realtime_->options.enabled()) {
+        stats["realtime"] = realtime_->to_struct();
+    }
+    return stats;
+}
+
+PlaybackSession Speaker::begin_playback(const vsdk::ProtoStruct& extra, PlaybackScratch& scratch) {
+    double gain = 1.0;
+    int priority = 0;
+    if (extra.count("gain")) {
+        if (!extra.at("gain").is_a<double>()) {
+            VIAM_SDK_LOG(error) << "gain must be a number";
+            throw std::invalid_argument("gain must be a number");
+        }
+        gain = *extra.at("gain").get<double>();
+        if (gain < 0 || gain > MAX_MIX_GAIN) {
+            VIAM_SDK_LOG(error) << "gain must be between 0 and " << MAX_MIX_GAIN << ", got: " << gain;
+            throw std::invalid_argument("gain must be between 0 and " + std::to_string(static_cast<int>(MAX_MIX_GAIN)));
+        }
+    }
+    if (extra.count("priority")) {
+        if (!extra.at("priority").is_a<double>()) {
+            VIAM_SDK_LOG(error) << "priority must be a number";
+            throw std::invalid_argument("priority must be a number");
+        }
+        priority = static_cast<int>(*extra.at("priority").get<double>());
+    }
+
+    std::shared_ptr<audio::OutputStreamContext> context;
+    int speaker_sample_rate;
+    int speaker_num_channels;
+    {
+        std::lock_guard<std::mutex> lock(stream_mu_);
+        if (!audio_context_) {
+            VIAM_SDK_LOG(error) << "[Play] Audio context is nullptr";
+            throw std::runtime_error("Audio context is nullptr");
+        }
+        context = audio_context_;
+        speaker_sample_rate = stream_params_.sample_rate;
+        speaker_num_channels = stream_params_.num_channels;
+    }
+
+    if (!mixing_) {
+        return PlaybackSession{context, nullptr, scratch, speaker_sample_rate, speaker_num_channels};
+    }
+
+    const viam::sdk::audio_info info{viam::sdk::audio_codecs::PCM_16, speaker_sample_rate, speaker_num_channels};
+    auto source = std::make_shared<MixSource>(info, static_cast<float>(gain), priority);
+    source->ring.lock_ring(realtime_);
+    {
+        std::lock_guard<std::mutex> lock(mix_mu_);
+        mix_sources_.push_back(source);
+    }
+    return PlaybackSession{std::shared_ptr<audio::OutputStreamContext>(source, &source->ring),
+                           source,
+                           scratch,
+                           speaker_sample_rate,
+                           speaker_num_channels};
+}
+
+bool Speaker::stopped(const PlaybackSession& session) const {
+    return session.source ? session.source->stop_requested.load() : stop_requested_.load();
+}
+
 /**
  * Play audio data through the speaker.
  *
  * This method blocks until the audio has been completely played back.
  * Audio is written to an internal circular buffer and played asynchronously
  * by the PortAudio callback. The method waits until playback is complete
- * before returning.
+ * before returning. With mixing enabled, concurrent calls play at the same time.
  *
  * @throws std::invalid_argument if codec is not PCM_16 or data size is invalid
  */
 void Speaker::play(std::vector<uint8_t> const& audio_data,
                    boost::optional<viam::sdk::audio_info> info,
                    const viam::sdk::ProtoStruct& extra) {
-    std::lock_guard<std::mutex> playback_lock(playback_mu_);
-    stop_requested_.store(false);
+    // This is a borrowed gRPC thread, so its scheduling is put back when the call returns
+    const audio::realtime::ScopedThreadSettings thread_settings(realtime_);
+
+    // Cache the clip for play_clip instead of playing it. Nothing plays, so this doesn't wait
+    // for other calls to finish.
+    if (extra.count("preload_clip")) {
+        const auto* id = extra.at("preload_clip").get<std::string>();
+        if (!id || id->empty() || !info) {
+            VIAM_SDK_LOG(error) << "[Play] preload_clip must be a clip id, with the audio info set";
+            throw std::invalid_argument("preload_clip must be a clip id, with the audio info set");
+        }
+        preload_clip(*id, make_clip_source(audio_data, audio::codec::parse_codec(info->codec), info->sample_rate_hz, info->num_channels));
+        return;
+    }
+
+    std::unique_lock<std::mutex> playback_lock(playback_mu_, std::defer_lock);
+    if (!mixing_) {
+        playback_lock.lock();
+        stop_requested_.store(false);
+    }
 
     VIAM_SDK_LOG(debug) << "Play called, adding samples to playback buffer";
 
@@ -310,6 +864,7 @@ void Speaker::play(std::vector<uint8_t> const& audio_data,
         VIAM_SDK_LOG(error) << "[Play]: Must specify audio info parameter";
         throw std::invalid_argument("[Play]: Must specify audio info parameter");
     }
+    stats_->chunks.add();
 
     const std::string codec_str = info->codec;
     AudioCodec codec = audio::codec::parse_codec(codec_str);
@@ -328,30 +883,12 @@ void Speaker::play(std::vector<uint8_t> const& audio_data,
         raw_audio_size -= audio::codec::wav_header_size;
     }
 
-    // MP3 needs a stateful whole-buffer decode; the rest of the pipeline only sees PCM_16.
-    std::vector<uint8_t> mp3_decoded;
-    if (codec == AudioCodec::MP3) {
-        MP3DecoderContext mp3_ctx;
-        decode_mp3_to_pcm16(mp3_ctx, raw_audio, raw_audio_size, mp3_decoded);
-        audio_sample_rate = mp3_ctx.sample_rate;
-        audio_num_channels = mp3_ctx.num_channels;
-        raw_audio = mp3_decoded.data();
-        raw_audio_size = mp3_decoded.size();
-        codec = AudioCodec::PCM_16;
-    }
+    PlaybackScratch call_scratch;
+    PlaybackSession session = begin_playback(extra, mixing_ ? call_scratch : scratch_);
 
-    int speaker_sample_rate;
-    int speaker_num_channels;
-    std::shared_ptr<audio::OutputStreamContext> playback_context;
-    {
-        std::lock_guard<std::mutex> lock(stream_mu_);
-        if (!audio_context_) {
-            VIAM_SDK_LOG(error) << "[Play] Audio context is nullptr";
-            throw std::runtime_error("Audio context is nullptr");
-        }
-        playback_context = audio_context_;
-        speaker_sample_rate = stream_params_.sample_rate;
-        speaker_num_channels = stream_params_.num_channels;
+    if (codec == AudioCodec::MP3 || codec == AudioCodec::OPUS) {
+        play_compressed(codec, raw_audio, raw_audio_size, session);
+        return;
     }
 
     // Estimate post-resample sample count from input bytes — exact for PCM_16, ~2x conservative
@@ -360,23 +897,129 @@ void Speaker::play(std::vector<uint8_t> const& audio_data,
         const size_t pcm16_bytes_estimate = (codec == AudioCodec::PCM_16) ? raw_audio_size : raw_audio_size / 2;
         const size_t input_samples_estimate = pcm16_bytes_estimate / sizeof(int16_t);
         const double duration_seconds = static_cast<double>(input_samples_estimate) / (audio_sample_rate * audio_num_channels);
-        if (duration_seconds > audio::BUFFER_DURATION_SECONDS) {
-            throw std::invalid_argument("Audio file too long for playback buffer (max " + std::to_string(audio::BUFFER_DURATION_SECONDS) +
+        if (duration_seconds > MAX_PLAY_DURATION_SECONDS) {
+            throw std::invalid_argument("Audio file too long for playback buffer (max " + std::to_string(MAX_PLAY_DURATION_SECONDS) +
                                         " seconds); use PlayStream for longer audio");
         }
     }
 
-    const uint64_t start_position = playback_context->get_write_position();
-    const size_t samples_written = process_and_write_pcm(raw_audio,
-                                                         raw_audio_size,
-                                                         codec,
-                                                         audio_sample_rate,
-                                                         audio_num_channels,
-                                                         speaker_sample_rate,
-                                                         speaker_num_channels,
-                                                         playback_context);
+    const uint64_t start_position = session.context->get_write_position();
+    const size_t samples_written = process_and_write_pcm(raw_audio, raw_audio_size, codec, audio_sample_rate, audio_num_channels, session);
+
+    wait_for_playback(session, start_position, samples_written);
+}
+
+std::shared_ptr<const audio::clips::Clip> Speaker::convert_clip(std::shared_ptr<const audio::clips::ClipSource> source,
+                                                                int speaker_sample_rate,
+                                                                int speaker_num_channels) {
+    std::vector<uint8_t> decoded;
+    int sample_rate = source->sample_rate;
+    int num_channels = source->num_channels;
+    {
+        const audio::metrics::ScopedTimer timer(stats_->codec_us);
+        switch (source->codec) {
+            case AudioCodec::MP3: {
+                MP3DecoderContext mp3_ctx;
+                decode_mp3_chunk(mp3_ctx, source->data.data(), source->data.size(), decoded);
+                sample_rate = mp3_ctx.sample_rate;
+                num_channels = mp3_ctx.num_channels;
+                break;
+            }
+            case AudioCodec::OPUS: {
+                OpusDecoderContext opus_ctx;
+                decode_opus_chunk(opus_ctx, source->data.data(), source->data.size(), speaker_sample_rate, decoded);
+                sample_rate = opus_ctx.sample_rate;
+                num_channels = opus_ctx.num_channels;
+                break;
+            }
+            case AudioCodec::PCM_32:
+                audio::codec::convert_pcm32_to_pcm16(source->data.data(), static_cast<int>(source->data.size()), decoded);
+                break;
+            case AudioCodec::PCM_32_FLOAT:
+                audio::codec::convert_float32_to_pcm16(source->data.data(), static_cast<int>(source->data.size()), decoded);
+                break;
+            default:
+                decoded = source->data;
+                break;
+        }
+    }
+    if (sample_rate <= 0 || num_channels <= 0 || decoded.size() < sizeof(int16_t)) {
+        VIAM_SDK_LOG(error) << "[preload_clip] Clip decoded to no audio";
+        throw std::invalid_argument("clip decoded to no audio");
+    }
+
+    const int16_t* samples = reinterpret_cast<const int16_t*>(decoded.data());
+    size_t num_samples = decoded.size() / sizeof(int16_t) / num_channels * num_channels;
+    PlaybackScratch scratch;
+    const ChannelMatrix* matrix = channel_matrix_for(num_channels, speaker_num_channels, scratch);
+    if (matrix) {
+        convert_channels(samples, num_samples, *matrix, scratch.channel_mixed);
+        samples = scratch.channel_mixed.data();
+        num_samples = scratch.channel_mixed.size();
+    }
+
+    auto clip = std::make_shared<audio::clips::Clip>();
+    clip->source = std::move(source);
+    clip->sample_rate = speaker_sample_rate;
+    clip->num_channels = speaker_num_channels;
+    if (sample_rate != speaker_sample_rate) {
+        const audio::metrics::ScopedTimer timer(stats_->resample_us);
+        resample_audio(sample_rate, speaker_sample_rate, speaker_num_channels, samples, num_samples, clip->samples, resample_options_);
+    } else {
+        clip->samples.assign(samples, samples + num_samples);
+    }
+    if (clip->samples.empty()) {
+        VIAM_SDK_LOG(error) << "[preload_clip] Clip is too short to play";
+        throw std::invalid_argument("clip is too short to play");
+    }
+    return clip;
+}
 
-    wait_for_playback(playback_context, start_position, samples_written);
+std::shared_ptr<const audio::clips::Clip> Speaker::preload_clip(const std::string& id,
+                                                                std::shared_ptr<const audio::clips::ClipSource> source) {
+    int speaker_sample_rate = 0;
+    int speaker_num_channels = 0;
+    {
+        std::lock_guard<std::mutex> lock(stream_mu_);
+        speaker_sample_rate = stream_params_.sample_rate;
+        speaker_num_channels = stream_params_.num_channels;
+    }
+    auto clip = convert_clip(std::move(source), speaker_sample_rate, speaker_num_channels);
+    clips_->put(id, clip);
+    VIAM_SDK_LOG(info) << "[preload_clip] Cached clip " << id << " (" << clip->duration_ms() << " ms, " << clip->bytes() << " bytes)";
+    return clip;
+}
+
+std::shared_ptr<const audio::clips::Clip> Speaker::play_clip(const std::string& id, const viam::sdk::ProtoStruct& extra) {
+    // This is a borrowed gRPC thread, so its scheduling is put back when the call returns
+    const audio::realtime::ScopedThreadSettings thread_settings(realtime_);
+    std::unique_lock<std::mutex> playback_lock(playback_mu_, std::defer_lock);
+    if (!mixing_) {
+        playback_lock.lock();
+        stop_requested_.store(false);
+    }
+
+    auto clip = clips_->get(id);
+    if (!clip) {
+        VIAM_SDK_LOG(error) << "[play_clip] No clip preloaded as " << id;
+        throw std::invalid_argument("no clip preloaded as " + id);
+    }
+    stats_->chunks.add();
+
+    PlaybackScratch call_scratch;
+    PlaybackSession session = begin_playback(extra, mixing_ ? call_scratch : scratch_);
+    if (clip->sample_rate != session.speaker_sample_rate || clip->num_channels != session.speaker_num_channels) {
+        VIAM_SDK_LOG(info) << "[play_clip] Converting clip " << id << " to the stream's new format (" << session.speaker_sample_rate
+                           << " Hz, " << session.speaker_num_channels << " channels)";
+        auto converted = convert_clip(clip->source, session.speaker_sample_rate, session.speaker_num_channels);
+        clips_->replace(id, clip, converted);
+        clip = std::move(converted);
+    }
+
+    const uint64_t start_position = session.context->get_write_position();
+    const size_t samples_written = write_with_backpressure(clip->samples.data(), clip->samples.size(), session);
+    wait_for_playback(session, start_position, samples_written);
+    return clip;
 }
 
 size_t Speaker::process_and_write_pcm(const uint8_t* data,
@@ -384,26 +1027,25 @@ size_t Speaker::process_and_write_pcm(const uint8_t* data,
                                       AudioCodec codec,
                                       int audio_sample_rate,
                                       int audio_num_channels,
-                                      int speaker_sample_rate,
-                                      int speaker_num_channels,
-                                      std::shared_ptr<audio::OutputStreamContext> playback_context) {
+                                      PlaybackSession& session,
+                                      StreamingResampler* resampler) {
     if (size == 0) {
         throw std::invalid_argument("process_and_write_pcm: empty input");
     }
 
-    std::vector<uint8_t> decoded_buf;
+    PlaybackScratch& scratch = session.scratch;
     const uint8_t* decoded_data = nullptr;
     size_t decoded_size = 0;
     switch (codec) {
         case AudioCodec::PCM_32:
-            audio::codec::convert_pcm32_to_pcm16(data, size, decoded_buf);
-            decoded_data = decoded_buf.data();
-            decoded_size = decoded_buf.size();
+            audio::codec::convert_pcm32_to_pcm16(data, size, scratch.decoded);
+            decoded_data = scratch.decoded.data();
+            decoded_size = scratch.decoded.size();
             break;
         case AudioCodec::PCM_32_FLOAT:
-            audio::codec::convert_float32_to_pcm16(data, size, decoded_buf);
-            decoded_data = decoded_buf.data();
-            decoded_size = decoded_buf.size();
+            audio::codec::convert_float32_to_pcm16(data, size, scratch.decoded);
+            decoded_data = scratch.decoded.data();
+            decoded_size = scratch.decoded.size();
             break;
         case AudioCodec::PCM_16:
             decoded_data = data;
@@ -420,160 +1062,479 @@ size_t Speaker::process_and_write_pcm(const uint8_t* data,
     const int16_t* samples = reinterpret_cast<const int16_t*>(decoded_data);
     size_t num_samples = decoded_size / sizeof(int16_t);
 
-    std::vector<int16_t> channel_converted;
-    if (audio_num_channels != speaker_num_channels) {
-        convert_channels(samples, num_samples, audio_num_channels, speaker_num_channels, channel_converted);
-        samples = channel_converted.data();
-        num_samples = channel_converted.size();
+    const ChannelMatrix* matrix = channel_matrix_for(audio_num_channels, session.speaker_num_channels, scratch);
+    if (matrix) {
+        convert_channels(samples, num_samples, *matrix, scratch.channel_mixed);
+        samples = scratch.channel_mixed.data();
+        num_samples = scratch.channel_mixed.size();
     }
 
-    std::vector<int16_t> resampled;
-    if (audio_sample_rate != speaker_sample_rate) {
-        resample_audio(audio_sample_rate, speaker_sample_rate, speaker_num_channels, samples, num_samples, resampled);
-        samples = resampled.data();
-        num_samples = resampled.size();
+    if (resampler) {
+        // A streaming resampler may hold the whole chunk back in its filter; that's not an error,
+        // the samples come out with a later chunk or the final flush.
+        {
+            const audio::metrics::ScopedTimer timer(stats_->resample_us);
+            resampler->process(samples, num_samples, scratch.resampled);
+        }
+        return write_with_backpressure(scratch.resampled.data(), scratch.resampled.size(), session);
+    }
+    if (audio_sample_rate != session.speaker_sample_rate) {
+        const audio::metrics::ScopedTimer timer(stats_->resample_us);
+        resample_audio(audio_sample_rate,
+                       session.speaker_sample_rate,
+                       session.speaker_num_channels,
+                       samples,
+                       num_samples,
+                       scratch.resampled,
+                       resample_options_);
+        samples = scratch.resampled.data();
+        num_samples = scratch.resampled.size();
     }
     if (num_samples == 0) {
         throw std::invalid_argument("process_and_write_pcm: input too small to produce any output samples after resample");
     }
 
-    // Backpressure: cap how far the producer can run ahead of the callback so a faster-than-
-    // real-time source can't lap the read pointer and erase audio.
-    const uint64_t margin_samples = static_cast<uint64_t>(speaker_sample_rate) * speaker_num_channels * BUFFER_MARGIN_MS / 1000;
+    return write_with_backpressure(samples, num_samples, session);
+}
+
+void Speaker::play_compressed(AudioCodec codec, const uint8_t* data, size_t size, PlaybackSession& session) {
+    std::unique_ptr<MP3DecoderContext> mp3_ctx;
+    std::unique_ptr<OpusDecoderContext> opus_ctx;
+    if (codec == AudioCodec::OPUS) {
+        opus_ctx = std::make_unique<OpusDecoderContext>();
+    } else {
+        mp3_ctx = std::make_unique<MP3DecoderContext>();
+    }
+    std::unique_ptr<StreamingResampler> resampler;
+    const uint64_t start_position = session.context->get_write_position();
+    uint64_t samples_written = 0;
+
+    // Decode in slices of a few frames and write each as it's produced, so playback starts
+    // after the first frame and the decoded PCM never exists all at once. Backpressure in
+    // write_with_backpressure keeps the decoder from running ahead of the callback.
+    for (size_t offset = 0; offset < size; offset += DECODE_SLICE_BYTES) {
+        if (stopped(session)) {
+            break;
+        }
+        const size_t slice = std::min(DECODE_SLICE_BYTES, size - offset);
+        if (opus_ctx) {
+            samples_written += decode_and_write_opus(*opus_ctx, data + offset, slice, resampler, session);
+        } else {
+            samples_written += decode_and_write_mp3(*mp3_ctx, data + offset, slice, resampler, session);
+        }
+    }
+
+    if (!stopped(session)) {
+        if (mp3_ctx && mp3_ctx->sample_rate == 0) {
+            VIAM_SDK_LOG(error) << "[Play] MP3 decoder: no valid frame found";
+            throw std::runtime_error("[Play] MP3 decoder: no valid frame found");
+        }
+        if (opus_ctx && opus_ctx->sample_rate == 0) {
+            VIAM_SDK_LOG(error) << "[Play] Opus decoder: no complete packet found";
+            throw std::runtime_error("[Play] Opus decoder: no complete packet found");
+        }
+    }
+
+    if (resampler && !stopped(session)) {
+        std::vector<int16_t> tail;
+        resampler->flush(tail);
+        samples_written += write_with_backpressure(tail.data(), tail.size(), session);
+    }
+
+    wait_for_playback(session, start_position, samples_written);
+}
+
+size_t Speaker::decode_and_write_mp3(MP3DecoderContext& mp3_ctx,
+                                     const uint8_t* data,
+                                     size_t size,
+                                     std::unique_ptr<StreamingResampler>& resampler,
+                                     PlaybackSession& session) {
+    const bool format_known = mp3_ctx.sample_rate != 0;
+    session.scratch.codec_decoded.clear();
+    {
+        const audio::metrics::ScopedTimer timer(stats_->codec_us);
+        decode_mp3_chunk(mp3_ctx, data, size, session.scratch.codec_decoded);
+    }
+    return write_decoded(format_known, mp3_ctx.sample_rate, mp3_ctx.num_channels, resampler, session);
+}
+
+size_t Speaker::decode_and_write_opus(OpusDecoderContext& opus_ctx,
+                                      const uint8_t* data,
+                                      size_t size,
+                                      std::unique_ptr<StreamingResampler>& resampler,
+                                      PlaybackSession& session) {
+    const bool format_known = opus_ctx.sample_rate != 0;
+    session.scratch.codec_decoded.clear();
+    {
+        const audio::metrics::ScopedTimer timer(stats_->codec_us);
+        decode_opus_chunk(opus_ctx, data, size, session.speaker_sample_rate, session.scratch.codec_decoded);
+    }
+    return write_decoded(format_known, opus_ctx.sample_rate, opus_ctx.num_channels, resampler, session);
+}
+
+size_t Speaker::write_decoded(bool format_was_known,
+                              int decoded_sample_rate,
+                              int decoded_num_channels,
+                              std::unique_ptr<StreamingResampler>& resampler,
+                              PlaybackSession& session) {
+    const std::vector<uint8_t>& decoded = session.scratch.codec_decoded;
+    if (decoded.empty()) {
+        return 0;
+    }
+    if (!format_was_known && decoded_sample_rate != session.speaker_sample_rate) {
+        resampler = std::make_unique<StreamingResampler>(
+            decoded_sample_rate, session.speaker_sample_rate, session.speaker_num_channels, resample_options_);
+    }
+    return process_and_write_pcm(
+        decoded.data(), decoded.size(), AudioCodec::PCM_16, decoded_sample_rate, decoded_num_channels, session, resampler.get());
+}
+
+const ChannelMatrix* Speaker::channel_matrix_for(int audio_num_channels, int speaker_num_channels, PlaybackScratch& scratch) {
+    if (channel_matrix_ && channel_matrix_->input_channels == audio_num_channels &&
+        channel_matrix_->output_channels == speaker_num_channels) {
+        return &*channel_matrix_;
+    }
+    if (audio_num_channels == speaker_num_channels) {
+        return nullptr;
+    }
+    ChannelMatrix& default_matrix = scratch.default_matrix;
+    if (default_matrix.input_channels != audio_num_channels || default_matrix.output_channels != speaker_num_channels) {
+        if (channel_matrix_) {
+            VIAM_SDK_LOG(warn) << "channel_matrix is " << channel_matrix_->input_channels << " -> " << channel_matrix_->output_channels
+                               << " channels but audio is " << audio_num_channels << " -> " << speaker_num_channels
+                               << "; using the default mix";
+        }
+        default_matrix = default_channel_matrix(audio_num_channels, speaker_num_channels);
+    }
+    return &default_matrix;
+}
+
+size_t Speaker::write_with_backpressure(const int16_t* samples, size_t num_samples, PlaybackSession& session) {
+    const std::shared_ptr<audio::OutputStreamContext>& playback_context = session.context;
+    // The scratch buffers have grown to this chunk's size by now
+    session.scratch.lock_memory(realtime_);
+
+    // Backpressure: cap how far the producer can run ahead of its reader (the callback, or the
+    // mixer for a mixed call) so a faster-than-real-time source can't lap it and erase audio.
+    const uint64_t margin_samples =
+        static_cast<uint64_t>(session.speaker_sample_rate) * session.speaker_num_channels * BUFFER_MARGIN_MS / 1000;
     const uint64_t max_ahead = static_cast<uint64_t>(playback_context->buffer_capacity) - margin_samples;
 
-    for (size_t i = 0; i < num_samples; ++i) {
+    size_t written = 0;
+    while (written < num_samples) {
         // Use `write >= read + max_ahead` rather than `write - read >= max_ahead` so a read
         // position ahead of write (only reachable in tests that pre-advance playback_position)
         // doesn't underflow into a huge unsigned diff and trap us forever.
-        while (playback_context->get_write_position() >= playback_context->playback_position.load() + max_ahead) {
-            if (stop_requested_.load()) {
-                return i;
+        const uint64_t write_pos = playback_context->get_write_position();
+        const uint64_t write_limit = playback_context->playback_position.load() + max_ahead;
+        if (write_pos >= write_limit) {
+            if (stopped(session)) {
+                return written;
             }
-            {
-                std::lock_guard<std::mutex> lock(stream_mu_);
-                if (audio_context_ != playback_context) {
-                    return i;
-                }
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            // Sleep until the reader frees room (or stop() / a restart notifies us).
+            playback_context->notifier.wait_for(audio::MAX_WAIT_SLICE, [&]() {
+                return stopped(session) || playback_context->playback_position.load() + max_ahead > write_pos;
+            });
+            continue;
+        }
+
+        // Write as much as fits under the cap in one block.
+        const size_t block = static_cast<size_t>(std::min<uint64_t>(num_samples - written, write_limit - write_pos));
+        playback_context->write_samples(samples + written, block);
+        written += block;
+        if (session.source) {
+            notify_mixer();
         }
-        playback_context->write_sample(samples[i]);
     }
     return num_samples;
 }
 
-void Speaker::wait_for_playback(std::shared_ptr<audio::OutputStreamContext> playback_context,
-                                uint64_t start_position,
-                                uint64_t samples_to_drain) {
+void Speaker::wait_for_playback(PlaybackSession& session, uint64_t start_position, uint64_t samples_to_drain) {
+    const std::shared_ptr<audio::OutputStreamContext>& playback_context = session.context;
+    // The mixer only takes whole frames, so a mixed call waits for those
+    if (session.source) {
+        samples_to_drain -= samples_to_drain % session.speaker_num_channels;
+    }
+
     uint64_t last_logged_overflow_count = 0;
     uint64_t last_logged_underflow_count = 0;
     uint64_t last_staleness_log_ns = 0;
+    // The context the stream plays from; for a mixed call, the one the mixer writes into
+    const std::shared_ptr<audio::OutputStreamContext>& output = audio_context_;
     while (playback_context->playback_position.load() - start_position < samples_to_drain) {
-        if (stop_requested_.load()) {
+        if (stopped(session)) {
             VIAM_SDK_LOG(debug) << "Playback stopped by stop command";
             return;
         }
-        PaStream* current_stream = nullptr;
-        {
-            std::lock_guard<std::mutex> lock(stream_mu_);
-            if (audio_context_ != playback_context) {
-                VIAM_SDK_LOG(debug) << "Audio playback interrupted by stream restart, exiting";
-                return;
-            }
-            current_stream = stream_;
-        }
 
-        audio::utils::log_callback_staleness(playback_context->last_callback_time_ns, "[playback]", current_stream, last_staleness_log_ns);
+        audio::utils::log_callback_staleness(
+            output->last_callback_time_ns,
+            "[playback]",
+            [this]() {
+                std::lock_guard<std::mutex> lock(stream_mu_);
+                return stream_;
+            },
+            last_staleness_log_ns);
 
-        const uint64_t overflow_count = playback_context->output_overflow_count.load();
-        if (overflow_count != last_logged_overflow_count) {
+        const uint64_t overflow_count = output->output_overflow_count.load();
+        if (overflow_count > last_logged_overflow_count) {
             VIAM_SDK_LOG(warn) << "[playback] Output overflow detected — " << (overflow_count - last_logged_overflow_count)
                                << " new overflow(s), " << overflow_count << " total";
-            last_logged_overflow_count = overflow_count;
         }
+        last_logged_overflow_count = overflow_count;
 
-        const uint64_t underflow_count = playback_context->output_underflow_count.load();
-        if (underflow_count != last_logged_underflow_count) {
+        const uint64_t underflow_count = output->output_underflow_count.load();
+        if (underflow_count > last_logged_underflow_count) {
             VIAM_SDK_LOG(warn) << "[playback] Output underflow detected — " << (underflow_count - last_logged_underflow_count)
                                << " new underflow(s), " << underflow_count << " total";
-            last_logged_underflow_count = underflow_count;
         }
+        last_logged_underflow_count = underflow_count;
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        // Sleep until the reader has taken everything (or stop() / a restart notifies us).
+        playback_context->notifier.wait_for(audio::MAX_WAIT_SLICE, [&]() {
+            return stopped(session) || playback_context->playback_position.load() - start_position >= samples_to_drain;
+        });
     }
 
-    // Drain the PortAudio pipeline so the caller knows the audio actually played. Skipped on
-    // the early-return paths above (stop / context swap) — both want to exit promptly.
+    // Drain the PortAudio pipeline so the caller knows the audio actually played. Skipped when
+    // stopped above, which wants to exit promptly.
     double drain_latency;
     {
         std::lock_guard<std::mutex> lock(stream_mu_);
         drain_latency = latency_;
     }
-    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(drain_latency * 1000)));
+    std::chrono::nanoseconds drain = std::chrono::milliseconds(static_cast<int>(drain_latency * 1000));
+    if (session.source) {
+        // A mixed call also waits out the mixer's lead, which is still queued in the stream buffer
+        drain += std::chrono::milliseconds(MIX_AHEAD_MS);
+    } else if (const auto remaining = playback_context->time_until_played(start_position + samples_to_drain)) {
+        // Return once the last sample reaches the DAC by the callback's output timing, capped at
+        // the fixed wait plus one callback buffer in case the host reports odd times
+        const auto buffer = std::chrono::nanoseconds(playback_context->callback_frames.load() * audio::NANOSECONDS_PER_SECOND /
+                                                     static_cast<uint64_t>(session.speaker_sample_rate));
+        drain = std::clamp<std::chrono::nanoseconds>(*remaining, std::chrono::nanoseconds::zero(), drain + buffer);
+    }
+    std::this_thread::sleep_for(drain);
 }
 
-// Resampling and channel conversion run per-chunk against the source's audio_info, so chunk
-// boundaries that don't align with the resampler's window can introduce minor artifacts.
+// Channel conversion runs per-chunk against the source's audio_info. Resampling goes through a
+// StreamingResampler that lives for the whole call, so chunk boundaries don't reset the filter;
+// its tail is flushed once the source is exhausted.
 void Speaker::play_stream(viam::sdk::audio_info info,
                           std::function<boost::optional<std::vector<uint8_t>>()> chunk_source,
                           const viam::sdk::ProtoStruct& extra) {
-    std::lock_guard<std::mutex> playback_lock(playback_mu_);
-    stop_requested_.store(false);
+    const audio::realtime::ScopedThreadSettings thread_settings(realtime_);
+    std::unique_lock<std::mutex> playback_lock(playback_mu_, std::defer_lock);
+    if (!mixing_) {
+        playback_lock.lock();
+        stop_requested_.store(false);
+    }
 
     const AudioCodec source_codec = audio::codec::parse_codec(info.codec);
-    if (source_codec == AudioCodec::MP3) {
-        throw std::invalid_argument("[PlayStream] MP3 streaming is not supported; use play() for MP3");
-    }
 
-    int speaker_sample_rate;
-    int speaker_num_channels;
-    std::shared_ptr<audio::OutputStreamContext> playback_context;
-    {
-        std::lock_guard<std::mutex> lock(stream_mu_);
-        if (!audio_context_) {
-            throw std::runtime_error("[PlayStream] Audio context is nullptr");
-        }
-        playback_context = audio_context_;
-        speaker_sample_rate = stream_params_.sample_rate;
-        speaker_num_channels = stream_params_.num_channels;
-    }
+    PlaybackScratch call_scratch;
+    PlaybackSession session = begin_playback(extra, mixing_ ? call_scratch : scratch_);
 
-    const uint64_t start_position = playback_context->get_write_position();
+    const uint64_t start_position = session.context->get_write_position();
     uint64_t total_samples_written = 0;
 
+    // Jitter buffer: hold playback until the pre-roll target is buffered. When the reader
+    // catches up with the source mid-stream (or the device underflows), double the target up to
+    // max_preroll_ms and buffer that much again before resuming; after a stable stretch, step it
+    // back toward preroll_ms. The target carries over to the next stream.
+    audio::OutputStreamContext& ring = *session.context;
+    const PrerollRelease preroll_release{ring};
+    const auto preroll_samples = [&session](int ms) {
+        return static_cast<uint64_t>(session.speaker_sample_rate) * session.speaker_num_channels * ms / 1000;
+    };
+    int preroll_ms = jitter_target_ms_.load();
+    if (preroll_ms > 0) {
+        ring.preroll_until.store(start_position + preroll_samples(preroll_ms));
+    }
+    uint64_t underflows_seen = ring.output_underflow_count.load();
+    uint64_t stable_since = ring.playback_position.load();
+
+    // For MP3 and Opus the source format comes from the stream itself, and the resampler is
+    // created once the first frame is decoded (see write_decoded).
+    std::unique_ptr<MP3DecoderContext> mp3_ctx;
+    std::unique_ptr<OpusDecoderContext> opus_ctx;
+    std::unique_ptr<StreamingResampler> resampler;
+    if (source_codec == AudioCodec::MP3) {
+        mp3_ctx = std::make_unique<MP3DecoderContext>();
+    } else if (source_codec == AudioCodec::OPUS) {
+        opus_ctx = std::make_unique<OpusDecoderContext>();
+    } else if (info.sample_rate_hz != session.speaker_sample_rate) {
+        resampler = std::make_unique<StreamingResampler>(
+            info.sample_rate_hz, session.speaker_sample_rate, session.speaker_num_channels, resample_options_);
+    }
+
     while (auto chunk = chunk_source()) {
-        if (stop_requested_.load()) {
+        if (stopped(session)) {
             break;
         }
-        {
-            std::lock_guard<std::mutex> lock(stream_mu_);
-            if (audio_context_ != playback_context) {
-                return;
-            }
-        }
         if (chunk->empty()) {
             continue;
         }
+        stats_->chunks.add();
+
+        const uint64_t write_pos = ring.get_write_position();
+        const uint64_t play_pos = ring.playback_position.load();
+        const uint64_t underflows = ring.output_underflow_count.load();
+        const bool ran_dry = total_samples_written > 0 && play_pos >= write_pos && write_pos >= ring.preroll_until.load();
+        if ((ran_dry || underflows != underflows_seen) && preroll_ms < max_preroll_ms_) {
+            preroll_ms = std::min(max_preroll_ms_, std::max(preroll_ms * 2, JITTER_STEP_MS));
+            VIAM_SDK_LOG(debug) << "[PlayStream] Source fell behind playback, pre-roll now " << preroll_ms << "ms";
+            stable_since = play_pos;
+        } else if (preroll_ms > preroll_ms_ && play_pos - stable_since >= preroll_samples(JITTER_SHRINK_AFTER_MS)) {
+            preroll_ms = std::max(preroll_ms_, preroll_ms - JITTER_STEP_MS);
+            stable_since = play_pos;
+        }
+        if (ran_dry && preroll_ms > 0) {
+            ring.preroll_until.store(write_pos + preroll_samples(preroll_ms));
+        }
+        underflows_seen = underflows;
+
+        if (mp3_ctx) {
+            // Play whatever frames this chunk completes right away
+            total_samples_written += decode_and_write_mp3(*mp3_ctx, chunk->data(), chunk->size(), resampler, session);
+            continue;
+        }
+        if (opus_ctx) {
+            total_samples_written += decode_and_write_opus(*opus_ctx, chunk->data(), chunk->size(), resampler, session);
+            continue;
+        }
+
+        total_samples_written += process_and_write_pcm(
+            chunk->data(), chunk->size(), source_codec, info.sample_rate_hz, info.num_channels, session, resampler.get());
+    }
+
+    if (mp3_ctx && mp3_ctx->sample_rate == 0 && !stopped(session)) {
+        VIAM_SDK_LOG(warn) << "[PlayStream] MP3 stream ended without any decodable frames";
+    }
+    if (opus_ctx && opus_ctx->sample_rate == 0 && !stopped(session)) {
+        VIAM_SDK_LOG(warn) << "[PlayStream] Opus stream ended without any complete packets";
+    }
+
+    if (resampler && !stopped(session)) {
+        std::vector<int16_t> tail;
+        resampler->flush(tail);
+        total_samples_written += write_with_backpressure(tail.data(), tail.size(), session);
+    }
+
+    // The source is done, so whatever is buffered plays even if it's short of the pre-roll
+    jitter_target_ms_.store(preroll_ms);
+    ring.preroll_until.store(0);
+    wait_for_playback(session, start_position, total_samples_written);
+}
+
+void Speaker::notify_mixer() {
+    mixer_wakeups_.fetch_add(1);
+    audio_context_->notifier.notify();
+}
+
+void Speaker::run_mixer() {
+    audio::realtime::apply_to_current_thread(realtime_);
+    const std::shared_ptr<audio::OutputStreamContext>& output = audio_context_;
+    while (!mixer_stop_.load()) {
+        if (mix_sources(*output) > 0) {
+            continue;
+        }
+        // Woken by every callback (room freed), source write, stop, and restart
+        const uint64_t seen_wakeups = mixer_wakeups_.load();
+        const uint64_t seen_playback = output->playback_position.load();
+        const uint64_t seen_callback = output->last_callback_time_ns.load();
+        output->notifier.wait_for(audio::MAX_WAIT_SLICE, [&]() {
+            return mixer_stop_.load() || mixer_wakeups_.load() != seen_wakeups || output->playback_position.load() != seen_playback ||
+                   output->last_callback_time_ns.load() != seen_callback;
+        });
+    }
+}
 
-        total_samples_written += process_and_write_pcm(chunk->data(),
-                                                       chunk->size(),
-                                                       source_codec,
-                                                       info.sample_rate_hz,
-                                                       info.num_channels,
-                                                       speaker_sample_rate,
-                                                       speaker_num_channels,
-                                                       playback_context);
+size_t Speaker::mix_sources(audio::OutputStreamContext& output) {
+    const uint64_t channels = static_cast<uint64_t>(output.info.num_channels);
+    const uint64_t lead = std::max(static_cast<uint64_t>(output.info.sample_rate_hz) * MIX_AHEAD_MS / 1000,
+                                   2 * output.callback_frames.load()) *
+                          channels;
+    const uint64_t write_pos = output.get_write_position();
+    const uint64_t limit = output.playback_position.load() + lead;
+    if (write_pos >= limit) {
+        return 0;
+    }
+    const uint64_t room = (limit - write_pos) / channels * channels;
+
+    // Whole frames a source has queued, so every source stays channel-aligned with the output.
+    // Nothing while the source is still buffering its pre-roll.
+    const auto ready = [channels](const MixSource& source) -> uint64_t {
+        const uint64_t written = source.ring.get_write_position();
+        const uint64_t read = source.ring.playback_position.load();
+        if (written < source.ring.preroll_until.load()) {
+            return 0;
+        }
+        return written > read ? (written - read) / channels * channels : 0;
+    };
+
+    std::lock_guard<std::mutex> lock(mix_mu_);
+    mix_sources_.erase(std::remove_if(mix_sources_.begin(),
+                                      mix_sources_.end(),
+                                      [&](const std::shared_ptr<MixSource>& source) {
+                                          return source->stop_requested.load() || (source->finished.load() && ready(*source) == 0);
+                                      }),
+                       mix_sources_.end());
+
+    int top_priority = std::numeric_limits<int>::min();
+    uint64_t block = 0;
+    for (const auto& source : mix_sources_) {
+        top_priority = std::max(top_priority, source->priority);
+        block = std::max(block, std::min(room, ready(*source)));
+    }
+    if (block == 0) {
+        return 0;
+    }
+
+    // Sum in float with each source's gain, then saturate once. Sources with less audio ready
+    // than the block are padded with silence.
+    mix_accum_.assign(block, 0.0f);
+    mix_read_.resize(block);
+    for (const auto& source : mix_sources_) {
+        const uint64_t wanted = std::min(block, ready(*source));
+        if (wanted == 0) {
+            continue;
+        }
+        uint64_t read_pos = source->ring.playback_position.load();
+        const int count = source->ring.read_samples(mix_read_.data(), static_cast<int>(wanted), read_pos);
+        source->ring.playback_position.store(read_pos);
+        source->ring.notifier.notify();
+
+        // Ramp linearly from the last block's gain so a change in ducking doesn't click
+        const float target = source->priority < top_priority ? source->gain * MIX_DUCK_GAIN : source->gain;
+        const float start = source->applied_gain;
+        const uint64_t frames = static_cast<uint64_t>(count) / channels;
+        for (uint64_t frame = 0; frame < frames; frame++) {
+            const float gain = start + (target - start) * static_cast<float>(frame + 1) / static_cast<float>(frames);
+            for (uint64_t ch = 0; ch < channels; ch++) {
+                const uint64_t i = frame * channels + ch;
+                mix_accum_[i] += static_cast<float>(mix_read_[i]) * gain;
+            }
+        }
+        source->applied_gain = target;
     }
 
-    wait_for_playback(playback_context, start_position, total_samples_written);
+    mix_out_.resize(block);
+    for (uint64_t i = 0; i < block; i++) {
+        mix_out_[i] = static_cast<int16_t>(std::clamp(mix_accum_[i], -32768.0f, 32767.0f));
+    }
+    output.write_samples(mix_out_.data(), block);
+    return block;
 }
 
 viam::sdk::audio_properties Speaker::get_properties(const vsdk::ProtoStruct& extra) {
     viam::sdk::audio_properties props;
 
-    props.supported_codecs = {
-        vsdk::audio_codecs::PCM_16, vsdk::audio_codecs::PCM_32, vsdk::audio_codecs::PCM_32_FLOAT, vsdk::audio_codecs::MP3};
+    props.supported_codecs = {vsdk::audio_codecs::PCM_16,
+                              vsdk::audio_codecs::PCM_32,
+                              vsdk::audio_codecs::PCM_32_FLOAT,
+                              vsdk::audio_codecs::MP3,
+                              audio::codec::OPUS_CODEC_NAME};
     std::lock_guard<std::mutex> lock(stream_mu_);
     props.sample_rate_hz = stream_params_.sample_rate;
     props.num_channels = stream_params_.num_channels;
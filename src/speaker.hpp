@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <functional>
 #include <memory>
@@ -14,8 +15,16 @@
 #include "audio_codec.hpp"
 #include "audio_stream.hpp"
 #include "audio_utils.hpp"
+#include "clip_cache.hpp"
+#include "hotplug.hpp"
+#include "metrics.hpp"
+#include "mp3_decoder.hpp"
+#include "opus_decoder.hpp"
 #include "portaudio.h"
 #include "portaudio.hpp"
+#include "realtime.hpp"
+#include "resample.hpp"
+#include "volume.hpp"
 #include "watchdog.hpp"
 
 namespace speaker {
@@ -37,6 +46,70 @@ struct SpeakerConfigParams {
     std::optional<double> latency_ms;
 };
 
+// One play()/play_stream() call while mixing is enabled. The call writes speaker-format audio
+// into ring with the usual backpressure, and the mixer thread drains it into the stream buffer.
+struct MixSource {
+    MixSource(const vsdk::audio_info& info, float gain, int priority);
+
+    // playback_position is the mixer's read cursor
+    audio::OutputStreamContext ring;
+    const float gain;
+    const int priority;
+    // Set by stop; the call exits and the mixer drops the source without draining it
+    std::atomic<bool> stop_requested{false};
+    // Set when the call returns; the mixer drops the source once it's drained
+    std::atomic<bool> finished{false};
+    // Gain the mixer applied at the end of the last block, ramped toward the target so
+    // ducking doesn't click. Only touched by the mixer.
+    float applied_gain;
+};
+
+// Scratch for one call's decode, channel conversion, and resampling, reused across its chunks
+// so steady-state playback doesn't allocate.
+struct PlaybackScratch {
+    std::vector<uint8_t> decoded;
+    std::vector<uint8_t> codec_decoded;
+    std::vector<int16_t> channel_mixed;
+    std::vector<int16_t> resampled;
+    ChannelMatrix default_matrix;
+    // With the mlock attribute, the four buffers above stay locked in RAM as they grow
+    std::array<audio::realtime::LockedRegion, 4> locks;
+
+    void lock_memory(const std::shared_ptr<audio::realtime::RealtimeSettings>& settings) {
+        audio::realtime::lock_vector(locks[0], decoded, settings);
+        audio::realtime::lock_vector(locks[1], codec_decoded, settings);
+        audio::realtime::lock_vector(locks[2], channel_mixed, settings);
+        audio::realtime::lock_vector(locks[3], resampled, settings);
+    }
+};
+
+// Where one play()/play_stream() call writes its audio.
+struct PlaybackSession {
+    ~PlaybackSession() {
+        if (source) {
+            source->finished.store(true);
+        }
+    }
+
+    // audio_context_ when playback is serialized, otherwise source->ring
+    std::shared_ptr<audio::OutputStreamContext> context;
+    // Set only when mixing is enabled
+    std::shared_ptr<MixSource> source;
+    PlaybackScratch& scratch;
+    int speaker_sample_rate;
+    int speaker_num_channels;
+};
+
+// What a microphone's duplex stream needs to play a speaker's audio: the context to play
+// from and the output half of the speaker's stream configuration.
+struct DuplexOutput {
+    std::shared_ptr<audio::OutputStreamContext> context;
+    PaDeviceIndex device_index;
+    int num_channels;
+    int sample_rate;
+    double latency_seconds;
+};
+
 int speakerCallback(const void* inputBuffer,
                     void* outputBuffer,
                     unsigned long framesPerBuffer,
@@ -44,6 +117,12 @@ int speakerCallback(const void* inputBuffer,
                     PaStreamCallbackFlags statusFlags,
                     void* userData);
 
+// The playback callback for a stream's layout: a copy of speakerCallback compiled for a fixed
+// channel count (1, 2, 4 or 8), so the silence fill and gain ramp have no runtime stride.
+// speakerCallback for any other count. Output streams are always int16, so the format is
+// ignored.
+PaStreamCallback* select_speaker_callback(int num_channels, audio::SampleFormat sample_format);
+
 class Speaker final : public viam::sdk::AudioOut {
    public:
     Speaker(viam::sdk::Dependencies deps, viam::sdk::ResourceConfig cfg, audio::portaudio::PortAudioInterface* pa = nullptr);
@@ -62,30 +141,85 @@ class Speaker final : public viam::sdk::AudioOut {
 
     viam::sdk::audio_properties get_properties(const viam::sdk::ProtoStruct& extra);
     std::vector<viam::sdk::GeometryConfig> get_geometries(const viam::sdk::ProtoStruct& extra);
-    viam::sdk::ProtoStruct get_status() override {
-        return {};
-    }
+    // Playback metrics, the same as the get_stats DoCommand
+    viam::sdk::ProtoStruct get_status() override;
+
+    // Hands playback to a microphone's duplex stream (its duplex_speaker attribute): closes
+    // this speaker's own stream and returns the context the duplex callback plays from.
+    // play() and play_stream() keep writing into that context as usual. Throws
+    // std::runtime_error if another microphone already holds it.
+    DuplexOutput attach_duplex();
+
+    // Takes playback back once the duplex stream is closed, reopening the speaker's own
+    // stream on the same context
+    void detach_duplex();
 
     // Member variables
     double latency_;
     std::optional<int> volume_;
+    // volume_control attribute: "hardware" sets volume on the ALSA mixer; the default,
+    // "software", applies it as a gain in the callback. Set once in the constructor.
+    bool hardware_volume_ = false;
+    // Software mute, whichever volume control is in use. Guarded by stream_mu_.
+    bool muted_ = false;
+    // Cached ALSA mixer for hardware volume. mixer_mu_ serializes set_volume calls so the
+    // ALSA write happens outside stream_mu_ but still in command order.
+    std::mutex mixer_mu_;
+    audio::volume::MixerControl hardware_mixer_;
+    // soxr quality profile for source rate -> speaker rate; set once in the constructor
+    ResampleOptions resample_options_;
+    // Optional channel_matrix attribute; used when the source and speaker channel counts match it
+    std::optional<ChannelMatrix> channel_matrix_;
     static vsdk::Model model;
 
-    // This is used to ensure there is only one play() call at a time.
+    // play_stream jitter buffer: preroll_ms_ is the starting pre-roll and the floor it shrinks
+    // back to, max_preroll_ms_ the ceiling it grows to. Set once in the constructor.
+    // jitter_target_ms_ is the current target, carried from one stream to the next.
+    int preroll_ms_ = 0;
+    int max_preroll_ms_ = 0;
+    std::atomic<int> jitter_target_ms_{0};
+
+    // This is used to ensure there is only one play() call at a time, unless mixing is enabled.
     std::mutex playback_mu_;
 
+    // mixing attribute: concurrent play()/play_stream() calls each get a MixSource and are
+    // summed by mixer_thread_ instead of waiting on playback_mu_. Set once in the constructor.
+    bool mixing_ = false;
+    // Active sources, guarded by mix_mu_. Calls add themselves; only the mixer removes them.
+    std::mutex mix_mu_;
+    std::vector<std::shared_ptr<MixSource>> mix_sources_;
+    std::atomic<bool> mixer_stop_{false};
+    // Bumped by notify_mixer so the mixer's wait predicate sees source writes
+    std::atomic<uint64_t> mixer_wakeups_{0};
+    std::thread mixer_thread_;
+
     PaStream* stream_;
     audio::portaudio::PortAudioInterface* pa_;
 
     // Protects stream_, audio_context_, and stream configuration
     std::mutex stream_mu_;
 
-    // Audio context for speaker playback (includes buffer and playback position tracking)
+    // Set while a microphone's duplex stream plays audio_context_ in place of stream_, which
+    // is closed meanwhile; the stall watchdog leaves restarts to the microphone. Guarded by
+    // stream_mu_.
+    bool duplex_attached_ = false;
+
+    // Audio context for speaker playback (includes buffer and playback position tracking).
+    // Set once in the constructor; stall restarts and duplex streams play from the same
+    // context, so it's read without stream_mu_.
     std::shared_ptr<audio::OutputStreamContext> audio_context_;
 
+    // Metrics for the resource's lifetime, across stall restarts; set once in the constructor
+    std::shared_ptr<audio::metrics::StreamMetrics> stats_;
+    // Real-time scheduling and memory locking options and their outcome; set once in the constructor
+    std::shared_ptr<audio::realtime::RealtimeSettings> realtime_;
+
     // Flag to interrupt playback
     std::atomic<bool> stop_requested_{false};
 
+    // Clips preloaded for play_clip, capped at clip_cache_mb; set once in the constructor
+    std::unique_ptr<audio::clips::ClipCache> clips_;
+
     // Saved stream params so the watchdog can rebuild the stream with the same configuration.
     audio::utils::StreamParams stream_params_;
 
@@ -104,28 +238,117 @@ class Speaker final : public viam::sdk::AudioOut {
     // Background watchdog that polls audio_context_->last_callback_time_ns and triggers
     // restart_stalled_stream when the speaker callback has gone silent for too long,
     std::unique_ptr<audio::utils::StallWatchdog<audio::OutputStreamContext>> watchdog_;
+    // Wakes watchdog_ when an audio device is added or removed, so a replugged device
+    // is picked up right away
+    std::unique_ptr<audio::hotplug::HotplugMonitor> hotplug_;
 
    private:
+    // Pushes volume_ / muted_ to the software gain of audio_context_. Caller must hold stream_mu_.
+    void update_software_gain();
+
     void restart_stalled_stream(const std::shared_ptr<audio::OutputStreamContext>& playback_context);
 
-    // Decode (PCM_16/32/32_FLOAT), channel-convert, resample, and write into the playback
-    // context's buffer. Writes are paced so the producer can't run more than buffer_capacity
-    // samples ahead of the callback; this propagates backpressure up through chunk_source.
+    // Reopens stream_ on stream_params_, playing from playback_context. Returns false with
+    // error set if the device wouldn't open. Caller must hold stream_mu_.
+    bool reopen_stream(const std::shared_ptr<audio::OutputStreamContext>& playback_context, std::string& error);
+
+    // Reports stats_ plus the current stream's overflow/underflow counts, zeroing stats_ when
+    // reset is set
+    viam::sdk::ProtoStruct stats_struct(bool reset);
+
+    // Snapshots the stream format and picks where the call writes: audio_context_, or with
+    // mixing a new MixSource (gain and priority from extra) registered with the mixer.
+    // Serialized callers must hold playback_mu_ and pass scratch_.
+    PlaybackSession begin_playback(const viam::sdk::ProtoStruct& extra, PlaybackScratch& scratch);
+
+    // True once a stop command has interrupted this call
+    bool stopped(const PlaybackSession& session) const;
+
+    // Decode (PCM_16/32/32_FLOAT), channel-convert, resample, and write into the session's
+    // context. Writes are paced so the producer can't run more than buffer_capacity
+    // samples ahead of its reader; this propagates backpressure up through chunk_source.
     // Returns the number of samples actually written — equal to the decoded input size on a
-    // full write, or a partial count if stop_requested_ fired or the stream context was
-    // swapped mid-write. Caller must hold playback_mu_.
+    // full write, or a partial count if the call was stopped mid-write. When resampler is non-null it is used instead of a one-shot
+    // resample, and may legitimately return fewer samples (or none) for this chunk.
     size_t process_and_write_pcm(const uint8_t* data,
                                  size_t size,
                                  audio::codec::AudioCodec codec,
                                  int audio_sample_rate,
                                  int audio_num_channels,
-                                 int speaker_sample_rate,
-                                 int speaker_num_channels,
-                                 std::shared_ptr<audio::OutputStreamContext> playback_context);
+                                 PlaybackSession& session,
+                                 StreamingResampler* resampler = nullptr);
+
+    // Decodes and plays an MP3 or Opus buffer slice by slice, then waits for it to drain.
+    void play_compressed(audio::codec::AudioCodec codec, const uint8_t* data, size_t size, PlaybackSession& session);
+
+    // Decodes one piece of an MP3 stream and writes whatever frames it completes. The source
+    // format comes from the first frame header; that's also when resampler is created, if the
+    // rate differs from the speaker's. Returns the number of samples written.
+    size_t decode_and_write_mp3(MP3DecoderContext& mp3_ctx,
+                                const uint8_t* data,
+                                size_t size,
+                                std::unique_ptr<StreamingResampler>& resampler,
+                                PlaybackSession& session);
+
+    // Same as decode_and_write_mp3 for a length-prefixed Opus stream. Packets are decoded at
+    // the speaker's rate when Opus supports it, so usually no resampler is needed.
+    size_t decode_and_write_opus(OpusDecoderContext& opus_ctx,
+                                 const uint8_t* data,
+                                 size_t size,
+                                 std::unique_ptr<StreamingResampler>& resampler,
+                                 PlaybackSession& session);
+
+    // Writes the PCM16 in the session's codec_decoded scratch from a decoder whose output
+    // format is decoded_sample_rate / decoded_num_channels, creating resampler when the format
+    // has just become known and differs from the speaker's.
+    size_t write_decoded(bool format_was_known,
+                         int decoded_sample_rate,
+                         int decoded_num_channels,
+                         std::unique_ptr<StreamingResampler>& resampler,
+                         PlaybackSession& session);
+
+    // Returns the mix for audio_num_channels -> speaker_num_channels: the configured
+    // channel_matrix when its shape matches, otherwise the default mix cached in scratch, or
+    // nullptr when the counts are equal and no override applies.
+    const ChannelMatrix* channel_matrix_for(int audio_num_channels, int speaker_num_channels, PlaybackScratch& scratch);
+
+    // Writes already-converted speaker-format samples with the backpressure described above.
+    size_t write_with_backpressure(const int16_t* samples, size_t num_samples, PlaybackSession& session);
+
+    // Decodes source and converts it to speaker_sample_rate / speaker_num_channels the way
+    // play() would, all at once. Throws std::invalid_argument if no audio comes out.
+    std::shared_ptr<const audio::clips::Clip> convert_clip(std::shared_ptr<const audio::clips::ClipSource> source,
+                                                           int speaker_sample_rate,
+                                                           int speaker_num_channels);
+
+    // Converts source to the current stream format and caches it under id
+    std::shared_ptr<const audio::clips::Clip> preload_clip(const std::string& id, std::shared_ptr<const audio::clips::ClipSource> source);
+
+    // Plays the clip cached under id like play(), blocking until it has played. A clip
+    // converted for a format the stream no longer has is converted again first, and the cache
+    // keeps the new version. Throws std::invalid_argument if nothing is cached under id.
+    std::shared_ptr<const audio::clips::Clip> play_clip(const std::string& id, const viam::sdk::ProtoStruct& extra);
+
+    // Scratch for serialized playback. Guarded by playback_mu_.
+    PlaybackScratch scratch_;
+
+    void wait_for_playback(PlaybackSession& session, uint64_t start_position, uint64_t samples_to_drain);
+
+    // Body of mixer_thread_: keeps the stream buffer a little ahead of the callback with the
+    // sum of every source's ready audio.
+    void run_mixer();
+
+    // Mixes one block into output. Returns the number of samples written, 0 if there's no room
+    // or no source has audio ready.
+    size_t mix_sources(audio::OutputStreamContext& output);
+
+    // Wakes the mixer after a source write or a stop
+    void notify_mixer();
 
-    void wait_for_playback(std::shared_ptr<audio::OutputStreamContext> playback_context,
-                           uint64_t start_position,
-                           uint64_t samples_to_drain);
+    // Mixer-thread scratch, guarded by mix_mu_
+    std::vector<int16_t> mix_read_;
+    std::vector<float> mix_accum_;
+    std::vector<int16_t> mix_out_;
 };
 
 }  // namespace speaker
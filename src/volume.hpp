@@ -1,15 +1,19 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <string>
 #include <viam/sdk/common/utils.hpp>
 #include "audio_utils.hpp"
 
+#ifdef __linux__
+#include <alsa/asoundlib.h>
+#endif
+
 namespace audio {
 namespace volume {
 
 #ifdef __linux__
-#include <alsa/asoundlib.h>
 
 // Extract ALSA card identifier from PortAudio device name.
 // PortAudio names look like "bcm2835 Headphones: - (hw:0,0)" on Pi.
@@ -31,73 +35,127 @@ inline std::string extract_alsa_card(const std::string& device_name) {
     return "default";
 }
 
-inline void set_volume(const std::string& device_name, int volume) {
-    const std::string card = extract_alsa_card(device_name);
+// Hardware playback volume for one sound card. The ALSA mixer is opened, loaded, and searched
+// for a volume element once, then reused, so repeated set_volume calls (e.g. a UI slider)
+// cost one ALSA write each. It's re-resolved when the card changes, after invalidate(), or
+// after a write fails. Not thread-safe; callers serialize access.
+class MixerControl {
+   public:
+    void set_volume(const std::string& device_name, int volume) {
+        const std::string card = extract_alsa_card(device_name);
+        const bool invalidated = invalidated_.exchange(false);
+        if (invalidated || card != card_) {
+            close();
+        }
+        if (!elem_ && !open(card)) {
+            return;
+        }
 
-    VIAM_SDK_LOG(debug) << "[set_volume] Setting ALSA volume to " << volume << " on card " << card;
+        // Pick up pending mixer events (e.g. the element going away) before writing
+        if (int err = snd_mixer_handle_events(mixer_.get()); err < 0) {
+            VIAM_SDK_LOG(warn) << "[set_volume] Mixer event handling failed, re-resolving: " << snd_strerror(err);
+            close();
+            if (!open(card)) {
+                return;
+            }
+        }
 
-    snd_mixer_t* mixer_ptr = nullptr;
-    if (int err = snd_mixer_open(&mixer_ptr, 0); err < 0) {
-        VIAM_SDK_LOG(error) << "[set_volume] Failed to open ALSA mixer: " << snd_strerror(err);
-        return;
-    }
-    audio::utils::CleanupPtr<snd_mixer_close> mixer(mixer_ptr);
+        VIAM_SDK_LOG(debug) << "[set_volume] Setting ALSA volume to " << volume << " on card " << card;
 
-    // Connect alsa mixer to our device's sound card
-    if (int err = snd_mixer_attach(mixer.get(), card.c_str()); err < 0) {
-        VIAM_SDK_LOG(error) << "[set_volume] Failed to attach mixer to card: " << card << " :  " << snd_strerror(err);
-        return;
+        const long target = min_ + (max_ - min_) * volume / 100;
+        if (int err = snd_mixer_selem_set_playback_volume_all(elem_, target); err < 0) {
+            VIAM_SDK_LOG(error) << "[set_volume] Failed to set playback volume: " << snd_strerror(err);
+            // The card may have been unplugged; start over on the next call
+            close();
+        }
     }
 
-    // Register simple element class to access high-level volume control
-    if (int err = snd_mixer_selem_register(mixer.get(), nullptr, nullptr); err < 0) {
-        VIAM_SDK_LOG(error) << "[set_volume] Failed to register mixer elements: " << snd_strerror(err);
-        return;
+    // Drops the cached mixer on the next set_volume, e.g. after the stream was restarted on a
+    // re-enumerated device. Safe to call from any thread.
+    void invalidate() noexcept {
+        invalidated_.store(true);
     }
 
-    // load elements (controls of the mixer)
-    if (int err = snd_mixer_load(mixer.get()); err < 0) {
-        VIAM_SDK_LOG(error) << "[set_volume] Failed to load mixer elements: " << snd_strerror(err);
-        return;
-    }
+   private:
+    bool open(const std::string& card) {
+        snd_mixer_t* mixer_ptr = nullptr;
+        if (int err = snd_mixer_open(&mixer_ptr, 0); err < 0) {
+            VIAM_SDK_LOG(error) << "[set_volume] Failed to open ALSA mixer: " << snd_strerror(err);
+            return false;
+        }
+        audio::utils::CleanupPtr<snd_mixer_close> mixer(mixer_ptr);
+
+        // Connect alsa mixer to our device's sound card
+        if (int err = snd_mixer_attach(mixer.get(), card.c_str()); err < 0) {
+            VIAM_SDK_LOG(error) << "[set_volume] Failed to attach mixer to card: " << card << " :  " << snd_strerror(err);
+            return false;
+        }
 
-    // Try "PCM" first (most common for Pi), then "Master"
-    snd_mixer_selem_id_t* sid = nullptr;
-    snd_mixer_selem_id_alloca(&sid);
-
-    // Volume control elements will either be called PCM, Master or Speaker depending on the device
-    const char* element_names[] = {"PCM", "Master", "Speaker"};
-    snd_mixer_elem_t* elem = nullptr;
-
-    for (const char* name : element_names) {
-        snd_mixer_selem_id_set_index(sid, 0);
-        snd_mixer_selem_id_set_name(sid, name);
-        elem = snd_mixer_find_selem(mixer.get(), sid);
-        if (elem) {
-            VIAM_SDK_LOG(debug) << "[set_volume] Found mixer element: " << name;
-            break;
+        // Register simple element class to access high-level volume control
+        if (int err = snd_mixer_selem_register(mixer.get(), nullptr, nullptr); err < 0) {
+            VIAM_SDK_LOG(error) << "[set_volume] Failed to register mixer elements: " << snd_strerror(err);
+            return false;
         }
+
+        // load elements (controls of the mixer)
+        if (int err = snd_mixer_load(mixer.get()); err < 0) {
+            VIAM_SDK_LOG(error) << "[set_volume] Failed to load mixer elements: " << snd_strerror(err);
+            return false;
+        }
+
+        snd_mixer_selem_id_t* sid = nullptr;
+        snd_mixer_selem_id_alloca(&sid);
+
+        // Volume control elements will either be called PCM, Master or Speaker depending on the device
+        const char* element_names[] = {"PCM", "Master", "Speaker"};
+        snd_mixer_elem_t* elem = nullptr;
+
+        for (const char* name : element_names) {
+            snd_mixer_selem_id_set_index(sid, 0);
+            snd_mixer_selem_id_set_name(sid, name);
+            elem = snd_mixer_find_selem(mixer.get(), sid);
+            if (elem) {
+                VIAM_SDK_LOG(debug) << "[set_volume] Found mixer element: " << name;
+                break;
+            }
+        }
+
+        if (!elem) {
+            VIAM_SDK_LOG(error) << "[set_volume] Could not find PCM or Master mixer element";
+            return false;
+        }
+
+        snd_mixer_selem_get_playback_volume_range(elem, &min_, &max_);
+        mixer_ = std::move(mixer);
+        elem_ = elem;
+        card_ = card;
+        return true;
     }
 
-    if (!elem) {
-        VIAM_SDK_LOG(error) << "[set_volume] Could not find PCM or Master mixer element";
-        return;
+    void close() {
+        elem_ = nullptr;
+        mixer_.reset();
+        card_.clear();
     }
 
-    long min = 0;
-    long max = 0;
-    snd_mixer_selem_get_playback_volume_range(elem, &min, &max);
+    std::string card_;
+    audio::utils::CleanupPtr<snd_mixer_close> mixer_;
+    // Owned by mixer_
+    snd_mixer_elem_t* elem_ = nullptr;
+    long min_ = 0;
+    long max_ = 0;
+    std::atomic<bool> invalidated_{false};
+};
 
-    const long target = min + (max - min) * volume / 100;
-    if (int err = snd_mixer_selem_set_playback_volume_all(elem, target); err < 0) {
-        VIAM_SDK_LOG(error) << "[set_volume] Failed to set playback volume: " << snd_strerror(err);
+#else
+class MixerControl {
+   public:
+    void set_volume(const std::string& /*device_name*/, int /*volume*/) {
+        VIAM_SDK_LOG(warn) << "[set_volume] Hardware volume is not supported on this platform";
     }
-}
 
-#else
-inline void set_volume(const std::string& /*device_name*/, int /*volume*/) {
-    VIAM_SDK_LOG(warn) << "[set_volume] Volume attribute is not supported on this platform";
-}
+    void invalidate() noexcept {}
+};
 
 #endif
 
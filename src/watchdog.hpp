@@ -2,10 +2,12 @@
 
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <exception>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 
@@ -22,9 +24,18 @@ constexpr std::chrono::milliseconds STALL_THRESHOLD{2000};
 // may come back later (USB plug-in, driver recovery) and we want to resume recovery
 // without requiring a config change.
 constexpr std::chrono::milliseconds BACKOFF_INTERVAL{2000};
+// After a hotplug event, a callback this stale counts as stalled, and restarts skip the
+// backoff gate, for HOTPLUG_WINDOW. Long enough for udev to finish creating the device's
+// nodes and symlinks, which lag the kernel's event.
+constexpr std::chrono::milliseconds HOTPLUG_STALL_THRESHOLD{500};
+constexpr std::chrono::milliseconds HOTPLUG_WINDOW{3000};
+// While the device is gone and hotplug events are being delivered, the watchdog sleeps
+// until one arrives, checking this often in case one was missed.
+constexpr std::chrono::milliseconds HOTPLUG_IDLE_INTERVAL{30000};
 
 // Background watchdog that polls an audio component's `last_callback_time_ns` and
-// triggers a restart when the callback has gone silent for too long. Used by both
+// triggers a restart when the callback has gone silent for too long, or sooner when
+// notify_device_change reports a hotplug event. Used by both
 // Speaker and Microphone — the component-specific bits are passed in as callbacks.
 //
 // ContextT is the concrete audio context type (InputStreamContext / OutputStreamContext).
@@ -42,8 +53,8 @@ class StallWatchdog {
     using GetAttemptsFn = std::function<int()>;
 
     // Performs the restart. Argument is the same context get_context returned a moment
-    // earlier — the component should bail if it has since been swapped by a prior
-    // restart.
+    // earlier; components keep one context for their lifetime and reopen the stream into it,
+    // so it is still the live one.
     using RestartFn = std::function<void(const std::shared_ptr<ContextT>&)>;
 
     StallWatchdog(GetContextFn get_context, GetAttemptsFn get_attempts, RestartFn restart_fn, std::string log_prefix)
@@ -57,13 +68,40 @@ class StallWatchdog {
     }
 
     // Spins up the poll thread. Call after the owning component has finished
-    // constructing its first stream so the first poll sees valid state.
-    void start() {
-        thread_ = std::thread([this] { loop(); });
+    // constructing its first stream so the first poll sees valid state. thread_init, if
+    // set, runs first on the new thread (e.g. to apply real-time scheduling).
+    void start(std::function<void()> thread_init = nullptr) {
+        thread_ = std::thread([this, thread_init = std::move(thread_init)] {
+            if (thread_init) {
+                thread_init();
+            }
+            loop();
+        });
+    }
+
+    // Wakes the watchdog to check its stream now, e.g. because an audio device was added
+    // or removed. For the next HOTPLUG_WINDOW, a stream whose callback has been silent for
+    // HOTPLUG_STALL_THRESHOLD is restarted, bypassing the backoff. Safe from any thread.
+    void notify_device_change() {
+        {
+            std::lock_guard<std::mutex> lock(wake_mu_);
+            device_changed_ = true;
+        }
+        wake_cv_.notify_one();
+    }
+
+    // Set when notify_device_change is wired to a working hotplug monitor. The watchdog then
+    // stops polling once the device is gone and waits for it to come back.
+    void set_hotplug_active(bool active) {
+        hotplug_active_.store(active);
     }
 
     void stop() {
-        stop_.store(true);
+        {
+            std::lock_guard<std::mutex> lock(wake_mu_);
+            stop_.store(true);
+        }
+        wake_cv_.notify_one();
         if (thread_.joinable()) {
             thread_.join();
         }
@@ -71,13 +109,27 @@ class StallWatchdog {
 
    private:
     void loop() {
+        std::chrono::steady_clock::time_point hotplug_until{};
+        bool device_gone = false;
         while (!stop_.load()) {
-            std::this_thread::sleep_for(POLL_INTERVAL);
-            if (stop_.load()) {
-                return;
+            {
+                std::unique_lock<std::mutex> lock(wake_mu_);
+                // Once the budget is spent, poll only as a fallback if hotplug events
+                // will say when the device is back
+                const auto wait = device_gone && hotplug_active_.load() ? HOTPLUG_IDLE_INTERVAL : POLL_INTERVAL;
+                wake_cv_.wait_for(lock, wait, [this] { return stop_.load() || device_changed_; });
+                if (stop_.load()) {
+                    return;
+                }
+                if (device_changed_) {
+                    device_changed_ = false;
+                    hotplug_until = std::chrono::steady_clock::now() + HOTPLUG_WINDOW;
+                }
             }
+            const bool after_hotplug = std::chrono::steady_clock::now() < hotplug_until;
 
             const std::shared_ptr<ContextT> ctx = get_context_();
+            device_gone = false;
             if (!ctx) {
                 continue;
             }
@@ -93,17 +145,22 @@ class StallWatchdog {
                 continue;
             }
             const auto stale = std::chrono::milliseconds((now_ns - last_cb) / audio::NS_PER_MS);
-            if (stale <= STALL_THRESHOLD) {
+            if (stale <= (after_hotplug ? HOTPLUG_STALL_THRESHOLD : STALL_THRESHOLD)) {
                 continue;
             }
 
             const int attempts = get_attempts_();
-            if (attempts >= MAX_RESTART_ATTEMPTS) {
+            if (attempts >= MAX_RESTART_ATTEMPTS && after_hotplug) {
+                // A device came or went: retry right away, every poll until the window
+                // closes, since udev may not have finished setting the device up
+                VIAM_SDK_LOG(debug) << log_prefix_ << " device change, checking for device";
+            } else if (attempts >= MAX_RESTART_ATTEMPTS) {
                 // Budget exhausted — back off to slow retries instead of giving up
                 // permanently, so hot-replug (device unplugged then plugged back in)
                 // recovers automatically without requiring a config change.
                 const auto since_last = std::chrono::milliseconds((now_ns - last_attempt_ns_.load()) / audio::NS_PER_MS);
                 if (since_last < BACKOFF_INTERVAL) {
+                    device_gone = true;
                     if (!backoff_logged_.exchange(true)) {
                         const auto backoff_seconds = std::chrono::duration_cast<std::chrono::seconds>(BACKOFF_INTERVAL).count();
                         VIAM_SDK_LOG(warn) << log_prefix_ << " Restart budget exhausted; backing off to " << backoff_seconds
@@ -125,6 +182,7 @@ class StallWatchdog {
             } catch (const std::exception& e) {
                 VIAM_SDK_LOG(error) << log_prefix_ << " restart_fn threw: " << e.what();
             }
+            device_gone = get_attempts_() >= MAX_RESTART_ATTEMPTS;
         }
     }
 
@@ -134,6 +192,12 @@ class StallWatchdog {
     std::string log_prefix_;
     std::thread thread_;
     std::atomic<bool> stop_{false};
+    // Guards device_changed_ and the stop_ transition so a notify can't be missed between
+    // the wait's predicate check and its sleep
+    std::mutex wake_mu_;
+    std::condition_variable wake_cv_;
+    bool device_changed_ = false;
+    std::atomic<bool> hotplug_active_{false};
     // Latches once the watchdog has logged the "backing off" message after the attempts
     // budget was exhausted, so we don't spam the log every poll while waiting for backoff.
     // Cleared automatically once get_attempts drops back below MAX_RESTART_ATTEMPTS
@@ -1,7 +1,10 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <thread>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <fstream>
 #include <viam/sdk/common/instance.hpp>
 #include "microphone.hpp"
 #include "test_utils.hpp"
@@ -106,6 +109,99 @@ TEST_F(AudioBufferTest, ConcurrentWriteAndRead) {
     EXPECT_EQ(read_total.load(), total_samples);
 }
 
+TEST_F(AudioBufferTest, WriteSamplesBlockAndRead) {
+    const std::vector<int16_t> test_samples = {100, 200, 300, 400, 500};
+
+    buffer_->write_samples(test_samples.data(), test_samples.size());
+    EXPECT_EQ(buffer_->get_write_position(), test_samples.size());
+
+    std::vector<int16_t> read_buffer(test_samples.size());
+    uint64_t read_pos = 0;
+    const int samples_read = buffer_->read_samples(read_buffer.data(), test_samples.size(), read_pos);
+
+    EXPECT_EQ(samples_read, test_samples.size());
+    EXPECT_EQ(read_pos, test_samples.size());
+    EXPECT_EQ(read_buffer, test_samples);
+}
+
+TEST_F(AudioBufferTest, WriteSamplesWrapsAroundEndOfBuffer) {
+    // Park the write position just before the end of the physical ring so the next block wraps.
+    std::vector<int16_t> filler(buffer_->ring_size - 3, 0);
+    buffer_->write_samples(filler.data(), filler.size());
+
+    const std::vector<int16_t> block = {1, 2, 3, 4, 5, 6, 7};
+    buffer_->write_samples(block.data(), block.size());
+    EXPECT_EQ(buffer_->get_write_position(), filler.size() + block.size());
+
+    std::vector<int16_t> read_buffer(block.size());
+    uint64_t read_pos = filler.size();
+    const int samples_read = buffer_->read_samples(read_buffer.data(), block.size(), read_pos);
+
+    EXPECT_EQ(samples_read, block.size());
+    EXPECT_EQ(read_buffer, block);
+}
+
+TEST_F(AudioBufferTest, WriteSilenceOverwritesOldAudio) {
+    // Fill past the end of the ring first, so the silence has to zero stale audio and wrap
+    std::vector<int16_t> filler(buffer_->ring_size - 3, 42);
+    buffer_->write_samples(filler.data(), filler.size());
+    buffer_->write_samples(filler.data(), 10);
+
+    buffer_->write_silence(20);
+    EXPECT_EQ(buffer_->get_write_position(), filler.size() + 30);
+
+    std::vector<int16_t> read_buffer(20, -1);
+    uint64_t read_pos = filler.size() + 10;
+    EXPECT_EQ(buffer_->read_samples(read_buffer.data(), 20, read_pos), 20);
+    EXPECT_EQ(read_buffer, std::vector<int16_t>(20, 0));
+
+    buffer_->write_silence(0);
+    EXPECT_EQ(buffer_->get_write_position(), filler.size() + 30);
+}
+
+TEST_F(AudioBufferTest, RingIsPowerOfTwoButHistoryStaysAtCapacity) {
+    const int capacity = buffer_->buffer_capacity;
+    EXPECT_GE(buffer_->ring_size, static_cast<size_t>(capacity));
+    EXPECT_EQ(buffer_->ring_size & (buffer_->ring_size - 1), 0u);
+    EXPECT_EQ(buffer_->ring_mask, buffer_->ring_size - 1);
+
+    std::vector<int16_t> block(capacity + 100);
+    for (size_t i = 0; i < block.size(); i++) {
+        block[i] = static_cast<int16_t>(i % 1000);
+    }
+    buffer_->write_samples(block.data(), block.size());
+
+    // Samples older than buffer_capacity are treated as overwritten even though the
+    // rounded-up ring still holds them.
+    std::vector<int16_t> read_buffer(10);
+    uint64_t read_pos = 0;
+    const int samples_read = buffer_->read_samples(read_buffer.data(), 10, read_pos);
+
+    EXPECT_EQ(samples_read, 10);
+    EXPECT_EQ(read_pos, 110u);
+    EXPECT_TRUE(std::equal(read_buffer.begin(), read_buffer.end(), block.begin() + 100));
+}
+
+TEST_F(AudioBufferTest, WriteSamplesLargerThanCapacityKeepsNewest) {
+    const int capacity = buffer_->buffer_capacity;
+
+    std::vector<int16_t> block(capacity + 10);
+    for (size_t i = 0; i < block.size(); i++) {
+        block[i] = static_cast<int16_t>(i % 1000);
+    }
+    buffer_->write_samples(block.data(), block.size());
+    EXPECT_EQ(buffer_->get_write_position(), block.size());
+
+    // Reading from the start skips to the oldest surviving sample.
+    std::vector<int16_t> read_buffer(capacity);
+    uint64_t read_pos = 0;
+    const int samples_read = buffer_->read_samples(read_buffer.data(), capacity, read_pos);
+
+    EXPECT_EQ(samples_read, capacity);
+    EXPECT_EQ(read_pos, block.size());
+    EXPECT_TRUE(std::equal(read_buffer.begin(), read_buffer.end(), block.begin() + 10));
+}
+
 TEST_F(AudioBufferTest, ReadMoreThanAvailable) {
     // Write only 50 samples
     const int num_samples = 50;
@@ -145,3 +241,134 @@ int main(int argc, char **argv) {
     ::testing::AddGlobalTestEnvironment(new test_utils::AudioTestEnvironment);
     return RUN_ALL_TESTS();
 }
+
+TEST_F(AudioBufferTest, WaitForWritePositionWakesOnWrite) {
+    std::thread writer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        std::vector<int16_t> block(100, 1);
+        buffer_->write_samples(block.data(), block.size());
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool reached = buffer_->wait_for_write_position(100, std::chrono::seconds(5));
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    writer.join();
+
+    EXPECT_TRUE(reached);
+    // Woken by the write, not the timeout.
+    EXPECT_LT(elapsed, std::chrono::seconds(1));
+}
+
+TEST_F(AudioBufferTest, WaitForWritePositionTimesOut) {
+    buffer_->write_sample(1);
+    EXPECT_TRUE(buffer_->wait_for_write_position(1, std::chrono::milliseconds(0)));
+    EXPECT_FALSE(buffer_->wait_for_write_position(2, std::chrono::milliseconds(10)));
+}
+
+TEST_F(AudioBufferTest, NotifierWakesOnExternalCursor) {
+    std::atomic<bool> flag{false};
+    std::thread signaller([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        flag.store(true);
+        buffer_->notifier.notify();
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool woke = buffer_->notifier.wait_for(std::chrono::seconds(5), [&]() { return flag.load(); });
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    signaller.join();
+
+    EXPECT_TRUE(woke);
+    EXPECT_LT(elapsed, std::chrono::seconds(1));
+}
+
+TEST_F(AudioBufferTest, NewRingReadsAsSilence) {
+    audio_info info{viam::sdk::audio_codecs::PCM_16, 48000, 2};
+    AudioBuffer buffer(info, 10);
+
+    // Pretend a whole ring was written so the read reaches every slot
+    buffer.total_samples_written.store(buffer.buffer_capacity);
+    std::vector<int16_t> samples(buffer.buffer_capacity, 1);
+    uint64_t position = 0;
+    ASSERT_EQ(buffer.read_samples(samples.data(), samples.size(), position), buffer.buffer_capacity);
+    EXPECT_TRUE(std::all_of(samples.begin(), samples.end(), [](int16_t sample) { return sample == 0; }));
+}
+
+TEST_F(AudioBufferTest, Int32RingKeepsNativeSamples) {
+    AudioBuffer buffer(audio_info{viam::sdk::audio_codecs::PCM_32, 8000, 1}, 2, SampleFormat::INT32);
+    EXPECT_EQ(buffer.memory_bytes(), buffer.ring_size * sizeof(int32_t));
+
+    // Wrap around the end of the ring so both spans are converted
+    std::vector<int32_t> filler(buffer.ring_size - 2, 0);
+    buffer.write_native(filler.data(), filler.size());
+    const std::vector<int32_t> block = {0x12345678, -0x12345678, 0x7fffffff, -0x7fffffff - 1, 65535};
+    buffer.write_native(block.data(), block.size());
+
+    std::vector<int32_t> native(block.size());
+    uint64_t position = filler.size();
+    ASSERT_EQ(buffer.read_native(native.data(), native.size(), position), static_cast<int>(block.size()));
+    EXPECT_EQ(native, block);
+
+    // int16 readers get the top 16 bits
+    std::vector<int16_t> narrowed(block.size());
+    position = filler.size();
+    ASSERT_EQ(buffer.read_samples(narrowed.data(), narrowed.size(), position), static_cast<int>(block.size()));
+    EXPECT_EQ(narrowed, (std::vector<int16_t>{0x1234, -0x1235, 32767, -32768, 0}));
+
+    // And int16 writers are widened the same way the pcm32 codec does it
+    const std::vector<int16_t> pcm16 = {1, -1};
+    buffer.write_samples(pcm16.data(), pcm16.size());
+    ASSERT_EQ(buffer.read_native(native.data(), 2, position), 2);
+    EXPECT_EQ(native[0], 65536);
+    EXPECT_EQ(native[1], -65536);
+}
+
+TEST_F(AudioBufferTest, FloatRingClampsWhenNarrowed) {
+    AudioBuffer buffer(audio_info{viam::sdk::audio_codecs::PCM_32_FLOAT, 8000, 1}, 2, SampleFormat::FLOAT32);
+    const std::vector<float> block = {0.5f, -0.5f, 2.0f, -2.0f, std::nanf("")};
+    buffer.write_native(block.data(), block.size());
+    buffer.write_silence(1);
+
+    std::vector<int16_t> narrowed(block.size() + 1, -1);
+    uint64_t position = 0;
+    ASSERT_EQ(buffer.read_samples(narrowed.data(), narrowed.size(), position), static_cast<int>(narrowed.size()));
+    EXPECT_EQ(narrowed, (std::vector<int16_t>{16383, -16383, 32767, -32767, 32767, 0}));
+
+    const std::vector<int16_t> pcm16 = {16384};
+    buffer.write_samples(pcm16.data(), pcm16.size());
+    float widened = 0;
+    ASSERT_EQ(buffer.read_native(&widened, 1, position), 1);
+    EXPECT_EQ(widened, 0.5f);
+}
+
+TEST(SampleFormatTest, ParsesAttributeNames) {
+    for (const SampleFormat format : {SampleFormat::INT16, SampleFormat::INT32, SampleFormat::FLOAT32}) {
+        EXPECT_EQ(parse_sample_format(sample_format_name(format)), format);
+    }
+    EXPECT_EQ(pa_sample_format(SampleFormat::FLOAT32), paFloat32);
+    EXPECT_THROW(parse_sample_format("int24"), std::invalid_argument);
+}
+
+#ifdef __linux__
+#include <unistd.h>
+
+// Resident set size in bytes, from /proc/self/statm
+static size_t resident_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    statm >> total_pages >> resident_pages;
+    return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+TEST_F(AudioBufferTest, ConstructionDoesNotCommitTheRing) {
+    // A minute of 8-channel 96 kHz audio: a ring of 128 MB
+    audio_info info{viam::sdk::audio_codecs::PCM_16, 96000, 8};
+    const size_t before = resident_bytes();
+    AudioBuffer buffer(info, 60);
+    const size_t after = resident_bytes();
+
+    EXPECT_GE(buffer.memory_bytes(), static_cast<size_t>(96000) * 8 * 60 * sizeof(int16_t));
+    EXPECT_LT(after - std::min(after, before), buffer.memory_bytes() / 100);
+}
+#endif
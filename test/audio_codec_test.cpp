@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
 #include <vector>
 #include <viam/sdk/common/instance.hpp>
 #include "test_utils.hpp"
@@ -92,6 +97,152 @@ TEST_F(WavHeaderTest, ParsesCorrectlyWithAudioPayload) {
     EXPECT_EQ(wav.size(), audio::codec::wav_header_size + num_samples * sizeof(int16_t));
 }
 
+// The vectorized conversions must produce exactly what the scalar loops do. Lengths are odd
+// and not a multiple of the vector width so the scalar tail runs too, and the input starts at
+// an odd offset so the vector loads are unaligned.
+class PcmConversionTest : public ::testing::Test {
+   protected:
+    static constexpr int kNumSamples = 1003;
+
+    std::vector<int16_t> pcm16_samples() {
+        std::vector<int16_t> samples = {0, 1, -1, 32767, -32768, 16384, -16384, 255, -256};
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> dist(-32768, 32767);
+        while (samples.size() < kNumSamples) {
+            samples.push_back(static_cast<int16_t>(dist(rng)));
+        }
+        return samples;
+    }
+
+    // Returns a buffer whose data starts at byte offset 1
+    template <typename T>
+    static std::vector<uint8_t> misaligned_bytes(const std::vector<T>& values) {
+        std::vector<uint8_t> bytes(values.size() * sizeof(T) + 1);
+        std::memcpy(bytes.data() + 1, values.data(), values.size() * sizeof(T));
+        return bytes;
+    }
+};
+
+TEST_F(PcmConversionTest, Pcm16ToPcm32MatchesScalar) {
+    const auto samples = pcm16_samples();
+    std::vector<uint8_t> vector_out, scalar_out;
+    audio::codec::convert_pcm16_to_pcm32(samples.data(), kNumSamples, vector_out);
+    audio::codec::scalar::convert_pcm16_to_pcm32(samples.data(), kNumSamples, scalar_out);
+    EXPECT_EQ(vector_out, scalar_out);
+}
+
+TEST_F(PcmConversionTest, Pcm16ToFloat32MatchesScalar) {
+    const auto samples = pcm16_samples();
+    std::vector<uint8_t> vector_out, scalar_out;
+    audio::codec::convert_pcm16_to_float32(samples.data(), kNumSamples, vector_out);
+    audio::codec::scalar::convert_pcm16_to_float32(samples.data(), kNumSamples, scalar_out);
+    EXPECT_EQ(vector_out, scalar_out);
+}
+
+TEST_F(PcmConversionTest, Pcm32ToPcm16MatchesScalar) {
+    std::vector<int32_t> samples = {0, 1, -1, 65535, 65536, -65536, -65537, std::numeric_limits<int32_t>::max(),
+                                    std::numeric_limits<int32_t>::min()};
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int32_t> dist(std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max());
+    while (samples.size() < kNumSamples) {
+        samples.push_back(dist(rng));
+    }
+    const auto bytes = misaligned_bytes(samples);
+    const int byte_count = kNumSamples * 4;
+
+    std::vector<uint8_t> vector_out, scalar_out;
+    audio::codec::convert_pcm32_to_pcm16(bytes.data() + 1, byte_count, vector_out);
+    audio::codec::scalar::convert_pcm32_to_pcm16(bytes.data() + 1, byte_count, scalar_out);
+    EXPECT_EQ(vector_out, scalar_out);
+}
+
+TEST_F(PcmConversionTest, Float32ToPcm16MatchesScalarIncludingOutOfRange) {
+    std::vector<float> samples = {0.0f,
+                                  -0.0f,
+                                  1.0f,
+                                  -1.0f,
+                                  1.5f,
+                                  -1.5f,
+                                  0.99999f,
+                                  -0.99999f,
+                                  1.0f / 32767.0f,
+                                  -1.0f / 32767.0f,
+                                  std::numeric_limits<float>::infinity(),
+                                  -std::numeric_limits<float>::infinity(),
+                                  std::numeric_limits<float>::quiet_NaN(),
+                                  std::numeric_limits<float>::denorm_min(),
+                                  std::numeric_limits<float>::max(),
+                                  std::numeric_limits<float>::lowest()};
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> dist(-1.25f, 1.25f);
+    while (samples.size() < kNumSamples) {
+        samples.push_back(dist(rng));
+    }
+    const auto bytes = misaligned_bytes(samples);
+    const int byte_count = kNumSamples * 4;
+
+    std::vector<uint8_t> vector_out, scalar_out;
+    audio::codec::convert_float32_to_pcm16(bytes.data() + 1, byte_count, vector_out);
+    audio::codec::scalar::convert_float32_to_pcm16(bytes.data() + 1, byte_count, scalar_out);
+    EXPECT_EQ(vector_out, scalar_out);
+
+    // Spot-check the clamping: +/-inf saturate, NaN maps to full scale like std::min(1.0f, NaN)
+    auto sample_at = [&](size_t i) {
+        int16_t s;
+        std::memcpy(&s, vector_out.data() + i * 2, 2);
+        return s;
+    };
+    EXPECT_EQ(sample_at(4), 32767);
+    EXPECT_EQ(sample_at(5), -32767);
+    EXPECT_EQ(sample_at(10), 32767);
+    EXPECT_EQ(sample_at(11), -32767);
+    EXPECT_EQ(sample_at(12), 32767);
+}
+
+TEST_F(PcmConversionTest, ShortInputsUseScalarTailOnly) {
+    const auto samples = pcm16_samples();
+    for (int n = 1; n < 8; n++) {
+        std::vector<uint8_t> vector_out, scalar_out;
+        audio::codec::convert_pcm16_to_float32(samples.data(), n, vector_out);
+        audio::codec::scalar::convert_pcm16_to_float32(samples.data(), n, scalar_out);
+        EXPECT_EQ(vector_out, scalar_out) << "n=" << n;
+    }
+}
+
+TEST_F(PcmConversionTest, InterleaveStereoMatchesScalar) {
+    const auto left = pcm16_samples();
+    auto right = left;
+    std::reverse(right.begin(), right.end());
+
+    std::vector<int16_t> vector_out(kNumSamples * 2), scalar_out(kNumSamples * 2);
+    audio::codec::interleave_stereo_pcm16(left.data(), right.data(), vector_out.data(), kNumSamples);
+    audio::codec::scalar::interleave_stereo_pcm16(left.data(), right.data(), scalar_out.data(), kNumSamples);
+    EXPECT_EQ(vector_out, scalar_out);
+    EXPECT_EQ(vector_out[0], left[0]);
+    EXPECT_EQ(vector_out[1], right[0]);
+    EXPECT_EQ(vector_out[kNumSamples * 2 - 1], right[kNumSamples - 1]);
+}
+
+TEST_F(PcmConversionTest, DownmixStereoMatchesScalar) {
+    auto stereo = pcm16_samples();
+    // Extremes, and negative odd sums that an arithmetic shift alone would round down
+    stereo[0] = INT16_MIN;
+    stereo[1] = INT16_MIN;
+    stereo[2] = INT16_MAX;
+    stereo[3] = INT16_MAX;
+    stereo[4] = -3;
+    stereo[5] = 0;
+    const size_t frames = stereo.size() / 2;
+
+    std::vector<int16_t> vector_out(frames), scalar_out(frames);
+    audio::codec::downmix_stereo_pcm16(stereo.data(), vector_out.data(), frames);
+    audio::codec::scalar::downmix_stereo_pcm16(stereo.data(), scalar_out.data(), frames);
+    EXPECT_EQ(vector_out, scalar_out);
+    EXPECT_EQ(vector_out[0], INT16_MIN);
+    EXPECT_EQ(vector_out[1], INT16_MAX);
+    EXPECT_EQ(vector_out[2], -1);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     ::testing::AddGlobalTestEnvironment(new test_utils::AudioTestEnvironment);
@@ -109,6 +109,34 @@ TEST_F(InputStreamContextTest, CalculateSampleTimestamp) {
     EXPECT_NEAR(timestamp3.count(), baseline_ns + 500'000'000, 1000);  // ~0.5 seconds
 }
 
+TEST_F(InputStreamContextTest, PadToClockFillsGapWithSilence) {
+    // Nothing to line up with before the first callback
+    context_->stream_start_time = std::chrono::system_clock::now() - std::chrono::seconds(1);
+    context_->pad_to_clock(0);
+    EXPECT_EQ(context_->get_write_position(), 0);
+
+    context_->first_callback_captured.store(true);
+    std::vector<int16_t> audio(100, 5);
+    context_->write_samples(audio.data(), audio.size());
+
+    // Leaves room for the block the caller is about to write
+    context_->pad_to_clock(4410);
+    const uint64_t position = context_->get_write_position();
+    EXPECT_GE(position, 44100u - 4410u);
+    EXPECT_LT(position, 44100u);
+
+    // The audio already written stays put, and the gap after it reads as silence
+    std::vector<int16_t> read(200, -1);
+    uint64_t read_pos = 0;
+    ASSERT_EQ(context_->read_samples(read.data(), 200, read_pos), 200);
+    EXPECT_EQ(std::vector<int16_t>(read.begin(), read.begin() + 100), audio);
+    EXPECT_EQ(std::vector<int16_t>(read.begin() + 100, read.end()), std::vector<int16_t>(100, 0));
+
+    // Already caught up: nothing more is written
+    context_->pad_to_clock(44100);
+    EXPECT_EQ(context_->get_write_position(), position);
+}
+
 
 
 // OutputStreamContext tests
@@ -190,6 +218,34 @@ TEST_F(OutputStreamContextTest, MultipleReadersWithSharedPlaybackPosition) {
     EXPECT_EQ(buffer2[0], 1000);
 }
 
+TEST_F(OutputStreamContextTest, TimeUntilPlayedWithoutTimingIsUnknown) {
+    EXPECT_FALSE(context_->time_until_played(0).has_value());
+
+    // A callback that didn't report output times
+    context_->last_callback_time_ns.store(std::chrono::steady_clock::now().time_since_epoch().count());
+    EXPECT_FALSE(context_->time_until_played(0).has_value());
+}
+
+TEST_F(OutputStreamContextTest, TimeUntilPlayedFromCallbackTiming) {
+    // A buffer starting at sample 9600 (100 ms of stereo at 48 kHz) that reaches the DAC 50 ms
+    // after the callback
+    context_->buffer_start_position.store(9600);
+    context_->output_delay_ns.store(50'000'000);
+    context_->last_callback_time_ns.store(std::chrono::steady_clock::now().time_since_epoch().count());
+
+    const auto start = context_->time_until_played(9600);
+    ASSERT_TRUE(start.has_value());
+    EXPECT_NEAR(start->count(), 50'000'000, 10'000'000);
+
+    // 100 ms further on
+    const auto later = context_->time_until_played(9600 + 9600);
+    ASSERT_TRUE(later.has_value());
+    EXPECT_NEAR(later->count() - start->count(), 100'000'000, 10'000'000);
+
+    // Already heard
+    EXPECT_LT(context_->time_until_played(0)->count(), 0);
+}
+
 TEST_F(OutputStreamContextTest, OutputStreamContextThrowsOnZeroNumChannels) {
     viam::sdk::audio_info info{viam::sdk::audio_codecs::PCM_16, 48000, 0};
 
@@ -103,6 +103,41 @@ TEST_F(AudioUtilsTest, ParseConfigAttributesLatency) {
     EXPECT_EQ(params.latency_ms.value(), 100.0);
 }
 
+TEST_F(AudioUtilsTest, ParseConfigAttributesResampleOptions) {
+    auto attributes = ProtoStruct{};
+    attributes["resample_quality"] = std::string("quick");
+    attributes["resample_low_latency"] = true;
+
+    ResourceConfig config(
+        "rdk:component:audioin", "", "test", attributes, "",
+        Model("viam", "audio", "microphone"), LinkConfig{}, log_level::info
+    );
+
+    auto params = audio::utils::parseConfigAttributes(config);
+
+    EXPECT_EQ(params.resample_options.quality, ResampleQuality::Quick);
+    EXPECT_TRUE(params.resample_options.low_latency);
+}
+
+TEST_F(AudioUtilsTest, ParseConfigAttributesResampleOptionsDefaultToHigh) {
+    ResourceConfig config(
+        "rdk:component:audioin", "", "test", ProtoStruct{}, "",
+        Model("viam", "audio", "microphone"), LinkConfig{}, log_level::info
+    );
+
+    auto params = audio::utils::parseConfigAttributes(config);
+
+    EXPECT_EQ(params.resample_options.quality, ResampleQuality::High);
+    EXPECT_FALSE(params.resample_options.low_latency);
+}
+
+TEST_F(AudioUtilsTest, ValidateResampleAttributesRejectsBadValues) {
+    EXPECT_NO_THROW(audio::utils::validate_resample_attributes(ProtoStruct{{"resample_quality", "very_high"}}));
+    EXPECT_THROW(audio::utils::validate_resample_attributes(ProtoStruct{{"resample_quality", "ultra"}}), std::invalid_argument);
+    EXPECT_THROW(audio::utils::validate_resample_attributes(ProtoStruct{{"resample_quality", 3.0}}), std::invalid_argument);
+    EXPECT_THROW(audio::utils::validate_resample_attributes(ProtoStruct{{"resample_low_latency", "yes"}}), std::invalid_argument);
+}
+
 TEST_F(AudioUtilsTest, ParseConfigAttributesAll) {
     auto attributes = ProtoStruct{};
     attributes["device_name"] = std::string("My Device");
@@ -495,6 +530,26 @@ std::unique_ptr<::testing::NiceMock<test_utils::MockDeviceIdResolver>> make_reso
 
 }  // namespace
 
+TEST_F(AudioUtilsTest, DeviceIndexStillMatches_ChecksOnlyTheCachedIndex) {
+    using ::testing::Return;
+    using ::testing::_;
+
+    auto resolver = make_resolver_mock();
+    EXPECT_CALL(*mock_pa_, getDeviceCount()).WillRepeatedly(Return(2));
+    PaDeviceInfo b = make_device_info("device b");
+    EXPECT_CALL(*mock_pa_, getDeviceInfo(0)).Times(0);
+    EXPECT_CALL(*mock_pa_, getDeviceInfo(1)).WillRepeatedly(Return(&b));
+    EXPECT_CALL(*resolver, resolve(1, _)).WillOnce(Return("usb-mic")).WillOnce(Return("other-card"));
+
+    EXPECT_TRUE(audio::utils::device_index_still_matches("usb-mic", params_at(1, "device b"), mock_pa_.get(), resolver.get()));
+    EXPECT_FALSE(audio::utils::device_index_still_matches("usb-mic", params_at(1, "device b"), mock_pa_.get(), resolver.get()))
+        << "another card took the index";
+    EXPECT_FALSE(audio::utils::device_index_still_matches("usb-mic", params_at(2, "gone"), mock_pa_.get(), resolver.get()))
+        << "index past the end of the device list";
+    EXPECT_TRUE(audio::utils::device_index_still_matches("", params_at(5, "any"), mock_pa_.get(), resolver.get()))
+        << "no device_id means the cached params are used as is";
+}
+
 TEST_F(AudioUtilsTest, ResolveDeviceId_EmptyDeviceIdIsNoOp) {
     auto resolver = make_resolver_mock();
     auto params = params_at(7, "old name");
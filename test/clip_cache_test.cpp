@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "clip_cache.hpp"
+#include "test_utils.hpp"
+
+using audio::clips::Clip;
+using audio::clips::ClipCache;
+using audio::clips::ClipSource;
+
+namespace {
+
+// A 1 kHz mono clip of `samples` samples whose source takes source_bytes
+std::shared_ptr<const Clip> make_clip(size_t samples, size_t source_bytes = 0) {
+    auto source = std::make_shared<ClipSource>();
+    source->data.resize(source_bytes);
+    auto clip = std::make_shared<Clip>();
+    clip->source = source;
+    clip->samples.resize(samples);
+    clip->sample_rate = 1000;
+    clip->num_channels = 1;
+    return clip;
+}
+
+std::vector<std::string> ids(const ClipCache& cache) {
+    std::vector<std::string> result;
+    for (const auto& entry : cache.entries()) {
+        result.push_back(entry.id);
+    }
+    return result;
+}
+
+}  // namespace
+
+TEST(ClipCacheTest, ChargesSamplesAndSource) {
+    const auto clip = make_clip(500, 300);
+    EXPECT_EQ(clip->bytes(), 1300);
+    EXPECT_EQ(clip->duration_ms(), 500);
+
+    ClipCache cache(10000);
+    cache.put("a", clip);
+    EXPECT_EQ(cache.bytes(), 1300);
+    EXPECT_EQ(cache.get("a"), clip);
+    EXPECT_EQ(cache.get("b"), nullptr);
+}
+
+TEST(ClipCacheTest, EvictsLeastRecentlyUsed) {
+    // Room for three 1000-byte clips
+    ClipCache cache(3000);
+    cache.put("a", make_clip(500));
+    cache.put("b", make_clip(500));
+    cache.put("c", make_clip(500));
+    // Playing a makes b the oldest
+    ASSERT_NE(cache.get("a"), nullptr);
+
+    cache.put("d", make_clip(500));
+    EXPECT_EQ(ids(cache), (std::vector<std::string>{"d", "a", "c"}));
+    EXPECT_EQ(cache.get("b"), nullptr);
+    EXPECT_EQ(cache.bytes(), 3000);
+
+    // A big clip pushes out as many as it needs
+    cache.put("e", make_clip(1250));
+    EXPECT_EQ(ids(cache), (std::vector<std::string>{"e"}));
+}
+
+TEST(ClipCacheTest, PutReplacesTheSameId) {
+    ClipCache cache(3000);
+    cache.put("a", make_clip(500));
+    cache.put("a", make_clip(250));
+    EXPECT_EQ(ids(cache), (std::vector<std::string>{"a"}));
+    EXPECT_EQ(cache.bytes(), 500);
+}
+
+TEST(ClipCacheTest, RejectsClipLargerThanTheCache) {
+    ClipCache cache(1000);
+    cache.put("a", make_clip(100));
+    EXPECT_THROW(cache.put("big", make_clip(1000)), std::invalid_argument);
+    // Nothing was evicted for it
+    EXPECT_EQ(ids(cache), (std::vector<std::string>{"a"}));
+}
+
+TEST(ClipCacheTest, ReplaceOnlyUpdatesTheExpectedClip) {
+    ClipCache cache(10000);
+    const auto original = make_clip(500);
+    cache.put("a", original);
+
+    const auto converted = make_clip(1000);
+    EXPECT_TRUE(cache.replace("a", original, converted));
+    EXPECT_EQ(cache.get("a"), converted);
+    EXPECT_EQ(cache.bytes(), 2000);
+
+    // A conversion of the old clip loses to the newer one
+    EXPECT_FALSE(cache.replace("a", original, make_clip(10)));
+    EXPECT_EQ(cache.get("a"), converted);
+    // And doesn't bring back a removed clip
+    EXPECT_TRUE(cache.erase("a"));
+    EXPECT_FALSE(cache.replace("a", converted, make_clip(10)));
+    EXPECT_FALSE(cache.erase("a"));
+    EXPECT_EQ(cache.bytes(), 0);
+}
+
+TEST(ClipCacheTest, HandedOutClipsOutliveEviction) {
+    ClipCache cache(1000);
+    cache.put("a", make_clip(500));
+    const auto playing = cache.get("a");
+    cache.put("b", make_clip(500));
+    EXPECT_EQ(cache.get("a"), nullptr);
+    EXPECT_EQ(playing->samples.size(), 500);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(new test_utils::AudioTestEnvironment);
+    return RUN_ALL_TESTS();
+}
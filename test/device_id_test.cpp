@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+#include "device_id.hpp"
+#include "test_utils.hpp"
+
+using audio::device_id::CardIdMap;
+using audio::device_id::RealDeviceIdResolver;
+using audio::device_id::scan_card_ids;
+
+namespace fs = std::filesystem;
+
+#ifdef __linux__
+
+namespace {
+
+PaDeviceInfo device_named(const char* name) {
+    PaDeviceInfo info{};
+    info.name = name;
+    return info;
+}
+
+}  // namespace
+
+// A fake /dev/snd and /sys/class/sound laid out like udev and the kernel would
+class CardIdScanTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        root_ = fs::temp_directory_path() / ("device_id_test_" + std::to_string(::getpid()));
+        fs::create_directories(root_ / "snd" / "by-id");
+        fs::create_directories(root_ / "snd" / "by-path");
+        fs::create_directories(root_ / "sound");
+    }
+
+    void TearDown() override {
+        fs::remove_all(root_);
+    }
+
+    void link(const std::string& dir, const std::string& name, const std::string& node) {
+        fs::create_symlink("../" + node, root_ / "snd" / dir / name);
+    }
+
+    void card(int num, const std::string& id) {
+        const fs::path dir = root_ / "sound" / ("card" + std::to_string(num));
+        fs::create_directories(dir);
+        std::ofstream(dir / "id") << id << "\n";
+    }
+
+    CardIdMap scan() const {
+        return scan_card_ids((root_ / "snd").string(), (root_ / "sound").string());
+    }
+
+    fs::path root_;
+};
+
+TEST_F(CardIdScanTest, PrefersByIdThenByPathThenKernelId) {
+    link("by-id", "usb-Logitech_Headset-00", "controlC1");
+    link("by-path", "pci-0000:00:14.0-usb-0:1:1.0", "controlC1");
+    link("by-path", "pci-0000:00:1f.3", "pcmC0D0p");
+    card(0, "PCH");
+    card(1, "Headset");
+    card(12, "APE");
+
+    const CardIdMap ids = scan();
+
+    ASSERT_EQ(ids.size(), 3);
+    EXPECT_EQ(ids.at(1), "by-id:usb-Logitech_Headset-00");
+    EXPECT_EQ(ids.at(0), "by-path:pci-0000:00:1f.3");
+    EXPECT_EQ(ids.at(12), "alsa-card:APE");
+}
+
+TEST_F(CardIdScanTest, IgnoresNodesThatArentCards) {
+    link("by-id", "some-timer", "timer");
+    link("by-id", "some-seq", "seq");
+    card(2, "");  // no kernel id either
+
+    EXPECT_TRUE(scan().empty());
+}
+
+TEST_F(CardIdScanTest, MultiDigitCardsDontCollide) {
+    link("by-id", "usb-card1", "controlC1");
+    link("by-id", "usb-card10", "pcmC10D0c");
+
+    const CardIdMap ids = scan();
+
+    EXPECT_EQ(ids.at(1), "by-id:usb-card1");
+    EXPECT_EQ(ids.at(10), "by-id:usb-card10");
+}
+
+TEST_F(CardIdScanTest, MissingDirectoriesYieldEmptyMap) {
+    EXPECT_TRUE(scan_card_ids((root_ / "nope").string(), (root_ / "nope").string()).empty());
+}
+
+TEST(RealDeviceIdResolver, LooksUpCardFromSnapshot) {
+    const RealDeviceIdResolver resolver(CardIdMap{{1, "by-id:usb-Mic-00"}});
+
+    EXPECT_EQ(resolver.resolve(0, device_named("USB Mic: Audio (hw:1,0)")), "by-id:usb-Mic-00");
+    // Every PCM on the card shares the card's id
+    EXPECT_EQ(resolver.resolve(1, device_named("USB Mic: Audio #1 (hw:1,1)")), "by-id:usb-Mic-00");
+    EXPECT_EQ(resolver.resolve(2, device_named("Other (hw:2,0)")), "");
+    EXPECT_EQ(resolver.resolve(3, device_named("default")), "");
+    EXPECT_EQ(resolver.resolve(4, PaDeviceInfo{}), "");
+}
+
+#endif
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(new test_utils::AudioTestEnvironment);
+    return RUN_ALL_TESTS();
+}
@@ -284,6 +284,85 @@ TEST_F(DiscoveryTest, MonoChannelCountNotUpclamped) {
     EXPECT_EQ(*channels, 1);
 }
 
+TEST_F(DiscoveryTest, ResultsAreCachedWithinTtl) {
+    createMockDevices({{"Cached Mic", 1, 0, 48000.0}});
+
+    // One scan serves both calls
+    EXPECT_CALL(*mock_pa_, getDeviceCount()).Times(1).WillRepeatedly(Return(1));
+    EXPECT_CALL(*mock_pa_, getDeviceInfo(0)).WillRepeatedly(Return(&device_infos_[0]));
+    EXPECT_CALL(*mock_resolver_, resolve(0, _)).Times(1).WillRepeatedly(Return(std::string("by-id:mic")));
+
+    AudioDiscovery discovery(deps_, *config_, mock_pa_.get(), mock_resolver_.get());
+    const auto first = discovery.discover_resources(ProtoStruct{});
+    const auto second = discovery.discover_resources(ProtoStruct{});
+
+    ASSERT_EQ(first.size(), 1);
+    ASSERT_EQ(second.size(), 1);
+    EXPECT_EQ(second[0].name(), first[0].name());
+}
+
+TEST_F(DiscoveryTest, RefreshForcesRescan) {
+    createMockDevices({{"Mic", 1, 0, 48000.0}, {"Speaker", 0, 2, 48000.0}});
+
+    // Initial scan, the refresh command, and the refresh extra
+    EXPECT_CALL(*mock_pa_, getDeviceCount()).Times(3).WillOnce(Return(1)).WillRepeatedly(Return(2));
+    EXPECT_CALL(*mock_pa_, getDeviceInfo(0)).WillRepeatedly(Return(&device_infos_[0]));
+    EXPECT_CALL(*mock_pa_, getDeviceInfo(1)).WillRepeatedly(Return(&device_infos_[1]));
+
+    AudioDiscovery discovery(deps_, *config_, mock_pa_.get(), mock_resolver_.get());
+    EXPECT_EQ(discovery.discover_resources(ProtoStruct{}).size(), 1);
+
+    const auto result = discovery.do_command(ProtoStruct{{"refresh", true}});
+    EXPECT_EQ(*result.at("refreshed").get<bool>(), true);
+    EXPECT_EQ(*result.at("devices").get<double>(), 2);
+    // The refreshed result is cached again
+    EXPECT_EQ(discovery.discover_resources(ProtoStruct{}).size(), 2);
+
+    EXPECT_EQ(discovery.discover_resources(ProtoStruct{{"refresh", true}}).size(), 2);
+}
+
+TEST_F(DiscoveryTest, RefreshCommandNeedsTrue) {
+    createMockDevices({{"Mic", 1, 0, 48000.0}});
+
+    // Only the initial scan
+    EXPECT_CALL(*mock_pa_, getDeviceCount()).Times(1).WillRepeatedly(Return(1));
+    EXPECT_CALL(*mock_pa_, getDeviceInfo(0)).WillRepeatedly(Return(&device_infos_[0]));
+
+    AudioDiscovery discovery(deps_, *config_, mock_pa_.get(), mock_resolver_.get());
+    EXPECT_EQ(discovery.discover_resources(ProtoStruct{}).size(), 1);
+
+    const auto result = discovery.do_command(ProtoStruct{{"refresh", false}});
+    EXPECT_EQ(*result.at("refreshed").get<bool>(), false);
+    EXPECT_THROW(discovery.do_command(ProtoStruct{{"refresh", 1.0}}), std::invalid_argument);
+    EXPECT_THROW(discovery.do_command(ProtoStruct{{"refresh", std::string("yes")}}), std::invalid_argument);
+}
+
+TEST_F(DiscoveryTest, ZeroTtlDisablesCache) {
+    createMockDevices({{"Mic", 1, 0, 48000.0}});
+
+    EXPECT_CALL(*mock_pa_, getDeviceCount()).Times(2).WillRepeatedly(Return(1));
+    EXPECT_CALL(*mock_pa_, getDeviceInfo(0)).WillRepeatedly(Return(&device_infos_[0]));
+
+    const ResourceConfig config(
+        "rdk:service:discovery", "", "test_discovery", ProtoStruct{{"cache_ttl_seconds", 0.0}}, "",
+        AudioDiscovery::model, LinkConfig{}, log_level::info
+    );
+    AudioDiscovery discovery(deps_, config, mock_pa_.get(), mock_resolver_.get());
+    discovery.discover_resources(ProtoStruct{});
+    discovery.discover_resources(ProtoStruct{});
+}
+
+TEST_F(DiscoveryTest, ValidateRejectsBadCacheTtl) {
+    for (const auto& ttl : {ProtoValue(-1.0), ProtoValue(1.5), ProtoValue(std::string("30"))}) {
+        const ResourceConfig config(
+            "rdk:service:discovery", "", "test_discovery", ProtoStruct{{"cache_ttl_seconds", ttl}}, "",
+            AudioDiscovery::model, LinkConfig{}, log_level::info
+        );
+        EXPECT_THROW(AudioDiscovery::validate(config), std::invalid_argument);
+    }
+    EXPECT_NO_THROW(AudioDiscovery::validate(*config_));
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     ::testing::AddGlobalTestEnvironment(new test_utils::AudioTestEnvironment);
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <viam/sdk/common/instance.hpp>
+#include "disk_history.hpp"
+#include "test_utils.hpp"
+
+using namespace audio;
+using namespace viam::sdk;
+
+class DiskHistoryTest : public ::testing::Test {
+protected:
+    static constexpr int sample_rate = 1000;
+
+    void SetUp() override {
+        audio_info info{viam::sdk::audio_codecs::PCM_16, sample_rate, 1};
+        context_ = std::make_shared<InputStreamContext>(info, 2);
+        path_ = (std::filesystem::temp_directory_path() /
+                 (std::string("disk_history_") + ::testing::UnitTest::GetInstance()->current_test_info()->name()))
+                    .string();
+    }
+
+    // Writes count consecutive sample values starting at first
+    void write_ramp(int first, int count) {
+        std::vector<int16_t> samples(count);
+        for (int i = 0; i < count; i++) {
+            samples[i] = static_cast<int16_t>(first + i);
+        }
+        context_->write_samples(samples.data(), samples.size());
+    }
+
+    static bool wait_for_end(const DiskHistory& history, uint64_t position) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (history.end_position() < position) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    std::shared_ptr<InputStreamContext> context_;
+    std::string path_;
+};
+
+TEST_F(DiskHistoryTest, SpillsWholeSegments) {
+    DiskHistory history(context_, path_, 10);
+    EXPECT_TRUE(std::filesystem::exists(path_));
+    EXPECT_EQ(history.capacity, 10 * sample_rate);
+
+    // 500 ms segments at 1 kHz mono: 1200 samples spill two, and the rest waits in the ring
+    write_ramp(0, 1200);
+    ASSERT_TRUE(wait_for_end(history, 1000));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(history.end_position(), 1000);
+    EXPECT_EQ(history.oldest_position(), 0);
+
+    std::vector<int16_t> buffer(1000);
+    uint64_t position = 0;
+    ASSERT_EQ(history.read_samples(buffer.data(), buffer.size(), position), 1000);
+    EXPECT_EQ(position, 1000);
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_EQ(buffer[i], i);
+    }
+
+    // Nothing beyond what was spilled
+    EXPECT_EQ(history.read_samples(buffer.data(), buffer.size(), position), 0);
+}
+
+TEST_F(DiskHistoryTest, OutlastsTheRing) {
+    DiskHistory history(context_, path_, 10);
+
+    // Six seconds through a two-second ring, keeping pace with the drain
+    for (int second = 0; second < 6; second++) {
+        write_ramp(second * sample_rate, sample_rate);
+        ASSERT_TRUE(wait_for_end(history, (second + 1) * sample_rate));
+    }
+
+    // The oldest second is gone from RAM but still on disk
+    EXPECT_GT(context_->get_write_position(), static_cast<uint64_t>(context_->buffer_capacity));
+    EXPECT_TRUE(history.contains(0, sample_rate));
+    std::vector<int16_t> buffer(sample_rate);
+    uint64_t position = 0;
+    ASSERT_EQ(history.read_samples(buffer.data(), buffer.size(), position), sample_rate);
+    EXPECT_EQ(buffer.front(), 0);
+    EXPECT_EQ(buffer.back(), sample_rate - 1);
+}
+
+TEST_F(DiskHistoryTest, FileRingLapsItself) {
+    DiskHistory history(context_, path_, 1);
+
+    for (int second = 0; second < 3; second++) {
+        write_ramp(second * sample_rate, sample_rate);
+        ASSERT_TRUE(wait_for_end(history, (second + 1) * sample_rate));
+    }
+
+    // One second on disk: only the last one is left, and older reads skip forward to it
+    EXPECT_EQ(history.oldest_position(), 2 * sample_rate);
+    EXPECT_FALSE(history.contains(0, 1));
+    std::vector<int16_t> buffer(10);
+    uint64_t position = 0;
+    ASSERT_EQ(history.read_samples(buffer.data(), buffer.size(), position), 10);
+    EXPECT_EQ(position, 2 * sample_rate + 10);
+    EXPECT_EQ(buffer[0], 2 * sample_rate);
+}
+
+TEST_F(DiskHistoryTest, RemovesFileOnDestruction) {
+    {
+        DiskHistory history(context_, path_, 1);
+    }
+    EXPECT_FALSE(std::filesystem::exists(path_));
+}
+
+TEST_F(DiskHistoryTest, ThrowsWhenFileCannotBeCreated) {
+    EXPECT_THROW(DiskHistory(context_, "/nonexistent-dir/history", 1), std::runtime_error);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(new test_utils::AudioTestEnvironment);
+    return RUN_ALL_TESTS();
+}
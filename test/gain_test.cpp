@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include "gain.hpp"
+
+using audio::gain::GainStage;
+using audio::gain::UNITY_Q16;
+
+class GainTest : public ::testing::Test {
+protected:
+    static constexpr int sample_rate = 48000;
+    // Frames a full-scale ramp takes
+    static constexpr size_t ramp_frames = sample_rate * audio::gain::RAMP_MS / 1000;
+};
+
+TEST_F(GainTest, VolumeCurve) {
+    EXPECT_EQ(audio::gain::volume_to_gain_q16(0), 0);
+    EXPECT_EQ(audio::gain::volume_to_gain_q16(100), UNITY_Q16);
+    EXPECT_EQ(audio::gain::volume_to_gain_q16(50), UNITY_Q16 / 8);
+    EXPECT_EQ(audio::gain::volume_to_gain_q16(150), UNITY_Q16);
+    EXPECT_EQ(audio::gain::volume_to_gain_q16(-5), 0);
+}
+
+TEST_F(GainTest, UnityLeavesSamplesUntouched) {
+    GainStage stage;
+    std::vector<int16_t> samples = {-32768, -1, 0, 1, 32767};
+    const auto original = samples;
+
+    stage.apply(samples.data(), samples.size(), 1, sample_rate);
+
+    EXPECT_EQ(samples, original);
+}
+
+TEST_F(GainTest, SteadyGainScalesEverySample) {
+    GainStage stage;
+    stage.reset(UNITY_Q16 / 2);
+    std::vector<int16_t> samples(960, 1000);
+
+    stage.apply(samples.data(), samples.size() / 2, 2, sample_rate);
+
+    for (int16_t sample : samples) {
+        EXPECT_EQ(sample, 500);
+    }
+}
+
+TEST_F(GainTest, RampsToNewTarget) {
+    GainStage stage;
+    stage.set_target(0);
+    std::vector<int16_t> samples(ramp_frames * 2, 10000);
+
+    stage.apply(samples.data(), samples.size(), 1, sample_rate);
+
+    // Falls steadily instead of jumping, and is silent once the ramp is done
+    EXPECT_GT(samples.front(), 9900);
+    for (size_t i = 1; i < ramp_frames; i++) {
+        EXPECT_LT(samples[i], samples[i - 1]) << "at frame " << i;
+    }
+    for (size_t i = ramp_frames; i < samples.size(); i++) {
+        EXPECT_EQ(samples[i], 0) << "at frame " << i;
+    }
+}
+
+TEST_F(GainTest, RampContinuesAcrossBuffers) {
+    GainStage stage;
+    stage.set_target(0);
+    const size_t frames = ramp_frames / 4;
+    std::vector<int16_t> first(frames * 2, 10000);
+    std::vector<int16_t> second(frames * 2, 10000);
+
+    stage.apply(first.data(), frames, 2, sample_rate);
+    stage.apply(second.data(), frames, 2, sample_rate);
+
+    // Stereo frames share one gain, and the second buffer picks up where the first stopped
+    EXPECT_EQ(first[first.size() - 2], first.back());
+    EXPECT_LT(second.front(), first.back());
+    EXPECT_GT(second.back(), 0);
+}
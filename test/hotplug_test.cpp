@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "hotplug.hpp"
+#include "test_utils.hpp"
+
+using audio::hotplug::is_sound_device_uevent;
+
+namespace {
+
+// Kernel uevents are NUL-separated, starting with "ACTION@devpath"
+bool check(const std::string& message) {
+    return is_sound_device_uevent(message.data(), message.size());
+}
+
+}  // namespace
+
+TEST(HotplugTest, SoundCardAddedAndRemoved) {
+    const std::string devpath = "/devices/pci0000:00/0000:00:14.0/usb1/1-2/1-2:1.0/sound/card2";
+    EXPECT_TRUE(check(std::string("add@") + devpath + '\0' + "ACTION=add" + '\0' + "DEVPATH=" + devpath + '\0' +
+                      "SUBSYSTEM=sound" + '\0' + "SEQNUM=4711"));
+    EXPECT_TRUE(check(std::string("remove@") + devpath + "/pcmC2D0c" + '\0' + "ACTION=remove" + '\0' + "SUBSYSTEM=sound" +
+                      '\0' + "DEVNAME=snd/pcmC2D0c"));
+}
+
+TEST(HotplugTest, IgnoresOtherSubsystemsAndActions) {
+    EXPECT_FALSE(check(std::string("add@/devices/usb1/1-2") + '\0' + "ACTION=add" + '\0' + "SUBSYSTEM=usb"));
+    // Jack and mixer changes aren't devices coming or going
+    EXPECT_FALSE(check(std::string("change@/devices/sound/card0") + '\0' + "ACTION=change" + '\0' + "SUBSYSTEM=sound"));
+    // A value that merely contains the key doesn't count
+    EXPECT_FALSE(check(std::string("add@/devices/x") + '\0' + "DRIVER=SUBSYSTEM=sound2"));
+}
+
+TEST(HotplugTest, ToleratesMalformedMessages) {
+    EXPECT_FALSE(check(""));
+    EXPECT_FALSE(check("add@"));
+    EXPECT_FALSE(check(std::string("add@/devices/sound/card0") + '\0'));
+    // Truncated mid-field
+    EXPECT_FALSE(check(std::string("add@/devices/sound/card0") + '\0' + "SUBSYS"));
+}
+
+TEST(HotplugTest, MonitorStartsAndStops) {
+    // Whether the OS grants the listener depends on the sandbox; either way it must shut
+    // down cleanly
+    audio::hotplug::HotplugMonitor monitor([]() {});
+    (void)monitor.active();
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(new test_utils::AudioTestEnvironment);
+    return RUN_ALL_TESTS();
+}
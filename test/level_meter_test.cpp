@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "level_meter.hpp"
+#include "test_utils.hpp"
+
+using audio::levels::FLOOR_DB;
+using audio::levels::LevelMeter;
+
+namespace {
+
+constexpr int sample_rate = 48000;
+// Frames in one meter slot
+constexpr size_t slot_frames = sample_rate * audio::levels::SLOT_MS / 1000;
+
+}  // namespace
+
+TEST(LevelMeterTest, EmptyBeforeTheFirstSlot) {
+    LevelMeter meter(2, sample_rate);
+    std::vector<int16_t> partial((slot_frames - 1) * 2, 1000);
+    meter.add(partial.data(), slot_frames - 1);
+
+    const auto levels = meter.window(100);
+    EXPECT_EQ(levels.window_ms, 0);
+    ASSERT_EQ(levels.channels.size(), 2);
+    EXPECT_EQ(levels.channels[0].peak_dbfs, FLOOR_DB);
+    EXPECT_EQ(levels.channels[0].rms_dbfs, FLOOR_DB);
+}
+
+TEST(LevelMeterTest, MetersEachChannelSeparately) {
+    LevelMeter meter(2, sample_rate);
+    // Left: a full-scale square wave. Right: a constant half scale.
+    std::vector<int16_t> block(slot_frames * 2 * 5);
+    for (size_t frame = 0; frame < slot_frames * 5; frame++) {
+        block[frame * 2] = frame % 2 ? 32767 : -32767;
+        block[frame * 2 + 1] = 16384;
+    }
+    meter.add(block.data(), slot_frames * 5);
+
+    const auto levels = meter.window(50);
+    EXPECT_EQ(levels.window_ms, 50);
+    ASSERT_EQ(levels.channels.size(), 2);
+    EXPECT_NEAR(levels.channels[0].peak_dbfs, 0, 0.01);
+    EXPECT_NEAR(levels.channels[0].rms_dbfs, 0, 0.01);
+    EXPECT_NEAR(levels.channels[1].peak_dbfs, -6.02, 0.01);
+    EXPECT_NEAR(levels.channels[1].rms_dbfs, -6.02, 0.01);
+}
+
+TEST(LevelMeterTest, ShortWindowsFollowTheNewestAudio) {
+    LevelMeter meter(1, sample_rate);
+    const std::vector<float> loud(slot_frames * 90, 0.5f);
+    const std::vector<float> quiet(slot_frames * 10, 0.0f);
+    meter.add(loud.data(), loud.size());
+    meter.add(quiet.data(), quiet.size());
+
+    // The newest 100 ms is silent; the last second is mostly loud
+    const auto recent = meter.window(100);
+    EXPECT_EQ(recent.channels[0].peak_dbfs, FLOOR_DB);
+    const auto second = meter.window(1000);
+    EXPECT_EQ(second.window_ms, 1000);
+    EXPECT_NEAR(second.channels[0].peak_dbfs, -6.02, 0.01);
+    EXPECT_NEAR(second.channels[0].rms_dbfs, 20 * std::log10(0.5 * std::sqrt(0.9)), 0.01);
+
+    // A window longer than the audio so far only covers what there is
+    EXPECT_EQ(meter.window(5000).window_ms, 1000);
+}
+
+TEST(LevelMeterTest, SlotsSpanCallbackBoundaries) {
+    LevelMeter whole(1, sample_rate);
+    LevelMeter split(1, sample_rate);
+    std::vector<int32_t> samples(slot_frames * 7);
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] = static_cast<int32_t>((i * 7919) % 2000000) - 1000000;
+    }
+    whole.add(samples.data(), samples.size());
+    // Callback sizes that don't divide a slot
+    for (size_t offset = 0; offset < samples.size();) {
+        const size_t frames = std::min<size_t>(173, samples.size() - offset);
+        split.add(static_cast<const void*>(samples.data() + offset), frames, audio::SampleFormat::INT32);
+        offset += frames;
+    }
+    const auto a = whole.window(70);
+    const auto b = split.window(70);
+    EXPECT_EQ(a.window_ms, 70);
+    EXPECT_EQ(b.window_ms, 70);
+    EXPECT_NEAR(a.channels[0].rms_dbfs, b.channels[0].rms_dbfs, 1e-6);
+    EXPECT_EQ(a.channels[0].peak_dbfs, b.channels[0].peak_dbfs);
+}
+
+TEST(LevelMeterTest, HistoryWrapsAround) {
+    LevelMeter meter(1, sample_rate);
+    const std::vector<int16_t> quiet(slot_frames, 100);
+    for (size_t i = 0; i < audio::levels::HISTORY_SLOTS * 2 + 3; i++) {
+        meter.add(quiet.data(), quiet.size());
+    }
+    const auto levels = meter.window(audio::levels::MAX_WINDOW_MS);
+    EXPECT_EQ(levels.window_ms, audio::levels::MAX_WINDOW_MS);
+    EXPECT_NEAR(levels.channels[0].rms_dbfs, 20 * std::log10(100.0 / 32768), 0.01);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(new test_utils::AudioTestEnvironment);
+    return RUN_ALL_TESTS();
+}
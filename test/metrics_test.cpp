@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include <viam/sdk/common/instance.hpp>
+#include "metrics.hpp"
+#include "test_utils.hpp"
+
+using namespace audio::metrics;
+using viam::sdk::ProtoList;
+using viam::sdk::ProtoStruct;
+using viam::sdk::ProtoValue;
+
+namespace {
+
+double field(const ProtoStruct& snapshot, const std::string& key) {
+    return *snapshot.at(key).get<double>();
+}
+
+}  // namespace
+
+TEST(HistogramTest, PowerOfTwoBuckets) {
+    EXPECT_EQ(Histogram::bucket_for(0), 0);
+    EXPECT_EQ(Histogram::bucket_for(1), 1);
+    EXPECT_EQ(Histogram::bucket_for(2), 2);
+    EXPECT_EQ(Histogram::bucket_for(3), 2);
+    EXPECT_EQ(Histogram::bucket_for(1024), 11);
+    EXPECT_EQ(Histogram::bucket_for(UINT64_MAX), Histogram::BUCKETS - 1);
+    EXPECT_EQ(Histogram::bucket_floor(0), 0);
+    EXPECT_EQ(Histogram::bucket_floor(11), 1024);
+}
+
+TEST(HistogramTest, SnapshotSummarizesValues) {
+    Histogram histogram;
+    for (uint64_t value : {1, 3, 3, 100}) {
+        histogram.record(value);
+    }
+
+    const auto snapshot = histogram.to_struct(false);
+    EXPECT_EQ(field(snapshot, "count"), 4);
+    EXPECT_DOUBLE_EQ(field(snapshot, "mean"), 107.0 / 4);
+    EXPECT_EQ(field(snapshot, "max"), 100);
+
+    // Only the non-empty buckets: [1, 2), [2, 4) and [64, 128)
+    const auto& buckets = *snapshot.at("buckets").get<ProtoList>();
+    ASSERT_EQ(buckets.size(), 3);
+    const auto& middle = *buckets[1].get<ProtoStruct>();
+    EXPECT_EQ(field(middle, "min"), 2);
+    EXPECT_EQ(field(middle, "count"), 2);
+    EXPECT_EQ(field(*buckets[2].get<ProtoStruct>(), "min"), 64);
+}
+
+TEST(HistogramTest, ResetZeroesAfterReading) {
+    Histogram histogram;
+    histogram.record(5);
+
+    EXPECT_EQ(field(histogram.to_struct(true), "count"), 1);
+    const auto after = histogram.to_struct(false);
+    EXPECT_EQ(field(after, "count"), 0);
+    EXPECT_EQ(field(after, "max"), 0);
+    EXPECT_TRUE(after.at("buckets").get<ProtoList>()->empty());
+}
+
+TEST(StreamMetricsTest, RecordCallbackMeasuresJitterAgainstThePeriod) {
+    StreamMetrics metrics;
+    // 480 frames at 48 kHz is a 10 ms period
+    metrics.record_callback(0, 1'000'000, 1'050'000, 480, 48000);
+    EXPECT_EQ(metrics.callback_duration_us.count(), 1);
+    EXPECT_EQ(metrics.callback_interval_us.count(), 0) << "the first callback has no interval";
+
+    metrics.record_callback(1'000'000, 13'000'000, 13'020'000, 480, 48000);
+    const auto interval = metrics.callback_interval_us.to_struct(false);
+    EXPECT_EQ(field(interval, "max"), 12000);
+    EXPECT_EQ(field(metrics.callback_jitter_us.to_struct(false), "max"), 2000);
+    EXPECT_EQ(field(metrics.callback_duration_us.to_struct(false), "max"), 50);
+}
+
+TEST(StreamMetricsTest, CountersReset) {
+    StreamMetrics metrics;
+    metrics.chunks.add(3);
+    metrics.restarts.add();
+
+    const auto snapshot = metrics.to_struct(true);
+    EXPECT_EQ(field(snapshot, "chunks"), 3);
+    EXPECT_EQ(field(snapshot, "restarts"), 1);
+    EXPECT_EQ(metrics.chunks.value(), 0);
+    EXPECT_EQ(metrics.restarts.value(), 0);
+}
+
+TEST(CallbackTimingTest, PercentilesAgainstThePeriod) {
+    CallbackTiming timing;
+    // 98 quick callbacks and two slow ones, with 480 frames at 48 kHz (a 10 ms period)
+    for (int i = 0; i < 98; i++) {
+        timing.record(1'234'000, 480, 48000);
+    }
+    timing.record(8'000'000, 480, 48000);
+    timing.record(12'000'000, 480, 48000);
+
+    const auto report = timing.to_struct(false);
+    EXPECT_EQ(field(report, "count"), 100);
+    EXPECT_EQ(field(report, "p50_us"), 1240);
+    EXPECT_EQ(field(report, "p99_us"), 8010);
+    EXPECT_EQ(field(report, "max_us"), 12000);
+    EXPECT_EQ(field(report, "period_us"), 10000);
+    EXPECT_DOUBLE_EQ(field(report, "p99_of_period"), 0.801);
+    EXPECT_EQ(field(report, "overruns"), 1);
+
+    timing.to_struct(true);
+    const auto after = timing.to_struct(false);
+    EXPECT_EQ(field(after, "count"), 0);
+    EXPECT_EQ(field(after, "p99_us"), 0);
+}
+
+TEST(CallbackTimingTest, LongCallbacksReportTheMax) {
+    CallbackTiming timing;
+    timing.record(250'000'000, 480, 48000);
+    EXPECT_EQ(field(timing.to_struct(false), "p50_us"), 250000);
+}
+
+TEST(StreamMetricsTest, ParseStatsReset) {
+    EXPECT_FALSE(parse_stats_reset(ProtoValue(true)));
+    EXPECT_FALSE(parse_stats_reset(ProtoValue(ProtoStruct{})));
+    EXPECT_TRUE(parse_stats_reset(ProtoValue(ProtoStruct{{"reset", true}})));
+    EXPECT_THROW(parse_stats_reset(ProtoValue(1.0)), std::invalid_argument);
+    EXPECT_THROW(parse_stats_reset(ProtoValue(ProtoStruct{{"reset", std::string("yes")}})), std::invalid_argument);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(new test_utils::AudioTestEnvironment);
+    return RUN_ALL_TESTS();
+}
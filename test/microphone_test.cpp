@@ -1,9 +1,13 @@
 #include <gtest/gtest.h>
+#include <filesystem>
 #include <viam/sdk/config/resource.hpp>
 #include <portaudio.h>
 #include <viam/sdk/common/audio.hpp>
 #include "microphone.hpp"
 #include "test_utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <map>
 #include <thread>
 
 using namespace viam::sdk;
@@ -238,6 +242,257 @@ TEST_F(MicrophoneTest, DoCommandReturnsEmptyStruct) {
 }
 
 
+TEST_F(MicrophoneTest, ValidateWithInvalidConfig_ResampleQualityUnknown) {
+  auto attributes = ProtoStruct{};
+  attributes["device_name"] = test_mic_name_;
+  attributes["resample_quality"] = std::string("ultra");
+
+  ResourceConfig invalid_config(
+      "rdk:component:microphone", "", test_name_, attributes, "",
+      Model("viam", "audio", "mic"), LinkConfig{}, log_level::info);
+
+  EXPECT_THROW(
+      { microphone::Microphone::validate(invalid_config); },
+      std::invalid_argument);
+}
+
+TEST_F(MicrophoneTest, DoCommandReportsResampleSettings) {
+    auto attributes = ProtoStruct{};
+    attributes["device_name"] = testDeviceName;
+    attributes["resample_quality"] = std::string("low");
+    attributes["resample_low_latency"] = true;
+    ResourceConfig config(
+        "rdk:component:audioin", "", test_name_, attributes, "",
+        microphone::Microphone::model, LinkConfig{}, log_level::info);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+
+    auto result = mic.do_command(ProtoStruct{{"get_resample_settings", true}});
+
+    ASSERT_TRUE(result.count("resample_quality"));
+    EXPECT_EQ(*result.at("resample_quality").get<std::string>(), "low");
+    EXPECT_EQ(*result.at("resample_low_latency").get<bool>(), true);
+    EXPECT_EQ(*result.at("soxr_recipe").get<std::string>(), "SOXR_LQ | SOXR_MINIMUM_PHASE");
+}
+
+TEST_F(MicrophoneTest, ValidateWithInvalidConfig_Mp3BitrateOutOfRange) {
+  auto attributes = ProtoStruct{};
+  attributes["device_name"] = test_mic_name_;
+  attributes["mp3_bitrate"] = 1000.0;
+
+  ResourceConfig invalid_config(
+      "rdk:component:microphone", "", test_name_, attributes, "",
+      Model("viam", "audio", "mic"), LinkConfig{}, log_level::info);
+
+  EXPECT_THROW(
+      { microphone::Microphone::validate(invalid_config); },
+      std::invalid_argument);
+}
+
+TEST_F(MicrophoneTest, DoCommandReportsMp3Settings) {
+    auto attributes = ProtoStruct{};
+    attributes["device_name"] = testDeviceName;
+    attributes["mp3_bitrate"] = 128.0;
+    attributes["mp3_bitrate_mode"] = std::string("abr");
+    ResourceConfig config(
+        "rdk:component:audioin", "", test_name_, attributes, "",
+        microphone::Microphone::model, LinkConfig{}, log_level::info);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+
+    auto result = mic.do_command(ProtoStruct{{"get_mp3_settings", true}});
+
+    EXPECT_EQ(*result.at("mp3_bitrate").get<double>(), 128.0);
+    EXPECT_EQ(*result.at("mp3_bitrate_mode").get<std::string>(), "abr");
+    EXPECT_EQ(*result.at("mp3_quality").get<double>(), static_cast<double>(microphone::MP3_QUALITY));
+}
+
+TEST_F(MicrophoneTest, BufferSecondsSetsHistoryWindow) {
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = 48000.0;
+    attributes["num_channels"] = 2.0;
+    attributes["buffer_seconds"] = 10.0;
+    ResourceConfig config(
+        "rdk:component:audioin", "", test_name_, attributes, "",
+        microphone::Microphone::model, LinkConfig{}, log_level::info);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+
+    EXPECT_EQ(mic.audio_context_->buffer_capacity, 48000 * 2 * 10);
+    auto result = mic.do_command(ProtoStruct{{"get_buffer_settings", true}});
+    EXPECT_EQ(*result.at("buffer_seconds").get<double>(), 10.0);
+    EXPECT_EQ(*result.at("buffer_bytes").get<double>(), mic.audio_context_->memory_bytes());
+
+    // A stream restart keeps the configured window
+    mic.restart_stalled_stream(mic.audio_context_);
+    EXPECT_EQ(mic.audio_context_->buffer_duration_seconds, 10);
+}
+
+TEST_F(MicrophoneTest, DefaultBufferHoldsThirtySeconds) {
+    microphone::Microphone mic(test_deps_, *test_config_, mock_pa_.get());
+    auto result = mic.do_command(ProtoStruct{{"get_buffer_settings", true}});
+    EXPECT_EQ(*result.at("buffer_seconds").get<double>(), audio::BUFFER_DURATION_SECONDS);
+}
+
+TEST_F(MicrophoneTest, GetStatsCountsChunksPerClient) {
+    auto config = createConfig(testDeviceName, 48000, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    mic.audio_context_ = createTestContext(mic, 0);
+
+    const int num_chunks = 3;
+    int chunks_received = 0;
+    ProtoStruct during;
+    auto handler = [&](viam::sdk::AudioIn::audio_chunk&&) {
+        if (++chunks_received == 2) {
+            during = mic.do_command(ProtoStruct{{"get_stats", true}});
+        }
+        return chunks_received < num_chunks;
+    };
+
+    std::thread reader([&]() { mic.get_audio(viam::sdk::audio_codecs::PCM_16, handler, 5.0, 0, ProtoStruct{}); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::vector<int16_t> block(4800 * num_chunks, 1);
+    mic.audio_context_->write_samples(block.data(), block.size());
+    reader.join();
+
+    // The running call is listed with what it has been sent so far
+    const auto& clients = *during.at("clients").get<ProtoList>();
+    ASSERT_EQ(clients.size(), 1);
+    const auto& client = *clients[0].get<ProtoStruct>();
+    EXPECT_EQ(*client.at("codec").get<std::string>(), viam::sdk::audio_codecs::PCM_16);
+    EXPECT_FALSE(*client.at("historical").get<bool>());
+    EXPECT_EQ(*client.at("chunks").get<double>(), 2);
+    EXPECT_EQ(*client.at("bytes").get<double>(), 2 * 4800 * sizeof(int16_t));
+
+    const auto stats = mic.do_command(ProtoStruct{{"get_stats", ProtoStruct{{"reset", true}}}});
+    EXPECT_EQ(*stats.at("chunks").get<double>(), num_chunks);
+    EXPECT_EQ(*stats.at("queued_ms").get<ProtoStruct>()->at("count").get<double>(), num_chunks);
+    EXPECT_TRUE(stats.at("clients").get<ProtoList>()->empty());
+    EXPECT_EQ(*mic.get_status().at("chunks").get<double>(), 0);
+}
+
+TEST_F(MicrophoneTest, GetStatsSurvivesRestart) {
+    microphone::Microphone mic(test_deps_, *test_config_, mock_pa_.get());
+    mic.audio_context_->stats->chunks.add(7);
+
+    mic.restart_stalled_stream(mic.audio_context_);
+    EXPECT_EQ(mic.audio_context_->stats, mic.stats_);
+    const auto stats = mic.get_status();
+    EXPECT_EQ(*stats.at("restarts").get<double>(), 1);
+    EXPECT_EQ(*stats.at("chunks").get<double>(), 7);
+    EXPECT_THROW(mic.do_command(ProtoStruct{{"get_stats", ProtoStruct{{"reset", 1.0}}}}), std::invalid_argument);
+}
+
+TEST_F(MicrophoneTest, CallbackTimingSurvivesRestart) {
+    auto attributes = ProtoStruct{};
+    attributes["callback_timing"] = true;
+    ResourceConfig config(
+        "rdk:component:audioin", "", test_name_, attributes, "",
+        microphone::Microphone::model, LinkConfig{}, log_level::info);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    ASSERT_TRUE(mic.audio_context_->callback_timing);
+
+    mic.restart_stalled_stream(mic.audio_context_);
+    ASSERT_TRUE(mic.audio_context_->callback_timing);
+    EXPECT_EQ(*mic.get_status().at("callback_timing").get<ProtoStruct>()->at("count").get<double>(), 0);
+
+    attributes["callback_timing"] = std::string("on");
+    ResourceConfig invalid(
+        "rdk:component:audioin", "", test_name_, attributes, "",
+        microphone::Microphone::model, LinkConfig{}, log_level::info);
+    EXPECT_THROW(microphone::Microphone::validate(invalid), std::invalid_argument);
+}
+
+TEST_F(MicrophoneTest, DoCommandReportsLevels) {
+    auto config = createConfig(testDeviceName, 48000, 2);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic, 0);
+    std::vector<int16_t> frames(4800 * 2, 3277);
+    ctx->levels.add(frames.data(), 4800);
+
+    const auto defaults = mic.do_command(ProtoStruct{{"get_levels", true}});
+    EXPECT_EQ(*defaults.at("num_channels").get<double>(), 2);
+    const auto* windows = defaults.at("windows").get<ProtoList>();
+    ASSERT_NE(windows, nullptr);
+    ASSERT_EQ(windows->size(), microphone::DEFAULT_LEVEL_WINDOWS_MS.size());
+    const auto& shortest = *(*windows)[0].get<ProtoStruct>();
+    EXPECT_EQ(*shortest.at("window_ms").get<double>(), 100);
+    const auto& rms = *shortest.at("rms_dbfs").get<ProtoList>();
+    ASSERT_EQ(rms.size(), 2);
+    EXPECT_NEAR(*rms[1].get<double>(), -20, 0.01);
+    // Only 100 ms has been captured, so the longer windows are cut short
+    EXPECT_EQ(*(*windows)[2].get<ProtoStruct>()->at("window_ms").get<double>(), 100);
+
+    const auto custom = mic.do_command(ProtoStruct{{"get_levels", ProtoStruct{{"window_ms", ProtoList{20.0}}}}});
+    const auto& custom_windows = *custom.at("windows").get<ProtoList>();
+    ASSERT_EQ(custom_windows.size(), 1);
+    EXPECT_EQ(*custom_windows[0].get<ProtoStruct>()->at("window_ms").get<double>(), 20);
+
+    EXPECT_THROW(mic.do_command(ProtoStruct{{"get_levels", ProtoStruct{{"window_ms", ProtoList{5.0}}}}}), std::invalid_argument);
+    EXPECT_THROW(mic.do_command(ProtoStruct{{"get_levels", 100.0}}), std::invalid_argument);
+}
+
+TEST_F(MicrophoneTest, SharedMemoryExportsTheRing) {
+    auto attrs = ProtoStruct{{"device_name", testDeviceName}, {"sample_rate", 48000.0}, {"num_channels", 1.0}, {"shared_memory", true}};
+    ResourceConfig config(
+        "rdk:component:audioin", "", "test_microphone", attrs, "", microphone::Microphone::model, LinkConfig{}, log_level::info);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+
+    const auto reply = mic.do_command(ProtoStruct{{"get_shared_memory", true}});
+    EXPECT_TRUE(*reply.at("enabled").get<bool>());
+    EXPECT_EQ(*reply.at("name").get<std::string>(), "/viam-audio-test_microphone");
+    EXPECT_EQ(*reply.at("sample_rate").get<double>(), 48000);
+    EXPECT_EQ(*reply.at("num_channels").get<double>(), 1);
+    EXPECT_EQ(*reply.at("sample_format").get<std::string>(), "int16");
+    EXPECT_EQ(*reply.at("header_bytes").get<double>(), audio::shm::RING_HEADER_BYTES);
+
+    std::shared_ptr<audio::InputStreamContext> ctx;
+    {
+        std::lock_guard<std::mutex> lock(mic.stream_ctx_mu_);
+        ctx = mic.audio_context_;
+    }
+    ASSERT_NE(ctx->shared_ring, nullptr);
+    const auto& header = ctx->shared_ring->header();
+    EXPECT_EQ(*reply.at("ring_samples").get<double>(), header.ring_samples);
+    EXPECT_EQ(header.cursor.stream_start_ns.load(), 0);
+
+    // The first callback publishes the stream clock along with the samples
+    const std::vector<int16_t> samples(480, 100);
+    PaStreamCallbackTimeInfo time_info{};
+    EXPECT_EQ(microphone::AudioCallback(samples.data(), nullptr, samples.size(), &time_info, 0, ctx.get()), paContinue);
+    EXPECT_EQ(header.cursor.stream_start_ns.load(),
+              std::chrono::duration_cast<std::chrono::nanoseconds>(ctx->stream_start_time.time_since_epoch()).count());
+    EXPECT_EQ(header.cursor.write_position.load(), samples.size());
+}
+
+TEST_F(MicrophoneTest, SharedMemoryIsOffByDefault) {
+    auto config = createConfig(testDeviceName, 48000, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    const auto reply = mic.do_command(ProtoStruct{{"get_shared_memory", true}});
+    EXPECT_FALSE(*reply.at("enabled").get<bool>());
+    EXPECT_EQ(reply.count("name"), 0);
+
+    auto attrs = ProtoStruct{{"shared_memory", std::string("yes")}};
+    ResourceConfig invalid("rdk:component:audioin", "", test_name_, attrs, "", microphone::Microphone::model, LinkConfig{}, log_level::info);
+    EXPECT_THROW(microphone::Microphone::validate(invalid), std::invalid_argument);
+}
+
+TEST_F(MicrophoneTest, ValidateRejectsInvalidBufferSeconds) {
+    for (const auto& value : {ProtoValue(0.0), ProtoValue(7.5), ProtoValue(1000.0), ProtoValue(true)}) {
+        auto attributes = ProtoStruct{};
+        attributes["buffer_seconds"] = value;
+        ResourceConfig config(
+            "rdk:component:audioin", "", test_name_, attributes, "",
+            microphone::Microphone::model, LinkConfig{}, log_level::info);
+        EXPECT_THROW(microphone::Microphone::validate(config), std::invalid_argument);
+    }
+}
+
+TEST_F(MicrophoneTest, GetAudioRejectsInvalidMp3Extra) {
+    microphone::Microphone mic(test_deps_, *test_config_, mock_pa_.get());
+    auto handler = [](AudioIn::audio_chunk&&) { return false; };
+
+    EXPECT_THROW(mic.get_audio("mp3", handler, 1.0, 0, ProtoStruct{{"mp3_bitrate_mode", std::string("lossless")}}),
+                 std::invalid_argument);
+}
+
 TEST_F(MicrophoneTest, GetPropertiesReturnsCorrectValues) {
     int sample_rate = 48000;
     int num_channels = 2;
@@ -267,7 +522,7 @@ TEST_F(MicrophoneTest, GetPropertiesReturnsCorrectValues) {
 
     EXPECT_EQ(props.sample_rate_hz, sample_rate);
     EXPECT_EQ(props.num_channels, num_channels);
-    ASSERT_EQ(props.supported_codecs.size(), 4);
+    ASSERT_EQ(props.supported_codecs.size(), 5);
 }
 
 TEST_F(MicrophoneTest, ModelExists) {
@@ -518,6 +773,510 @@ TEST_F(MicrophoneTest, MultipleConcurrentGetAudioCalls) {
     EXPECT_GE(max_active.load(), 2);
 }
 
+TEST_F(MicrophoneTest, AcquireSharedEncoderReusesStagePerCodec) {
+    auto config = createConfig(testDeviceName, 44100, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic, 0);
+
+    auto pcm_a = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_16, ctx);
+    auto pcm_b = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_16, ctx);
+    auto pcm32 = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_32, ctx);
+
+    EXPECT_EQ(pcm_a, pcm_b);
+    EXPECT_NE(pcm_a, pcm32);
+    EXPECT_EQ(pcm_a->samples_per_chunk, 4410);
+
+    // Once every reader has released the stage, a fresh one is created.
+    pcm_a.reset();
+    pcm_b.reset();
+    auto pcm_c = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_16, ctx);
+    EXPECT_EQ(pcm_c.use_count(), 1);
+}
+
+TEST_F(MicrophoneTest, AcquireSharedEncoderSplitsMp3StagesBySettings) {
+    auto config = createConfig(testDeviceName, 44100, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic, 0);
+
+    microphone::StageOptions low;
+    low.mp3.bitrate_kbps = 64;
+
+    auto mp3_default = mic.acquire_shared_encoder(audio::codec::AudioCodec::MP3, ctx);
+    auto mp3_default_again = mic.acquire_shared_encoder(audio::codec::AudioCodec::MP3, ctx, microphone::StageOptions{});
+    auto mp3_low = mic.acquire_shared_encoder(audio::codec::AudioCodec::MP3, ctx, low);
+    EXPECT_EQ(mp3_default, mp3_default_again);
+    EXPECT_NE(mp3_default, mp3_low);
+
+    // Encoder settings don't apply to PCM, so they must not split its stage
+    auto pcm_a = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_16, ctx);
+    auto pcm_b = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_16, ctx, low);
+    EXPECT_EQ(pcm_a, pcm_b);
+}
+
+TEST_F(MicrophoneTest, SharedEncoderGatesSilence) {
+    auto config = createConfig(testDeviceName, 44100, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic, 0);
+
+    microphone::StageOptions gated;
+    gated.silence.enabled = true;
+    gated.silence.threshold_db = -40;
+    gated.silence.hangover_ms = 0;
+    gated.silence.preroll_ms = 100;
+    auto encoder = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_16, ctx, gated);
+    EXPECT_NE(encoder, mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_16, ctx));
+    const int chunk_samples = encoder->device_samples_per_chunk;
+
+    // Three quiet chunks, then a loud one
+    const std::vector<int16_t> quiet(chunk_samples, 3);
+    const std::vector<int16_t> loud(chunk_samples, 8000);
+    uint64_t index = encoder->next_index();
+    for (int i = 0; i < 3; i++) {
+        ctx->write_samples(quiet.data(), quiet.size());
+        EXPECT_EQ(encoder->get_chunk(index), nullptr);
+    }
+    ctx->write_samples(loud.data(), loud.size());
+
+    // The first two quiet chunks collapse into one gap; the third is the pre-roll
+    const auto gap = encoder->get_chunk(index);
+    ASSERT_NE(gap, nullptr);
+    EXPECT_TRUE(gap->gap);
+    EXPECT_TRUE(gap->audio_data.empty());
+    EXPECT_EQ(gap->start_timestamp_ns, ctx->calculate_sample_timestamp(0));
+    EXPECT_EQ(gap->end_timestamp_ns, ctx->calculate_sample_timestamp(2 * chunk_samples));
+
+    index++;
+    const auto preroll = encoder->get_chunk(index);
+    ASSERT_NE(preroll, nullptr);
+    EXPECT_FALSE(preroll->gap);
+    EXPECT_EQ(preroll->start_timestamp_ns, gap->end_timestamp_ns);
+    EXPECT_EQ(std::memcmp(preroll->audio_data.data(), quiet.data(), preroll->audio_data.size()), 0);
+
+    index++;
+    const auto speech = encoder->get_chunk(index);
+    ASSERT_NE(speech, nullptr);
+    EXPECT_EQ(speech->start_timestamp_ns, preroll->end_timestamp_ns);
+    EXPECT_EQ(std::memcmp(speech->audio_data.data(), loud.data(), speech->audio_data.size()), 0);
+
+    // With no hangover the next quiet chunk is skipped again
+    ctx->write_samples(quiet.data(), quiet.size());
+    index++;
+    EXPECT_EQ(encoder->get_chunk(index), nullptr);
+    EXPECT_EQ(encoder->read_position(), static_cast<uint64_t>(5 * chunk_samples));
+}
+
+TEST_F(MicrophoneTest, GetAudioSendsGapsInSequence) {
+    auto config = createConfig(testDeviceName, 48000, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    mic.audio_context_ = createTestContext(mic, 0);
+
+    std::vector<viam::sdk::AudioIn::audio_chunk> received;
+    auto handler = [&](viam::sdk::AudioIn::audio_chunk&& chunk) {
+        received.push_back(std::move(chunk));
+        return received.size() < 3;
+    };
+    std::thread reader([&]() {
+        mic.get_audio(viam::sdk::audio_codecs::PCM_16,
+                      handler,
+                      5.0,
+                      0,
+                      ProtoStruct{{"chunk_duration_ms", 10.0}, {"silence_threshold_db", -40.0}, {"silence_preroll_ms", 0.0}});
+    });
+    // Give get_audio time to initialize its read position
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    // 50 ms of silence, then 20 ms of tone
+    const std::vector<int16_t> silence(2400, 0);
+    const std::vector<int16_t> tone(960, 10000);
+    mic.audio_context_->write_samples(silence.data(), silence.size());
+    mic.audio_context_->write_samples(tone.data(), tone.size());
+    reader.join();
+
+    ASSERT_EQ(received.size(), 3);
+    EXPECT_TRUE(received[0].audio_data.empty());
+    EXPECT_EQ(received[0].end_timestamp_ns - received[0].start_timestamp_ns, std::chrono::milliseconds(50));
+    for (size_t i = 0; i < received.size(); i++) {
+        EXPECT_EQ(received[i].sequence_number, i);
+        if (i > 0) {
+            EXPECT_EQ(received[i].start_timestamp_ns, received[i - 1].end_timestamp_ns);
+            EXPECT_EQ(received[i].audio_data.size(), 480 * sizeof(int16_t));
+        }
+    }
+}
+
+TEST_F(MicrophoneTest, ValidateRejectsInvalidSilenceGate) {
+    for (const auto& attributes : {ProtoStruct{{"silence_threshold_db", 6.0}},
+                                   ProtoStruct{{"silence_hangover_ms", -10.0}},
+                                   ProtoStruct{{"silence_preroll_ms", std::string("100")}}}) {
+        ResourceConfig config(
+            "rdk:component:audioin", "", test_name_, attributes, "", microphone::Microphone::model, LinkConfig{}, log_level::info);
+        EXPECT_THROW(microphone::Microphone::validate(config), std::invalid_argument);
+    }
+}
+
+TEST_F(MicrophoneTest, SharedEncoderOpusChunkIsOnePacket) {
+    auto config = createConfig(testDeviceName, 16000, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic, 0);
+
+    auto encoder = mic.acquire_shared_encoder(audio::codec::AudioCodec::OPUS, ctx);
+    EXPECT_EQ(encoder->requested_sample_rate, 16000);
+    EXPECT_EQ(encoder->samples_per_chunk, 320);  // 20 ms
+
+    for (int i = 0; i < encoder->device_samples_per_chunk; i++) {
+        ctx->write_sample(static_cast<int16_t>(i));
+    }
+
+    uint64_t index = encoder->next_index();
+    auto chunk = encoder->get_chunk(index);
+    ASSERT_NE(chunk, nullptr);
+    ASSERT_GT(chunk->audio_data.size(), audio::codec::OPUS_LENGTH_PREFIX_BYTES);
+    const size_t packet_length = chunk->audio_data[0] | (chunk->audio_data[1] << 8);
+    EXPECT_EQ(packet_length + audio::codec::OPUS_LENGTH_PREFIX_BYTES, chunk->audio_data.size());
+}
+
+TEST_F(MicrophoneTest, SharedEncoderOpusResamplesUnsupportedRate) {
+    auto config = createConfig(testDeviceName, 44100, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic, 0);
+
+    auto encoder = mic.acquire_shared_encoder(audio::codec::AudioCodec::OPUS, ctx);
+    EXPECT_EQ(encoder->requested_sample_rate, 48000);
+    EXPECT_EQ(encoder->samples_per_chunk, 960);
+    EXPECT_EQ(encoder->device_samples_per_chunk, 882);
+}
+
+TEST_F(MicrophoneTest, ValidateDuplexSpeaker) {
+    auto attrs = ProtoStruct{{"duplex_speaker", std::string("test_speaker")}};
+    ResourceConfig config("rdk:component:audioin", "", test_name_, attrs, "", microphone::Microphone::model, LinkConfig{}, log_level::info);
+    // The speaker is a dependency
+    EXPECT_EQ(microphone::Microphone::validate(config), std::vector<std::string>{"test_speaker"});
+
+    for (const auto& value : {ProtoValue(std::string("")), ProtoValue(1.0)}) {
+        auto invalid_attrs = ProtoStruct{{"duplex_speaker", value}};
+        ResourceConfig invalid(
+            "rdk:component:audioin", "", test_name_, invalid_attrs, "", microphone::Microphone::model, LinkConfig{}, log_level::info);
+        EXPECT_THROW(microphone::Microphone::validate(invalid), std::invalid_argument);
+    }
+}
+
+TEST_F(MicrophoneTest, DuplexSpeakerSharesOneStream) {
+    using ::testing::_;
+    using ::testing::IsNull;
+    using ::testing::NotNull;
+
+    auto speaker_attrs = ProtoStruct{{"sample_rate", 44100.0}, {"num_channels", 2.0}};
+    ResourceConfig speaker_config(
+        "rdk:component:audioout", "", "test_speaker", speaker_attrs, "", speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    // The speaker's own stream before and after the microphone holds it, and one duplex stream
+    EXPECT_CALL(*mock_pa_, openStream(_, IsNull(), NotNull(), _, _, _, _, _)).Times(2);
+    EXPECT_CALL(*mock_pa_, openStream(_, NotNull(), NotNull(), 44100.0, _, _, &microphone::DuplexCallback, NotNull())).Times(1);
+
+    auto speaker = std::make_shared<speaker::Speaker>(Dependencies{}, speaker_config, mock_pa_.get());
+    Dependencies deps{{Name(API::get<AudioOut>(), "", "test_speaker"), speaker}};
+    auto attrs = ProtoStruct{{"device_name", std::string(testDeviceName)},
+                             {"sample_rate", 44100.0},
+                             {"num_channels", 1.0},
+                             {"duplex_speaker", std::string("test_speaker")}};
+    ResourceConfig config("rdk:component:audioin", "", test_name_, attrs, "", microphone::Microphone::model, LinkConfig{}, log_level::info);
+    {
+        microphone::Microphone mic(deps, config, mock_pa_.get());
+        EXPECT_TRUE(speaker->duplex_attached_);
+        ASSERT_TRUE(mic.duplex_);
+        EXPECT_EQ(&mic.duplex_->output, speaker->audio_context_.get());
+        EXPECT_EQ(mic.stream_params_.output_num_channels, 2);
+
+        // Captured channel plus the reference
+        EXPECT_EQ(mic.get_properties(ProtoStruct{}).num_channels, 2);
+        EXPECT_EQ(mic.audio_context_->info.num_channels, 2);
+    }
+    EXPECT_FALSE(speaker->duplex_attached_);
+}
+
+TEST_F(MicrophoneTest, DuplexSpeakerNeedsMatchingSampleRate) {
+    auto speaker_attrs = ProtoStruct{{"sample_rate", 48000.0}};
+    ResourceConfig speaker_config(
+        "rdk:component:audioout", "", "test_speaker", speaker_attrs, "", speaker::Speaker::model, LinkConfig{}, log_level::info);
+    auto speaker = std::make_shared<speaker::Speaker>(Dependencies{}, speaker_config, mock_pa_.get());
+    Dependencies deps{{Name(API::get<AudioOut>(), "", "test_speaker"), speaker}};
+
+    auto attrs = ProtoStruct{{"sample_rate", 44100.0}, {"duplex_speaker", std::string("test_speaker")}};
+    ResourceConfig config("rdk:component:audioin", "", test_name_, attrs, "", microphone::Microphone::model, LinkConfig{}, log_level::info);
+    EXPECT_THROW(microphone::Microphone(deps, config, mock_pa_.get()), std::invalid_argument);
+    // The speaker got its stream back
+    EXPECT_FALSE(speaker->duplex_attached_);
+
+    // A dependency that isn't one of this module's speakers can't be used either
+    auto other = ProtoStruct{{"duplex_speaker", std::string("missing_speaker")}};
+    ResourceConfig missing("rdk:component:audioin", "", test_name_, other, "", microphone::Microphone::model, LinkConfig{}, log_level::info);
+    EXPECT_THROW(microphone::Microphone(deps, missing, mock_pa_.get()), std::invalid_argument);
+}
+
+TEST_F(MicrophoneTest, ValidateWithInvalidConfig_OpusFrameMs) {
+  auto attributes = ProtoStruct{};
+  attributes["device_name"] = test_mic_name_;
+  attributes["opus_frame_ms"] = 25.0;
+
+  ResourceConfig invalid_config(
+      "rdk:component:microphone", "", test_name_, attributes, "",
+      Model("viam", "audio", "mic"), LinkConfig{}, log_level::info);
+
+  EXPECT_THROW(
+      { microphone::Microphone::validate(invalid_config); },
+      std::invalid_argument);
+}
+
+TEST_F(MicrophoneTest, SharedEncoderPublishesEachChunkOnce) {
+    auto config = createConfig(testDeviceName, 44100, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic, 0);
+
+    auto encoder = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_16, ctx);
+    const int chunk_samples = encoder->device_samples_per_chunk;
+
+    uint64_t index_a = encoder->next_index();
+    uint64_t index_b = index_a;
+    EXPECT_EQ(encoder->get_chunk(index_a), nullptr);  // nothing captured yet
+
+    for (int i = 0; i < chunk_samples; i++) {
+        ctx->write_sample(static_cast<int16_t>(i));
+    }
+
+    auto first = encoder->get_chunk(index_a);
+    auto second = encoder->get_chunk(index_b);
+    ASSERT_NE(first, nullptr);
+    // Both readers get the same published chunk, and the device buffer was only read once.
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(first->audio_data.size(), chunk_samples * sizeof(int16_t));
+    EXPECT_EQ(encoder->read_position(), static_cast<uint64_t>(chunk_samples));
+}
+
+TEST_F(MicrophoneTest, SharedEncoderSlowReaderSkipsEvictedChunks) {
+    auto config = createConfig(testDeviceName, 44100, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic, 0);
+
+    auto encoder = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_16, ctx);
+    const int chunk_samples = encoder->device_samples_per_chunk;
+    const size_t total_chunks = microphone::SharedEncoder::MAX_RETAINED_CHUNKS + 5;
+
+    std::vector<int16_t> block(chunk_samples, 0);
+    uint64_t fast_index = encoder->next_index();
+    const uint64_t slow_start = fast_index;
+    for (size_t i = 0; i < total_chunks; i++) {
+        ctx->write_samples(block.data(), block.size());
+        ASSERT_NE(encoder->get_chunk(fast_index), nullptr);
+        fast_index++;
+    }
+
+    uint64_t slow_index = slow_start;
+    ASSERT_NE(encoder->get_chunk(slow_index), nullptr);
+    EXPECT_EQ(slow_index, slow_start + 5);
+}
+
+TEST_F(MicrophoneTest, Pcm16AtDeviceRateReadsDirectlyIntoPayload) {
+    auto config = createConfig(testDeviceName, 44100, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic, 0);
+
+    auto pcm16 = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_16, ctx);
+    auto pcm32 = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_32, ctx);
+    EXPECT_TRUE(pcm16->direct_copy);
+    EXPECT_FALSE(pcm32->direct_copy);
+
+    const int chunk_samples = pcm16->device_samples_per_chunk;
+    std::vector<int16_t> block(chunk_samples);
+    for (int i = 0; i < chunk_samples; i++) {
+        block[i] = static_cast<int16_t>(i * 3 - 5000);
+    }
+    ctx->write_samples(block.data(), block.size());
+
+    uint64_t index = pcm16->next_index();
+    const auto chunk = pcm16->get_chunk(index);
+    ASSERT_NE(chunk, nullptr);
+    ASSERT_EQ(chunk->audio_data.size(), block.size() * sizeof(int16_t));
+    EXPECT_EQ(std::memcmp(chunk->audio_data.data(), block.data(), chunk->audio_data.size()), 0);
+
+    // A different requested rate needs the resampler, so it can't take the direct path
+    pcm16.reset();
+    mic.requested_sample_rate_ = 16000;
+    auto resampled = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_16, ctx);
+    EXPECT_FALSE(resampled->direct_copy);
+}
+
+TEST_F(MicrophoneTest, Int32SampleFormatCapturesNatively) {
+    auto attributes = ProtoStruct{};
+    attributes["device_name"] = testDeviceName;
+    attributes["sample_rate"] = 44100.0;
+    attributes["num_channels"] = 1.0;
+    attributes["sample_format"] = std::string("int32");
+    ResourceConfig config(
+        "rdk:component:audioin", "", test_name_, attributes, "",
+        microphone::Microphone::model, LinkConfig{}, log_level::info);
+
+    using ::testing::_;
+    EXPECT_CALL(*mock_pa_, openStream(_, ::testing::Pointee(::testing::Field(&PaStreamParameters::sampleFormat, paInt32)), _, _, _, _, _, _));
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic, 0);
+
+    EXPECT_EQ(ctx->sample_format, audio::SampleFormat::INT32);
+    EXPECT_EQ(ctx->memory_bytes(), ctx->ring_size * sizeof(int32_t));
+    auto settings = mic.do_command(ProtoStruct{{"get_buffer_settings", true}});
+    EXPECT_EQ(*settings.at("sample_format").get<std::string>(), "int32");
+
+    auto pcm32 = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_32, ctx);
+    auto pcm16 = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_16, ctx);
+    EXPECT_TRUE(pcm32->direct_copy);
+    EXPECT_FALSE(pcm16->direct_copy);
+
+    // Bits below the top 16 would be lost on a round trip through int16
+    const int chunk_samples = pcm32->device_samples_per_chunk;
+    std::vector<int32_t> block(chunk_samples);
+    for (int i = 0; i < chunk_samples; i++) {
+        block[i] = (i - 100) * 65536 + 123;
+    }
+    ctx->write_native(block.data(), block.size());
+
+    uint64_t index = pcm32->next_index();
+    const auto chunk = pcm32->get_chunk(index);
+    ASSERT_NE(chunk, nullptr);
+    ASSERT_EQ(chunk->audio_data.size(), block.size() * sizeof(int32_t));
+    EXPECT_EQ(std::memcmp(chunk->audio_data.data(), block.data(), chunk->audio_data.size()), 0);
+
+    // Other codecs see the same audio narrowed to int16
+    index = pcm16->next_index();
+    const auto narrowed = pcm16->get_chunk(index);
+    ASSERT_NE(narrowed, nullptr);
+    ASSERT_EQ(narrowed->audio_data.size(), block.size() * sizeof(int16_t));
+    const int16_t* samples = reinterpret_cast<const int16_t*>(narrowed->audio_data.data());
+    EXPECT_EQ(samples[0], -100);
+    EXPECT_EQ(samples[chunk_samples - 1], chunk_samples - 101);
+}
+
+TEST_F(MicrophoneTest, StreamUsesCallbackSpecializedForItsLayout) {
+    auto config = createConfig(testDeviceName, 44100, 2);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    EXPECT_EQ(mic.stream_params_.callback, microphone::select_audio_callback(2, audio::SampleFormat::INT16));
+    EXPECT_NE(mic.stream_params_.callback, &microphone::AudioCallback);
+
+    // Restarts reopen with the same callback
+    mic.restart_stalled_stream(mic.audio_context_);
+    EXPECT_EQ(mic.stream_params_.callback, microphone::select_audio_callback(2, audio::SampleFormat::INT16));
+}
+
+TEST_F(MicrophoneTest, ValidateSampleFormat) {
+    for (const auto& value : {ProtoValue(std::string("float32")), ProtoValue(std::string("int16"))}) {
+        auto attributes = ProtoStruct{{"sample_format", value}};
+        ResourceConfig config("rdk:component:audioin", "", test_name_, attributes, "", microphone::Microphone::model, LinkConfig{}, log_level::info);
+        EXPECT_NO_THROW(microphone::Microphone::validate(config));
+    }
+    for (const auto& value : {ProtoValue(std::string("int24")), ProtoValue(32.0)}) {
+        auto attributes = ProtoStruct{{"sample_format", value}};
+        ResourceConfig config("rdk:component:audioin", "", test_name_, attributes, "", microphone::Microphone::model, LinkConfig{}, log_level::info);
+        EXPECT_THROW(microphone::Microphone::validate(config), std::invalid_argument);
+    }
+}
+
+TEST_F(MicrophoneTest, SharedEncoderRecyclesEvictedChunks) {
+    auto config = createConfig(testDeviceName, 44100, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic, 0);
+
+    auto encoder = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_16, ctx);
+    const int chunk_samples = encoder->device_samples_per_chunk;
+    std::vector<int16_t> block(chunk_samples, 0);
+    uint64_t index = encoder->next_index();
+
+    // Produce enough chunks that the first ones are evicted, without holding any of them
+    std::vector<const uint8_t*> payloads;
+    for (size_t i = 0; i < microphone::SharedEncoder::MAX_RETAINED_CHUNKS + 3; i++) {
+        std::fill(block.begin(), block.end(), static_cast<int16_t>(i));
+        ctx->write_samples(block.data(), block.size());
+        const auto chunk = encoder->get_chunk(index);
+        ASSERT_NE(chunk, nullptr);
+        payloads.push_back(chunk->audio_data.data());
+        // Recycled chunks carry the new audio, not the old
+        int16_t first_sample;
+        std::memcpy(&first_sample, chunk->audio_data.data(), sizeof(first_sample));
+        EXPECT_EQ(first_sample, static_cast<int16_t>(i));
+        EXPECT_EQ(chunk->audio_data.size(), chunk_samples * sizeof(int16_t));
+        index++;
+    }
+
+    // Once eviction starts, each new chunk reuses the payload buffer of the one just evicted
+    const size_t n = microphone::SharedEncoder::MAX_RETAINED_CHUNKS;
+    EXPECT_EQ(payloads[n + 1], payloads[0]);
+    EXPECT_EQ(payloads[n + 2], payloads[1]);
+}
+
+TEST_F(MicrophoneTest, SharedEncoderDoesNotRecycleChunksStillHeld) {
+    auto config = createConfig(testDeviceName, 44100, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic, 0);
+
+    auto encoder = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_16, ctx);
+    const int chunk_samples = encoder->device_samples_per_chunk;
+    std::vector<int16_t> block(chunk_samples, 7);
+    uint64_t index = encoder->next_index();
+
+    ctx->write_samples(block.data(), block.size());
+    const auto held = encoder->get_chunk(index);
+    ASSERT_NE(held, nullptr);
+    const std::vector<uint8_t> original = held->audio_data;
+    index++;
+
+    std::fill(block.begin(), block.end(), static_cast<int16_t>(-7));
+    for (size_t i = 0; i < microphone::SharedEncoder::MAX_RETAINED_CHUNKS + 3; i++) {
+        ctx->write_samples(block.data(), block.size());
+        const auto chunk = encoder->get_chunk(index);
+        ASSERT_NE(chunk, nullptr);
+        EXPECT_NE(chunk.get(), held.get());
+        index++;
+    }
+    EXPECT_EQ(held->audio_data, original);
+}
+
+TEST_F(MicrophoneTest, ConcurrentLiveReadersReceiveIdenticalChunks) {
+    auto config = createConfig(testDeviceName, 44100, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic, 0);
+
+    std::mutex results_mu;
+    std::map<int64_t, std::vector<uint8_t>> chunks_by_start[2];
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; r++) {
+        readers.emplace_back([&, r]() {
+            auto handler = [&, r](viam::sdk::AudioIn::audio_chunk&& chunk) {
+                std::lock_guard<std::mutex> lock(results_mu);
+                chunks_by_start[r][chunk.start_timestamp_ns.count()] = std::move(chunk.audio_data);
+                return chunks_by_start[r].size() < 5;
+            };
+            mic.get_audio(viam::sdk::audio_codecs::PCM_16, handler, 0, 0, ProtoStruct{});
+        });
+    }
+
+    // Let both readers join the shared stage before audio arrives.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::vector<int16_t> block(4410);
+    for (int c = 0; c < 8; c++) {
+        for (size_t i = 0; i < block.size(); i++) {
+            block[i] = static_cast<int16_t>(c * 1000 + i);
+        }
+        ctx->write_samples(block.data(), block.size());
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    ASSERT_EQ(chunks_by_start[0].size(), 5u);
+    ASSERT_EQ(chunks_by_start[1].size(), 5u);
+    EXPECT_EQ(chunks_by_start[0], chunks_by_start[1]);
+}
+
 TEST_F(MicrophoneTest, GetAudioReceivesChunks) {
     auto config = createConfig(testDeviceName, 44100, 1);
     microphone::Microphone mic(test_deps_, config, mock_pa_.get());
@@ -553,6 +1312,118 @@ TEST_F(MicrophoneTest, GetAudioReceivesChunks) {
     EXPECT_EQ(chunks_received, num_chunks);
 }
 
+TEST_F(MicrophoneTest, GetAudioDoesNotLockPerChunk) {
+    auto config = createConfig(testDeviceName, 48000, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    mic.audio_context_ = createTestContext(mic, 0);
+
+    const int samples_per_chunk = 480;
+    const int num_chunks = 5;
+    int chunks_received = 0;
+    auto handler = [&](viam::sdk::AudioIn::audio_chunk&&) { return ++chunks_received < num_chunks; };
+
+    std::thread reader([&]() {
+        mic.get_audio(viam::sdk::audio_codecs::PCM_16, handler, 5.0, 0, ProtoStruct{{"chunk_duration_ms", 10.0}});
+    });
+    // Wait for the reader to finish setting up, which is the last time it takes the lock
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (mic.do_command(ProtoStruct{{"get_stats", true}}).at("clients").get<ProtoList>()->empty()) {
+        ASSERT_LT(std::chrono::steady_clock::now(), deadline);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // A command or stall restart holding the stream lock doesn't hold up chunks
+    {
+        std::lock_guard<std::mutex> lock(mic.stream_ctx_mu_);
+        const std::vector<int16_t> block(samples_per_chunk * num_chunks, 1);
+        mic.audio_context_->write_samples(block.data(), block.size());
+        reader.join();
+    }
+
+    EXPECT_EQ(chunks_received, num_chunks);
+}
+
+TEST_F(MicrophoneTest, GetAudioHonorsChunkDuration) {
+    auto config = createConfig(testDeviceName, 48000, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+
+    // 10ms = 480 samples at 48kHz mono
+    const int samples_per_chunk = 480;
+    const int num_chunks = 5;
+
+    mic.audio_context_ = createTestContext(mic, 0);
+
+    int chunks_received = 0;
+    auto handler = [&](viam::sdk::AudioIn::audio_chunk&& chunk) {
+        chunks_received++;
+        EXPECT_EQ(chunk.audio_data.size(), samples_per_chunk * sizeof(int16_t));
+        return chunks_received < num_chunks;
+    };
+
+    std::thread reader([&]() {
+        mic.get_audio(viam::sdk::audio_codecs::PCM_16, handler, 5.0, 0, ProtoStruct{{"chunk_duration_ms", 10.0}});
+    });
+
+    // Give get_audio time to initialize its read position
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    for (int i = 0; i < num_chunks * samples_per_chunk; i++) {
+        mic.audio_context_->write_sample(static_cast<int16_t>(i));
+    }
+
+    reader.join();
+
+    EXPECT_EQ(chunks_received, num_chunks);
+}
+
+TEST_F(MicrophoneTest, AcquireSharedEncoderChunkDurationPerCodec) {
+    auto config = createConfig(testDeviceName, 48000, 2);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic, 0);
+
+    microphone::StageOptions short_chunks;
+    short_chunks.chunk_duration_ms = 20;
+
+    auto pcm_default = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_16, ctx);
+    auto pcm_short = mic.acquire_shared_encoder(audio::codec::AudioCodec::PCM_16, ctx, short_chunks);
+    EXPECT_NE(pcm_default, pcm_short);
+    EXPECT_EQ(pcm_short->samples_per_chunk, 960 * 2);
+
+    // MP3 rounds to whole frames: 50ms at 48kHz is two 1152-sample frames
+    short_chunks.chunk_duration_ms = 50;
+    auto mp3 = mic.acquire_shared_encoder(audio::codec::AudioCodec::MP3, ctx, short_chunks);
+    EXPECT_EQ(mp3->samples_per_chunk, 2 * 1152 * 2);
+
+    // Opus chunks are whole packets
+    short_chunks.chunk_duration_ms = 40;
+    auto opus = mic.acquire_shared_encoder(audio::codec::AudioCodec::OPUS, ctx, short_chunks);
+    EXPECT_EQ(opus->samples_per_chunk, 2 * 960 * 2);
+}
+
+TEST_F(MicrophoneTest, AcquireSharedEncoderRejectsChunkDurationBelowFrame) {
+    auto config = createConfig(testDeviceName, 48000, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic, 0);
+
+    microphone::StageOptions options;
+    options.chunk_duration_ms = 10;
+    // One MP3 frame is 24ms at 48kHz; the default Opus packet is 20ms
+    EXPECT_THROW(mic.acquire_shared_encoder(audio::codec::AudioCodec::MP3, ctx, options), std::invalid_argument);
+    EXPECT_THROW(mic.acquire_shared_encoder(audio::codec::AudioCodec::OPUS, ctx, options), std::invalid_argument);
+}
+
+TEST_F(MicrophoneTest, GetAudioRejectsInvalidChunkDuration) {
+    microphone::Microphone mic(test_deps_, *test_config_, mock_pa_.get());
+    auto handler = [](AudioIn::audio_chunk&&) { return false; };
+
+    EXPECT_THROW(mic.get_audio(viam::sdk::audio_codecs::PCM_16, handler, 1.0, 0, ProtoStruct{{"chunk_duration_ms", 2.0}}),
+                 std::invalid_argument);
+    EXPECT_THROW(mic.get_audio(viam::sdk::audio_codecs::PCM_16, handler, 1.0, 0, ProtoStruct{{"chunk_duration_ms", 12.5}}),
+                 std::invalid_argument);
+    EXPECT_THROW(mic.get_audio(viam::sdk::audio_codecs::PCM_16, handler, 1.0, 0, ProtoStruct{{"chunk_duration_ms", std::string("10")}}),
+                 std::invalid_argument);
+}
+
 TEST_F(MicrophoneTest, GetAudioHandlerCanStopEarly) {
     auto config = createConfig(testDeviceName, 44100, 2);
     microphone::Microphone mic(test_deps_, config, mock_pa_.get());
@@ -1071,6 +1942,57 @@ TEST_F(MicrophoneTest, CodecConversion_MP3_Stereo) {
     EXPECT_EQ(chunks_received, 5);
 }
 
+namespace {
+
+// Reads 0.5 s of live MP3 from mic while a background thread feeds ctx, and returns each
+// chunk's duration
+std::vector<std::chrono::nanoseconds> read_mp3_durations(microphone::Microphone& mic, const std::shared_ptr<audio::InputStreamContext>& ctx) {
+    std::vector<std::chrono::nanoseconds> durations;
+    auto handler = [&](viam::sdk::AudioIn::audio_chunk&& chunk) {
+        durations.push_back(chunk.end_timestamp_ns - chunk.start_timestamp_ns);
+        return true;
+    };
+
+    std::atomic<bool> stop_writing{false};
+    std::thread writer([&]() {
+        for (int i = 0; i < 500000 && !stop_writing.load(); i++) {
+            ctx->write_sample(static_cast<int16_t>(i % 1000));
+        }
+    });
+    mic.get_audio(viam::sdk::audio_codecs::MP3, handler, 0.5, 0, ProtoStruct{});
+    stop_writing = true;
+    writer.join();
+    return durations;
+}
+
+}  // namespace
+
+TEST_F(MicrophoneTest, LiveMp3ReaderGetsEncoderTail) {
+    auto config = createConfig(testDeviceName, 48000, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic);
+
+    // The only reader of its shared stage flushes it, so the call ends with the encoder's
+    // lookahead: a chunk shorter than the frame-aligned ones before it
+    const auto durations = read_mp3_durations(mic, ctx);
+    ASSERT_GE(durations.size(), 2u);
+    EXPECT_LT(durations.back(), durations.front());
+}
+
+TEST_F(MicrophoneTest, LiveMp3ReaderLeavingSharedStageGetsNoTail) {
+    auto config = createConfig(testDeviceName, 48000, 1);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    auto ctx = createTestContext(mic);
+
+    // Another reader still holds the stage, so it keeps running unflushed
+    const auto other = mic.acquire_shared_encoder(audio::codec::AudioCodec::MP3, ctx);
+    const auto durations = read_mp3_durations(mic, ctx);
+    ASSERT_GE(durations.size(), 2u);
+    for (const auto& duration : durations) {
+        EXPECT_EQ(duration, durations.front());
+    }
+}
+
 TEST_F(MicrophoneTest, HistoricalDataRespectsDuration) {
     auto config = createConfig("", 48000, 2);
     expectSuccessfulStreamCreation();
@@ -1114,6 +2036,167 @@ TEST_F(MicrophoneTest, HistoricalDataRespectsDuration) {
     EXPECT_EQ(chunk_count, 100);
 }
 
+TEST_F(MicrophoneTest, HistoricalReplayIsPacedByConsumer) {
+    auto config = createConfig("", 48000, 2);
+    expectSuccessfulStreamCreation();
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+
+    auto ctx = createTestContext(mic, 48000 * 2 * 20);
+    auto stream_start_ns = std::chrono::time_point_cast<std::chrono::nanoseconds>(ctx->stream_start_time);
+    int64_t previous_timestamp_ns = stream_start_ns.time_since_epoch().count() + (5 * NANOSECONDS_PER_SECOND);
+
+    int chunk_count = 0;
+    auto chunk_handler = [&](viam::sdk::AudioIn::audio_chunk chunk) -> bool {
+        chunk_count++;
+        return true;
+    };
+
+    // No fixed pause between chunks: 10 s of history replays as fast as the handler takes it
+    const auto start = std::chrono::steady_clock::now();
+    mic.get_audio("pcm16", chunk_handler, 10.0, previous_timestamp_ns, ProtoStruct{});
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+    EXPECT_EQ(chunk_count, 100);
+}
+
+TEST_F(MicrophoneTest, HistoricalReplayCoalescesChunks) {
+    auto config = createConfig("", 48000, 2);
+    expectSuccessfulStreamCreation();
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+
+    auto ctx = createTestContext(mic, 48000 * 2 * 20);
+    auto stream_start_ns = std::chrono::time_point_cast<std::chrono::nanoseconds>(ctx->stream_start_time);
+    int64_t previous_timestamp_ns = stream_start_ns.time_since_epoch().count() + (5 * NANOSECONDS_PER_SECOND);
+
+    std::vector<viam::sdk::AudioIn::audio_chunk> chunks;
+    auto chunk_handler = [&](viam::sdk::AudioIn::audio_chunk chunk) -> bool {
+        chunks.push_back(std::move(chunk));
+        return true;
+    };
+
+    mic.get_audio("pcm16", chunk_handler, 10.0, previous_timestamp_ns, ProtoStruct{{"replay_chunk_ms", 1000.0}});
+
+    // Ten 1 s chunks, contiguous, with the same audio a normal read returns
+    ASSERT_EQ(chunks.size(), 10);
+    size_t total_samples = 0;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        EXPECT_EQ(chunks[i].end_timestamp_ns - chunks[i].start_timestamp_ns, std::chrono::seconds(1));
+        if (i > 0) {
+            EXPECT_EQ(chunks[i].start_timestamp_ns, chunks[i - 1].end_timestamp_ns);
+        }
+        total_samples += chunks[i].audio_data.size() / sizeof(int16_t);
+    }
+    EXPECT_EQ(total_samples, 48000 * 2 * 10);
+}
+
+TEST_F(MicrophoneTest, ParseReplayOptions) {
+    auto options = microphone::parse_replay_options(ProtoStruct{});
+    EXPECT_EQ(options.speed, 0);
+    EXPECT_EQ(options.chunk_ms, 0);
+
+    options = microphone::parse_replay_options(ProtoStruct{{"replay_speed", 4.0}, {"replay_chunk_ms", 500.0}});
+    EXPECT_EQ(options.speed, 4.0);
+    EXPECT_EQ(options.chunk_ms, 500);
+
+    EXPECT_THROW(microphone::parse_replay_options(ProtoStruct{{"replay_speed", 0.5}}), std::invalid_argument);
+    EXPECT_THROW(microphone::parse_replay_options(ProtoStruct{{"replay_speed", std::string("fast")}}), std::invalid_argument);
+    EXPECT_THROW(microphone::parse_replay_options(ProtoStruct{{"replay_chunk_ms", -1.0}}), std::invalid_argument);
+    EXPECT_THROW(microphone::parse_replay_options(ProtoStruct{{"replay_chunk_ms", 10000.0}}), std::invalid_argument);
+}
+
+TEST_F(MicrophoneTest, ReplayPacerLimitsSpeed) {
+    // Unlimited never sleeps
+    microphone::ReplayPacer unlimited(0);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; i++) {
+        unlimited.pace(std::chrono::seconds(1));
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+
+    // 1 s of audio at 10x real time takes about 100 ms
+    microphone::ReplayPacer pacer(10);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; i++) {
+        pacer.pace(std::chrono::milliseconds(100));
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, std::chrono::milliseconds(90));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(500));
+}
+
+TEST_F(MicrophoneTest, ReplayPacerCreditsBlockedTime) {
+    // Time spent blocked in the handler has already paid for the audio sent
+    microphone::ReplayPacer pacer(10);
+    pacer.pace(std::chrono::milliseconds(100));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto start = std::chrono::steady_clock::now();
+    pacer.pace(std::chrono::milliseconds(100));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(30));
+}
+
+TEST_F(MicrophoneTest, HistoricalReadFallsBackToDiskHistory) {
+    const int sample_rate = 16000;
+    const std::string path = (std::filesystem::temp_directory_path() / "microphone_test_disk_history").string();
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = static_cast<double>(sample_rate);
+    attributes["num_channels"] = 1.0;
+    attributes["buffer_seconds"] = 2.0;
+    attributes["disk_history_seconds"] = 10.0;
+    attributes["disk_history_path"] = path;
+    ResourceConfig config(
+        "rdk:component:audioin", "", test_name_, attributes, "",
+        microphone::Microphone::model, LinkConfig{}, log_level::info);
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    ASSERT_NE(mic.disk_history_, nullptr);
+    EXPECT_TRUE(std::filesystem::exists(path));
+
+    // Six seconds through the two-second ring, letting the drain keep up
+    auto ctx = createTestContext(mic);
+    std::vector<int16_t> second(sample_rate);
+    for (int s = 0; s < 6; s++) {
+        for (int i = 0; i < sample_rate; i++) {
+            second[i] = static_cast<int16_t>((s * sample_rate + i) % 30000);
+        }
+        ctx->write_samples(second.data(), second.size());
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (mic.disk_history_->end_position() < static_cast<uint64_t>((s + 1) * sample_rate) &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // Half a second in is long gone from the ring, but on disk
+    auto stream_start_ns = std::chrono::time_point_cast<std::chrono::nanoseconds>(ctx->stream_start_time);
+    const int64_t previous_timestamp_ns = stream_start_ns.time_since_epoch().count() + NANOSECONDS_PER_SECOND / 2;
+    std::vector<int16_t> received;
+    auto handler = [&](viam::sdk::AudioIn::audio_chunk&& chunk) -> bool {
+        const auto* samples = reinterpret_cast<const int16_t*>(chunk.audio_data.data());
+        received.insert(received.end(), samples, samples + chunk.audio_data.size() / sizeof(int16_t));
+        return true;
+    };
+    mic.get_audio("pcm16", handler, 1.0, previous_timestamp_ns, ProtoStruct{});
+
+    ASSERT_EQ(received.size(), sample_rate);
+    EXPECT_NEAR(received.front(), sample_rate / 2, 2);
+    for (size_t i = 1; i < received.size(); i++) {
+        ASSERT_EQ(received[i], received[i - 1] + 1);
+    }
+
+    // Without the disk tier the same request is too old
+    EXPECT_THROW(microphone::get_initial_read_position(ctx, previous_timestamp_ns), std::invalid_argument);
+}
+
+TEST_F(MicrophoneTest, ValidateRejectsInvalidDiskHistory) {
+    for (const auto& attributes : {ProtoStruct{{"disk_history_seconds", -1.0}},
+                                   ProtoStruct{{"disk_history_seconds", 1.5}},
+                                   ProtoStruct{{"disk_history_seconds", std::string("60")}},
+                                   ProtoStruct{{"disk_history_path", 1.0}}}) {
+        ResourceConfig config(
+            "rdk:component:audioin", "", test_name_, attributes, "",
+            microphone::Microphone::model, LinkConfig{}, log_level::info);
+        EXPECT_THROW(microphone::Microphone::validate(config), std::invalid_argument);
+    }
+}
+
 TEST_F(MicrophoneTest, RestartStalledStream_RestartsStream) {
     auto config = createConfig();
     microphone::Microphone mic(test_deps_, config, mock_pa_.get());
@@ -1127,7 +2210,8 @@ TEST_F(MicrophoneTest, RestartStalledStream_RestartsStream) {
 
     mic.restart_stalled_stream(original_context);
 
-    EXPECT_NE(mic.audio_context_, original_context);
+    // The new stream writes into the same context, so readers carry on
+    EXPECT_EQ(mic.audio_context_, original_context);
     EXPECT_EQ(mic.restart_attempts_, 0);
 }
 
@@ -1147,7 +2231,8 @@ TEST_F(MicrophoneTest, RestartStalledStream_ShutsDownExistingStream) {
 
     mic.restart_stalled_stream(original_context);
 
-    EXPECT_NE(mic.audio_context_, original_context);
+    // The new stream writes into the same context, so readers carry on
+    EXPECT_EQ(mic.audio_context_, original_context);
     EXPECT_EQ(mic.restart_attempts_, 0);
 }
 
@@ -1224,7 +2309,44 @@ TEST_F(MicrophoneTest, RestartStalledStream_ResetsAttemptsOnSuccess) {
     mic.restart_stalled_stream(original_context);  // success
 
     EXPECT_EQ(mic.restart_attempts_, 0);
-    EXPECT_NE(mic.audio_context_, original_context);
+    EXPECT_EQ(mic.audio_context_, original_context);
+}
+
+TEST_F(MicrophoneTest, RestartStalledStream_KeepsHistoryAndFillsGap) {
+    auto config = createConfig();
+    microphone::Microphone mic(test_deps_, config, mock_pa_.get());
+    const auto context = mic.audio_context_;
+    const int rate = context->info.sample_rate_hz;
+    const int channels = context->info.num_channels;
+
+    // One second of audio from a stream that started two seconds ago, then stalled
+    context->stream_start_time = std::chrono::system_clock::now() - std::chrono::seconds(2);
+    context->first_callback_captured.store(true);
+    std::vector<int16_t> audio(static_cast<size_t>(rate * channels), 1234);
+    context->write_samples(audio.data(), audio.size());
+    test_utils::mark_callback_stale(context);
+
+    mic.restart_stalled_stream(context);
+
+    EXPECT_EQ(mic.audio_context_, context);
+    EXPECT_EQ(mic.restart_attempts_, 0);
+    EXPECT_EQ(*mic.get_status().at("restarts").get<double>(), 1);
+    EXPECT_TRUE(context->resync_pending.load());
+    EXPECT_EQ(context->last_callback_time_ns.load(), 0);
+
+    // The missing second is silence, so positions still match the capture clock
+    const uint64_t position = context->get_write_position();
+    EXPECT_GE(position, static_cast<uint64_t>(2 * rate * channels));
+    EXPECT_LT(position, static_cast<uint64_t>(3 * rate * channels));
+
+    // And the audio from before the stall is still there
+    std::vector<int16_t> read(audio.size());
+    uint64_t read_position = 0;
+    ASSERT_EQ(context->read_samples(read.data(), static_cast<int>(read.size()), read_position), static_cast<int>(read.size()));
+    EXPECT_EQ(read, audio);
+    std::vector<int16_t> gap(static_cast<size_t>(rate * channels / 2));
+    ASSERT_EQ(context->read_samples(gap.data(), static_cast<int>(gap.size()), read_position), static_cast<int>(gap.size()));
+    EXPECT_TRUE(std::all_of(gap.begin(), gap.end(), [](int16_t sample) { return sample == 0; }));
 }
 
 class AudioCallbackTest : public ::testing::Test {
@@ -1288,6 +2410,154 @@ class AudioCallbackTest : public ::testing::Test {
       EXPECT_EQ(read_buffer, samples);
   }
 
+  TEST_F(AudioCallbackTest, SpecializedCallbacksMatchGeneric) {
+      for (const auto format : {audio::SampleFormat::INT16, audio::SampleFormat::FLOAT32}) {
+          for (const int channels : {1, 2, 4, 8}) {
+              PaStreamCallback* const callback = microphone::select_audio_callback(channels, format);
+              EXPECT_NE(callback, &microphone::AudioCallback);
+
+              const viam::sdk::audio_info info{viam::sdk::audio_codecs::PCM_16, 48000, channels};
+              audio::InputStreamContext generic(info, 2, format);
+              audio::InputStreamContext specialized(info, 2, format);
+              const unsigned long frames = 37;
+              std::vector<uint8_t> input(frames * channels * audio::sample_bytes(format));
+              for (size_t i = 0; i < input.size(); i++) {
+                  input[i] = static_cast<uint8_t>(i * 7);
+              }
+
+              EXPECT_EQ(microphone::AudioCallback(input.data(), nullptr, frames, &mock_time_info, 0, &generic), paContinue);
+              EXPECT_EQ(callback(input.data(), nullptr, frames, &mock_time_info, 0, &specialized), paContinue);
+
+              ASSERT_EQ(specialized.get_write_position(), frames * channels);
+              std::vector<uint8_t> read(input.size());
+              uint64_t read_pos = 0;
+              specialized.read_native(read.data(), static_cast<int>(frames * channels), read_pos);
+              EXPECT_EQ(read, input) << channels << " channels";
+              EXPECT_EQ(generic.get_write_position(), specialized.get_write_position());
+          }
+      }
+      // Other layouts fall back to the generic callback
+      EXPECT_EQ(microphone::select_audio_callback(3, audio::SampleFormat::INT16), &microphone::AudioCallback);
+      EXPECT_EQ(microphone::select_audio_callback(2, audio::SampleFormat::INT32), &microphone::AudioCallback);
+  }
+
+  TEST_F(AudioCallbackTest, MetersCapturedAudio) {
+      // 100 ms at 44.1 kHz through the generic callback, at half scale
+      EXPECT_EQ(call_callback(create_test_samples(4410, 16384)), paContinue);
+      const auto levels = ctx->levels.window(100);
+      EXPECT_EQ(levels.window_ms, 100);
+      ASSERT_EQ(levels.channels.size(), 1);
+      EXPECT_NEAR(levels.channels[0].peak_dbfs, -6.02, 0.01);
+      EXPECT_NEAR(levels.channels[0].rms_dbfs, -6.02, 0.01);
+
+      // The specialized stereo float callback meters each channel
+      audio::InputStreamContext stereo(viam::sdk::audio_info{viam::sdk::audio_codecs::PCM_32_FLOAT, 48000, 2}, 2,
+                                       audio::SampleFormat::FLOAT32);
+      std::vector<float> frames(480 * 2);
+      for (size_t i = 0; i < frames.size(); i += 2) {
+          frames[i] = 0.25f;
+      }
+      PaStreamCallback* const callback = microphone::select_audio_callback(2, audio::SampleFormat::FLOAT32);
+      EXPECT_EQ(callback(frames.data(), nullptr, 480, &mock_time_info, 0, &stereo), paContinue);
+      const auto stereo_levels = stereo.levels.window(10);
+      ASSERT_EQ(stereo_levels.channels.size(), 2);
+      EXPECT_NEAR(stereo_levels.channels[0].rms_dbfs, -12.04, 0.01);
+      EXPECT_EQ(stereo_levels.channels[1].peak_dbfs, audio::levels::FLOOR_DB);
+  }
+
+  TEST_F(AudioCallbackTest, DuplexAppendsPlayedAudioAsReference) {
+      // Stereo playback and mono capture, over a callback long enough to take two passes
+      const unsigned long frames = microphone::DUPLEX_BLOCK_FRAMES + 100;
+      audio::OutputStreamContext output(viam::sdk::audio_info{viam::sdk::audio_codecs::PCM_16, 48000, 2}, 2);
+      std::vector<int16_t> queued(frames * 2);
+      std::vector<int16_t> captured(frames);
+      for (size_t i = 0; i < frames; i++) {
+          queued[2 * i] = static_cast<int16_t>(2 * i);
+          queued[2 * i + 1] = static_cast<int16_t>(4 * i);
+          captured[i] = static_cast<int16_t>(-static_cast<int>(i));
+      }
+      output.write_samples(queued.data(), queued.size());
+      audio::InputStreamContext input(viam::sdk::audio_info{viam::sdk::audio_codecs::PCM_16, 48000, 2}, 2);
+      microphone::DuplexContext duplex(input, output);
+      EXPECT_EQ(duplex.capture_channels, 1);
+
+      std::vector<int16_t> played(frames * 2);
+      EXPECT_EQ(microphone::DuplexCallback(captured.data(), played.data(), frames, &mock_time_info, 0, &duplex), paContinue);
+
+      // The speaker's audio went out, and each captured frame carries its mono mix
+      EXPECT_EQ(played, queued);
+      EXPECT_EQ(output.playback_position.load(), queued.size());
+      ASSERT_EQ(input.get_write_position(), frames * 2);
+      std::vector<int16_t> ring(frames * 2);
+      uint64_t read_pos = 0;
+      input.read_samples(ring.data(), static_cast<int>(ring.size()), read_pos);
+      for (size_t i = 0; i < frames; i++) {
+          ASSERT_EQ(ring[2 * i], captured[i]) << "frame " << i;
+          ASSERT_EQ(ring[2 * i + 1], static_cast<int16_t>(3 * i)) << "frame " << i;
+      }
+
+      // Both halves count it as one callback
+      EXPECT_TRUE(input.first_callback_captured.load());
+      EXPECT_EQ(input.stats->callback_duration_us.count(), 1);
+      EXPECT_EQ(output.stats->callback_duration_us.count(), 1);
+      EXPECT_EQ(input.levels.num_channels(), 2);
+  }
+
+  TEST_F(AudioCallbackTest, DuplexReferenceFollowsRingFormat) {
+      audio::OutputStreamContext output(viam::sdk::audio_info{viam::sdk::audio_codecs::PCM_16, 48000, 1}, 2);
+      const std::vector<int16_t> queued = {16384, -8192};
+      output.write_samples(queued.data(), queued.size());
+      audio::InputStreamContext input(viam::sdk::audio_info{viam::sdk::audio_codecs::PCM_32_FLOAT, 48000, 2}, 2,
+                                      audio::SampleFormat::FLOAT32);
+      microphone::DuplexContext duplex(input, output);
+
+      // Three frames against two queued: the last one plays, and references, silence
+      const std::vector<float> captured = {0.25f, -0.25f, 0.125f};
+      std::vector<int16_t> played(captured.size());
+      EXPECT_EQ(microphone::DuplexCallback(captured.data(), played.data(), captured.size(), &mock_time_info, 0, &duplex), paContinue);
+
+      std::vector<float> ring(captured.size() * 2);
+      uint64_t read_pos = 0;
+      ASSERT_EQ(input.read_native(ring.data(), static_cast<int>(ring.size()), read_pos), static_cast<int>(ring.size()));
+      EXPECT_EQ(ring, (std::vector<float>{0.25f, 0.5f, -0.25f, -0.25f, 0.125f, 0.0f}));
+  }
+
+  TEST_F(AudioCallbackTest, CopiesFloatStreamIntoFloatRing) {
+      ctx = std::make_unique<audio::InputStreamContext>(test_info, 10, audio::SampleFormat::FLOAT32);
+      const std::vector<float> samples = {0.25f, -0.5f, 1.0f, 0.0001f};
+
+      EXPECT_EQ(microphone::AudioCallback(samples.data(), nullptr, samples.size(), &mock_time_info, 0, ctx.get()), paContinue);
+
+      EXPECT_EQ(ctx->get_write_position(), samples.size());
+      std::vector<float> read(samples.size());
+      uint64_t read_pos = 0;
+      ASSERT_EQ(ctx->read_native(read.data(), static_cast<int>(read.size()), read_pos), static_cast<int>(read.size()));
+      EXPECT_EQ(read, samples);
+  }
+
+  TEST_F(AudioCallbackTest, ResyncPadsGapBeforeBlock) {
+      // A stream that started a second ago but only delivered 100 frames before a restart
+      call_callback(create_test_samples(100));
+      ctx->stream_start_time = std::chrono::system_clock::now() - std::chrono::seconds(1);
+      ctx->resync_pending.store(true);
+
+      call_callback(create_test_samples(100, 7));
+
+      EXPECT_FALSE(ctx->resync_pending.load());
+      // The block lands where the clock says it was captured, a second in
+      const uint64_t position = ctx->get_write_position();
+      EXPECT_GE(position, 44100u);
+      EXPECT_LT(position, 44100u + 4410u);
+      std::vector<int16_t> block(100);
+      uint64_t read_pos = position - block.size();
+      ctx->read_samples(block.data(), static_cast<int>(block.size()), read_pos);
+      EXPECT_EQ(block, create_test_samples(100, 7));
+
+      // Only the first callback after the restart resyncs
+      call_callback(create_test_samples(100));
+      EXPECT_EQ(ctx->get_write_position(), position + 100);
+  }
+
   TEST_F(AudioCallbackTest, TracksFirstCallbackTime) {
       std::vector<int16_t> samples = create_test_samples(100);
       EXPECT_FALSE(ctx->first_callback_captured.load());
@@ -1306,6 +2576,16 @@ class AudioCallbackTest : public ::testing::Test {
       EXPECT_EQ(ctx->total_samples_written.load(), 200);
   }
 
+  TEST_F(AudioCallbackTest, RecordsCallbackTiming) {
+      std::vector<int16_t> samples = create_test_samples(100);
+      call_callback(samples);
+      call_callback(samples);
+
+      EXPECT_EQ(ctx->stats->callback_duration_us.count(), 2);
+      EXPECT_EQ(ctx->stats->callback_interval_us.count(), 1);
+      EXPECT_EQ(ctx->stats->callback_jitter_us.count(), 1);
+  }
+
   TEST_F(AudioCallbackTest, HandlesNullInputBuffer) {
       int result = microphone::AudioCallback(
           nullptr,           // null input buffer
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <algorithm>
 #include <viam/sdk/common/instance.hpp>
 #include "mp3_decoder.hpp"
 #include "mp3_encoder.hpp"
@@ -124,6 +125,46 @@ TEST_F(MP3DecoderTest, DecodeInvalidMP3Data) {
     );
 }
 
+TEST_F(MP3DecoderTest, DecodeChunkedMatchesOneShot) {
+    const int sample_rate = 44100;
+    const int num_channels = 2;
+
+    auto encoded_data = encode_to_mp3(create_test_samples(1152 * 2 * 6), sample_rate, num_channels);
+    // Prepend a 20-byte ID3v2 tag; chunking below splits both the tag and the frames
+    std::vector<uint8_t> stream = {'I', 'D', '3', 3, 0, 0, 0, 0, 0, 20};
+    stream.resize(30, 0);
+    stream.insert(stream.end(), encoded_data.begin(), encoded_data.end());
+
+    MP3DecoderContext oneshot_ctx;
+    std::vector<uint8_t> expected;
+    decode_mp3_to_pcm16(oneshot_ctx, stream, expected);
+
+    std::vector<uint8_t> streamed;
+    const size_t chunk_size = 7;
+    for (size_t offset = 0; offset < stream.size(); offset += chunk_size) {
+        const size_t n = std::min(chunk_size, stream.size() - offset);
+        ASSERT_NO_THROW(decode_mp3_chunk(*decoder_ctx_, stream.data() + offset, n, streamed));
+    }
+
+    EXPECT_EQ(decoder_ctx_->sample_rate, sample_rate);
+    EXPECT_EQ(decoder_ctx_->num_channels, num_channels);
+    EXPECT_EQ(streamed, expected);
+}
+
+TEST_F(MP3DecoderTest, DecodeChunkBeforeFirstFrameProducesNothing) {
+    auto encoded_data = encode_to_mp3(create_test_samples(1152), 48000, 1);
+    std::vector<uint8_t> decoded_data;
+
+    // A few bytes of a frame aren't enough to decode anything yet
+    ASSERT_NO_THROW(decode_mp3_chunk(*decoder_ctx_, encoded_data.data(), 4, decoded_data));
+    EXPECT_TRUE(decoded_data.empty());
+    EXPECT_EQ(decoder_ctx_->sample_rate, 0);
+
+    ASSERT_NO_THROW(decode_mp3_chunk(*decoder_ctx_, encoded_data.data() + 4, encoded_data.size() - 4, decoded_data));
+    EXPECT_FALSE(decoded_data.empty());
+    EXPECT_EQ(decoder_ctx_->sample_rate, 48000);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     ::testing::AddGlobalTestEnvironment(new test_utils::AudioTestEnvironment);
@@ -146,6 +146,54 @@ TEST_F(MP3EncoderTest, InitializeDifferentConfigs) {
 }
 
 
+TEST_F(MP3EncoderTest, InitializeVbrAndAbr) {
+    MP3EncoderOptions vbr;
+    vbr.mode = MP3BitrateMode::VBR;
+    vbr.quality = 4;
+    ASSERT_NO_THROW(initialize_mp3_encoder(ctx_, 48000, 2, vbr));
+    EXPECT_NE(ctx_.encoder, nullptr);
+    EXPECT_GT(ctx_.frame_size, 0);
+    cleanup_mp3_encoder(ctx_);
+
+    MP3EncoderOptions abr;
+    abr.mode = MP3BitrateMode::ABR;
+    abr.bitrate_kbps = 128;
+    ASSERT_NO_THROW(initialize_mp3_encoder(ctx_, 44100, 1, abr));
+    EXPECT_NE(ctx_.encoder, nullptr);
+
+    std::vector<uint8_t> output;
+    auto samples = create_test_samples(ctx_.frame_size);
+    EXPECT_NO_THROW(encode_samples_to_mp3(ctx_, samples.data(), samples.size(), 0, output));
+}
+
+TEST_F(MP3EncoderTest, ParseMp3OptionsOverridesDefaults) {
+    MP3EncoderOptions defaults;
+    defaults.bitrate_kbps = 96;
+
+    auto unchanged = parse_mp3_options(vsdk::ProtoStruct{}, defaults);
+    EXPECT_EQ(unchanged, defaults);
+
+    auto parsed = parse_mp3_options(
+        vsdk::ProtoStruct{{"mp3_bitrate", 256.0}, {"mp3_bitrate_mode", std::string("vbr")}, {"mp3_quality", 0.0}}, defaults);
+    EXPECT_EQ(parsed.bitrate_kbps, 256);
+    EXPECT_EQ(parsed.mode, MP3BitrateMode::VBR);
+    EXPECT_EQ(parsed.quality, 0);
+
+    auto settings = mp3_settings_struct(parsed);
+    EXPECT_EQ(*settings.at("mp3_bitrate").get<double>(), 256.0);
+    EXPECT_EQ(*settings.at("mp3_bitrate_mode").get<std::string>(), "vbr");
+    EXPECT_EQ(*settings.at("mp3_quality").get<double>(), 0.0);
+}
+
+TEST_F(MP3EncoderTest, ParseMp3OptionsRejectsInvalidValues) {
+    EXPECT_THROW(parse_mp3_options(vsdk::ProtoStruct{{"mp3_bitrate", 4.0}}), std::invalid_argument);
+    EXPECT_THROW(parse_mp3_options(vsdk::ProtoStruct{{"mp3_bitrate", 512.0}}), std::invalid_argument);
+    EXPECT_THROW(parse_mp3_options(vsdk::ProtoStruct{{"mp3_bitrate", std::string("high")}}), std::invalid_argument);
+    EXPECT_THROW(parse_mp3_options(vsdk::ProtoStruct{{"mp3_bitrate_mode", std::string("lossless")}}), std::invalid_argument);
+    EXPECT_THROW(parse_mp3_options(vsdk::ProtoStruct{{"mp3_quality", 10.0}}), std::invalid_argument);
+}
+
+
 TEST_F(MP3EncoderTest, FlushUninitializedEncoder) {
     std::vector<uint8_t> output;
 
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <viam/sdk/common/instance.hpp>
+#include "audio_codec.hpp"
+#include "opus_decoder.hpp"
+#include "opus_encoder.hpp"
+#include "test_utils.hpp"
+
+using namespace speaker;
+using namespace microphone;
+
+class OpusTest : public ::testing::Test {
+protected:
+    OpusEncoderContext encoder_ctx_;
+
+    void TearDown() override {
+        cleanup_opus_encoder(encoder_ctx_);
+    }
+
+    std::vector<int16_t> create_test_samples(int num_samples) {
+        std::vector<int16_t> samples(num_samples);
+        for (int i = 0; i < num_samples; i++) {
+            samples[i] = static_cast<int16_t>((i % 1000) * 32);
+        }
+        return samples;
+    }
+
+    // Returns the packet lengths found walking the length prefixes of an encoded stream
+    std::vector<size_t> packet_lengths(const std::vector<uint8_t>& encoded) {
+        std::vector<size_t> lengths;
+        size_t offset = 0;
+        while (offset + audio::codec::OPUS_LENGTH_PREFIX_BYTES <= encoded.size()) {
+            const size_t length = encoded[offset] | (encoded[offset + 1] << 8);
+            lengths.push_back(length);
+            offset += audio::codec::OPUS_LENGTH_PREFIX_BYTES + length;
+        }
+        EXPECT_EQ(offset, encoded.size());
+        return lengths;
+    }
+
+    std::vector<uint8_t> encode_frames(int sample_rate, int num_channels, int frames) {
+        initialize_opus_encoder(encoder_ctx_, sample_rate, num_channels);
+        auto samples = create_test_samples(encoder_ctx_.frame_size * num_channels * frames);
+        std::vector<uint8_t> encoded;
+        encode_samples_to_opus(encoder_ctx_, samples.data(), samples.size(), encoded);
+        return encoded;
+    }
+};
+
+TEST_F(OpusTest, InitializeSucceeds) {
+    ASSERT_NO_THROW(initialize_opus_encoder(encoder_ctx_, 48000, 2));
+
+    EXPECT_NE(encoder_ctx_.encoder, nullptr);
+    EXPECT_EQ(encoder_ctx_.sample_rate, 48000);
+    EXPECT_EQ(encoder_ctx_.num_channels, 2);
+    EXPECT_EQ(encoder_ctx_.frame_size, 960);  // 20 ms
+    EXPECT_GT(encoder_ctx_.encoder_delay, 0);
+
+    cleanup_opus_encoder(encoder_ctx_);
+    ASSERT_NO_THROW(initialize_opus_encoder(encoder_ctx_, 16000, 1, 10));
+    EXPECT_EQ(encoder_ctx_.frame_size, 160);
+}
+
+TEST_F(OpusTest, InitializeRejectsUnsupportedFormats) {
+    EXPECT_THROW(initialize_opus_encoder(encoder_ctx_, 44100, 1), std::invalid_argument);
+    EXPECT_THROW(initialize_opus_encoder(encoder_ctx_, 48000, 4), std::invalid_argument);
+}
+
+TEST_F(OpusTest, ParseFrameMs) {
+    EXPECT_EQ(parse_opus_frame_ms(vsdk::ProtoStruct{}), OPUS_DEFAULT_FRAME_MS);
+    EXPECT_EQ(parse_opus_frame_ms(vsdk::ProtoStruct{{"opus_frame_ms", 10.0}}), 10);
+    EXPECT_THROW(parse_opus_frame_ms(vsdk::ProtoStruct{{"opus_frame_ms", 15.0}}), std::invalid_argument);
+    EXPECT_THROW(parse_opus_frame_ms(vsdk::ProtoStruct{{"opus_frame_ms", std::string("20")}}), std::invalid_argument);
+}
+
+TEST_F(OpusTest, EncodeWithoutInitializationThrows) {
+    auto samples = create_test_samples(960);
+    std::vector<uint8_t> output;
+    EXPECT_THROW(encode_samples_to_opus(encoder_ctx_, samples.data(), samples.size(), output), std::runtime_error);
+}
+
+TEST_F(OpusTest, EncodeOnePacketPerFrame) {
+    auto encoded = encode_frames(48000, 1, 5);
+
+    auto lengths = packet_lengths(encoded);
+    ASSERT_EQ(lengths.size(), 5);
+    for (size_t length : lengths) {
+        EXPECT_GT(length, 0);
+    }
+    EXPECT_TRUE(encoder_ctx_.pending.empty());
+}
+
+TEST_F(OpusTest, EncodeBuffersPartialFrames) {
+    initialize_opus_encoder(encoder_ctx_, 16000, 1);
+    const int frame = encoder_ctx_.frame_size;
+    auto samples = create_test_samples(frame * 2);
+
+    std::vector<uint8_t> encoded;
+    encode_samples_to_opus(encoder_ctx_, samples.data(), frame + frame / 2, encoded);
+    EXPECT_EQ(packet_lengths(encoded).size(), 1);
+    EXPECT_EQ(encoder_ctx_.pending.size(), frame / 2);
+
+    encode_samples_to_opus(encoder_ctx_, samples.data() + frame + frame / 2, frame / 2, encoded);
+    EXPECT_EQ(packet_lengths(encoded).size(), 2);
+    EXPECT_TRUE(encoder_ctx_.pending.empty());
+}
+
+TEST_F(OpusTest, DecodeRoundTrip) {
+    auto encoded = encode_frames(16000, 2, 5);
+
+    OpusDecoderContext decoder;
+    std::vector<uint8_t> decoded;
+    decode_opus_chunk(decoder, encoded.data(), encoded.size(), 16000, decoded);
+
+    EXPECT_EQ(decoder.sample_rate, 16000);
+    EXPECT_EQ(decoder.num_channels, 2);
+    EXPECT_EQ(decoded.size(), 5 * 320 * 2 * sizeof(int16_t));
+}
+
+TEST_F(OpusTest, DecodeAtPreferredRate) {
+    auto encoded = encode_frames(16000, 1, 5);
+
+    // Opus decodes to any of its native rates, whatever it was encoded at
+    OpusDecoderContext at_48k;
+    std::vector<uint8_t> decoded;
+    decode_opus_chunk(at_48k, encoded.data(), encoded.size(), 48000, decoded);
+    EXPECT_EQ(at_48k.sample_rate, 48000);
+    EXPECT_EQ(decoded.size(), 5 * 960 * sizeof(int16_t));
+
+    // Rates Opus can't produce fall back to 48 kHz
+    OpusDecoderContext at_44k;
+    decoded.clear();
+    decode_opus_chunk(at_44k, encoded.data(), encoded.size(), 44100, decoded);
+    EXPECT_EQ(at_44k.sample_rate, 48000);
+}
+
+TEST_F(OpusTest, DecodeChunkedMatchesWhole) {
+    auto encoded = encode_frames(24000, 1, 8);
+
+    OpusDecoderContext whole_ctx;
+    std::vector<uint8_t> whole;
+    decode_opus_chunk(whole_ctx, encoded.data(), encoded.size(), 24000, whole);
+
+    // Split at every size from 1 byte up, so prefixes and packets are cut everywhere
+    for (size_t piece : {size_t{1}, size_t{3}, size_t{17}, size_t{100}}) {
+        OpusDecoderContext chunked_ctx;
+        std::vector<uint8_t> chunked;
+        for (size_t offset = 0; offset < encoded.size(); offset += piece) {
+            decode_opus_chunk(chunked_ctx, encoded.data() + offset, std::min(piece, encoded.size() - offset), 24000, chunked);
+        }
+        EXPECT_EQ(chunked, whole) << "piece size " << piece;
+        EXPECT_TRUE(chunked_ctx.pending.empty());
+    }
+}
+
+TEST_F(OpusTest, DecodePartialPacketProducesNothing) {
+    auto encoded = encode_frames(48000, 1, 1);
+
+    OpusDecoderContext decoder;
+    std::vector<uint8_t> decoded;
+    decode_opus_chunk(decoder, encoded.data(), encoded.size() - 1, 48000, decoded);
+
+    EXPECT_TRUE(decoded.empty());
+    EXPECT_EQ(decoder.sample_rate, 0);
+    EXPECT_EQ(decoder.pending.size(), encoded.size() - 1);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(new test_utils::AudioTestEnvironment);
+    return RUN_ALL_TESTS();
+}
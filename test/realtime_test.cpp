@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "audio_buffer.hpp"
+#include "realtime.hpp"
+#include "test_utils.hpp"
+
+using namespace audio::realtime;
+using namespace viam::sdk;
+
+namespace {
+
+double field(const ProtoStruct& s, const std::string& key) {
+    return *s.at(key).get<double>();
+}
+
+bool flag(const ProtoStruct& s, const std::string& key) {
+    return *s.at(key).get<bool>();
+}
+
+// The process's locked memory in kB as the kernel sees it, or -1 where it isn't reported
+long locked_kb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmLck:", 0) == 0) {
+            return std::stol(line.substr(6));
+        }
+    }
+    return -1;
+}
+
+}  // namespace
+
+TEST(RealtimeTest, ParseDefaultsToOff) {
+    const RealtimeOptions options = parse_realtime_options(ProtoStruct{});
+    EXPECT_EQ(options.priority, 0);
+    EXPECT_TRUE(options.cpus.empty());
+    EXPECT_FALSE(options.lock_memory);
+    EXPECT_FALSE(options.enabled());
+}
+
+TEST(RealtimeTest, ParsesAllOptions) {
+    const RealtimeOptions options = parse_realtime_options(ProtoStruct{{"realtime_priority", 70.0},
+                                                                      {"realtime_policy", std::string("rr")},
+                                                                      {"cpu_affinity", ProtoList{2.0, 3.0}},
+                                                                      {"mlock", true}});
+    EXPECT_EQ(options.priority, 70);
+    EXPECT_EQ(options.policy, SchedPolicy::RR);
+    EXPECT_EQ(options.cpus, (std::vector<int>{2, 3}));
+    EXPECT_TRUE(options.lock_memory);
+    EXPECT_TRUE(options.configures_threads());
+}
+
+TEST(RealtimeTest, ParseRejectsInvalidValues) {
+    for (const auto& attrs : {ProtoStruct{{"realtime_priority", 0.0}},
+                              ProtoStruct{{"realtime_priority", 100.0}},
+                              ProtoStruct{{"realtime_priority", 10.5}},
+                              ProtoStruct{{"realtime_priority", std::string("high")}},
+                              ProtoStruct{{"realtime_policy", std::string("idle")}},
+                              ProtoStruct{{"cpu_affinity", ProtoList{}}},
+                              ProtoStruct{{"cpu_affinity", ProtoList{-1.0}}},
+                              ProtoStruct{{"cpu_affinity", 1.0}},
+                              ProtoStruct{{"mlock", 1.0}}}) {
+        EXPECT_THROW(parse_realtime_options(attrs), std::invalid_argument);
+    }
+}
+
+TEST(RealtimeTest, ScopedPriorityIsRestoredAndReported) {
+    int policy_before = 0;
+    sched_param param_before{};
+    ASSERT_EQ(pthread_getschedparam(pthread_self(), &policy_before, &param_before), 0);
+
+    RealtimeOptions options;
+    options.priority = 10;
+    auto settings = std::make_shared<RealtimeSettings>(options);
+    {
+        const ScopedThreadSettings scoped(settings);
+    }
+
+    int policy_after = 0;
+    sched_param param_after{};
+    ASSERT_EQ(pthread_getschedparam(pthread_self(), &policy_after, &param_after), 0);
+    EXPECT_EQ(policy_after, policy_before);
+    EXPECT_EQ(param_after.sched_priority, param_before.sched_priority);
+
+    // Whether SCHED_FIFO is permitted depends on where the test runs; the report must agree
+    // with the failure count either way
+    const auto report = settings->to_struct();
+    EXPECT_EQ(field(report, "threads"), 1);
+    EXPECT_EQ(flag(report, "priority_honored"), field(report, "priority_failures") == 0);
+    EXPECT_EQ(flag(report, "priority_honored"), report.count("last_error") == 0);
+}
+
+#ifdef __linux__
+TEST(RealtimeTest, ScopedAffinityPinsAndRestores) {
+    cpu_set_t before;
+    CPU_ZERO(&before);
+    ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(before), &before), 0);
+    int first_cpu = 0;
+    while (!CPU_ISSET(first_cpu, &before)) {
+        first_cpu++;
+    }
+
+    RealtimeOptions options;
+    options.cpus = {first_cpu};
+    auto settings = std::make_shared<RealtimeSettings>(options);
+    {
+        const ScopedThreadSettings scoped(settings);
+        cpu_set_t during;
+        CPU_ZERO(&during);
+        ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(during), &during), 0);
+        EXPECT_EQ(CPU_COUNT(&during), 1);
+        EXPECT_TRUE(CPU_ISSET(first_cpu, &during));
+    }
+
+    cpu_set_t after;
+    CPU_ZERO(&after);
+    ASSERT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(after), &after), 0);
+    EXPECT_TRUE(CPU_EQUAL(&before, &after));
+    EXPECT_TRUE(flag(settings->to_struct(), "affinity_honored"));
+}
+#endif
+
+TEST(RealtimeTest, NoThreadOptionsLeavesThreadsAlone) {
+    auto settings = std::make_shared<RealtimeSettings>(RealtimeOptions{});
+    {
+        const ScopedThreadSettings scoped(settings);
+    }
+    apply_to_current_thread(settings);
+    apply_to_current_thread(nullptr);
+    EXPECT_EQ(field(settings->to_struct(), "threads"), 0);
+}
+
+TEST(RealtimeTest, LockedRegionTracksLockedBytes) {
+    RealtimeOptions options;
+    options.lock_memory = true;
+    auto settings = std::make_shared<RealtimeSettings>(options);
+    std::vector<uint8_t> buffer(4096);
+    {
+        LockedRegion region;
+        lock_vector(region, buffer, settings);
+        const auto report = settings->to_struct();
+        // RLIMIT_MEMLOCK may refuse even a page; then it's reported instead
+        if (flag(report, "mlock_honored")) {
+            EXPECT_EQ(field(report, "locked_bytes"), buffer.capacity());
+            EXPECT_EQ(region.locked_bytes(), buffer.capacity());
+            // Same range again doesn't relock
+            lock_vector(region, buffer, settings);
+            EXPECT_EQ(field(settings->to_struct(), "locked_bytes"), buffer.capacity());
+        } else {
+            EXPECT_EQ(field(report, "mlock_failures"), 1);
+            EXPECT_EQ(region.locked_bytes(), 0);
+        }
+    }
+    EXPECT_EQ(field(settings->to_struct(), "locked_bytes"), 0);
+}
+
+TEST(RealtimeTest, LockedRegionsSharingAPageUnlockItOnlyOnce) {
+    RealtimeOptions options;
+    options.lock_memory = true;
+    auto settings = std::make_shared<RealtimeSettings>(options);
+    const auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    std::vector<uint8_t> buffer(page * 2);
+    // Two small ranges on the same page, like two scratch vectors from one heap page
+    const auto aligned = (reinterpret_cast<uintptr_t>(buffer.data()) + page - 1) & ~(page - 1);
+    const auto* first = reinterpret_cast<const uint8_t*>(aligned);
+    const uint8_t* second = first + 64;
+
+    LockedRegion a;
+    LockedRegion b;
+    a.update(first, 32, settings);
+    b.update(second, 32, settings);
+    if (!flag(settings->to_struct(), "mlock_honored")) {
+        GTEST_SKIP() << "mlock refused by RLIMIT_MEMLOCK";
+    }
+    EXPECT_EQ(page_lock_count(first), 2);
+    const long both_kb = locked_kb();
+
+    a.reset();
+    EXPECT_EQ(page_lock_count(second), 1);
+    EXPECT_EQ(b.locked_bytes(), 32);
+    if (both_kb >= 0) {
+        // Still locked in the kernel, not just in the count
+        EXPECT_EQ(locked_kb(), both_kb);
+    }
+
+    b.reset();
+    EXPECT_EQ(page_lock_count(second), 0);
+    if (both_kb >= 0) {
+        EXPECT_LT(locked_kb(), both_kb);
+    }
+    EXPECT_EQ(field(settings->to_struct(), "locked_bytes"), 0);
+}
+
+TEST(RealtimeTest, LockedRegionIsANoOpWithoutMlock) {
+    auto settings = std::make_shared<RealtimeSettings>(RealtimeOptions{});
+    std::vector<uint8_t> buffer(4096);
+    LockedRegion region;
+    lock_vector(region, buffer, settings);
+    lock_vector(region, buffer, nullptr);
+    EXPECT_EQ(region.locked_bytes(), 0);
+}
+
+TEST(RealtimeTest, AudioBufferLocksItsRing) {
+    RealtimeOptions options;
+    options.lock_memory = true;
+    auto settings = std::make_shared<RealtimeSettings>(options);
+    {
+        audio::AudioBuffer buffer(audio_info{audio_codecs::PCM_16, 8000, 1}, audio::MIN_BUFFER_SECONDS);
+        buffer.lock_ring(settings);
+        const auto report = settings->to_struct();
+        if (flag(report, "mlock_honored")) {
+            EXPECT_EQ(field(report, "locked_bytes"), buffer.memory_bytes());
+        }
+    }
+    EXPECT_EQ(field(settings->to_struct(), "locked_bytes"), 0);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(new test_utils::AudioTestEnvironment);
+    return RUN_ALL_TESTS();
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include <vector>
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <viam/sdk/common/instance.hpp>
 #include "test_utils.hpp"
@@ -61,13 +63,199 @@ TEST_F(ConvertChannelsTest, MonoToStereoSingleSample) {
     EXPECT_EQ(output, expected);
 }
 
-TEST_F(ConvertChannelsTest, UnsupportedConversionThrows) {
+TEST_F(ConvertChannelsTest, InvalidChannelCountThrows) {
     const std::vector<int16_t> input = {100, 200, 300};
     std::vector<int16_t> output;
 
-    EXPECT_THROW(convert_channels(input.data(), input.size(), 1, 3, output), std::invalid_argument);
-    EXPECT_THROW(convert_channels(input.data(), input.size(), 3, 1, output), std::invalid_argument);
-    EXPECT_THROW(convert_channels(input.data(), input.size(), 2, 2, output), std::invalid_argument);
+    EXPECT_THROW(convert_channels(input.data(), input.size(), 0, 2, output), std::invalid_argument);
+    EXPECT_THROW(convert_channels(input.data(), input.size(), 2, 0, output), std::invalid_argument);
+    EXPECT_THROW(convert_channels(input.data(), input.size(), -1, 1, output), std::invalid_argument);
+}
+
+TEST_F(ConvertChannelsTest, SameChannelCountIsIdentity) {
+    const std::vector<int16_t> stereo = {100, -200, INT16_MIN, INT16_MAX};
+    std::vector<int16_t> output;
+
+    convert_channels(stereo.data(), stereo.size(), 2, 2, output);
+
+    EXPECT_EQ(output, stereo);
+}
+
+TEST_F(ConvertChannelsTest, QuadToStereoAveragesPairs) {
+    // Frames of (ch0, ch1, ch2, ch3); L = avg(ch0, ch2), R = avg(ch1, ch3)
+    const std::vector<int16_t> quad = {100, 200, 300, 400, -10, -20, -31, -40};
+    std::vector<int16_t> output;
+
+    convert_channels(quad.data(), quad.size(), 4, 2, output);
+
+    const std::vector<int16_t> expected = {200, 300, -20, -30};
+    EXPECT_EQ(output, expected);
+}
+
+TEST_F(ConvertChannelsTest, SixChannelsToMonoAveragesAll) {
+    const std::vector<int16_t> input = {600, 600, 600, 600, 600, 600, 6, 0, 0, 0, 0, 0};
+    std::vector<int16_t> output;
+
+    convert_channels(input.data(), input.size(), 6, 1, output);
+
+    const std::vector<int16_t> expected = {600, 1};
+    EXPECT_EQ(output, expected);
+}
+
+TEST_F(ConvertChannelsTest, StereoToQuadRepeatsChannels) {
+    const std::vector<int16_t> stereo = {1, 2, 3, 4};
+    std::vector<int16_t> output;
+
+    convert_channels(stereo.data(), stereo.size(), 2, 4, output);
+
+    const std::vector<int16_t> expected = {1, 2, 1, 2, 3, 4, 3, 4};
+    EXPECT_EQ(output, expected);
+}
+
+TEST_F(ConvertChannelsTest, MonoToThreeChannelsDuplicates) {
+    const std::vector<int16_t> mono = {7, -8};
+    std::vector<int16_t> output;
+
+    convert_channels(mono.data(), mono.size(), 1, 3, output);
+
+    const std::vector<int16_t> expected = {7, 7, 7, -8, -8, -8};
+    EXPECT_EQ(output, expected);
+}
+
+TEST_F(ConvertChannelsTest, CustomMatrixAppliesGainsAndSaturates) {
+    // Swap L/R, and mix a boosted sum into a third channel that saturates
+    const ChannelMatrix matrix{2, 3, {0.0f, 1.0f, 1.0f, 0.0f, 2.0f, 2.0f}};
+    const std::vector<int16_t> stereo = {1000, -2000, 20000, 20000};
+    std::vector<int16_t> output;
+
+    convert_channels(stereo.data(), stereo.size(), matrix, output);
+
+    const std::vector<int16_t> expected = {-2000, 1000, -2000, 20000, 20000, INT16_MAX};
+    EXPECT_EQ(output, expected);
+}
+
+TEST_F(ConvertChannelsTest, MixChannelsWritesIntoCallerBuffer) {
+    const std::vector<int16_t> stereo = {100, 200, 300, 400};
+    std::vector<int16_t> output(3, -1);
+
+    mix_channels(stereo.data(), stereo.size(), default_channel_matrix(2, 1), output.data());
+
+    // Only the two output frames are written
+    const std::vector<int16_t> expected = {150, 350, -1};
+    EXPECT_EQ(output, expected);
+}
+
+TEST_F(ConvertChannelsTest, DefaultShapesMatchPerFrameMix) {
+    // Long enough for the vector kernels, with a tail they leave to the scalar loop
+    std::vector<int16_t> input(6 * 37);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = static_cast<int16_t>((i * 7919) % 65536 - 32768);
+    }
+    std::vector<int16_t> output;
+
+    convert_channels(input.data(), input.size(), 1, 2, output);
+    for (size_t i = 0; i < input.size(); i++) {
+        ASSERT_EQ(output[i * 2], input[i]);
+        ASSERT_EQ(output[i * 2 + 1], input[i]);
+    }
+
+    convert_channels(input.data(), input.size(), 2, 1, output);
+    for (size_t f = 0; f < input.size() / 2; f++) {
+        ASSERT_EQ(output[f], (input[f * 2] + input[f * 2 + 1]) / 2) << "frame " << f;
+    }
+
+    // 1/3 isn't exact in float; the average still is
+    convert_channels(input.data(), input.size(), 3, 1, output);
+    for (size_t f = 0; f < input.size() / 3; f++) {
+        ASSERT_EQ(output[f], (input[f * 3] + input[f * 3 + 1] + input[f * 3 + 2]) / 3) << "frame " << f;
+    }
+}
+
+TEST(ResampleQualityTest, ParsesAllProfileNames) {
+    for (auto quality : {ResampleQuality::Quick, ResampleQuality::Low, ResampleQuality::Medium, ResampleQuality::High,
+                         ResampleQuality::VeryHigh}) {
+        EXPECT_EQ(parse_resample_quality(resample_quality_name(quality)), quality);
+    }
+    EXPECT_THROW(parse_resample_quality("best"), std::invalid_argument);
+}
+
+TEST(ResampleQualityTest, RecipeNameIncludesPhase) {
+    EXPECT_EQ(soxr_recipe_name(ResampleOptions{}), "SOXR_HQ");
+    EXPECT_EQ(soxr_recipe_name(ResampleOptions{ResampleQuality::Quick, true}), "SOXR_QQ | SOXR_MINIMUM_PHASE");
+}
+
+TEST(ResampleQualityTest, QuickProfileStillProducesExpectedLength) {
+    std::vector<int16_t> input(4410, 100);
+    std::vector<int16_t> output;
+    resample_audio(44100, 16000, 1, input.data(), input.size(), output, ResampleOptions{ResampleQuality::Quick, false});
+    EXPECT_EQ(output.size(), 1600u);
+}
+
+class StreamingResamplerTest : public ::testing::Test {
+protected:
+    static std::vector<int16_t> MakeSine(size_t frames, int channels) {
+        std::vector<int16_t> samples(frames * channels);
+        for (size_t f = 0; f < frames; f++) {
+            for (int c = 0; c < channels; c++) {
+                samples[f * channels + c] = static_cast<int16_t>(10000 * std::sin(f * 0.05));
+            }
+        }
+        return samples;
+    }
+
+    // Feeds input through the resampler in chunks of chunk_frames and returns everything
+    // it produced, including the final flush.
+    static std::vector<int16_t> Run(StreamingResampler& resampler, const std::vector<int16_t>& input, int channels, size_t chunk_frames) {
+        std::vector<int16_t> all;
+        std::vector<int16_t> out;
+        for (size_t offset = 0; offset < input.size(); offset += chunk_frames * channels) {
+            const size_t count = std::min(chunk_frames * channels, input.size() - offset);
+            resampler.process(input.data() + offset, count, out);
+            all.insert(all.end(), out.begin(), out.end());
+        }
+        resampler.flush(out);
+        all.insert(all.end(), out.begin(), out.end());
+        return all;
+    }
+};
+
+TEST_F(StreamingResamplerTest, TotalLengthMatchesOneshot) {
+    const int channels = 2;
+    const auto input = MakeSine(4410, channels);
+
+    StreamingResampler resampler(44100, 48000, channels);
+    const auto streamed = Run(resampler, input, channels, 441);
+
+    std::vector<int16_t> oneshot;
+    resample_audio(44100, 48000, channels, input.data(), input.size(), oneshot);
+    EXPECT_EQ(streamed.size(), oneshot.size());
+}
+
+TEST_F(StreamingResamplerTest, ChunkBoundariesDoNotChangeOutput) {
+    const int channels = 1;
+    const auto input = MakeSine(16000, channels);
+
+    StreamingResampler whole(16000, 48000, channels);
+    StreamingResampler chunked(16000, 48000, channels);
+    const auto whole_out = Run(whole, input, channels, input.size());
+    const auto chunked_out = Run(chunked, input, channels, 160);
+
+    EXPECT_EQ(whole_out, chunked_out);
+}
+
+TEST_F(StreamingResamplerTest, ReusableAfterFlushAndReset) {
+    const int channels = 1;
+    const auto input = MakeSine(4800, channels);
+
+    StreamingResampler resampler(48000, 16000, channels);
+    const auto first = Run(resampler, input, channels, 480);
+    const auto second = Run(resampler, input, channels, 480);
+    EXPECT_EQ(first, second);
+
+    std::vector<int16_t> out;
+    resampler.process(input.data(), input.size(), out);
+    resampler.reset();
+    EXPECT_EQ(Run(resampler, input, channels, 480), first);
 }
 
 int main(int argc, char** argv) {
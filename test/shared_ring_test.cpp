@@ -0,0 +1,211 @@
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "audio_stream.hpp"
+#include "shared_ring.hpp"
+#include "test_utils.hpp"
+
+using audio::shm::RingHeader;
+using audio::shm::SharedRing;
+
+namespace {
+
+// Unique per test process, so parallel runs don't trip over each other's rings
+std::string test_name(const std::string& suffix) {
+    return audio::shm::ring_name("shared-ring-test-" + std::to_string(::getpid()) + "-" + suffix);
+}
+
+// Maps a ring the way a reader in another process would: by name, read-only
+class Reader {
+   public:
+    explicit Reader(const std::string& name) {
+        fd_ = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd_ < 0) {
+            return;
+        }
+        // Map the header first to learn how big the whole thing is
+        void* header = ::mmap(nullptr, audio::shm::RING_HEADER_BYTES, PROT_READ, MAP_SHARED, fd_, 0);
+        const auto* peek = static_cast<const RingHeader*>(header);
+        size_ = peek->header_bytes + peek->ring_samples * peek->sample_bytes;
+        ::munmap(header, audio::shm::RING_HEADER_BYTES);
+        map_ = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+    }
+    ~Reader() {
+        if (map_ && map_ != MAP_FAILED) {
+            ::munmap(map_, size_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    bool ok() const {
+        return fd_ >= 0 && map_ && map_ != MAP_FAILED;
+    }
+    const RingHeader& header() const {
+        return *static_cast<const RingHeader*>(map_);
+    }
+
+    // The README's reader protocol: copies count int16 samples from position, or returns false
+    // if the writer overwrote them meanwhile
+    bool read(uint64_t position, size_t count, std::vector<int16_t>& out) const {
+        const RingHeader& h = header();
+        if (position + count > h.cursor.write_position.load(std::memory_order_acquire)) {
+            return false;
+        }
+        const auto* ring = reinterpret_cast<const int16_t*>(static_cast<const uint8_t*>(map_) + h.header_bytes);
+        out.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            out[i] = ring[(position + i) % h.ring_samples];
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return h.cursor.write_reserved.load(std::memory_order_relaxed) <= position + h.ring_samples;
+    }
+
+   private:
+    int fd_ = -1;
+    void* map_ = nullptr;
+    size_t size_ = 0;
+};
+
+bool name_exists(const std::string& name) {
+    const int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    ::close(fd);
+    return true;
+}
+
+}  // namespace
+
+class SharedRingTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        context_ = std::make_shared<audio::InputStreamContext>(viam::sdk::audio_info{viam::sdk::audio_codecs::PCM_16, 16000, 2}, 2);
+    }
+
+    std::shared_ptr<audio::InputStreamContext> context_;
+};
+
+TEST_F(SharedRingTest, HeaderDescribesTheRing) {
+    const std::string name = test_name("header");
+    context_->shared_ring = std::make_unique<SharedRing>(name, *context_);
+
+    Reader reader(name);
+    ASSERT_TRUE(reader.ok());
+    const RingHeader& header = reader.header();
+    EXPECT_EQ(std::memcmp(header.magic, audio::shm::RING_MAGIC, sizeof(audio::shm::RING_MAGIC)), 0);
+    EXPECT_EQ(header.version, audio::shm::RING_VERSION);
+    EXPECT_EQ(header.header_bytes, audio::shm::RING_HEADER_BYTES);
+    EXPECT_EQ(header.sample_rate, 16000u);
+    EXPECT_EQ(header.num_channels, 2u);
+    EXPECT_EQ(header.sample_format, 0u);
+    EXPECT_EQ(header.sample_bytes, 2u);
+    EXPECT_EQ(header.ring_samples, context_->ring_size);
+    EXPECT_EQ(header.capacity_samples, static_cast<uint64_t>(context_->buffer_capacity));
+    EXPECT_EQ(header.cursor.write_position.load(), 0u);
+    EXPECT_EQ(header.cursor.stream_start_ns.load(), 0);
+    EXPECT_EQ(header.closed.load(), 0u);
+    EXPECT_EQ(context_->shared_ring->size, audio::shm::RING_HEADER_BYTES + context_->memory_bytes());
+}
+
+TEST_F(SharedRingTest, ReaderSeesWrittenSamples) {
+    const std::string name = test_name("samples");
+    context_->shared_ring = std::make_unique<SharedRing>(name, *context_);
+    Reader reader(name);
+    ASSERT_TRUE(reader.ok());
+
+    std::vector<int16_t> block(1000);
+    std::iota(block.begin(), block.end(), int16_t{1});
+    context_->write_samples(block.data(), block.size());
+    EXPECT_EQ(reader.header().cursor.write_position.load(), block.size());
+
+    std::vector<int16_t> copied;
+    ASSERT_TRUE(reader.read(0, block.size(), copied));
+    EXPECT_EQ(copied, block);
+
+    // The process's own readers still work off the same ring
+    std::vector<int16_t> local(block.size());
+    uint64_t position = 0;
+    EXPECT_EQ(context_->read_samples(local.data(), static_cast<int>(local.size()), position), static_cast<int>(block.size()));
+    EXPECT_EQ(local, block);
+}
+
+TEST_F(SharedRingTest, ReaderDetectsOverwrittenSamples) {
+    const std::string name = test_name("lapped");
+    context_->shared_ring = std::make_unique<SharedRing>(name, *context_);
+    Reader reader(name);
+    ASSERT_TRUE(reader.ok());
+
+    // Write a ring and a half: the first half ring is gone
+    const size_t total = context_->ring_size + context_->ring_size / 2;
+    std::vector<int16_t> block(context_->ring_size / 2, 7);
+    for (size_t written = 0; written < total; written += block.size()) {
+        context_->write_samples(block.data(), block.size());
+    }
+    std::vector<int16_t> copied;
+    EXPECT_FALSE(reader.read(0, 100, copied));
+    EXPECT_TRUE(reader.read(total - 100, 100, copied));
+}
+
+TEST_F(SharedRingTest, ClosingRemovesTheName) {
+    const std::string name = test_name("close");
+    context_->shared_ring = std::make_unique<SharedRing>(name, *context_);
+    Reader reader(name);
+    ASSERT_TRUE(reader.ok());
+
+    context_->shared_ring.reset();
+    EXPECT_FALSE(name_exists(name));
+    // A reader that still has it mapped is told to look again
+    EXPECT_EQ(reader.header().closed.load(), 1u);
+    EXPECT_EQ(context_->shared_cursor, nullptr);
+}
+
+TEST_F(SharedRingTest, NewerRingKeepsTheName) {
+    const std::string name = test_name("reconfigure");
+    context_->shared_ring = std::make_unique<SharedRing>(name, *context_);
+
+    // A reconfigure builds the new microphone before the old one is destroyed
+    auto replacement = std::make_shared<audio::InputStreamContext>(viam::sdk::audio_info{viam::sdk::audio_codecs::PCM_16, 48000, 1}, 2);
+    replacement->shared_ring = std::make_unique<SharedRing>(name, *replacement);
+    context_->shared_ring.reset();
+
+    Reader reader(name);
+    ASSERT_TRUE(reader.ok());
+    EXPECT_EQ(reader.header().sample_rate, 48000u);
+    EXPECT_EQ(reader.header().closed.load(), 0u);
+}
+
+TEST_F(SharedRingTest, ExportsTheNativeFormat) {
+    auto context = std::make_shared<audio::InputStreamContext>(
+        viam::sdk::audio_info{viam::sdk::audio_codecs::PCM_16, 16000, 1}, 2, audio::SampleFormat::FLOAT32);
+    const std::string name = test_name("float");
+    context->shared_ring = std::make_unique<SharedRing>(name, *context);
+
+    const std::vector<float> block = {0.5f, -0.25f, 1.0f};
+    context->write_native(block.data(), block.size());
+
+    Reader reader(name);
+    ASSERT_TRUE(reader.ok());
+    EXPECT_EQ(reader.header().sample_format, 2u);
+    EXPECT_EQ(reader.header().sample_bytes, 4u);
+    const auto* ring = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(&reader.header()) + reader.header().header_bytes);
+    EXPECT_EQ(ring[0], 0.5f);
+    EXPECT_EQ(ring[1], -0.25f);
+    EXPECT_EQ(ring[2], 1.0f);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(new test_utils::AudioTestEnvironment);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+#include "silence_gate.hpp"
+#include "test_utils.hpp"
+
+using audio::silence::GateOptions;
+using audio::silence::SilenceGate;
+using viam::sdk::ProtoStruct;
+
+namespace {
+
+// 1000 samples per second, so one sample is a millisecond
+constexpr uint64_t SAMPLES_PER_SECOND = 1000;
+constexpr uint64_t CHUNK = 100;
+constexpr double LOUD = -10;
+constexpr double QUIET = -80;
+
+struct Span {
+    uint64_t start;
+    uint64_t end;
+    bool gap;
+
+    bool operator==(const Span& other) const {
+        return start == other.start && end == other.end && gap == other.gap;
+    }
+};
+
+// Drives a gate the way SharedEncoder::produce_chunk does over chunks with the given levels,
+// returning what would be published: encoded chunks and reported gaps, in order
+std::vector<Span> run(SilenceGate& gate, const std::vector<double>& levels) {
+    std::vector<Span> published;
+    uint64_t position = 0;
+    while (position + CHUNK <= levels.size() * CHUNK) {
+        const uint64_t start = position;
+        const uint64_t end = position + CHUNK;
+        const auto decision = gate.next(start, end, levels[start / CHUNK]);
+        switch (decision.action) {
+            case SilenceGate::Action::ENCODE:
+                published.push_back({start, end, false});
+                position = end;
+                break;
+            case SilenceGate::Action::GAP:
+                published.push_back({decision.gap_start, decision.gap_end, true});
+                position = decision.resume;
+                break;
+            case SilenceGate::Action::SKIP:
+                position = decision.resume;
+                break;
+        }
+    }
+    return published;
+}
+
+GateOptions options(int hangover_ms, int preroll_ms) {
+    GateOptions gate_options;
+    gate_options.enabled = true;
+    gate_options.threshold_db = -40;
+    gate_options.hangover_ms = hangover_ms;
+    gate_options.preroll_ms = preroll_ms;
+    return gate_options;
+}
+
+}  // namespace
+
+TEST(SilenceGateTest, OpensWithPrerollAndClosesAfterHangover) {
+    SilenceGate gate(options(200, 100), CHUNK, SAMPLES_PER_SECOND);
+    // Quiet 0-4, loud 5, quiet 6-11
+    std::vector<double> levels(12, QUIET);
+    levels[5] = LOUD;
+
+    const std::vector<Span> expected = {
+        {0, 400, true},     // the silence before the pre-roll
+        {400, 500, false},  // pre-roll
+        {500, 600, false},  // the loud chunk
+        {600, 700, false},  // hangover
+        {700, 800, false},
+    };
+    EXPECT_EQ(run(gate, levels), expected);
+    EXPECT_FALSE(gate.is_open());
+}
+
+TEST(SilenceGateTest, LongSilenceIsReportedPeriodically) {
+    SilenceGate gate(options(0, 100), CHUNK, SAMPLES_PER_SECOND);
+    const auto published = run(gate, std::vector<double>(35, QUIET));
+
+    // Every second, holding back the pre-roll; nothing is ever encoded
+    const std::vector<Span> expected = {{0, 1000, true}, {1000, 2000, true}, {2000, 3000, true}};
+    EXPECT_EQ(published, expected);
+}
+
+TEST(SilenceGateTest, LoudStartNeedsNoGap) {
+    SilenceGate gate(options(0, 300), CHUNK, SAMPLES_PER_SECOND);
+    const std::vector<Span> expected = {{0, 100, false}, {100, 200, false}};
+    EXPECT_EQ(run(gate, {LOUD, LOUD, QUIET}), expected);
+}
+
+TEST(SilenceGateTest, PrerollStopsAtTheLastPublishedChunk) {
+    SilenceGate gate(options(0, 300), CHUNK, SAMPLES_PER_SECOND);
+    // Loud, quiet for 2, loud again: the pre-roll only replays the two quiet chunks
+    const std::vector<Span> expected = {{0, 100, false}, {100, 200, false}, {200, 300, false}, {300, 400, false}};
+    EXPECT_EQ(run(gate, {LOUD, QUIET, QUIET, LOUD}), expected);
+}
+
+TEST(SilenceGateTest, HangoverAndPrerollRoundUpToWholeChunks) {
+    // 150 ms of hangover is two 100 ms chunks, 50 ms of pre-roll is one
+    SilenceGate gate(options(150, 50), CHUNK, SAMPLES_PER_SECOND);
+    const auto published = run(gate, {QUIET, QUIET, LOUD, QUIET, QUIET, QUIET});
+    const std::vector<Span> expected = {{0, 100, true}, {100, 200, false}, {200, 300, false}, {300, 400, false}, {400, 500, false}};
+    EXPECT_EQ(published, expected);
+}
+
+TEST(SilenceGateTest, PublishedSpansTileTheStream) {
+    std::mt19937 rng(7);
+    std::bernoulli_distribution loud(0.2);
+    std::vector<double> levels(2000);
+    for (auto& level : levels) {
+        level = loud(rng) ? LOUD : QUIET;
+    }
+
+    SilenceGate gate(options(300, 200), CHUNK, SAMPLES_PER_SECOND);
+    const auto published = run(gate, levels);
+    ASSERT_FALSE(published.empty());
+    uint64_t encoded = 0;
+    for (size_t i = 0; i < published.size(); i++) {
+        const uint64_t expected_start = i == 0 ? 0 : published[i - 1].end;
+        EXPECT_EQ(published[i].start, expected_start) << "span " << i;
+        EXPECT_LT(published[i].start, published[i].end);
+        if (!published[i].gap) {
+            encoded++;
+        } else {
+            // No loud chunk is ever skipped
+            for (uint64_t chunk = published[i].start / CHUNK; chunk < published[i].end / CHUNK; chunk++) {
+                EXPECT_EQ(levels[chunk], QUIET) << "chunk " << chunk << " inside a gap";
+            }
+        }
+    }
+    EXPECT_LT(encoded, levels.size());
+}
+
+TEST(SilenceGateTest, ResetStartsClosedOnTheNextChunk) {
+    SilenceGate gate(options(1000, 0), CHUNK, SAMPLES_PER_SECOND);
+    EXPECT_EQ(gate.next(0, 100, LOUD).action, SilenceGate::Action::ENCODE);
+    EXPECT_TRUE(gate.is_open());
+
+    gate.reset();
+    EXPECT_FALSE(gate.is_open());
+    const auto decision = gate.next(5000, 5100, QUIET);
+    EXPECT_EQ(decision.action, SilenceGate::Action::SKIP);
+    EXPECT_EQ(decision.resume, 5100);
+}
+
+TEST(SilenceGateTest, RmsLevel) {
+    const std::vector<int16_t> full_scale = {32767, -32767, 32767, -32767};
+    EXPECT_NEAR(audio::silence::rms_dbfs(full_scale.data(), full_scale.size(), audio::SampleFormat::INT16), 0, 0.01);
+
+    const std::vector<int16_t> zeros(64, 0);
+    EXPECT_EQ(audio::silence::rms_dbfs(zeros.data(), zeros.size(), audio::SampleFormat::INT16), audio::silence::SILENT_DB);
+
+    const std::vector<float> tenth = {0.1f, -0.1f};
+    EXPECT_NEAR(audio::silence::rms_dbfs(tenth.data(), tenth.size(), audio::SampleFormat::FLOAT32), -20, 0.01);
+
+    const std::vector<int32_t> hundredth = {21474836, -21474836};
+    EXPECT_NEAR(audio::silence::rms_dbfs(hundredth.data(), hundredth.size(), audio::SampleFormat::INT32), -40, 0.01);
+}
+
+TEST(SilenceGateTest, ParseOptions) {
+    const GateOptions defaults = audio::silence::parse_gate_options(ProtoStruct{});
+    EXPECT_FALSE(defaults.enabled);
+    EXPECT_EQ(defaults.hangover_ms, audio::silence::DEFAULT_HANGOVER_MS);
+    EXPECT_EQ(defaults.preroll_ms, audio::silence::DEFAULT_PREROLL_MS);
+
+    const GateOptions configured = audio::silence::parse_gate_options(
+        ProtoStruct{{"silence_threshold_db", -45.0}, {"silence_hangover_ms", 500.0}, {"silence_preroll_ms", 0.0}});
+    EXPECT_TRUE(configured.enabled);
+    EXPECT_EQ(configured.threshold_db, -45.0);
+    EXPECT_EQ(configured.hangover_ms, 500);
+    EXPECT_EQ(configured.preroll_ms, 0);
+
+    // Keys layer over the defaults passed in, like get_audio's extra over the attributes
+    const GateOptions overridden = audio::silence::parse_gate_options(ProtoStruct{{"silence_hangover_ms", 100.0}}, configured);
+    EXPECT_TRUE(overridden.enabled);
+    EXPECT_EQ(overridden.threshold_db, -45.0);
+    EXPECT_EQ(overridden.hangover_ms, 100);
+
+    for (const auto& attrs : {ProtoStruct{{"silence_threshold_db", 3.0}},
+                              ProtoStruct{{"silence_threshold_db", -100.0}},
+                              ProtoStruct{{"silence_threshold_db", std::string("-40")}},
+                              ProtoStruct{{"silence_hangover_ms", -1.0}},
+                              ProtoStruct{{"silence_hangover_ms", 20000.0}},
+                              ProtoStruct{{"silence_preroll_ms", 1500.0}},
+                              ProtoStruct{{"silence_preroll_ms", 12.5}}}) {
+        EXPECT_THROW(audio::silence::parse_gate_options(attrs), std::invalid_argument);
+    }
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(new test_utils::AudioTestEnvironment);
+    return RUN_ALL_TESTS();
+}
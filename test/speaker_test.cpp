@@ -4,11 +4,17 @@
 
 #include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <thread>
 #include "speaker.hpp"
 #include "test_utils.hpp"
 #include "audio_codec.hpp"
+#include "mp3_decoder.hpp"
 #include "mp3_encoder.hpp"
+#include "opus_decoder.hpp"
+#include "opus_encoder.hpp"
 
 using namespace viam::sdk;
 using namespace audio;
@@ -175,6 +181,126 @@ TEST_F(SpeakerTest, DoCommandSetVolume) {
     ASSERT_TRUE(result.count("volume"));
     EXPECT_EQ(*result.at("volume").get<double>(), 75.0);
     EXPECT_EQ(speaker.volume_, 75);
+    // Software volume is the default
+    EXPECT_EQ(speaker.audio_context_->gain.target(), audio::gain::volume_to_gain_q16(75));
+}
+
+TEST_F(SpeakerTest, DoCommandSetVolumeHardwareLeavesSoftwareGain) {
+    auto attributes = ProtoStruct{};
+    attributes["volume_control"] = std::string("hardware");
+    ResourceConfig config(
+        "rdk:component:speaker", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    Dependencies deps{};
+    speaker::Speaker speaker(deps, config, mock_pa_.get());
+
+    auto result = speaker.do_command(ProtoStruct{{"set_volume", 30.0}});
+
+    EXPECT_EQ(*result.at("volume").get<double>(), 30.0);
+    EXPECT_EQ(speaker.audio_context_->gain.target(), audio::gain::UNITY_Q16);
+}
+
+TEST_F(SpeakerTest, ValidateRejectsUnknownVolumeControl) {
+    auto attributes = ProtoStruct{};
+    attributes["volume_control"] = std::string("alsa");
+    ResourceConfig config(
+        "rdk:component:speaker", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    EXPECT_THROW(speaker::Speaker::validate(config), std::invalid_argument);
+}
+
+TEST_F(SpeakerTest, ConfiguredVolumeAppliesFromFirstCallback) {
+    auto attributes = ProtoStruct{};
+    attributes["volume"] = 50.0;
+    ResourceConfig config(
+        "rdk:component:speaker", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    Dependencies deps{};
+    speaker::Speaker speaker(deps, config, mock_pa_.get());
+
+    const int frames = 64;
+    const int samples = frames * speaker.audio_context_->info.num_channels;
+    std::vector<int16_t> input(samples, 1000);
+    speaker.audio_context_->write_samples(input.data(), input.size());
+
+    std::vector<int16_t> output(samples);
+    speaker::speakerCallback(nullptr, output.data(), frames, nullptr, 0, speaker.audio_context_.get());
+
+    // 50 is 1/8 gain on the cubic curve, with no ramp up from unity
+    for (int16_t sample : output) {
+        EXPECT_EQ(sample, 125);
+    }
+}
+
+TEST_F(SpeakerTest, DoCommandMuteSilencesAndRestores) {
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = 48000.0;
+    attributes["num_channels"] = 1.0;
+    ResourceConfig config(
+        "rdk:component:speaker", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    Dependencies deps{};
+    speaker::Speaker speaker(deps, config, mock_pa_.get());
+
+    // Long enough for the ramp (5 ms) to finish inside each buffer
+    const int frames = 480;
+    auto play_buffer = [&]() {
+        std::vector<int16_t> input(frames, 1000);
+        speaker.audio_context_->write_samples(input.data(), input.size());
+        std::vector<int16_t> output(frames);
+        speaker::speakerCallback(nullptr, output.data(), frames, nullptr, 0, speaker.audio_context_.get());
+        return output;
+    };
+
+    auto result = speaker.do_command(ProtoStruct{{"mute", true}});
+    EXPECT_EQ(*result.at("muted").get<bool>(), true);
+    auto muted = play_buffer();
+    EXPECT_GT(muted.front(), 0) << "mute should fade out, not cut";
+    EXPECT_EQ(muted.back(), 0);
+
+    result = speaker.do_command(ProtoStruct{{"get_volume", true}});
+    EXPECT_EQ(*result.at("muted").get<bool>(), true);
+    EXPECT_EQ(*result.at("volume").get<double>(), 100.0);
+    EXPECT_EQ(*result.at("volume_control").get<std::string>(), "software");
+
+    speaker.do_command(ProtoStruct{{"mute", false}});
+    auto restored = play_buffer();
+    EXPECT_LT(restored.front(), 1000);
+    EXPECT_EQ(restored.back(), 1000);
+
+    EXPECT_THROW(speaker.do_command(ProtoStruct{{"mute", 1.0}}), std::invalid_argument);
+}
+
+TEST_F(SpeakerTest, DoCommandReportsResampleSettings) {
+    auto attributes = ProtoStruct{};
+    attributes["resample_quality"] = std::string("medium");
+    ResourceConfig config(
+        "rdk:component:speaker", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    Dependencies deps{};
+    speaker::Speaker speaker(deps, config, mock_pa_.get());
+
+    auto result = speaker.do_command(ProtoStruct{{"get_resample_settings", true}});
+
+    ASSERT_TRUE(result.count("resample_quality"));
+    EXPECT_EQ(*result.at("resample_quality").get<std::string>(), "medium");
+    EXPECT_EQ(*result.at("resample_low_latency").get<bool>(), false);
+    EXPECT_EQ(*result.at("soxr_recipe").get<std::string>(), "SOXR_MQ");
+}
+
+TEST_F(SpeakerTest, ValidateRejectsNonBooleanResampleLowLatency) {
+    auto attributes = ProtoStruct{};
+    attributes["resample_low_latency"] = 1.0;
+    ResourceConfig config(
+        "rdk:component:speaker", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    EXPECT_THROW(speaker::Speaker::validate(config), std::invalid_argument);
 }
 
 TEST_F(SpeakerTest, DoCommandSetVolumeInvalidType) {
@@ -266,7 +392,7 @@ TEST_F(SpeakerTest, GetPropertiesReturnsCorrectValues) {
 
     EXPECT_EQ(props.sample_rate_hz, sample_rate);
     EXPECT_EQ(props.num_channels, num_channels);
-    ASSERT_EQ(props.supported_codecs.size(), 4);
+    ASSERT_EQ(props.supported_codecs.size(), 5);
 }
 
 TEST_F(SpeakerTest, PlayWithValidPCM16Data) {
@@ -335,7 +461,7 @@ TEST_F(SpeakerTest, PlayWithUnsupportedCodec) {
 
     std::vector<uint8_t> audio_data(4800);
 
-    viam::sdk::audio_info info{"opus", sample_rate, num_channels};
+    viam::sdk::audio_info info{"aac", sample_rate, num_channels};
     ProtoStruct extra{};
 
     EXPECT_THROW({
@@ -438,6 +564,37 @@ TEST_F(SpeakerTest, CallbackWithNoData) {
     }
 }
 
+TEST_F(SpeakerTest, SpecializedCallbacksMatchGeneric) {
+    for (const int channels : {1, 2, 4, 8}) {
+        PaStreamCallback* const callback = speaker::select_speaker_callback(channels, SampleFormat::INT16);
+        EXPECT_NE(callback, &speaker::speakerCallback);
+
+        viam::sdk::audio_info info{viam::sdk::audio_codecs::PCM_16, 48000, channels};
+        audio::OutputStreamContext generic(info, 2);
+        audio::OutputStreamContext specialized(info, 2);
+        // A volume change mid-stream, so the buffer includes a gain ramp
+        generic.gain.set_target(audio::gain::UNITY_Q16 / 3);
+        specialized.gain.set_target(audio::gain::UNITY_Q16 / 3);
+
+        // Less audio than the callback asks for, so the tail is silence-filled
+        const int frames = 300;
+        std::vector<int16_t> input((frames - 37) * channels);
+        for (size_t i = 0; i < input.size(); i++) {
+            input[i] = static_cast<int16_t>(i * 97 - 12000);
+        }
+        generic.write_samples(input.data(), input.size());
+        specialized.write_samples(input.data(), input.size());
+
+        std::vector<int16_t> expected(frames * channels, -1);
+        std::vector<int16_t> output(frames * channels, -1);
+        EXPECT_EQ(speaker::speakerCallback(nullptr, expected.data(), frames, nullptr, 0, &generic), paContinue);
+        EXPECT_EQ(callback(nullptr, output.data(), frames, nullptr, 0, &specialized), paContinue);
+        EXPECT_EQ(output, expected) << channels << " channels";
+        EXPECT_EQ(specialized.playback_position.load(), generic.playback_position.load());
+    }
+    EXPECT_EQ(speaker::select_speaker_callback(3, SampleFormat::INT16), &speaker::speakerCallback);
+}
+
 TEST_F(SpeakerTest, CallbackWithNullUserData) {
     const int frames_per_buffer = 256;
     std::vector<int16_t> output_buffer(frames_per_buffer * 2);
@@ -853,6 +1010,86 @@ TEST_F(SpeakerTest, CodecConversion_ChannelConversion) {
 }
 
 
+TEST_F(SpeakerTest, CodecConversion_QuadToStereoDefaultMix) {
+    const int sample_rate = 48000;
+
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = static_cast<double>(sample_rate);
+    attributes["num_channels"] = 2.0;
+    ResourceConfig config(
+        "rdk:component:audioout", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    Dependencies deps{};
+    speaker::Speaker speaker(deps, config, mock_pa_.get());
+
+    // Two 4-channel frames; the default mix averages channels 0+2 into L and 1+3 into R
+    const std::vector<int16_t> quad = {100, 200, 300, 400, -100, -200, -300, -400};
+    std::vector<uint8_t> audio_data(quad.size() * sizeof(int16_t));
+    std::memcpy(audio_data.data(), quad.data(), audio_data.size());
+
+    viam::sdk::audio_info info{viam::sdk::audio_codecs::PCM_16, sample_rate, 4};
+    speaker.audio_context_->playback_position.store(4);
+    EXPECT_NO_THROW(speaker.play(audio_data, info, ProtoStruct{}));
+
+    std::vector<int16_t> read_buffer(4);
+    uint64_t read_pos = 0;
+    ASSERT_EQ(speaker.audio_context_->read_samples(read_buffer.data(), 4, read_pos), 4);
+    const std::vector<int16_t> expected = {200, 300, -200, -300};
+    EXPECT_EQ(read_buffer, expected);
+}
+
+TEST_F(SpeakerTest, CodecConversion_ConfiguredChannelMatrix) {
+    const int sample_rate = 48000;
+
+    // 4 in -> 2 out: L takes only channel 3, R takes channel 0 at half gain
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = static_cast<double>(sample_rate);
+    attributes["num_channels"] = 2.0;
+    attributes["channel_matrix"] = ProtoList{ProtoList{0.0, 0.0, 0.0, 1.0}, ProtoList{0.5, 0.0, 0.0, 0.0}};
+    ResourceConfig config(
+        "rdk:component:audioout", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    EXPECT_NO_THROW(speaker::Speaker::validate(config));
+    Dependencies deps{};
+    speaker::Speaker speaker(deps, config, mock_pa_.get());
+
+    const std::vector<int16_t> quad = {100, 200, 300, 400};
+    std::vector<uint8_t> audio_data(quad.size() * sizeof(int16_t));
+    std::memcpy(audio_data.data(), quad.data(), audio_data.size());
+
+    viam::sdk::audio_info info{viam::sdk::audio_codecs::PCM_16, sample_rate, 4};
+    speaker.audio_context_->playback_position.store(2);
+    EXPECT_NO_THROW(speaker.play(audio_data, info, ProtoStruct{}));
+
+    std::vector<int16_t> read_buffer(2);
+    uint64_t read_pos = 0;
+    ASSERT_EQ(speaker.audio_context_->read_samples(read_buffer.data(), 2, read_pos), 2);
+    const std::vector<int16_t> expected = {400, 50};
+    EXPECT_EQ(read_buffer, expected);
+}
+
+TEST_F(SpeakerTest, ValidateRejectsMalformedChannelMatrix) {
+    auto make_config = [&](ProtoStruct attributes) {
+        return ResourceConfig(
+            "rdk:component:audioout", "", test_name_, attributes, "",
+            speaker::Speaker::model, LinkConfig{}, log_level::info);
+    };
+
+    EXPECT_THROW(speaker::Speaker::validate(make_config({{"channel_matrix", 1.0}})), std::invalid_argument);
+    EXPECT_THROW(speaker::Speaker::validate(make_config({{"channel_matrix", ProtoList{}}})), std::invalid_argument);
+    // Ragged rows
+    EXPECT_THROW(speaker::Speaker::validate(make_config({{"channel_matrix", ProtoList{ProtoList{1.0, 0.0}, ProtoList{1.0}}}})),
+                 std::invalid_argument);
+    // Non-numeric gain
+    EXPECT_THROW(speaker::Speaker::validate(make_config({{"channel_matrix", ProtoList{ProtoValue(ProtoList{std::string("x")})}}})),
+                 std::invalid_argument);
+    // Row count must match num_channels
+    EXPECT_THROW(speaker::Speaker::validate(make_config({{"num_channels", 2.0}, {"channel_matrix", ProtoList{ProtoValue(ProtoList{0.5, 0.5})}}})),
+                 std::invalid_argument);
+}
+
 TEST_F(SpeakerTest, PlayPCM16WithWavHeader) {
     const int sample_rate = 48000;
     const int num_channels = 1;
@@ -1007,7 +1244,92 @@ TEST_F(SpeakerTest, PlayPCM16WithWavHeader) {
 
 // play_stream tests
 
-TEST_F(SpeakerTest, PlayStream_RejectsMP3) {
+// Encodes num_frames MP3 frames of a ramp at the given format
+static std::vector<uint8_t> encode_test_mp3(int sample_rate, int num_channels, int num_frames) {
+    std::vector<int16_t> pcm(1152 * num_channels * num_frames);
+    for (size_t i = 0; i < pcm.size(); i++) {
+        pcm[i] = static_cast<int16_t>((i % 100) * 100);
+    }
+    microphone::MP3EncoderContext encoder;
+    microphone::initialize_mp3_encoder(encoder, sample_rate, num_channels);
+    std::vector<uint8_t> mp3;
+    microphone::encode_samples_to_mp3(encoder, pcm.data(), pcm.size(), 0, mp3);
+    microphone::flush_mp3_encoder(encoder, mp3);
+    return mp3;
+}
+
+TEST_F(SpeakerTest, Play_MP3_DecodesIncrementally) {
+    const int sample_rate = 48000;
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = static_cast<double>(sample_rate);
+    attributes["num_channels"] = 2.0;
+    ResourceConfig config(
+        "rdk:component:audioout", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    Dependencies deps{};
+    speaker::Speaker speaker(deps, config, mock_pa_.get());
+
+    // Long enough to span many decode slices
+    const auto mp3 = encode_test_mp3(sample_rate, 2, 20);
+    speaker::MP3DecoderContext reference_ctx;
+    std::vector<uint8_t> expected;
+    speaker::decode_mp3_to_pcm16(reference_ctx, mp3, expected);
+    const size_t expected_samples = expected.size() / sizeof(int16_t);
+
+    speaker.audio_context_->playback_position.store(expected_samples);
+    viam::sdk::audio_info info{viam::sdk::audio_codecs::MP3, sample_rate, 2};
+    EXPECT_NO_THROW(speaker.play(mp3, info, ProtoStruct{}));
+    ASSERT_EQ(speaker.audio_context_->get_write_position(), static_cast<uint64_t>(expected_samples));
+
+    std::vector<int16_t> read_buffer(expected_samples);
+    uint64_t read_pos = 0;
+    ASSERT_EQ(speaker.audio_context_->read_samples(read_buffer.data(), expected_samples, read_pos), static_cast<int>(expected_samples));
+    EXPECT_EQ(std::memcmp(read_buffer.data(), expected.data(), expected.size()), 0);
+}
+
+TEST_F(SpeakerTest, Play_MP3_ResamplesToSpeakerRate) {
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = 48000.0;
+    attributes["num_channels"] = 1.0;
+    ResourceConfig config(
+        "rdk:component:audioout", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    Dependencies deps{};
+    speaker::Speaker speaker(deps, config, mock_pa_.get());
+
+    const auto mp3 = encode_test_mp3(24000, 1, 10);
+    speaker::MP3DecoderContext reference_ctx;
+    std::vector<uint8_t> decoded;
+    speaker::decode_mp3_to_pcm16(reference_ctx, mp3, decoded);
+    const size_t expected_samples = decoded.size() / sizeof(int16_t) * 2;
+
+    speaker.audio_context_->playback_position.store(expected_samples);
+    viam::sdk::audio_info info{viam::sdk::audio_codecs::MP3, 24000, 1};
+    EXPECT_NO_THROW(speaker.play(mp3, info, ProtoStruct{}));
+    // The streaming resampler's flush trims the total to exactly the rate ratio
+    EXPECT_EQ(speaker.audio_context_->get_write_position(), static_cast<uint64_t>(expected_samples));
+}
+
+TEST_F(SpeakerTest, Play_MP3_InvalidDataThrows) {
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = 48000.0;
+    attributes["num_channels"] = 1.0;
+    ResourceConfig config(
+        "rdk:component:audioout", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    Dependencies deps{};
+    speaker::Speaker speaker(deps, config, mock_pa_.get());
+
+    const std::vector<uint8_t> garbage(5000, 0x42);
+    viam::sdk::audio_info info{viam::sdk::audio_codecs::MP3, 48000, 1};
+    EXPECT_THROW(speaker.play(garbage, info, ProtoStruct{}), std::runtime_error);
+    EXPECT_EQ(speaker.audio_context_->get_write_position(), 0u);
+}
+
+TEST_F(SpeakerTest, PlayStream_MP3_DecodesAcrossChunks) {
     const int sample_rate = 48000;
     const int num_channels = 1;
 
@@ -1022,14 +1344,146 @@ TEST_F(SpeakerTest, PlayStream_RejectsMP3) {
     Dependencies deps{};
     speaker::Speaker speaker(deps, config, mock_pa_.get());
 
-    viam::sdk::audio_info info{viam::sdk::audio_codecs::MP3, sample_rate, num_channels};
-    ProtoStruct extra{};
+    // Encode a few MP3 frames at the speaker's format, then split into small chunks
+    const auto mp3 = encode_test_mp3(sample_rate, num_channels, 4);
 
-    auto chunk_source = []() -> boost::optional<std::vector<uint8_t>> {
-        return boost::none;
+    speaker::MP3DecoderContext reference_ctx;
+    std::vector<uint8_t> expected;
+    speaker::decode_mp3_to_pcm16(reference_ctx, mp3, expected);
+    const size_t expected_samples = expected.size() / sizeof(int16_t);
+
+    size_t offset = 0;
+    auto chunk_source = [&]() -> boost::optional<std::vector<uint8_t>> {
+        if (offset >= mp3.size()) {
+            return boost::none;
+        }
+        const size_t n = std::min<size_t>(300, mp3.size() - offset);
+        std::vector<uint8_t> chunk(mp3.begin() + offset, mp3.begin() + offset + n);
+        offset += n;
+        return chunk;
+    };
+
+    // Deliberately wrong: the decoder's frame headers are authoritative for MP3
+    viam::sdk::audio_info info{viam::sdk::audio_codecs::MP3, 16000, 2};
+    speaker.audio_context_->playback_position.store(expected_samples);
+
+    EXPECT_NO_THROW(speaker.play_stream(info, chunk_source, ProtoStruct{}));
+    EXPECT_EQ(speaker.audio_context_->get_write_position(), static_cast<uint64_t>(expected_samples));
+
+    std::vector<int16_t> read_buffer(expected_samples);
+    uint64_t read_pos = 0;
+    ASSERT_EQ(speaker.audio_context_->read_samples(read_buffer.data(), expected_samples, read_pos), static_cast<int>(expected_samples));
+    EXPECT_EQ(std::memcmp(read_buffer.data(), expected.data(), expected.size()), 0);
+}
+
+TEST_F(SpeakerTest, PlayStream_MP3_EmptySourceCompletes) {
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = 48000.0;
+    attributes["num_channels"] = 1.0;
+
+    ResourceConfig config(
+        "rdk:component:audioout", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    Dependencies deps{};
+    speaker::Speaker speaker(deps, config, mock_pa_.get());
+
+    viam::sdk::audio_info info{viam::sdk::audio_codecs::MP3, 48000, 1};
+    auto chunk_source = []() -> boost::optional<std::vector<uint8_t>> { return boost::none; };
+
+    EXPECT_NO_THROW(speaker.play_stream(info, chunk_source, ProtoStruct{}));
+    EXPECT_EQ(speaker.audio_context_->get_write_position(), 0u);
+}
+
+static std::vector<uint8_t> encode_test_opus(int sample_rate, int num_channels, int num_frames) {
+    microphone::OpusEncoderContext encoder;
+    microphone::initialize_opus_encoder(encoder, sample_rate, num_channels);
+    std::vector<int16_t> pcm(encoder.frame_size * num_channels * num_frames);
+    for (size_t i = 0; i < pcm.size(); i++) {
+        pcm[i] = static_cast<int16_t>((i % 100) * 100);
+    }
+    std::vector<uint8_t> opus;
+    microphone::encode_samples_to_opus(encoder, pcm.data(), pcm.size(), opus);
+    return opus;
+}
+
+TEST_F(SpeakerTest, Play_Opus_DecodesAtSpeakerRate) {
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = 48000.0;
+    attributes["num_channels"] = 1.0;
+    ResourceConfig config(
+        "rdk:component:audioout", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    Dependencies deps{};
+    speaker::Speaker speaker(deps, config, mock_pa_.get());
+
+    // Encoded at 16 kHz; Opus decodes straight to the speaker's 48 kHz without a resampler
+    const auto opus = encode_test_opus(16000, 1, 10);
+    const size_t expected_samples = 10 * 960;
+
+    speaker.audio_context_->playback_position.store(expected_samples);
+    viam::sdk::audio_info info{audio::codec::OPUS_CODEC_NAME, 16000, 1};
+    EXPECT_NO_THROW(speaker.play(opus, info, ProtoStruct{}));
+    EXPECT_EQ(speaker.audio_context_->get_write_position(), static_cast<uint64_t>(expected_samples));
+}
+
+TEST_F(SpeakerTest, Play_Opus_InvalidDataThrows) {
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = 48000.0;
+    attributes["num_channels"] = 1.0;
+    ResourceConfig config(
+        "rdk:component:audioout", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    Dependencies deps{};
+    speaker::Speaker speaker(deps, config, mock_pa_.get());
+
+    // The first length prefix claims more bytes than there are
+    const std::vector<uint8_t> truncated{0xFF, 0x0F, 0x01, 0x02};
+    viam::sdk::audio_info info{audio::codec::OPUS_CODEC_NAME, 48000, 1};
+    EXPECT_THROW(speaker.play(truncated, info, ProtoStruct{}), std::runtime_error);
+    EXPECT_EQ(speaker.audio_context_->get_write_position(), 0u);
+}
+
+TEST_F(SpeakerTest, PlayStream_Opus_DecodesAcrossChunks) {
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = 24000.0;
+    attributes["num_channels"] = 2.0;
+    ResourceConfig config(
+        "rdk:component:audioout", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    Dependencies deps{};
+    speaker::Speaker speaker(deps, config, mock_pa_.get());
+
+    const auto opus = encode_test_opus(24000, 2, 6);
+    speaker::OpusDecoderContext reference_ctx;
+    std::vector<uint8_t> expected;
+    speaker::decode_opus_chunk(reference_ctx, opus.data(), opus.size(), 24000, expected);
+    const size_t expected_samples = expected.size() / sizeof(int16_t);
+
+    // Chunks deliberately cut packets and their length prefixes
+    size_t offset = 0;
+    auto chunk_source = [&]() -> boost::optional<std::vector<uint8_t>> {
+        if (offset >= opus.size()) {
+            return boost::none;
+        }
+        const size_t n = std::min<size_t>(7, opus.size() - offset);
+        std::vector<uint8_t> chunk(opus.begin() + offset, opus.begin() + offset + n);
+        offset += n;
+        return chunk;
     };
 
-    EXPECT_THROW(speaker.play_stream(info, chunk_source, extra), std::invalid_argument);
+    speaker.audio_context_->playback_position.store(expected_samples);
+    viam::sdk::audio_info info{audio::codec::OPUS_CODEC_NAME, 24000, 2};
+    EXPECT_NO_THROW(speaker.play_stream(info, chunk_source, ProtoStruct{}));
+    ASSERT_EQ(speaker.audio_context_->get_write_position(), static_cast<uint64_t>(expected_samples));
+
+    std::vector<int16_t> read_buffer(expected_samples);
+    uint64_t read_pos = 0;
+    ASSERT_EQ(speaker.audio_context_->read_samples(read_buffer.data(), expected_samples, read_pos), static_cast<int>(expected_samples));
+    EXPECT_EQ(std::memcmp(read_buffer.data(), expected.data(), expected.size()), 0);
 }
 
 TEST_F(SpeakerTest, PlayStream_EmptySourceCompletes) {
@@ -1116,8 +1570,8 @@ TEST_F(SpeakerTest, PlayStream_PCM16_MultipleChunks) {
 
 TEST_F(SpeakerTest, PlayStream_BackpressureBlocksProducerWhenBufferFull) {
     // Small sample_rate keeps buffer_capacity tractable and the test fast.
-    // buffer_capacity = sample_rate * num_channels * BUFFER_DURATION_SECONDS = 30000.
-    // BUFFER_MARGIN_MS = 50 → margin_samples = 50, max_ahead = 29950.
+    // buffer_capacity = sample_rate * num_channels * OUTPUT_BUFFER_DURATION_SECONDS = 5000.
+    // BUFFER_MARGIN_MS = 50 → margin_samples = 50, max_ahead = 4950.
     const int sample_rate = 1000;
     const int num_channels = 1;
     const int buffer_margin_ms = 50;
@@ -1441,6 +1895,219 @@ TEST_F(SpeakerTest, PlayStream_StopRequestedBreaksLoop) {
     EXPECT_EQ(speaker.audio_context_->get_write_position(), static_cast<uint64_t>(samples_per_chunk));
 }
 
+TEST_F(SpeakerTest, CallbackHoldsUntilPrerollBuffered) {
+    viam::sdk::audio_info info{viam::sdk::audio_codecs::PCM_16, 48000, 1};
+    audio::OutputStreamContext ctx(info, 30);
+    for (int i = 0; i < 100; i++) {
+        ctx.write_sample(static_cast<int16_t>(i + 1));
+    }
+    ctx.preroll_until.store(200);
+
+    std::vector<int16_t> output_buffer(64, 1);
+    speaker::speakerCallback(nullptr, output_buffer.data(), output_buffer.size(), nullptr, 0, &ctx);
+    EXPECT_EQ(ctx.playback_position.load(), 0);
+    for (int16_t sample : output_buffer) {
+        EXPECT_EQ(sample, 0);
+    }
+
+    for (int i = 100; i < 200; i++) {
+        ctx.write_sample(static_cast<int16_t>(i + 1));
+    }
+    speaker::speakerCallback(nullptr, output_buffer.data(), output_buffer.size(), nullptr, 0, &ctx);
+    EXPECT_EQ(ctx.playback_position.load(), output_buffer.size());
+    EXPECT_EQ(output_buffer[0], 1);
+}
+
+TEST_F(SpeakerTest, PlayStream_PrerollArmedAndReleased) {
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = 48000.0;
+    attributes["num_channels"] = 1.0;
+    attributes["preroll_ms"] = 100.0;
+
+    ResourceConfig config(
+        "rdk:component:audioout", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    Dependencies deps{};
+    speaker::Speaker speaker(deps, config, mock_pa_.get());
+
+    const int samples_per_chunk = 100;
+    std::vector<uint8_t> chunk(samples_per_chunk * sizeof(int16_t), 1);
+    uint64_t preroll_at_start = 0;
+    int chunks_pulled = 0;
+    auto chunk_source = [&]() -> boost::optional<std::vector<uint8_t>> {
+        if (chunks_pulled++ == 2) {
+            return boost::none;
+        }
+        if (chunks_pulled == 1) {
+            preroll_at_start = speaker.audio_context_->preroll_until.load();
+        }
+        return chunk;
+    };
+
+    speaker.audio_context_->playback_position.store(2 * samples_per_chunk);
+    viam::sdk::audio_info info{viam::sdk::audio_codecs::PCM_16, 48000, 1};
+    EXPECT_NO_THROW(speaker.play_stream(info, chunk_source, ProtoStruct{}));
+
+    // 100 ms at 48 kHz mono, and nothing held back once the stream has ended
+    EXPECT_EQ(preroll_at_start, 4800);
+    EXPECT_EQ(speaker.audio_context_->preroll_until.load(), 0);
+}
+
+TEST_F(SpeakerTest, PlayStream_PrerollGrowsWhenSourceFallsBehind) {
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = 48000.0;
+    attributes["num_channels"] = 1.0;
+    attributes["preroll_ms"] = 20.0;
+    attributes["max_preroll_ms"] = 200.0;
+
+    ResourceConfig config(
+        "rdk:component:audioout", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    Dependencies deps{};
+    speaker::Speaker speaker(deps, config, mock_pa_.get());
+
+    // Every chunk, the reader has caught up with everything written, as when a network source
+    // stalls. Chunks are longer than any pre-roll, so each one completes the pending pre-roll.
+    const int samples_per_chunk = 9600;
+    const int num_chunks = 6;
+    std::vector<uint8_t> chunk(samples_per_chunk * sizeof(int16_t), 1);
+    int chunks_pulled = 0;
+    auto chunk_source = [&]() -> boost::optional<std::vector<uint8_t>> {
+        speaker.audio_context_->playback_position.store(speaker.audio_context_->get_write_position());
+        if (chunks_pulled++ == num_chunks) {
+            return boost::none;
+        }
+        return chunk;
+    };
+
+    viam::sdk::audio_info info{viam::sdk::audio_codecs::PCM_16, 48000, 1};
+    EXPECT_NO_THROW(speaker.play_stream(info, chunk_source, ProtoStruct{}));
+
+    // 20 -> 40 -> 80 -> 160 -> 200 (capped), and the next stream starts there
+    EXPECT_EQ(speaker.jitter_target_ms_.load(), 200);
+}
+
+TEST_F(SpeakerTest, BufferSecondsSizesPlaybackBuffer) {
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = 48000.0;
+    attributes["num_channels"] = 2.0;
+
+    ResourceConfig default_config(
+        "rdk:component:audioout", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+    speaker::Speaker default_speaker(test_deps_, default_config, mock_pa_.get());
+    auto settings = default_speaker.do_command(ProtoStruct{{"get_buffer_settings", true}});
+    EXPECT_EQ(*settings.at("buffer_seconds").get<double>(), audio::OUTPUT_BUFFER_DURATION_SECONDS);
+
+    attributes["buffer_seconds"] = 3.0;
+    ResourceConfig config(
+        "rdk:component:audioout", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+    speaker::Speaker speaker(test_deps_, config, mock_pa_.get());
+    EXPECT_EQ(speaker.audio_context_->buffer_capacity, 48000 * 2 * 3);
+
+    settings = speaker.do_command(ProtoStruct{{"get_buffer_settings", true}});
+    EXPECT_EQ(*settings.at("buffer_seconds").get<double>(), 3.0);
+    EXPECT_EQ(*settings.at("buffer_samples").get<double>(), 48000 * 2 * 3);
+    EXPECT_EQ(*settings.at("buffer_bytes").get<double>(), speaker.audio_context_->memory_bytes());
+}
+
+TEST_F(SpeakerTest, GetStatsReportsCallbacksAndChunks) {
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = 48000.0;
+    attributes["num_channels"] = 1.0;
+    ResourceConfig config(
+        "rdk:component:speaker", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+    speaker::Speaker speaker(test_deps_, config, mock_pa_.get());
+
+    // 100 ms queued ahead of the first callback, 90 ms ahead of the second
+    const int frames = 480;
+    std::vector<int16_t> input(4800, 1000);
+    speaker.audio_context_->write_samples(input.data(), input.size());
+    std::vector<int16_t> output(frames);
+    speaker::speakerCallback(nullptr, output.data(), frames, nullptr, 0, speaker.audio_context_.get());
+    speaker::speakerCallback(nullptr, output.data(), frames, nullptr, 0, speaker.audio_context_.get());
+
+    auto stats = speaker.do_command(ProtoStruct{{"get_stats", true}});
+    EXPECT_EQ(*stats.at("callback_duration_us").get<ProtoStruct>()->at("count").get<double>(), 2);
+    EXPECT_EQ(*stats.at("callback_interval_us").get<ProtoStruct>()->at("count").get<double>(), 1);
+    const auto& queued = *stats.at("queued_ms").get<ProtoStruct>();
+    EXPECT_EQ(*queued.at("max").get<double>(), 100);
+    EXPECT_DOUBLE_EQ(*queued.at("mean").get<double>(), 95);
+    EXPECT_EQ(*stats.at("output_underflows").get<double>(), 0);
+
+    // Resampled playback is timed per call
+    const std::vector<uint8_t> audio(480 * sizeof(int16_t), 0);
+    speaker.audio_context_->playback_position.store(speaker.audio_context_->get_write_position());
+    std::thread drain([&]() {
+        for (int i = 0; i < 50; i++) {
+            speaker::speakerCallback(nullptr, output.data(), frames, nullptr, 0, speaker.audio_context_.get());
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    });
+    speaker.play(audio, viam::sdk::audio_info{viam::sdk::audio_codecs::PCM_16, 24000, 1}, ProtoStruct{});
+    drain.join();
+
+    stats = speaker.do_command(ProtoStruct{{"get_stats", ProtoStruct{{"reset", true}}}});
+    EXPECT_EQ(*stats.at("chunks").get<double>(), 1);
+    EXPECT_EQ(*stats.at("resample_us").get<ProtoStruct>()->at("count").get<double>(), 1);
+    EXPECT_EQ(*speaker.get_status().at("callback_duration_us").get<ProtoStruct>()->at("count").get<double>(), 0);
+}
+
+TEST_F(SpeakerTest, CallbackTimingIsOptIn) {
+    speaker::Speaker plain(test_deps_, *test_config_, mock_pa_.get());
+    EXPECT_FALSE(plain.audio_context_->callback_timing);
+    EXPECT_EQ(plain.get_status().count("callback_timing"), 0);
+
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = 48000.0;
+    attributes["num_channels"] = 1.0;
+    attributes["callback_timing"] = true;
+    ResourceConfig config(
+        "rdk:component:speaker", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+    speaker::Speaker speaker(test_deps_, config, mock_pa_.get());
+
+    std::vector<int16_t> output(480);
+    speaker::speakerCallback(nullptr, output.data(), output.size(), nullptr, 0, speaker.audio_context_.get());
+    const auto timing = *speaker.get_status().at("callback_timing").get<ProtoStruct>();
+    EXPECT_EQ(*timing.at("count").get<double>(), 1);
+    EXPECT_EQ(*timing.at("period_us").get<double>(), 10000);
+
+    attributes["callback_timing"] = 1.0;
+    ResourceConfig invalid(
+        "rdk:component:speaker", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+    EXPECT_THROW(speaker::Speaker::validate(invalid), std::invalid_argument);
+}
+
+TEST_F(SpeakerTest, ValidateRejectsInvalidBufferSeconds) {
+    for (const auto& value : {ProtoValue(1.0), ProtoValue(2.5), ProtoValue(601.0), ProtoValue(std::string("10"))}) {
+        auto attributes = ProtoStruct{};
+        attributes["buffer_seconds"] = value;
+        ResourceConfig config(
+            "rdk:component:audioout", "", test_name_, attributes, "",
+            speaker::Speaker::model, LinkConfig{}, log_level::info);
+        EXPECT_THROW(speaker::Speaker::validate(config), std::invalid_argument);
+    }
+}
+
+TEST_F(SpeakerTest, ValidateRejectsInvalidPreroll) {
+    const auto rejects = [this](ProtoStruct attributes) {
+        ResourceConfig config(
+            "rdk:component:audioout", "", test_name_, attributes, "",
+            speaker::Speaker::model, LinkConfig{}, log_level::info);
+        EXPECT_THROW(speaker::Speaker::validate(config), std::invalid_argument);
+    };
+    rejects(ProtoStruct{{"preroll_ms", -1.0}});
+    rejects(ProtoStruct{{"preroll_ms", std::string("100")}});
+    rejects(ProtoStruct{{"max_preroll_ms", 5000.0}});
+    rejects(ProtoStruct{{"preroll_ms", 200.0}, {"max_preroll_ms", 100.0}});
+}
+
 TEST_F(SpeakerTest, PlayStream_ResetsStopRequestedOnEntry) {
     // play_stream() must clear a previously-set stop_requested_ so a prior stop command
     // doesn't poison the next stream.
@@ -1487,7 +2154,7 @@ TEST_F(SpeakerTest, PlayStream_ResetsStopRequestedOnEntry) {
 
 
 // Watchdog: when the speaker callback stops firing, the background watcher should
-// detect the staleness on its next poll and replace audio_context_ with a fresh one.
+// detect the staleness on its next poll and reopen the stream on the same audio_context_.
 // We force the stale state by manually setting last_callback_time_ns to a timestamp
 // well past STREAM_RESTART_THRESHOLD_MS in the past, then sleep one poll cycle + slack.
 TEST_F(SpeakerTest, WatchdogRestartsStalledStream) {
@@ -1528,15 +2195,19 @@ TEST_F(SpeakerTest, WatchdogRestartsStalledStream) {
         after_attempts = speaker.restart_attempts_;
     }
 
-    EXPECT_NE(after_context.get(), initial_context.get())
-        << "watchdog should have replaced audio_context_ after detecting stall";
+    EXPECT_EQ(after_context.get(), initial_context.get())
+        << "the restarted stream should keep playing from the same audio_context_";
     EXPECT_EQ(after_attempts, 0)
         << "restart should have succeeded with the mock pa returning paNoError";
+    EXPECT_EQ(after_context->last_callback_time_ns.load(), 0)
+        << "the new stream's first callback gets the usual grace period";
+
+    EXPECT_EQ(after_context->stats, speaker.stats_);
+    EXPECT_EQ(*speaker.get_status().at("restarts").get<double>(), 1);
 }
 
 // Watchdog: if restart_stream fails (e.g. PortAudio errors), restart_attempts_ should
-// climb instead of resetting to 0. The fresh audio_context_ is also NOT swapped in
-// because restart_stalled_stream only updates audio_context_ on success.
+// climb instead of resetting to 0, and audio_context_ stays put.
 TEST_F(SpeakerTest, WatchdogIncrementsAttemptsOnRestartFailure) {
     using ::testing::_;
     using ::testing::Return;
@@ -1583,6 +2254,335 @@ TEST_F(SpeakerTest, WatchdogIncrementsAttemptsOnRestartFailure) {
         << "audio_context_ should not be swapped on failed restart";
 }
 
+// Duplex: a microphone takes over playback, so the speaker closes its own stream, leaves stall
+// restarts to the microphone, and reopens on the same context once it's handed back.
+TEST_F(SpeakerTest, AttachDuplexHandsOverPlayback) {
+    using ::testing::_;
+    using ::testing::IsNull;
+    using ::testing::NotNull;
+
+    auto attributes = ProtoStruct{};
+    attributes["sample_rate"] = 48000.0;
+    attributes["num_channels"] = 2.0;
+    ResourceConfig config(
+        "rdk:component:audioout", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    // The constructor's stream and the one reopened by detach_duplex; never a duplex one
+    EXPECT_CALL(*mock_pa_, openStream(_, IsNull(), NotNull(), _, _, _, _, _)).Times(2);
+    Dependencies deps{};
+    speaker::Speaker speaker(deps, config, mock_pa_.get());
+
+    const speaker::DuplexOutput output = speaker.attach_duplex();
+    EXPECT_EQ(output.context, speaker.audio_context_);
+    EXPECT_EQ(output.sample_rate, 48000);
+    EXPECT_EQ(output.num_channels, 2);
+    EXPECT_EQ(speaker.stream_, nullptr);
+    EXPECT_THROW(speaker.attach_duplex(), std::runtime_error);
+
+    // A stall while attached is the microphone's to recover from
+    test_utils::mark_callback_stale(output.context);
+    test_utils::wait_one_poll();
+    EXPECT_EQ(*speaker.get_status().at("restarts").get<double>(), 0);
+
+    speaker.detach_duplex();
+    EXPECT_FALSE(speaker.duplex_attached_);
+    // Detaching again is a no-op
+    speaker.detach_duplex();
+}
+
+// Mixing tests drive the callback by hand, since the mock stream never calls it.
+class SpeakerMixingTest: public SpeakerTest {
+protected:
+    static constexpr int sample_rate = 48000;
+    static constexpr int frames_per_buffer = 480;
+
+    std::unique_ptr<speaker::Speaker> make_mixing_speaker() {
+        auto attributes = ProtoStruct{};
+        attributes["sample_rate"] = static_cast<double>(sample_rate);
+        attributes["num_channels"] = 1.0;
+        attributes["mixing"] = true;
+        ResourceConfig config(
+            "rdk:component:audioout", "", test_name_, attributes, "",
+            speaker::Speaker::model, LinkConfig{}, log_level::info);
+        return std::make_unique<speaker::Speaker>(test_deps_, config, mock_pa_.get());
+    }
+
+    static std::vector<uint8_t> constant_pcm(size_t num_samples, int16_t value) {
+        std::vector<int16_t> samples(num_samples, value);
+        std::vector<uint8_t> bytes(num_samples * sizeof(int16_t));
+        std::memcpy(bytes.data(), samples.data(), bytes.size());
+        return bytes;
+    }
+
+    // play_stream of a single chunk on its own thread; done is set when it returns
+    static std::thread play_async(speaker::Speaker& speaker, std::vector<uint8_t> chunk, ProtoStruct extra, std::atomic<bool>& done) {
+        return std::thread([&speaker, chunk = std::move(chunk), extra = std::move(extra), &done]() {
+            bool delivered = false;
+            auto chunk_source = [&]() -> boost::optional<std::vector<uint8_t>> {
+                if (delivered) {
+                    return boost::none;
+                }
+                delivered = true;
+                return chunk;
+            };
+            speaker.play_stream(viam::sdk::audio_info{viam::sdk::audio_codecs::PCM_16, sample_rate, 1}, chunk_source, extra);
+            done.store(true);
+        });
+    }
+
+    // Waits until count sources are registered with every sample written to their rings
+    static bool wait_for_sources(speaker::Speaker& speaker, size_t count, uint64_t samples_each) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (std::chrono::steady_clock::now() < deadline) {
+            {
+                std::lock_guard<std::mutex> lock(speaker.mix_mu_);
+                size_t ready = 0;
+                for (const auto& source : speaker.mix_sources_) {
+                    ready += source->ring.get_write_position() >= samples_each ? 1 : 0;
+                }
+                if (ready == count) {
+                    return true;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    // Runs the callback until done() and returns everything it played, including silence
+    static std::vector<int16_t> drive_callback(speaker::Speaker& speaker, const std::function<bool()>& done) {
+        std::vector<int16_t> played;
+        std::vector<int16_t> buffer(frames_per_buffer);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!done() && std::chrono::steady_clock::now() < deadline) {
+            speaker::speakerCallback(nullptr, buffer.data(), frames_per_buffer, nullptr, 0, speaker.audio_context_.get());
+            played.insert(played.end(), buffer.begin(), buffer.end());
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return played;
+    }
+};
+
+TEST_F(SpeakerTest, ValidateRejectsNonBooleanMixing) {
+    auto attributes = ProtoStruct{};
+    attributes["mixing"] = std::string("yes");
+    ResourceConfig config(
+        "rdk:component:audioout", "", test_name_, attributes, "",
+        speaker::Speaker::model, LinkConfig{}, log_level::info);
+
+    EXPECT_THROW(speaker::Speaker::validate(config), std::invalid_argument);
+}
+
+TEST_F(SpeakerTest, PreloadedClipPlaysById) {
+    auto attributes = ProtoStruct{{"sample_rate", 48000.0}, {"num_channels", 2.0}};
+    ResourceConfig config(
+        "rdk:component:audioout", "", test_name_, attributes, "", speaker::Speaker::model, LinkConfig{}, log_level::info);
+    speaker::Speaker speaker(Dependencies{}, config, mock_pa_.get());
+
+    // 100 ms of 24 kHz mono, converted once to 48 kHz stereo: 9600 samples
+    std::vector<int16_t> samples(2400, 1000);
+    std::vector<uint8_t> audio_data(reinterpret_cast<uint8_t*>(samples.data()),
+                                    reinterpret_cast<uint8_t*>(samples.data() + samples.size()));
+    speaker.play(audio_data, viam::sdk::audio_info{viam::sdk::audio_codecs::PCM_16, 24000, 1}, ProtoStruct{{"preload_clip", std::string("beep")}});
+    // Preloading plays nothing
+    EXPECT_EQ(speaker.audio_context_->get_write_position(), 0u);
+
+    const auto clips = speaker.do_command(ProtoStruct{{"get_clips", true}});
+    const auto& entries = *clips.at("clips").get<ProtoList>();
+    ASSERT_EQ(entries.size(), 1);
+    EXPECT_EQ(*entries[0].get<ProtoStruct>()->at("id").get<std::string>(), "beep");
+    EXPECT_EQ(*entries[0].get<ProtoStruct>()->at("duration_ms").get<double>(), 100);
+    EXPECT_EQ(*clips.at("max_bytes").get<double>(), audio::clips::DEFAULT_CACHE_MB << 20);
+
+    for (uint64_t i = 1; i <= 2; i++) {
+        speaker.audio_context_->playback_position.store(9600 * i);
+        const auto result = speaker.do_command(ProtoStruct{{"play_clip", std::string("beep")}});
+        EXPECT_EQ(*result.at("played").get<std::string>(), "beep");
+        EXPECT_EQ(speaker.audio_context_->get_write_position(), 9600 * i);
+    }
+
+    EXPECT_THROW(speaker.do_command(ProtoStruct{{"play_clip", std::string("chime")}}), std::invalid_argument);
+    EXPECT_TRUE(*speaker.do_command(ProtoStruct{{"remove_clip", std::string("beep")}}).at("removed").get<bool>());
+    EXPECT_THROW(speaker.do_command(ProtoStruct{{"play_clip", ProtoStruct{{"id", std::string("beep")}}}}), std::invalid_argument);
+}
+
+TEST_F(SpeakerTest, PreloadedClipFollowsFormatChange) {
+    auto attributes = ProtoStruct{{"sample_rate", 48000.0}, {"num_channels", 1.0}};
+    ResourceConfig config(
+        "rdk:component:audioout", "", test_name_, attributes, "", speaker::Speaker::model, LinkConfig{}, log_level::info);
+    speaker::Speaker speaker(Dependencies{}, config, mock_pa_.get());
+
+    // A WAV file on disk: 100 ms of 48 kHz mono
+    const std::string path = ::testing::TempDir() + "speaker_test_clip.wav";
+    {
+        std::vector<int16_t> samples(4800, 500);
+        const uint32_t data_bytes = samples.size() * sizeof(int16_t);
+        std::vector<uint8_t> wav(audio::codec::wav_header_size, 0);
+        std::memcpy(wav.data(), "RIFF", 4);
+        wav[22] = 1;                              // channels
+        const uint32_t rate = 48000;
+        std::memcpy(wav.data() + 24, &rate, 4);  // sample rate
+        std::memcpy(wav.data() + 40, &data_bytes, 4);
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(wav.data()), wav.size());
+        file.write(reinterpret_cast<const char*>(samples.data()), data_bytes);
+    }
+    const auto loaded = speaker.do_command(ProtoStruct{{"preload_clip", ProtoStruct{{"id", std::string("chime")}, {"path", path}}}});
+    EXPECT_EQ(*loaded.at("duration_ms").get<double>(), 100);
+    const double bytes_before = *speaker.do_command(ProtoStruct{{"get_clips", true}}).at("bytes").get<double>();
+
+    // The stream comes back at another rate: the clip is converted again on its next play
+    {
+        std::lock_guard<std::mutex> lock(speaker.stream_mu_);
+        speaker.stream_params_.sample_rate = 24000;
+    }
+    speaker.audio_context_->playback_position.store(2400);
+    speaker.do_command(ProtoStruct{{"play_clip", std::string("chime")}});
+    EXPECT_EQ(speaker.audio_context_->get_write_position(), 2400u);
+    EXPECT_LT(*speaker.do_command(ProtoStruct{{"get_clips", true}}).at("bytes").get<double>(), bytes_before);
+
+    EXPECT_THROW(speaker.do_command(ProtoStruct{{"preload_clip", ProtoStruct{{"id", std::string("x")}, {"path", path + ".missing"}}}}),
+                 std::invalid_argument);
+    std::remove(path.c_str());
+}
+
+TEST_F(SpeakerTest, ValidateRejectsInvalidClipCache) {
+    for (const auto& value : {ProtoValue(-1.0), ProtoValue(2.5), ProtoValue(4096.0), ProtoValue(std::string("16"))}) {
+        auto attributes = ProtoStruct{{"clip_cache_mb", value}};
+        ResourceConfig config(
+            "rdk:component:audioout", "", test_name_, attributes, "", speaker::Speaker::model, LinkConfig{}, log_level::info);
+        EXPECT_THROW(speaker::Speaker::validate(config), std::invalid_argument);
+    }
+}
+
+TEST_F(SpeakerMixingTest, ConcurrentCallsAreSummed) {
+    auto speaker = make_mixing_speaker();
+    const size_t num_samples = 4800;
+
+    std::atomic<bool> stream_done{false};
+    std::atomic<bool> play_done{false};
+    auto stream_thread = play_async(*speaker, constant_pcm(num_samples, 1000), ProtoStruct{}, stream_done);
+    // play() doesn't wait on the stream above and mixes the same way
+    std::thread play_thread([&]() {
+        speaker->play(constant_pcm(num_samples, 2000), viam::sdk::audio_info{viam::sdk::audio_codecs::PCM_16, sample_rate, 1}, {});
+        play_done.store(true);
+    });
+
+    ASSERT_TRUE(wait_for_sources(*speaker, 2, num_samples));
+    auto played = drive_callback(*speaker, [&]() { return stream_done.load() && play_done.load(); });
+    stream_thread.join();
+    play_thread.join();
+
+    int64_t total = 0;
+    size_t overlapped = 0;
+    for (int16_t sample : played) {
+        total += sample;
+        overlapped += sample == 3000 ? 1 : 0;
+    }
+    EXPECT_EQ(total, static_cast<int64_t>(num_samples) * 3000) << "every sample of both calls should be played exactly once";
+    // At most the mixer's lead can be mixed before the second call's audio lands
+    EXPECT_GE(overlapped, num_samples - sample_rate * 20 / 1000);
+
+    // Finished sources are dropped on the mixer's next pass
+    drive_callback(*speaker, [&]() {
+        std::lock_guard<std::mutex> lock(speaker->mix_mu_);
+        return speaker->mix_sources_.empty();
+    });
+    std::lock_guard<std::mutex> lock(speaker->mix_mu_);
+    EXPECT_TRUE(speaker->mix_sources_.empty());
+}
+
+TEST_F(SpeakerMixingTest, AppliesPerCallGain) {
+    auto speaker = make_mixing_speaker();
+    const size_t num_samples = 2400;
+
+    std::atomic<bool> done{false};
+    auto thread = play_async(*speaker, constant_pcm(num_samples, 1000), ProtoStruct{{"gain", 0.5}}, done);
+    ASSERT_TRUE(wait_for_sources(*speaker, 1, num_samples));
+    auto played = drive_callback(*speaker, [&]() { return done.load(); });
+    thread.join();
+
+    EXPECT_EQ(std::count(played.begin(), played.end(), 500), num_samples);
+    EXPECT_EQ(std::count(played.begin(), played.end(), 0), played.size() - num_samples);
+}
+
+TEST_F(SpeakerMixingTest, SumSaturates) {
+    auto speaker = make_mixing_speaker();
+    const size_t num_samples = 2400;
+
+    std::atomic<bool> done_a{false};
+    std::atomic<bool> done_b{false};
+    auto thread_a = play_async(*speaker, constant_pcm(num_samples, 30000), ProtoStruct{}, done_a);
+    auto thread_b = play_async(*speaker, constant_pcm(num_samples, 30000), ProtoStruct{}, done_b);
+    ASSERT_TRUE(wait_for_sources(*speaker, 2, num_samples));
+    auto played = drive_callback(*speaker, [&]() { return done_a.load() && done_b.load(); });
+    thread_a.join();
+    thread_b.join();
+
+    EXPECT_EQ(*std::max_element(played.begin(), played.end()), 32767);
+    EXPECT_GE(*std::min_element(played.begin(), played.end()), 0) << "clipped sum must not wrap around";
+}
+
+TEST_F(SpeakerMixingTest, DucksLowerPriorityCalls) {
+    auto speaker = make_mixing_speaker();
+    const size_t num_samples = 4800;
+
+    std::atomic<bool> done_low{false};
+    std::atomic<bool> done_high{false};
+    auto low = play_async(*speaker, constant_pcm(num_samples, 1000), ProtoStruct{}, done_low);
+    auto high = play_async(*speaker, constant_pcm(num_samples, 1000), ProtoStruct{{"priority", 1.0}}, done_high);
+    ASSERT_TRUE(wait_for_sources(*speaker, 2, num_samples));
+    auto played = drive_callback(*speaker, [&]() { return done_low.load() && done_high.load(); });
+    low.join();
+    high.join();
+
+    // Once ramped down, the low-priority call plays at a quarter of its level under the other
+    EXPECT_GT(std::count(played.begin(), played.end(), 1250), num_samples / 2);
+    EXPECT_EQ(std::count(played.begin(), played.end(), 2000), 0) << "both calls at full level means no ducking";
+}
+
+TEST_F(SpeakerMixingTest, StopInterruptsEveryCall) {
+    auto speaker = make_mixing_speaker();
+
+    // Endless sources; with no callback running, both block on backpressure
+    auto endless = [&](std::atomic<bool>& done) {
+        return std::thread([&]() {
+            int chunks = 0;
+            auto chunk_source = [&]() -> boost::optional<std::vector<uint8_t>> {
+                if (++chunks > 1000) {
+                    return boost::none;
+                }
+                return constant_pcm(4800, 100);
+            };
+            speaker->play_stream(viam::sdk::audio_info{viam::sdk::audio_codecs::PCM_16, sample_rate, 1}, chunk_source, {});
+            done.store(true);
+        });
+    };
+    std::atomic<bool> done_a{false};
+    std::atomic<bool> done_b{false};
+    auto thread_a = endless(done_a);
+    auto thread_b = endless(done_b);
+
+    ASSERT_TRUE(wait_for_sources(*speaker, 2, 48000));
+    EXPECT_FALSE(done_a.load() || done_b.load());
+
+    speaker->do_command(ProtoStruct{{"stop", true}});
+    thread_a.join();
+    thread_b.join();
+    EXPECT_TRUE(done_a.load() && done_b.load());
+}
+
+TEST_F(SpeakerMixingTest, RejectsInvalidGain) {
+    auto speaker = make_mixing_speaker();
+    ProtoStruct extra{{"gain", 10.0}};
+    auto chunk_source = []() -> boost::optional<std::vector<uint8_t>> { return boost::none; };
+
+    EXPECT_THROW(speaker->play_stream(viam::sdk::audio_info{viam::sdk::audio_codecs::PCM_16, sample_rate, 1}, chunk_source, extra),
+                 std::invalid_argument);
+    EXPECT_TRUE(speaker->mix_sources_.empty());
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   ::testing::AddGlobalTestEnvironment(new test_utils::AudioTestEnvironment);
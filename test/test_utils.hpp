@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <memory>
@@ -149,9 +150,8 @@ protected:
 // Helper function to clear an AudioBuffer - resets all samples and write position
 inline void ClearAudioBuffer(audio::AudioBuffer& buffer) {
     buffer.total_samples_written.store(0);
-    for (int i = 0; i < buffer.buffer_capacity; i++) {
-        buffer.audio_buffer[i].store(0);
-    }
+    buffer.write_reserved.store(0);
+    std::fill(buffer.audio_buffer.get(), buffer.audio_buffer.get() + buffer.memory_bytes(), 0);
 }
 
 } // namespace test_utils
@@ -125,6 +125,81 @@ TEST(StallWatchdog, NoRestartWhenContextIsNull) {
     EXPECT_EQ(restart_calls.load(), 0);
 }
 
+// A device change wakes the watchdog right away and restarts a stream whose callback has
+// gone quiet, without waiting for STALL_THRESHOLD.
+TEST(StallWatchdog, DeviceChangeRestartsQuietStreamImmediately) {
+    const auto ctx = make_context_stale_by(1000);  // under STALL_THRESHOLD, over HOTPLUG_STALL_THRESHOLD
+    std::atomic<int> restart_calls{0};
+
+    audio::utils::StallWatchdog<FakeContext> wd(
+        [ctx]() { return ctx; },
+        []() { return 0; },
+        [&restart_calls](const std::shared_ptr<FakeContext>&) { restart_calls.fetch_add(1); },
+        "[wd_test_7]");
+    wd.start();
+
+    test_utils::wait_one_poll();
+    EXPECT_EQ(restart_calls.load(), 0);
+
+    wd.notify_device_change();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));  // well under POLL_INTERVAL
+    wd.stop();
+
+    EXPECT_GE(restart_calls.load(), 1);
+}
+
+// A device change elsewhere on the system leaves a healthy stream alone.
+TEST(StallWatchdog, DeviceChangeLeavesHealthyStreamAlone) {
+    const auto ctx = std::make_shared<FakeContext>();
+    std::atomic<bool> running{true};
+    std::thread callback([&]() {
+        while (running.load()) {
+            ctx->last_callback_time_ns.store(test_utils::now_ns());
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+    std::atomic<int> restart_calls{0};
+
+    audio::utils::StallWatchdog<FakeContext> wd(
+        [ctx]() { return ctx; },
+        []() { return 0; },
+        [&restart_calls](const std::shared_ptr<FakeContext>&) { restart_calls.fetch_add(1); },
+        "[wd_test_8]");
+    wd.start();
+    wd.notify_device_change();
+    test_utils::wait_one_poll();
+    wd.stop();
+    running.store(false);
+    callback.join();
+
+    EXPECT_EQ(restart_calls.load(), 0);
+}
+
+// With hotplug events available, a watchdog whose device is gone stops its backoff retries
+// and waits for the next device change, which it retries on immediately.
+TEST(StallWatchdog, HotplugSleepsUntilDeviceChange) {
+    const auto ctx = make_context_stale_by(5000);
+    std::atomic<int> restart_calls{0};
+
+    audio::utils::StallWatchdog<FakeContext> wd(
+        [ctx]() { return ctx; },
+        []() { return audio::utils::MAX_RESTART_ATTEMPTS; },  // the device never comes back
+        [&restart_calls](const std::shared_ptr<FakeContext>&) { restart_calls.fetch_add(1); },
+        "[wd_test_9]");
+    wd.set_hotplug_active(true);
+    wd.start();
+
+    // Past BACKOFF_INTERVAL, which would have allowed a second retry without hotplug
+    std::this_thread::sleep_for(audio::utils::BACKOFF_INTERVAL + std::chrono::milliseconds(500));
+    EXPECT_EQ(restart_calls.load(), 1);
+
+    wd.notify_device_change();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    wd.stop();
+
+    EXPECT_EQ(restart_calls.load(), 2);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     ::testing::AddGlobalTestEnvironment(new test_utils::AudioTestEnvironment);